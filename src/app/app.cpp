@@ -38,6 +38,8 @@
 #include "app/script/app_scripting.h"
 #include "app/send_crash.h"
 #include "app/shell.h"
+#include "app/startup_profiler.h"
+#include "app/task_manager.h"
 #include "app/tools/active_tool.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/color_bar.h"
@@ -52,6 +54,7 @@
 #include "app/ui/workspace.h"
 #include "app/ui_context.h"
 #include "app/util/clipboard.h"
+#include "app/util/replay_strokes.h"
 #include "base/convert_to.h"
 #include "base/exception.h"
 #include "base/fs.h"
@@ -74,6 +77,7 @@
 #include "ui/intern.h"
 #include "ui/ui.h"
 
+#include <future>
 #include <iostream>
 
 namespace app {
@@ -140,12 +144,18 @@ App::App()
 
 void App::initialize(const AppOptions& options)
 {
+  if (options.profileStartup())
+    start_startup_profiler();
+
   m_isGui = options.startUI();
   m_isShell = options.startShell();
   if (m_isGui)
     m_uiSystem.reset(new ui::UISystem);
 
-  m_coreModules = std::make_unique<CoreModules>();
+  {
+    StartupPhase phase("core modules");
+    m_coreModules = std::make_unique<CoreModules>();
+  }
 
   bool createLogInDesktop = false;
   switch (options.verboseLevel()) {
@@ -161,23 +171,50 @@ void App::initialize(const AppOptions& options)
       break;
   }
 
-  m_modules = std::make_unique<Modules>(createLogInDesktop);
-  m_legacy = std::make_unique<LegacyModules>(isGui() ? REQUIRE_INTERFACE: 0);
-  m_brushes.reset(new AppBrushes);
+  {
+    StartupPhase phase("modules");
+    m_modules = std::make_unique<Modules>(createLogInDesktop);
+  }
+
+  // Read the default palette file in background while the rest of
+  // the modules are initialized (it's set as the current palette
+  // later, from this thread).
+  std::future<std::shared_ptr<Palette>> defaultPalette =
+    std::async(std::launch::async,
+               [palFile = options.paletteFileName()]{
+                 StartupPhase phase("read default palette");
+                 return read_default_palette(palFile);
+               });
+
+  {
+    StartupPhase phase("legacy modules");
+    m_legacy = std::make_unique<LegacyModules>(isGui() ? REQUIRE_INTERFACE: 0);
+  }
+  {
+    StartupPhase phase("brushes");
+    m_brushes.reset(new AppBrushes);
+  }
 
   if (options.hasExporterParams())
     m_exporter.reset(new DocumentExporter);
 
   // Data recovery is enabled only in GUI mode
-  if (isGui() && preferences().general.dataRecovery())
+  if (isGui() && preferences().general.dataRecovery()) {
+    StartupPhase phase("data recovery");
     m_modules->createDataRecovery();
+  }
 
   if (isPortable())
     LOG("Running in portable mode\n");
 
   // Load or create the default palette, or migrate the default
   // palette from an old format palette to the new one, etc.
-  load_default_palette(options.paletteFileName());
+  {
+    StartupPhase phase("default palette");
+    if (auto pal = defaultPalette.get())
+      set_default_palette(pal.get());
+    set_current_palette(nullptr, true);
+  }
 
   // Initialize GUI interface
   UIContext* ctx = UIContext::instance();
@@ -195,7 +232,10 @@ void App::initialize(const AppOptions& options)
     ui::Manager::getDefault()->invalidate();
 
     // Create the main window and show it.
-    m_mainWindow.reset(new MainWindow);
+    {
+      StartupPhase phase("main window");
+      m_mainWindow.reset(new MainWindow);
+    }
 
     // Default status of the main window.
     app_rebuild_documents_tabs();
@@ -211,6 +251,15 @@ void App::initialize(const AppOptions& options)
     ui::Manager::getDefault()->invalidate();
   }
 
+  if (options.profileStartup()) {
+    // In GUI mode the report is printed after the tasks delayed
+    // until the main window is open (e.g. the scripts scan).
+    if (isGui())
+      TaskManager::instance().delayed([]{ std::cout << startup_report(); });
+    else
+      std::cout << startup_report();
+  }
+
   // Procress options
   LOG("Processing options...\n");
 
@@ -508,6 +557,28 @@ void App::initialize(const AppOptions& options)
           AppScripting engine;
           engine.evalFile(value.value());
         }
+        // --replay-strokes <filename>
+        else if (opt == &options.replayStrokes()) {
+          Document* doc = nullptr;
+          if (!ctx->documents().empty())
+            doc = dynamic_cast<Document*>(ctx->documents().lastAdded());
+
+          if (!doc) {
+            console.printf("A document is needed before --replay-strokes argument\n");
+          }
+          else {
+            ctx->setActiveDocument(doc);
+
+            ReplayStrokesStats stats =
+              replay_strokes(ctx,
+                             tools::load_recorded_pointers(value.value()),
+                             tools::WellKnownTools::Pencil);
+
+            std::cout << "strokes=" << stats.strokes
+                      << " total=" << (stats.total / 1000) << "ms"
+                      << " frames(us): " << stats.frames.summary() << "\n";
+          }
+        }
         // --list-layers
         else if (opt == &options.listLayers()) {
           listLayers = true;
@@ -21,6 +21,8 @@
 #include "app/console.h"
 #include "app/gui_xml.h"
 #include "app/resource_finder.h"
+#include "app/startup_profiler.h"
+#include "app/task_manager.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/app_menuitem.h"
 #include "app/ui/keyboard_shortcuts.h"
@@ -73,7 +75,18 @@ void AppMenus::reload()
 
   LOG("Main menu loaded.\n");
 
-  rebuildScriptsList();
+  // Scanning the scripts folder can be slow, so in the first load
+  // (at startup) it's done when the main window is already visible.
+  if (m_loaded) {
+    rebuildScriptsList();
+  }
+  else {
+    TaskManager::instance().delayed([this]{
+      StartupPhase phase("scripts scan");
+      rebuildScriptsList();
+    });
+    m_loaded = true;
+  }
 
   ////////////////////////////////////////
   // Load keyboard shortcuts for commands
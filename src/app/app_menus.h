@@ -71,6 +71,7 @@ namespace app {
     RecentFilesMenu m_recentFilesMenu;
     ScriptMenu m_scriptMenu;
     std::unordered_map<std::string, Widget*> m_identifiedWidgets;
+    bool m_loaded = false;
   };
 
 } // namespace app
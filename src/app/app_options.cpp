@@ -51,10 +51,12 @@ AppOptions::AppOptions(int argc, const char* argv[])
   , m_crop(m_po.add("crop").requiresValue("x,y,width,height").description("Crop all the images to the given rectangle"))
   , m_filenameFormat(m_po.add("filename-format").requiresValue("<fmt>").description("Special format to generate filenames"))
   , m_script(m_po.add("script").requiresValue("<filename>").description("Execute a specific script"))
+  , m_replayStrokes(m_po.add("replay-strokes").requiresValue("<filename>").description("Draw the recorded strokes with the pencil in\nthe last given document and report the time\nspent in each pointer event"))
   , m_listLayers(m_po.add("list-layers").description("List layers of the next given sprite\nor include layers in JSON data"))
   , m_listTags(m_po.add("list-tags").description("List tags of the next given sprite sprite\nor include frame tags in JSON data"))
   , m_verbose(m_po.add("verbose").mnemonic('v').description("Explain what is being done"))
   , m_debug(m_po.add("debug").description("Extreme verbose mode and\ncopy log to desktop"))
+  , m_profileStartup(m_po.add("profile-startup").description("Print the time spent in each phase\nof the program startup"))
   , m_help(m_po.add("help").mnemonic('?').description("Display this help and exits"))
   , m_version(m_po.add("version").description("Output version information and exit"))
 {
@@ -89,6 +91,11 @@ AppOptions::AppOptions(int argc, const char* argv[])
   }
 }
 
+bool AppOptions::profileStartup() const
+{
+  return m_po.enabled(m_profileStartup);
+}
+
 bool AppOptions::hasExporterParams() const
 {
   return
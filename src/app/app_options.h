@@ -63,10 +63,12 @@ public:
   const Option& crop() const { return m_crop; }
   const Option& filenameFormat() const { return m_filenameFormat; }
   const Option& script() const { return m_script; }
+  const Option& replayStrokes() const { return m_replayStrokes; }
   const Option& listLayers() const { return m_listLayers; }
   const Option& listTags() const { return m_listTags; }
 
   bool hasExporterParams() const;
+  bool profileStartup() const;
 
 private:
   void showHelp();
@@ -105,11 +107,13 @@ private:
   Option& m_crop;
   Option& m_filenameFormat;
   Option& m_script;
+  Option& m_replayStrokes;
   Option& m_listLayers;
   Option& m_listTags;
 
   Option& m_verbose;
   Option& m_debug;
+  Option& m_profileStartup;
   Option& m_help;
   Option& m_version;
 
@@ -14,6 +14,7 @@
 #include "doc/image.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace app {
 namespace cmd {
@@ -27,6 +28,8 @@ CopyRegion::CopyRegion(Image* dst, const Image* src,
   , m_alreadyCopied(alreadyCopied)
 {
   // Create region to save/swap later
+  std::vector<gfx::Rect> rects;
+  rects.reserve(region.size());
   for (const auto& rc : region) {
     gfx::Clip clip(
       rc.x+dstPos.x, rc.y+dstPos.y,
@@ -36,8 +39,9 @@ CopyRegion::CopyRegion(Image* dst, const Image* src,
           src->width(), src->height()))
       continue;
 
-    m_region.createUnion(m_region, gfx::Region(clip.dstBounds()));
+    rects.push_back(clip.dstBounds());
   }
+  m_region = gfx::Region(rects);
 
   // Save region pixels
   for (const auto& rc : m_region) {
@@ -0,0 +1,39 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/cmd/set_cel_copy_on_write.h"
+
+#include "doc/cel.h"
+
+namespace app {
+namespace cmd {
+
+using namespace doc;
+
+SetCelCopyOnWrite::SetCelCopyOnWrite(std::shared_ptr<Cel> cel, bool state)
+  : WithCel(cel)
+  , m_oldState(cel->data()->isCopyOnWrite())
+  , m_newState(state)
+{
+}
+
+void SetCelCopyOnWrite::onExecute()
+{
+  cel()->data()->setCopyOnWrite(m_newState);
+}
+
+void SetCelCopyOnWrite::onUndo()
+{
+  cel()->data()->setCopyOnWrite(m_oldState);
+}
+
+} // namespace cmd
+} // namespace app
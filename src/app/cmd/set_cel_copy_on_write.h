@@ -0,0 +1,37 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "app/cmd.h"
+#include "app/cmd/with_cel.h"
+
+namespace app {
+namespace cmd {
+  using namespace doc;
+
+  // Changes the copy-on-write flag of the CelData of the given cel
+  // (see doc::CelData::setCopyOnWrite()).
+  class SetCelCopyOnWrite : public Cmd
+                          , public WithCel {
+  public:
+    SetCelCopyOnWrite(std::shared_ptr<Cel> cel, bool state);
+
+  protected:
+    void onExecute() override;
+    void onUndo() override;
+    size_t onMemSize() const override {
+      return sizeof(*this);
+    }
+
+  private:
+    bool m_oldState;
+    bool m_newState;
+  };
+
+} // namespace cmd
+} // namespace app
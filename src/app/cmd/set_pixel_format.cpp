@@ -16,16 +16,20 @@
 #include "app/cmd/set_cel_opacity.h"
 #include "app/cmd/set_palette.h"
 #include "app/document.h"
+#include "base/parallel_for.h"
 #include "doc/cel.h"
 #include "doc/cels_range.h"
 #include "doc/document.h"
 #include "doc/document_event.h"
 #include "doc/layer.h"
 #include "doc/palette.h"
+#include "doc/rgbmap.h"
 #include "doc/sprite.h"
 #include "render/quantization.h"
 
+#include <map>
 #include <memory>
+#include <vector>
 
 namespace app {
 namespace cmd {
@@ -42,19 +46,45 @@ SetPixelFormat::SetPixelFormat(Sprite* sprite,
   if (sprite->pixelFormat() == newFormat)
     return;
 
-  for (auto cel : sprite->uniqueCels()) {
-    ImageRef old_image = cel->imageRef();
-    ImageRef new_image(
-      render::convert_pixel_format
-      (old_image.get(), NULL, newFormat, m_dithering,
-       sprite->rgbMap(cel->frame()),
-       sprite->palette(cel->frame()),
-       cel->layer()->isBackground(),
-       old_image->maskColor()));
-
-    m_seq.add(new cmd::ReplaceImage(sprite, old_image, new_image));
+  CelList cels;
+  for (auto cel : sprite->uniqueCels())
+    cels.push_back(cel);
+
+  // One RgbMap for each palette (the sprite RgbMap is regenerated for
+  // the palette of each frame, so it cannot be used from several
+  // threads). RgbMap::mapColor() can be used from several threads.
+  const int maskIndex = (sprite->backgroundLayer() ? -1: sprite->transparentColor());
+  std::map<const Palette*, std::unique_ptr<RgbMap>> rgbmaps;
+  for (auto& cel : cels) {
+    const Palette* palette = sprite->palette(cel->frame());
+    auto& rgbmap = rgbmaps[palette];
+    if (!rgbmap) {
+      rgbmap.reset(new RgbMap);
+      rgbmap->regenerate(palette, maskIndex);
+    }
   }
 
+  // Convert all images in parallel
+  std::vector<ImageRef> new_images(cels.size());
+  base::parallel_for(
+    0, int(cels.size()), 1,
+    [&](int i, int) {
+      const Cel* cel = cels[i].get();
+      const Palette* palette = sprite->palette(cel->frame());
+      const Image* old_image = cel->image();
+
+      new_images[i].reset(
+        render::convert_pixel_format
+        (old_image, NULL, newFormat, m_dithering,
+         rgbmaps.find(palette)->second.get(),
+         palette,
+         cel->layer()->isBackground(),
+         old_image->maskColor()));
+    });
+
+  for (std::size_t i=0; i<cels.size(); ++i)
+    m_seq.add(new cmd::ReplaceImage(sprite, cels[i]->imageRef(), new_images[i]));
+
   // Set all cels opacity to 100% if we are converting to indexed.
   // TODO remove this
   if (newFormat == IMAGE_INDEXED) {
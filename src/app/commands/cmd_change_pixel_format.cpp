@@ -56,6 +56,12 @@ void ChangePixelFormatCommand::onLoadParams(const Params& params)
   std::string dithering = params.get("dithering");
   if (dithering == "ordered")
     m_dithering = DitheringMethod::ORDERED;
+  else if (dithering == "floyd-steinberg")
+    m_dithering = DitheringMethod::FLOYD_STEINBERG;
+  else if (dithering == "jarvis-judice-ninke")
+    m_dithering = DitheringMethod::JARVIS_JUDICE_NINKE;
+  else if (dithering == "atkinson")
+    m_dithering = DitheringMethod::ATKINSON;
   else
     m_dithering = DitheringMethod::NONE;
 }
@@ -68,7 +74,7 @@ bool ChangePixelFormatCommand::onEnabled(Context* context)
   if (sprite != NULL &&
       sprite->pixelFormat() == IMAGE_INDEXED &&
       m_format == IMAGE_INDEXED &&
-      m_dithering == DitheringMethod::ORDERED)
+      m_dithering != DitheringMethod::NONE)
     return false;
 
   return sprite != NULL;
@@ -82,7 +88,7 @@ bool ChangePixelFormatCommand::onChecked(Context* context)
   if (sprite != NULL &&
       sprite->pixelFormat() == IMAGE_INDEXED &&
       m_format == IMAGE_INDEXED &&
-      m_dithering == DitheringMethod::ORDERED)
+      m_dithering != DitheringMethod::NONE)
     return false;
 
   return
@@ -0,0 +1,93 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/cmd/set_cel_copy_on_write.h"
+#include "app/cmd/set_cel_data.h"
+#include "app/commands/command.h"
+#include "app/context_access.h"
+#include "app/modules/gui.h"
+#include "app/transaction.h"
+#include "app/ui/status_bar.h"
+#include "doc/algorithm/identical_cels.h"
+#include "doc/cel.h"
+#include "doc/layer.h"
+#include "doc/sprite.h"
+
+namespace app {
+
+class LinkIdenticalCelsCommand : public Command {
+public:
+  LinkIdenticalCelsCommand();
+  Command* clone() const override { return new LinkIdenticalCelsCommand(*this); }
+
+protected:
+  bool onEnabled(Context* context) override;
+  void onExecute(Context* context) override;
+};
+
+LinkIdenticalCelsCommand::LinkIdenticalCelsCommand()
+  : Command("LinkIdenticalCels",
+            "Link Identical Cels",
+            CmdRecordableFlag)
+{
+}
+
+bool LinkIdenticalCelsCommand::onEnabled(Context* context)
+{
+  return context->checkFlags(ContextFlags::ActiveDocumentIsWritable |
+                             ContextFlags::HasActiveSprite);
+}
+
+void LinkIdenticalCelsCommand::onExecute(Context* context)
+{
+  ContextWriter writer(context);
+  Document* document(writer.document());
+  bool nonEditableLayers = false;
+  int linked = 0;
+  {
+    Transaction transaction(writer.context(), friendlyName());
+
+    for (auto& item : doc::algorithm::find_identical_cels(writer.sprite())) {
+      if (!item.first->layer()->isEditable()) {
+        nonEditableLayers = true;
+        continue;
+      }
+
+      // The cels share the data only to save memory, a cel is
+      // unlinked when it's modified
+      if (!item.second->data()->isCopyOnWrite())
+        transaction.execute(new cmd::SetCelCopyOnWrite(item.second, true));
+
+      transaction.execute(new cmd::SetCelData(item.first, item.second->dataRef()));
+      ++linked;
+    }
+
+    transaction.commit();
+  }
+
+  if (context->isUIAvailable()) {
+    if (nonEditableLayers)
+      StatusBar::instance()->showTip(1000,
+        "There are locked layers");
+    else
+      StatusBar::instance()->showTip(1000,
+        "%d cel(s) linked", linked);
+  }
+
+  update_screen_for_document(document);
+}
+
+Command* CommandFactory::createLinkIdenticalCelsCommand()
+{
+  return new LinkIdenticalCelsCommand;
+}
+
+} // namespace app
@@ -19,6 +19,7 @@
 #include "app/job.h"
 #include "app/modules/editors.h"
 #include "app/modules/gui.h"
+#include "app/pref/preferences.h"
 #include "app/recent_files.h"
 #include "app/ui/status_bar.h"
 #include "app/ui_context.h"
@@ -119,9 +120,13 @@ void OpenFileCommand::onExecute(Context* context)
   }
 
   if (!m_filename.empty()) {
+    int flags = FILE_LOAD_SEQUENCE_ASK;
+    if (Preferences::instance().general.linkIdenticalCels())
+      flags |= FILE_LOAD_LINK_IDENTICAL_CELS;
+
     std::unique_ptr<FileOp> fop(
       FileOp::createLoadDocumentOperation(
-        context, m_filename.c_str(), FILE_LOAD_SEQUENCE_ASK));
+        context, m_filename.c_str(), flags));
     bool unrecent = false;
 
     if (fop) {
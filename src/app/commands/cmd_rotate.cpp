@@ -26,6 +26,7 @@
 #include "app/ui/toolbar.h"
 #include "app/util/range_utils.h"
 #include "base/convert_to.h"
+#include "base/parallel_for.h"
 #include "doc/cel.h"
 #include "doc/cels_range.h"
 #include "doc/image.h"
@@ -33,6 +34,10 @@
 #include "doc/sprite.h"
 #include "ui/ui.h"
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 namespace app {
 
 class RotateJob : public Job {
@@ -89,26 +94,44 @@ protected:
       }
     }
 
-    // 2) Rotate images
-    int i = 0;
-    for (auto cel : m_cels) {
-      Image* image = cel->image();
-      if (image) {
-        ImageRef new_image(Image::create(image->pixelFormat(),
-            m_angle == 180 ? image->width(): image->height(),
-            m_angle == 180 ? image->height(): image->width()));
-        new_image->setMaskColor(image->maskColor());
-
-        doc::rotate_image(image, new_image.get(), m_angle);
-        api.replaceImage(m_sprite, cel->imageRef(), new_image);
-      }
+    // 2) Rotate images in parallel (cels don't depend on each other),
+    // and then replace them in the same order as the cels.
+    std::vector<ImageRef> new_images(m_cels.size());
+    std::mutex progress_mutex;
+    std::atomic<bool> canceled(false);
+    int progress = 0;
+
+    base::parallel_for(
+      0, int(m_cels.size()), 1,
+      [&](int i, int) {
+        if (canceled)
+          return;
+
+        Image* image = m_cels[i]->image();
+        if (image) {
+          ImageRef new_image(Image::create(image->pixelFormat(),
+              m_angle == 180 ? image->width(): image->height(),
+              m_angle == 180 ? image->height(): image->width()));
+          new_image->setMaskColor(image->maskColor());
+
+          doc::rotate_image(image, new_image.get(), m_angle);
+          new_images[i] = new_image;
+        }
+
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        jobProgress((float)++progress / m_cels.size());
+
+        // cancel all the operation?
+        if (isCanceled())
+          canceled = true;
+      });
 
-      jobProgress((float)i / m_cels.size());
-      ++i;
+    if (canceled)
+      return;        // Transaction destructor will undo all operations
 
-      // cancel all the operation?
-      if (isCanceled())
-        return;        // Transaction destructor will undo all operations
+    for (std::size_t i=0; i<m_cels.size(); ++i) {
+      if (new_images[i])
+        api.replaceImage(m_sprite, m_cels[i]->imageRef(), new_images[i]);
     }
 
     // rotate mask
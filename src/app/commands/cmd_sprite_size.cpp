@@ -21,19 +21,26 @@
 #include "app/modules/palettes.h"
 #include "app/transaction.h"
 #include "base/bind.h"
+#include "base/parallel_for.h"
 #include "doc/algorithm/resize_image.h"
 #include "doc/cel.h"
 #include "doc/cels_range.h"
 #include "doc/image.h"
 #include "doc/layer.h"
 #include "doc/mask.h"
+#include "doc/palette.h"
 #include "doc/primitives.h"
+#include "doc/rgbmap.h"
 #include "doc/sprite.h"
 #include "ui/ui.h"
 
 #include "sprite_size.xml.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #define PERC_FORMAT     "%.1f"
 
@@ -76,44 +83,77 @@ protected:
     Transaction transaction(m_writer.context(), "Sprite Size");
     DocumentApi api = m_writer.document()->getApi(transaction);
 
-    int cels_count = 0;
-    for (auto cel : m_sprite->uniqueCels()) { // TODO add size() member function to CelsRange
-      (void)cel;
-      ++cels_count;
-    }
+    CelList cels;
+    for (auto cel : m_sprite->uniqueCels())
+      cels.push_back(cel);
 
-    // For each cel...
+    // Resize the images of all cels in parallel (cels don't depend on
+    // each other). The new images are added to the transaction later,
+    // in the same order as the cels.
+    std::vector<ImageRef> new_images(cels.size());
+    std::mutex progress_mutex;
+    std::atomic<bool> canceled(false);
     int progress = 0;
-    for (auto cel : m_sprite->uniqueCels()) {
+
+    // The sprite RgbMap is regenerated for the palette of each frame,
+    // so it cannot be shared between threads. Each chunk of cels uses
+    // its own RgbMap instead (only the bilinear method uses it).
+    const int maskIndex = (m_sprite->backgroundLayer() ? -1: m_sprite->transparentColor());
+    const int grain = std::max<int>(1, cels.size() / (4*base::parallel_for_threads()));
+
+    base::parallel_for(
+      0, int(cels.size()), grain,
+      [&](int begin, int end) {
+        RgbMap rgbmap;
+
+        for (int i=begin; i<end && !canceled; ++i) {
+          Cel* cel = cels[i].get();
+
+          // Get cel's image
+          Image* image = cel->image();
+          if (image && !cel->link()) {
+            // Resize the image
+            int w = scale_x(image->width());
+            int h = scale_y(image->height());
+            ImageRef new_image(Image::create(image->pixelFormat(), MAX(1, w), MAX(1, h)));
+            new_image->setMaskColor(image->maskColor());
+
+            const Palette* palette = m_sprite->palette(cel->frame());
+            if (m_resize_method == doc::algorithm::RESIZE_METHOD_BILINEAR &&
+                (!rgbmap.match(palette) || rgbmap.maskIndex() != maskIndex))
+              rgbmap.regenerate(palette, maskIndex);
+
+            doc::algorithm::fixup_image_transparent_colors(image);
+            doc::algorithm::resize_image(
+              image, new_image.get(),
+              m_resize_method,
+              palette,
+              &rgbmap,
+              (cel->layer()->isBackground() ? -1: m_sprite->transparentColor()));
+
+            new_images[i] = new_image;
+          }
+
+          std::lock_guard<std::mutex> lock(progress_mutex);
+          jobProgress((float)++progress / cels.size());
+
+          // cancel all the operation?
+          if (isCanceled())
+            canceled = true;
+        }
+      });
+
+    if (canceled)
+      return;        // Transaction destructor will undo all operations
+
+    for (std::size_t i=0; i<cels.size(); ++i) {
+      auto& cel = cels[i];
+
       // Change its location
       api.setCelPosition(m_sprite, cel, scale_x(cel->x()), scale_y(cel->y()));
 
-      // Get cel's image
-      Image* image = cel->image();
-      if (image && !cel->link()) {
-        // Resize the image
-        int w = scale_x(image->width());
-        int h = scale_y(image->height());
-        ImageRef new_image(Image::create(image->pixelFormat(), MAX(1, w), MAX(1, h)));
-        new_image->setMaskColor(image->maskColor());
-
-        doc::algorithm::fixup_image_transparent_colors(image);
-        doc::algorithm::resize_image(
-          image, new_image.get(),
-          m_resize_method,
-          m_sprite->palette(cel->frame()),
-          m_sprite->rgbMap(cel->frame()),
-          (cel->layer()->isBackground() ? -1: m_sprite->transparentColor()));
-
-        api.replaceImage(m_sprite, cel->imageRef(), new_image);
-      }
-
-      jobProgress((float)progress / cels_count);
-      ++progress;
-
-      // cancel all the operation?
-      if (isCanceled())
-        return;        // Transaction destructor will undo all operations
+      if (new_images[i])
+        api.replaceImage(m_sprite, cel->imageRef(), new_images[i]);
     }
 
     // Resize mask
@@ -70,6 +70,7 @@ FOR_EACH_COMMAND(LayerFromBackground)
 FOR_EACH_COMMAND(LayerProperties)
 FOR_EACH_COMMAND(LayerVisibility)
 FOR_EACH_COMMAND(LinkCels)
+FOR_EACH_COMMAND(LinkIdenticalCels)
 FOR_EACH_COMMAND(LoadMask)
 FOR_EACH_COMMAND(LoadPalette)
 FOR_EACH_COMMAND(MaskAll)
@@ -190,6 +190,13 @@ void FilterManagerImpl::apply(Transaction& transaction)
     gfx::Rect output;
     if (algorithm::shrink_bounds2(m_src.get(), m_dst.get(),
                                   m_bounds, output)) {
+      // Identical cels that share the image to save memory keep
+      // their pixels when the filter is applied only in this frame
+      // (with all frames, all of them are modified in the same way)
+      if ((m_target & TARGET_ALL_FRAMES) != TARGET_ALL_FRAMES &&
+          m_cel->isCopyOnWrite())
+        transaction.execute(new cmd::UnlinkCel(m_cel));
+
       // Patch "m_cel"
       transaction.execute(
         new cmd::PatchCel(
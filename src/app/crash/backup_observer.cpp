@@ -21,6 +21,8 @@
 #include "base/scoped_lock.h"
 #include "doc/context.h"
 
+#include <algorithm>
+
 namespace app {
 namespace crash {
 
@@ -60,6 +62,12 @@ void BackupObserver::onRemoveDocument(doc::Document* document)
     base::scoped_lock hold(m_mutex);
     base::remove_from_container(m_documents, static_cast<app::Document*>(document));
   }
+
+  // Wait if the background thread is saving this document
+  {
+    base::scoped_lock hold(m_saveMutex);
+  }
+
   m_session->removeDocument(static_cast<app::Document*>(document));
 }
 
@@ -78,13 +86,34 @@ void BackupObserver::backgroundThread()
   while (!m_done) {
     seconds++;
     if (seconds >= waitUntil) {
-      TRACE("DataRecovery: Start backup process for %d documents\n", m_documents.size());
+      // The list of documents is copied so m_mutex is not locked
+      // while the documents are compressed and written to disk
+      // (onAddDocument/onRemoveDocument are called from the UI
+      // thread).
+      std::vector<app::Document*> documents;
+      {
+        base::scoped_lock hold(m_mutex);
+        documents = m_documents;
+      }
+
+      TRACE("DataRecovery: Start backup process for %d documents\n", documents.size());
 
-      base::scoped_lock hold(m_mutex);
       base::Chrono chrono;
       bool somethingLocked = false;
 
-      for (app::Document* doc : m_documents) {
+      for (app::Document* doc : documents) {
+        // m_saveMutex is locked before unlocking m_mutex, so if the
+        // document is removed now, onRemoveDocument() waits until it
+        // is saved.
+        m_mutex.lock();
+        if (std::find(m_documents.begin(), m_documents.end(), doc) == m_documents.end()) {
+          m_mutex.unlock();
+          continue;
+        }
+        m_saveMutex.lock();
+        m_mutex.unlock();
+        base::scoped_unlock unlockSave(m_saveMutex);
+
         try {
           if (doc->needsBackup())
             m_session->saveDocumentChanges(doc);
@@ -40,7 +40,8 @@ namespace crash {
     void backgroundThread();
 
     Session* m_session;
-    base::mutex m_mutex;
+    base::mutex m_mutex;      // Protects m_documents
+    base::mutex m_saveMutex;  // Locked while a document is saved
     doc::Context* m_ctx;
     std::vector<app::Document*> m_documents;
     bool m_done;
@@ -18,6 +18,14 @@ namespace crash {
 
   const uint32_t MAGIC_NUMBER = 0x454E4946; // 'FINE' in ASCII
 
+  // A modified image can be saved as the tiles that changed from the
+  // last full copy of the image (its "base" version). These files
+  // start with DELTA_IMAGE where a full image has its ID (which is
+  // never zero), followed by the image ID, the base version, the
+  // mask color, and the list of tiles.
+  const uint32_t DELTA_IMAGE = 0;
+  const int DELTA_TILE_SIZE = 64;
+
   class ObjVersions {
   public:
     ObjVersions() {
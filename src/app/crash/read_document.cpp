@@ -32,6 +32,7 @@
 #include "doc/layer.h"
 #include "doc/palette.h"
 #include "doc/palette_io.h"
+#include "doc/primitives.h"
 #include "doc/sprite.h"
 #include "doc/string_io.h"
 #include "doc/subobjects_io.h"
@@ -141,26 +142,9 @@ private:
       if (!ver)
         continue;
 
-      TRACE(" - Restoring %s #%d v%d\n", prefix, id, ver);
-
-      std::string fn = prefix;
-      fn.push_back('-');
-      fn += base::convert_to<std::string>(id);
-      fn.push_back('.');
-      fn += base::convert_to<std::string>(ver);
-
-      std::ifstream s(FSTREAM_PATH(base::join_path(m_dir, fn)), std::ifstream::binary);
-      T obj = nullptr;
-      if (read32(s) == MAGIC_NUMBER)
-        obj = (this->*readMember)(s);
-
-      if (obj) {
-        TRACE(" - %s #%d v%d restored successfully\n", prefix, id, ver);
+      T obj = loadObjectVersion(prefix, id, ver, readMember);
+      if (obj)
         return obj;
-      }
-      else {
-        TRACE(" - %s #%d v%d was not restored\n", prefix, id, ver);
-      }
     }
 
     // Show error only if we've failed to load all versions
@@ -170,6 +154,31 @@ private:
     return nullptr;
   }
 
+  template<typename T>
+  T loadObjectVersion(const char* prefix, ObjectId id, ObjectVersion ver,
+                      T (Reader::*readMember)(std::ifstream&)) {
+    TRACE(" - Restoring %s #%d v%d\n", prefix, id, ver);
+
+    std::string fn = prefix;
+    fn.push_back('-');
+    fn += base::convert_to<std::string>(id);
+    fn.push_back('.');
+    fn += base::convert_to<std::string>(ver);
+
+    std::ifstream s(FSTREAM_PATH(base::join_path(m_dir, fn)), std::ifstream::binary);
+    T obj = nullptr;
+    if (read32(s) == MAGIC_NUMBER)
+      obj = (this->*readMember)(s);
+
+    if (obj) {
+      TRACE(" - %s #%d v%d restored successfully\n", prefix, id, ver);
+    }
+    else {
+      TRACE(" - %s #%d v%d was not restored\n", prefix, id, ver);
+    }
+    return obj;
+  }
+
   app::Document* readDocument(std::ifstream& s) {
     ObjectId sprId = read32(s);
     std::string filename = read_string(s);
@@ -319,7 +328,37 @@ private:
   }
 
   Image* readImage(std::ifstream& s) {
-    return read_image(s, false);
+    std::ifstream::pos_type pos = s.tellg();
+    if (read32(s) != DELTA_IMAGE) {
+      s.seekg(pos);
+      return read_image(s, false);
+    }
+
+    // Only the modified tiles were saved, the rest of the image is
+    // in its base version.
+    ObjectId id = read32(s);
+    ObjectVersion baseVer = read32(s);
+    color_t maskColor = read32(s);
+    int ntiles = read32(s);
+    if (!s)
+      return nullptr;
+
+    std::unique_ptr<Image> image(
+      loadObjectVersion<Image*>("img", id, baseVer, &Reader::readImage));
+    if (!image)
+      return nullptr;
+
+    for (int i=0; i<ntiles; ++i) {
+      int x = read16(s);
+      int y = read16(s);
+      std::unique_ptr<Image> tile(read_image(s, false));
+      if (!tile || tile->pixelFormat() != image->pixelFormat())
+        return nullptr;
+      copy_image(image.get(), tile.get(), x, y);
+    }
+
+    image->setMaskColor(maskColor);
+    return image.release();
   }
 
   std::shared_ptr<Palette> readPalette(std::ifstream& s) {
@@ -407,9 +446,15 @@ app::Document* read_document_with_raw_images(const std::string& dir,
     if (!s)
       continue;
 
+    // Image deltas are skipped (they contain only modified tiles)
     ImageRef img;
-    if (read32(s) == MAGIC_NUMBER)
-      img.reset(read_image(s, false));
+    if (read32(s) == MAGIC_NUMBER) {
+      std::ifstream::pos_type pos = s.tellg();
+      if (read32(s) != DELTA_IMAGE) {
+        s.seekg(pos);
+        img.reset(read_image(s, false));
+      }
+    }
 
     if (img) {
         lay->addCel(std::make_shared<Cel>(frame, img));
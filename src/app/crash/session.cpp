@@ -23,14 +23,24 @@
 #include "base/convert_to.h"
 #include "base/fs.h"
 #include "base/fstream_path.h"
+#include "base/latency_histogram.h"
 #include "base/path.h"
 #include "base/process.h"
 #include "base/split_string.h"
 #include "base/string.h"
 
+#include <memory>
+#include <mutex>
+
 namespace app {
 namespace crash {
 
+// Durations of Session::saveDocumentChanges() (it's called from the
+// backup thread)
+static std::mutex g_backupStatsMutex;
+static base::LatencyHistogram g_backupLockTime;
+static base::LatencyHistogram g_backupTotalTime;
+
 Session::Backup::Backup(const std::string& dir)
   : m_dir(dir)
 {
@@ -131,17 +141,32 @@ void Session::removeFromDisk()
 
 void Session::saveDocumentChanges(app::Document* doc)
 {
-  DocumentReader reader(doc, 250);
-  app::Context ctx;
+  const base::timestamp_t start = base::current_timestamp();
   std::string dir = base::join_path(m_path,
     base::convert_to<std::string>(doc->id()));
-  TRACE("DataRecovery: Saving document '%s'...\n", dir.c_str());
 
-  if (!base::is_directory(dir))
-    base::make_directory(dir);
+  // The document is locked only to copy the modified objects, they
+  // are compressed and saved on disk after unlocking it.
+  std::unique_ptr<DocumentChanges> changes;
+  {
+    DocumentReader reader(doc, 250);
+    changes.reset(new DocumentChanges(dir, doc));
+  }
+  const base::timestamp_t locked = base::current_timestamp() - start;
+
+  if (!changes->empty()) {
+    TRACE("DataRecovery: Saving document '%s'...\n", dir.c_str());
+
+    if (!base::is_directory(dir))
+      base::make_directory(dir);
 
-  // Save document information
-  write_document(dir, doc);
+    // Save document information
+    changes->write();
+  }
+
+  std::lock_guard<std::mutex> lock(g_backupStatsMutex);
+  g_backupLockTime.add(locked);
+  g_backupTotalTime.add(base::current_timestamp() - start);
 }
 
 void Session::removeDocument(app::Document* doc)
@@ -261,5 +286,13 @@ void Session::fixFilename(app::Document* doc)
       base::get_file_title(fn) + "-Recovered" + ext));
 }
 
+std::string backup_duration_report()
+{
+  std::lock_guard<std::mutex> lock(g_backupStatsMutex);
+  return
+    "locked: " + g_backupLockTime.summary() + "\n" +
+    "total: " + g_backupTotalTime.summary() + "\n";
+}
+
 } // namespace crash
 } // namespace app
@@ -72,5 +72,9 @@ namespace crash {
 
   typedef base::SharedPtr<Session> SessionPtr;
 
+  // Returns the percentiles of the time used to backup each document
+  // and how much of it the document was locked.
+  std::string backup_duration_report();
+
 } // namespace crash
 } // namespace app
@@ -27,14 +27,20 @@
 #include "doc/frame_tag.h"
 #include "doc/frame_tag_io.h"
 #include "doc/image_io.h"
+#include "doc/image_ref.h"
 #include "doc/layer.h"
 #include "doc/palette.h"
 #include "doc/palette_io.h"
+#include "doc/primitives.h"
 #include "doc/sprite.h"
 #include "doc/string_io.h"
+#include "gfx/rect.h"
 
+#include <cstring>
 #include <fstream>
 #include <map>
+#include <set>
+#include <sstream>
 
 namespace app {
 namespace crash {
@@ -43,16 +49,105 @@ using namespace base::serialization;
 using namespace base::serialization::little_endian;
 using namespace doc;
 
+struct DocumentChanges::Object {
+  std::string prefix;
+  ObjectId id;
+  ObjectVersion version;
+  std::string data;             // Serialized object (except images)
+  ImageRef image;               // Copy of the image
+};
+
 namespace {
 
+// zlib compression level for images. The backup is made while the
+// user is working, so we prefer speed over smaller files.
+const int kImageCompressionLevel = 1;
+
+// What we know about the last full copy of each image in the backup.
+struct ImageBackup {
+  ObjectVersion base = 0;
+  PixelFormat format = IMAGE_RGB;
+  int width = 0;
+  int height = 0;
+  // Hash of each tile of the base version
+  std::vector<uint64_t> hashes;
+  // Version of each file of the image on disk -> version of the full
+  // image needed to restore it (the same version for full images).
+  std::map<ObjectVersion, ObjectVersion> files;
+};
+
+typedef std::map<ObjectId, ImageBackup> ImageBackupsMap;
+
 static std::map<ObjectId, ObjVersionsMap> g_docVersions;
+static std::map<ObjectId, ImageBackupsMap> g_docImages;
+
+std::string object_filename(const std::string& dir, const std::string& prefix,
+                            ObjectId id, ObjectVersion version)
+{
+  std::string fn = prefix;
+  fn.push_back('-');
+  fn += base::convert_to<std::string>(id);
+  fn.push_back('.');
+  fn += base::convert_to<std::string>(version);
+  return base::join_path(dir, fn);
+}
+
+void delete_object_file(const std::string& fn)
+{
+  try {
+    if (base::is_file(fn))
+      base::delete_file(fn);
+  }
+  catch (const std::exception&) {
+    TRACE(" - Cannot delete %s\n", fn.c_str());
+  }
+}
+
+gfx::Rect tile_bounds(const Image* image, int tile)
+{
+  const int cols = (image->width()+DELTA_TILE_SIZE-1) / DELTA_TILE_SIZE;
+  gfx::Rect bounds((tile % cols) * DELTA_TILE_SIZE,
+                   (tile / cols) * DELTA_TILE_SIZE,
+                   DELTA_TILE_SIZE, DELTA_TILE_SIZE);
+  return bounds.createIntersection(image->bounds());
+}
+
+// FNV-1a of the pixels of each tile (8 bytes at a time).
+std::vector<uint64_t> hash_tiles(const Image* image)
+{
+  const int cols = (image->width()+DELTA_TILE_SIZE-1) / DELTA_TILE_SIZE;
+  const int rows = (image->height()+DELTA_TILE_SIZE-1) / DELTA_TILE_SIZE;
+  std::vector<uint64_t> hashes(cols*rows);
+
+  for (int tile=0; tile<int(hashes.size()); ++tile) {
+    const gfx::Rect bounds = tile_bounds(image, tile);
+    const int rowSize = image->getRowStrideSize(bounds.w);
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (int y=bounds.y; y<bounds.y2(); ++y) {
+      const uint8_t* p = image->getPixelAddress(bounds.x, y);
+      int n = rowSize;
+      for (; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+      }
+      for (; n > 0; --n, ++p)
+        hash = (hash ^ *p) * 0x100000001b3ull;
+    }
+    hashes[tile] = hash;
+  }
+  return hashes;
+}
 
 class Writer {
 public:
-  Writer(const std::string& dir, app::Document* doc)
+  Writer(const std::string& dir, app::Document* doc,
+         std::vector<std::unique_ptr<DocumentChanges::Object>>& objects)
     : m_dir(dir)
     , m_doc(doc)
-    , m_objVersions(g_docVersions[doc->id()]) {
+    , m_objVersions(g_docVersions[doc->id()])
+    , m_objects(objects) {
   }
 
   void saveDocument() {
@@ -68,7 +163,7 @@ public:
       saveObject("frtag", frtag, &Writer::writeFrameTag);
 
     for (auto cel : spr->uniqueCels()) {
-      saveObject("img", cel->image(), &Writer::writeImage);
+      saveImage(cel->image());
       saveObject("celdata", cel->data(), &Writer::writeCelData);
     }
 
@@ -86,12 +181,12 @@ public:
 
 private:
 
-  void writeDocumentFile(std::ofstream& s, app::Document* doc) {
+  void writeDocumentFile(std::ostream& s, app::Document* doc) {
     write32(s, doc->sprite()->id());
     write_string(s, doc->filename());
   }
 
-  void writeSprite(std::ofstream& s, Sprite* spr) {
+  void writeSprite(std::ostream& s, Sprite* spr) {
     write8(s, spr->pixelFormat());
     write16(s, spr->width());
     write16(s, spr->height());
@@ -120,7 +215,7 @@ private:
       write32(s, frtag->id());
   }
 
-  void writeLayerStructure(std::ofstream& s, Layer* lay) {
+  void writeLayerStructure(std::ostream& s, Layer* lay) {
     write32(s, static_cast<int>(lay->flags())); // Flags
     write16(s, static_cast<int>(lay->type()));  // Type
     write_string(s, lay->name());
@@ -137,46 +232,130 @@ private:
     }
   }
 
-  void writeCel(std::ofstream& s, Cel* cel) {
+  void writeCel(std::ostream& s, Cel* cel) {
     write_cel(s, cel);
   }
 
-  void writeCelData(std::ofstream& s, CelData* celdata) {
+  void writeCelData(std::ostream& s, CelData* celdata) {
     write_celdata(s, celdata);
   }
 
-  void writeImage(std::ofstream& s, Image* img) {
-    write_image(s, img);
-  }
-
-  void writePalette(std::ofstream& s, Palette* pal) {
+  void writePalette(std::ostream& s, Palette* pal) {
     write_palette(s, *pal);
   }
 
-  void writeFrameTag(std::ofstream& s, FrameTag* frameTag) {
+  void writeFrameTag(std::ostream& s, FrameTag* frameTag) {
     write_frame_tag(s, frameTag);
   }
 
   template<typename T>
-  void saveObject(const char* prefix, T* obj, void (Writer::*writeMember)(std::ofstream&, T*)) {
+  DocumentChanges::Object* addObject(const char* prefix, T* obj) {
     if (!obj->version())
       obj->incrementVersion();
 
     ObjVersions& versions = m_objVersions[obj->id()];
     if (versions.newer() == obj->version())
-      return;
+      return nullptr;
+
+    auto change = new DocumentChanges::Object;
+    change->prefix = prefix;
+    change->id = obj->id();
+    change->version = obj->version();
+    m_objects.emplace_back(change);
+    return change;
+  }
+
+  template<typename T>
+  void saveObject(const char* prefix, T* obj, void (Writer::*writeMember)(std::ostream&, T*)) {
+    if (auto change = addObject(prefix, obj)) {
+      std::ostringstream s(std::ios::binary);
+      (this->*writeMember)(s, obj); // Write the object
+      change->data = s.str();
+    }
+  }
+
+  // Images are compressed later, in DocumentChanges::write(), we
+  // just copy their pixels here.
+  void saveImage(Image* image) {
+    if (auto change = addObject("img", image))
+      change->image.reset(Image::createCopy(image));
+  }
+
+  std::string m_dir;
+  app::Document* m_doc;
+  ObjVersionsMap& m_objVersions;
+  std::vector<std::unique_ptr<DocumentChanges::Object>>& m_objects;
+};
 
-    std::string fn = prefix;
-    fn.push_back('-');
-    fn += base::convert_to<std::string>(obj->id());
+} // anonymous namespace
 
-    std::string fullfn = base::join_path(m_dir, fn);
-    std::string oldfn = fullfn + "." + base::convert_to<std::string>(versions.older());
-    fullfn += "." + base::convert_to<std::string>(obj->version());
+//////////////////////////////////////////////////////////////////////
+// DocumentChanges
 
-    std::ofstream s(FSTREAM_PATH(fullfn), std::ofstream::binary);
+DocumentChanges::DocumentChanges(const std::string& dir, app::Document* doc)
+  : m_dir(dir)
+  , m_docId(doc->id())
+{
+  Writer writer(dir, doc, m_objects);
+  writer.saveDocument();
+}
+
+DocumentChanges::~DocumentChanges()
+{
+}
+
+void DocumentChanges::write()
+{
+  ObjVersionsMap& objVersions = g_docVersions[m_docId];
+  ImageBackupsMap& images = g_docImages[m_docId];
+
+  for (const auto& obj : m_objects) {
+    ObjVersions& versions = objVersions[obj->id];
+    std::string fn = object_filename(m_dir, obj->prefix, obj->id, obj->version);
+    std::ofstream s(FSTREAM_PATH(fn), std::ofstream::binary);
     write32(s, 0);                // Leave a room for the magic number
-    (this->*writeMember)(s, obj); // Write the object
+
+    std::vector<int> tiles;
+    std::vector<uint64_t> hashes;
+    if (obj->image) {
+      const Image* image = obj->image.get();
+      const ImageBackup& backup = images[obj->id];
+      hashes = hash_tiles(image);
+
+      if (backup.base &&
+          backup.format == image->pixelFormat() &&
+          backup.width == image->width() &&
+          backup.height == image->height()) {
+        for (int i=0; i<int(hashes.size()); ++i)
+          if (hashes[i] != backup.hashes[i])
+            tiles.push_back(i);
+
+        // Save a new full copy when the delta would be too big
+        if (tiles.size() > hashes.size()/2)
+          tiles.clear();
+        else {
+          write32(s, DELTA_IMAGE);
+          write32(s, obj->id);
+          write32(s, backup.base);
+          write32(s, image->maskColor());
+          write32(s, tiles.size());
+          for (int tile : tiles) {
+            const gfx::Rect bounds = tile_bounds(image, tile);
+            std::unique_ptr<Image> tileImage(crop_image(image, bounds, 0));
+            write16(s, bounds.x);
+            write16(s, bounds.y);
+            write_image(s, tileImage.get(), kImageCompressionLevel);
+          }
+          hashes.clear();
+        }
+      }
+
+      // The hashes are discarded if a delta was saved
+      if (!hashes.empty())
+        write_image(s, image, kImageCompressionLevel);
+    }
+    else
+      s.write(obj->data.c_str(), obj->data.size());
 
     // Flush all data. In this way we ensure that the magic number is
     // the last thing being written in the file.
@@ -185,36 +364,61 @@ private:
     // Write the magic number
     s.seekp(0);
     write32(s, MAGIC_NUMBER);
+    s.close();
 
-    // Remove the older version
-    try {
-      if (versions.older() && base::is_file(oldfn))
-        base::delete_file(oldfn);
-    }
-    catch (const std::exception&) {
-      TRACE(" - Cannot delete %s #%d v%d\n", prefix, obj->id(), versions.older());
-    }
+    const ObjectVersion older = versions.older();
 
     // Rotate versions and add the latest one
-    versions.rotateRevisions(obj->version());
+    versions.rotateRevisions(obj->version);
+
+    if (obj->image) {
+      ImageBackup& backup = images[obj->id];
+      if (!hashes.empty()) {
+        backup.base = obj->version;
+        backup.format = obj->image->pixelFormat();
+        backup.width = obj->image->width();
+        backup.height = obj->image->height();
+        backup.hashes = std::move(hashes);
+      }
+      backup.files[obj->version] = backup.base;
+
+      // Remove the files that aren't needed to restore the last
+      // versions (the older version could be the base of them).
+      std::set<ObjectVersion> needed;
+      for (size_t i=0; i<versions.size(); ++i) {
+        auto it = backup.files.find(versions[i]);
+        if (it != backup.files.end()) {
+          needed.insert(it->first);
+          needed.insert(it->second);
+        }
+      }
+      for (auto it=backup.files.begin(); it!=backup.files.end(); ) {
+        if (needed.find(it->first) == needed.end()) {
+          delete_object_file(object_filename(m_dir, obj->prefix, obj->id, it->first));
+          it = backup.files.erase(it);
+        }
+        else
+          ++it;
+      }
+      TRACE(" - Saved %s #%d v%d (%d tiles)\n", obj->prefix.c_str(), obj->id, obj->version,
+            int(backup.base == obj->version ? backup.hashes.size(): tiles.size()));
+    }
+    else {
+      // Remove the older version
+      if (older)
+        delete_object_file(object_filename(m_dir, obj->prefix, obj->id, older));
 
-    TRACE(" - Saved %s #%d v%d\n", prefix, obj->id(), obj->version());
+      TRACE(" - Saved %s #%d v%d\n", obj->prefix.c_str(), obj->id, obj->version);
+    }
   }
-
-  std::string m_dir;
-  app::Document* m_doc;
-  ObjVersionsMap& m_objVersions;
-};
-
-} // anonymous namespace
+}
 
 //////////////////////////////////////////////////////////////////////
 // Public API
 
 void write_document(const std::string& dir, app::Document* doc)
 {
-  Writer writer(dir, doc);
-  writer.saveDocument();
+  DocumentChanges(dir, doc).write();
 }
 
 void delete_document_internals(app::Document* doc)
@@ -226,6 +430,10 @@ void delete_document_internals(app::Document* doc)
   // never saved by the backup process.
   if (it != g_docVersions.end())
     g_docVersions.erase(it);
+
+  auto it2 = g_docImages.find(doc->id());
+  if (it2 != g_docImages.end())
+    g_docImages.erase(it2);
 }
 
 } // namespace crash
@@ -7,12 +7,44 @@
 
 #pragma once
 
+#include "base/disable_copying.h"
+#include "doc/object.h"
+
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace app {
 class Document;
 namespace crash {
 
+  // Objects of a document modified since its last backup.
+  //
+  // The constructor copies the modified objects, so the document must
+  // be locked only while it's called (copying images is much faster
+  // than compressing them). Then write() saves the copies in the
+  // backup directory without the document lock. Modified images are
+  // saved as the list of tiles that changed from the last full copy
+  // of the image in the backup.
+  class DocumentChanges {
+  public:
+    struct Object;
+
+    DocumentChanges(const std::string& dir, app::Document* doc);
+    ~DocumentChanges();
+
+    bool empty() const { return m_objects.empty(); }
+
+    void write();
+
+  private:
+    std::string m_dir;
+    doc::ObjectId m_docId;
+    std::vector<std::unique_ptr<Object>> m_objects;
+
+    DISABLE_COPYING(DocumentChanges);
+  };
+
   void write_document(const std::string& dir, app::Document* doc);
   void delete_document_internals(app::Document* doc);
 
@@ -21,8 +21,6 @@
 #include "app/pref/preferences.h"
 #include "app/util/create_cel_copy.h"
 #include "base/memory.h"
-#include "base/scoped_lock.h"
-#include "base/thread.h"
 #include "doc/cel.h"
 #include "doc/context.h"
 #include "doc/document_event.h"
@@ -44,8 +42,6 @@ using namespace doc;
 Document::Document(Sprite* sprite)
   : m_undo(new DocumentUndo)
   , m_associated_to_file(false)
-  , m_write_lock(false)
-  , m_read_locks(0)
     // Information about the file format used to load/save this document
   , m_format_options(NULL)
   // Mask
@@ -199,12 +195,12 @@ void Document::setFormatOptions(const base::SharedPtr<FormatOptions>& format_opt
 
 void Document::generateMaskBoundaries(const Mask* mask)
 {
-  m_maskBoundaries.reset();
-
   // No mask specified? Use the current one in the document
   if (!mask) {
-    if (!isMaskVisible())       // The mask is hidden
+    if (!isMaskVisible()) {     // The mask is hidden
+      m_maskBoundaries.reset();
       return;                   // Done, without boundaries
+    }
     else
       mask = this->mask();      // Use the document mask
   }
@@ -212,10 +208,14 @@ void Document::generateMaskBoundaries(const Mask* mask)
   ASSERT(mask);
 
   if (!mask->isEmpty()) {
-    m_maskBoundaries.reset(new MaskBoundaries(mask->bitmap()));
-    m_maskBoundaries->offset(mask->bounds().x,
-                             mask->bounds().y);
+    // The same boundaries are regenerated, so only the parts of the
+    // mask that were modified are recalculated.
+    if (!m_maskBoundaries)
+      m_maskBoundaries.reset(new MaskBoundaries);
+    m_maskBoundaries->regenerate(mask);
   }
+  else
+    m_maskBoundaries.reset();
 
   // TODO move this to the exact place where selection is modified.
   notifySelectionChanged();
@@ -433,104 +433,36 @@ Document* Document::duplicate(DuplicateType type) const
 
 bool Document::lock(LockType lockType, int timeout)
 {
-  while (timeout >= 0) {
-    {
-      scoped_lock lock(m_mutex);
-      switch (lockType) {
-
-        case ReadLock:
-          // If no body is writting the sprite...
-          if (!m_write_lock) {
-            // We can read it
-            ++m_read_locks;
-            return true;
-          }
-          break;
-
-        case WriteLock:
-          // If no body is reading and writting...
-          if (m_read_locks == 0 && !m_write_lock) {
-            // We can start writting the sprite...
-            m_write_lock = true;
-            TRACE("Document::lock: Locked <%d> to write\n", id());
-            return true;
-          }
-          break;
-
-      }
-    }
-
-    if (timeout > 0) {
-      int delay = MIN(100, timeout);
-      timeout -= delay;
-
-      TRACE("Document::lock: wait 100 msecs for <%d>\n", id());
-      base::this_thread::sleep_for(double(delay) / 1000.0);
-    }
-    else
-      break;
+  if (m_rwLock.lock(static_cast<base::RWLock::LockType>(lockType), timeout)) {
+    if (lockType == WriteLock)
+      TRACE("Document::lock: Locked <%d> to write\n", id());
+    return true;
   }
 
-  TRACE("Document::lock: Cannot lock <%d> to %s (has %d read locks and %d write locks)\n",
-    id(), (lockType == ReadLock ? "read": "write"), m_read_locks, m_write_lock);
+  TRACE("Document::lock: Cannot lock <%d> to %s\n",
+    id(), (lockType == ReadLock ? "read": "write"));
   return false;
 }
 
 bool Document::lockToWrite(int timeout)
 {
-  while (timeout >= 0) {
-    {
-      scoped_lock lock(m_mutex);
-      // this only is possible if there are just one reader
-      if (m_read_locks == 1) {
-        ASSERT(!m_write_lock);
-        m_read_locks = 0;
-        m_write_lock = true;
-        TRACE("Document::lockToWrite: Locked <%d> to write\n", id());
-        return true;
-      }
-    }
-
-    if (timeout > 0) {
-      int delay = MIN(100, timeout);
-      timeout -= delay;
-
-      TRACE("Document::lockToWrite: wait 100 msecs for <%d>\n", id());
-      base::this_thread::sleep_for(double(delay) / 1000.0);
-    }
-    else
-      break;
+  if (m_rwLock.upgradeToWrite(timeout)) {
+    TRACE("Document::lockToWrite: Locked <%d> to write\n", id());
+    return true;
   }
 
-  TRACE("Document::lockToWrite: Cannot lock <%d> to write (has %d read locks and %d write locks)\n",
-    id(), m_read_locks, m_write_lock);
+  TRACE("Document::lockToWrite: Cannot lock <%d> to write\n", id());
   return false;
 }
 
 void Document::unlockToRead()
 {
-  scoped_lock lock(m_mutex);
-
-  ASSERT(m_read_locks == 0);
-  ASSERT(m_write_lock);
-
-  m_write_lock = false;
-  m_read_locks = 1;
+  m_rwLock.downgradeToRead();
 }
 
 void Document::unlock()
 {
-  scoped_lock lock(m_mutex);
-
-  if (m_write_lock) {
-    m_write_lock = false;
-  }
-  else if (m_read_locks > 0) {
-    --m_read_locks;
-  }
-  else {
-    ASSERT(false);
-  }
+  m_rwLock.unlock();
 }
 
 void Document::onContextChanged()
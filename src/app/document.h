@@ -11,8 +11,8 @@
 #include "app/file/format_options.h"
 #include "app/transformation.h"
 #include "base/disable_copying.h"
-#include "base/mutex.h"
 #include "base/observable.h"
+#include "base/rw_lock.h"
 #include "doc/blend_mode.h"
 #include "doc/color.h"
 #include "doc/document.h"
@@ -51,8 +51,8 @@ namespace app {
   class Document : public doc::Document {
   public:
     enum LockType {
-      ReadLock,
-      WriteLock
+      ReadLock = base::RWLock::ReadLock,
+      WriteLock = base::RWLock::WriteLock
     };
 
     Document(Sprite* sprite);
@@ -172,6 +172,10 @@ namespace app {
 
     void unlock();
 
+    // Counters of lock()/lockToWrite() calls (contention, wait time,
+    // and timeouts).
+    base::RWLock::Stats lockStats() const { return m_rwLock.stats(); }
+
   protected:
     virtual void onContextChanged() override;
 
@@ -185,14 +189,8 @@ namespace app {
     // Selected mask region boundaries
     std::unique_ptr<doc::MaskBoundaries> m_maskBoundaries;
 
-    // Mutex to modify the 'locked' flag.
-    base::mutex m_mutex;
-
-    // True if some thread is writing the sprite.
-    bool m_write_lock;
-
-    // Greater than zero when one or more threads are reading the sprite.
-    int m_read_locks;
+    // To read/write the sprite from several threads.
+    base::RWLock m_rwLock;
 
     // Data to save the file in the same format that it was loaded
     base::SharedPtr<FormatOptions> m_format_options;
@@ -1180,6 +1180,11 @@ static Cel* ase_file_read_cel_chunk(FILE* f, Sprite* sprite, frame_t frame,
     return NULL;
   }
 
+  // Hidden layers aren't rendered in thumbnails, so we can skip the
+  // decompression of their cels.
+  if (fop->isThumbnail() && !layer->isVisible())
+    return NULL;
+
   // Create the new frame.
   std::shared_ptr<Cel> cel;
 
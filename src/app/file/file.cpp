@@ -28,6 +28,7 @@
 #include "base/scoped_lock.h"
 #include "base/shared_ptr.h"
 #include "base/string.h"
+#include "doc/algorithm/identical_cels.h"
 #include "doc/doc.h"
 #include "render/quantization.h"
 #include "render/render.h"
@@ -186,6 +187,12 @@ FileOp* FileOp::createLoadDocumentOperation(Context* context, const char* filena
   if (fop->m_loadFlags & FILE_LOAD_ONE_FRAME)
     fop->m_oneframe = true;
 
+  // Thumbnails need just the first frame
+  if (fop->m_loadFlags & FILE_LOAD_THUMBNAIL) {
+    fop->m_oneframe = true;
+    fop->m_thumbnail = true;
+  }
+
   return fop.release();
 }
 
@@ -512,25 +519,9 @@ bool FileOp::operateLoadTryFormat(IFileOpProgress* progress)
         break;
       }
 
-      // Compare the old frame with the new one
-#if USE_LINK // TODO this should be configurable through a check-box
-      if (count_diff_between_images(old_image, m_seq.image)) {
-        add_image();
-      }
-      // We don't need this image
-      else {
-        delete m_seq.image;
-
-        // But add a link frame
-        m_seq.last_cel->image = image_index;
-        layer_add_frame(m_seq.layer, m_seq.last_cel);
-
-        m_seq.last_image = NULL;
-        m_seq.last_cel = NULL;
-      }
-#else
+      // Identical frames are linked after loading the whole
+      // sequence (FILE_LOAD_LINK_IDENTICAL_CELS)
       add_image();
-#endif
     }
 
     ++frame;
@@ -623,8 +614,14 @@ void FileOp::operate(IFileOpProgress* progress)
   m_progressInterface = progress;
 
   // Load //////////////////////////////////////////////////////////////////////
-  if (m_type == FileOpLoad)
+  if (m_type == FileOpLoad) {
     operateLoad(progress);
+
+    // Share one image between the cels with the same content
+    if ((m_loadFlags & FILE_LOAD_LINK_IDENTICAL_CELS) &&
+        m_document && m_document->sprite() && !isStop())
+      doc::algorithm::link_identical_cels(m_document->sprite());
+  }
   // Save //////////////////////////////////////////////////////////////////////
   else if (m_type == FileOpSave &&
            m_format != NULL &&
@@ -924,6 +921,8 @@ FileOp::FileOp(FileOpType type, Context* context)
   , m_done(false)
   , m_stop(false)
   , m_oneframe(false)
+  , m_thumbnail(false)
+  , m_thumbnailSize(0)
 {
   m_seq.palette = nullptr;
   m_seq.image.reset();
@@ -21,6 +21,8 @@
 #define FILE_LOAD_SEQUENCE_ASK          0x00000002
 #define FILE_LOAD_SEQUENCE_YES          0x00000004
 #define FILE_LOAD_ONE_FRAME             0x00000008
+#define FILE_LOAD_THUMBNAIL             0x00000010
+#define FILE_LOAD_LINK_IDENTICAL_CELS   0x00000020
 
 namespace doc {
   class Document;
@@ -67,6 +69,15 @@ namespace app {
     bool isSequence() const { return !m_seq.filename_list.empty(); }
     bool isOneFrame() const { return m_oneframe; }
 
+    // True if the document is loaded just to create a thumbnail
+    // (FILE_LOAD_THUMBNAIL). In this case only the first frame is
+    // loaded, and formats can skip anything that isn't visible and
+    // decode a smaller image (but not smaller than thumbnailSize() on
+    // its largest side).
+    bool isThumbnail() const { return m_thumbnail; }
+    int thumbnailSize() const { return m_thumbnailSize; }
+    void setThumbnailSize(int size) { m_thumbnailSize = size; }
+
     const std::string& filename() const { return m_filename; }
     Context* context() const { return m_context; }
     Document* document() const { return m_document; }
@@ -136,6 +147,10 @@ namespace app {
     bool m_oneframe;            // Load just one frame (in formats
                                 // that support animation like
                                 // GIF/FLI/ASE).
+    bool m_thumbnail;           // Load just what is needed to create
+                                // a thumbnail.
+    int m_thumbnailSize;        // Minimum size of the decoded image
+                                // when m_thumbnail is true.
 
     // Data for sequences.
     struct {
@@ -18,7 +18,6 @@
 #include "app/file/gif_options.h"
 #include "app/ini_file.h"
 #include "app/modules/gui.h"
-#include "app/util/autocrop.h"
 #include "base/file_handle.h"
 #include "base/fs.h"
 #include "doc/doc.h"
@@ -978,17 +977,9 @@ private:
   }
 
   static gfx::Rect calculateFrameBounds(Image* a, Image* b) {
-    gfx::Rect frameBounds;
-    int x1, y1, x2, y2;
-
-    if (get_shrink_rect2(&x1, &y1, &x2, &y2, a, b)) {
-      frameBounds.x = x1;
-      frameBounds.y = y1;
-      frameBounds.w = x2 - x1 + 1;
-      frameBounds.h = y2 - y1 + 1;
-    }
-
-    return frameBounds;
+    ImagesDiff diff(ImagesDiff::kBounds);
+    diff.compare(a, b);
+    return diff.bounds();
   }
 
   void calculateBestDisposalMethod(int frameNum,
@@ -24,6 +24,7 @@
 #include "doc/doc.h"
 #include "ui/ui.h"
 
+#include <algorithm>
 #include <csetjmp>
 #include <cstdio>
 #include <cstdlib>
@@ -128,6 +129,18 @@ bool JpegFormat::onLoad(FileOp* fop)
   else
     cinfo.out_color_space = JCS_RGB;
 
+  // Decode 1/2, 1/4 or 1/8 of the original size when we need just a
+  // thumbnail (libjpeg skips most of the IDCT work in this case).
+  if (fop->isThumbnail() && fop->thumbnailSize() > 0) {
+    int size = std::max(int(cinfo.image_width), int(cinfo.image_height));
+    int denom = 1;
+    while (denom < 8 && size / (denom*2) >= fop->thumbnailSize())
+      denom *= 2;
+
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = denom;
+  }
+
   // Start decompressor.
   jpeg_start_decompress(&cinfo);
 
@@ -191,10 +191,10 @@ bool PixlyFormat::onLoad(FileOp* fop)
           auto prev_cel = static_cast<LayerImage*>(layer)->cel(frame-1);
           if (prev_cel && prev_cel->x() == bounds.x && prev_cel->y() == bounds.y) {
             Image *prev_image = prev_cel->image();
-            if (prev_image && doc::count_diff_between_images(prev_image, trim_image.get()) == 0) {
+            if (prev_image && doc::is_same_image(prev_image, trim_image.get())) {
               cel = Cel::createLink(prev_cel);
               cel->setFrame(frame);
-            } // count_diff_between_images
+            } // is_same_image
           } // prev_cel
         } // frame > 0
 
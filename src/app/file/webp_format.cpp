@@ -113,12 +113,28 @@ bool WebPFormat::onLoad(FileOp* fop)
 
   fop->sequenceSetHasAlpha(config.input.has_alpha != 0);
 
-  Image* image = fop->sequenceImage(IMAGE_RGB, config.input.width, config.input.height);
+  int w = config.input.width;
+  int h = config.input.height;
+
+  // Let the decoder scale down the image when we need just a
+  // thumbnail
+  int size = std::max(w, h);
+  if (fop->isThumbnail() && fop->thumbnailSize() > 0 &&
+      size > fop->thumbnailSize()) {
+    w = std::max(1, w * fop->thumbnailSize() / size);
+    h = std::max(1, h * fop->thumbnailSize() / size);
+
+    config.options.use_scaling = 1;
+    config.options.scaled_width = w;
+    config.options.scaled_height = h;
+  }
+
+  Image* image = fop->sequenceImage(IMAGE_RGB, w, h);
 
   config.output.colorspace = MODE_RGBA;
   config.output.u.RGBA.rgba = (uint8_t*)image->getPixelAddress(0, 0);
-  config.output.u.RGBA.stride = config.input.width * sizeof(uint32_t);
-  config.output.u.RGBA.size = config.input.width * config.input.height * sizeof(uint32_t);
+  config.output.u.RGBA.stride = w * sizeof(uint32_t);
+  config.output.u.RGBA.size = w * h * sizeof(uint32_t);
   config.output.is_external_memory = 1;
 
   WebPIDecoder* idec = WebPIDecode(NULL, 0, &config);
@@ -41,7 +41,7 @@ void exit_module_palette()
 {
 }
 
-void load_default_palette(const std::string& userDefined)
+std::shared_ptr<Palette> read_default_palette(const std::string& userDefined)
 {
   std::shared_ptr<Palette> pal;
 
@@ -120,7 +120,12 @@ void load_default_palette(const std::string& userDefined)
     }
   }
 
-  if (pal)
+  return pal;
+}
+
+void load_default_palette(const std::string& userDefined)
+{
+  if (auto pal = read_default_palette(userDefined))
     set_default_palette(pal.get());
 
   set_current_palette(nullptr, true);
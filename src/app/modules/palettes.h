@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 namespace doc {
@@ -25,6 +26,10 @@ namespace app {
   // line.
   void load_default_palette(const std::string& userDefined);
 
+  // Loads the default palette file (or creates it) without changing
+  // the default palette, so it can be called from other thread.
+  std::shared_ptr<Palette> read_default_palette(const std::string& userDefined);
+
   Palette* get_default_palette();
   Palette* get_current_palette();
 
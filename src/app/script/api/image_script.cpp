@@ -5,13 +5,30 @@
 // it under the terms of the GNU General Public License version 2 as
 // published by the Free Software Foundation.
 
+#include "app/document.h"
+#include "app/modules/palettes.h"
+#include "app/ui_context.h"
 #include "base/base64.h"
 #include "script/script_object.h"
+#include "doc/blend_mode.h"
+#include "doc/cel.h"
+#include "doc/cels_range.h"
+#include "doc/conversion_she.h"
 #include "doc/image.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+#include "gfx/rect.h"
+#include "gfx/region.h"
+#include "render/render.h"
 #include "she/surface.h"
 #include "she/system.h"
 #include "ui/manager.h"
+
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 class ImageScriptObject : public script::ScriptObject {
 public:
@@ -55,6 +72,66 @@ public:
     addMethod("getPNGData", &ImageScriptObject::getPNGData)
       .doc("Encodes the image as a PNG.")
       .docReturns("The image as a Base64-encoded PNG string.");
+
+    addMethod("getRect", &ImageScriptObject::getRect)
+      .doc("creates an array with the pixels of the given rectangle of the image.")
+      .docArg("x", "integer")
+      .docArg("y", "integer")
+      .docArg("width", "integer")
+      .docArg("height", "integer")
+      .docReturns("The pixels in a Uint8Array, row by row (without padding).");
+
+    addMethod("putRect", &ImageScriptObject::putRect)
+      .doc("writes the given pixels in a rectangle of the image.")
+      .docArg("x", "integer")
+      .docArg("y", "integer")
+      .docArg("width", "integer")
+      .docArg("height", "integer")
+      .docArg("data", "The pixels of the rectangle, row by row (as returned by getRect).");
+
+    addMethod("fillRect", &ImageScriptObject::fillRect)
+      .doc("fills a rectangle of the image with the specified color.")
+      .docArg("x", "integer")
+      .docArg("y", "integer")
+      .docArg("width", "integer")
+      .docArg("height", "integer")
+      .docArg("color", "a 32-bit color in 8888 RGBA format.");
+
+    addMethod("copyRect", &ImageScriptObject::copyRect)
+      .doc("copies a rectangle of other image (with the same format) to this image, replacing its pixels.")
+      .docArg("image", "the source image")
+      .docArg("srcX", "integer")
+      .docArg("srcY", "integer")
+      .docArg("width", "integer")
+      .docArg("height", "integer")
+      .docArg("dstX", "integer")
+      .docArg("dstY", "integer");
+
+    addMethod("blit", &ImageScriptObject::blit)
+      .doc("draws other image onto this image.")
+      .docArg("image", "the source image")
+      .docArg("x", "integer")
+      .docArg("y", "integer")
+      .docArg("opacity", "integer from 0 to 255")
+      .docArg("blendMode", "a BlendMode value (0 is normal)");
+
+    addMethod("remap", &ImageScriptObject::remap)
+      .doc("replaces each byte of each pixel using a lookup table. The table has 256 entries "
+           "for each byte of a pixel (e.g. 1024 for RGBA images: red, green, blue and alpha).")
+      .docArg("table", "a Uint8Array with the new values.");
+
+    addMethod("convolve", &ImageScriptObject::convolve)
+      .doc("applies a convolution matrix to each channel of the image (RGB and grayscale images only). "
+           "Pixels outside the image are the ones of the nearest edge.")
+      .docArg("kernel", "a Float32Array with size*size weights, row by row.")
+      .docArg("size", "odd integer, the width and height of the kernel.");
+  }
+
+  static doc::Image* toImage(script::ScriptObject* sobj) {
+    auto obj = (sobj ? sobj->handle<doc::Object>(): nullptr);
+    if (!obj || obj->type() != doc::ObjectType::Image)
+      return nullptr;
+    return static_cast<doc::Image*>(obj);
   }
 
   doc::Image* img() {
@@ -64,6 +141,61 @@ public:
     return img;
   }
 
+  // Returns the bytes of a row of "w" pixels, or 0 if rectangles of
+  // this image cannot be accessed byte by byte.
+  int rectRowSize(int w) {
+    if (img()->pixelFormat() == doc::IMAGE_BITMAP) {
+      std::cout << "Not supported in bitmap images" << std::endl;
+      return 0;
+    }
+    return img()->getRowStrideSize(w);
+  }
+
+  bool checkRect(const gfx::Rect& rc) {
+    if (rc.isEmpty() || !img()->bounds().contains(rc)) {
+      std::cout << "Rectangle outside the image: "
+                << rc.x << "," << rc.y << " " << rc.w << "x" << rc.h << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Palette of the sprite where the image is displayed (or the
+  // current palette if it isn't in a sprite).
+  const doc::Palette* palette() {
+    auto image = img();
+    for (auto doc : app::UIContext::instance()->documents()) {
+      for (auto cel : doc->sprite()->cels()) {
+        if (cel->image() == image)
+          return doc->sprite()->palette(cel->frame());
+      }
+    }
+    return app::get_current_palette();
+  }
+
+  // Redraws the modified rectangle in the editors, or the whole UI if
+  // the image isn't in a sprite.
+  void invalidate(const gfx::Rect& bounds) {
+    auto image = img();
+    bool found = false;
+    for (auto d : app::UIContext::instance()->documents()) {
+      auto doc = static_cast<app::Document*>(d);
+      for (auto cel : doc->sprite()->cels()) {
+        if (cel->image() == image) {
+          doc->notifySpritePixelsModified(
+            doc->sprite(),
+            gfx::Region(gfx::Rect(bounds).offset(cel->position())),
+            cel->frame());
+          found = true;
+        }
+      }
+    }
+    if (!found) {
+      if (auto manager = ui::Manager::getDefault())
+        manager->invalidate();
+    }
+  }
+
   void putImageData(script::Value::Buffer& data) {
     auto image = img();
     if (data.size() != std::size_t(image->getRowStrideSize()*image->height())) {
@@ -71,7 +203,7 @@ public:
       return;
     }
     std::memcpy(image->getPixelAddress(0, 0), data.data(), data.size());
-    ui::Manager::getDefault()->invalidate();
+    invalidate(image->bounds());
   }
 
   script::Value getImageData() {
@@ -92,11 +224,7 @@ public:
     if (!surface)
       return "";
 
-    for (auto y = 0; y < h; ++y) {
-      for (auto x = 0; x < w; ++x) {
-        surface->putPixel(img()->getPixel(x, y), x, y);
-      }
-    }
+    doc::convert_image_to_surface(img(), palette(), surface.get(), 0, 0, 0, 0, w, h);
 
     std::string encoded;
     base::encode_base64(she::instance()->encodeSurfaceAsPNG(surface.get()), encoded);
@@ -111,6 +239,165 @@ public:
   void clear(int color) {
     img()->clear(color);
   }
+
+  script::Value getRect(int x, int y, int w, int h) {
+    const gfx::Rect rc(x, y, w, h);
+    const int rowSize = rectRowSize(w);
+    if (!rowSize || !checkRect(rc))
+      return {};
+
+    auto image = img();
+    auto data = new uint8_t[std::size_t(rowSize)*h];
+    for (int v=0; v<h; ++v)
+      std::memcpy(data + std::size_t(rowSize)*v, image->getPixelAddress(x, y+v), rowSize);
+    return {data, std::size_t(rowSize)*h, true};
+  }
+
+  void putRect(int x, int y, int w, int h, script::Value::Buffer& data) {
+    const gfx::Rect rc(x, y, w, h);
+    const int rowSize = rectRowSize(w);
+    if (!rowSize || !checkRect(rc))
+      return;
+
+    if (data.size() != std::size_t(rowSize)*h) {
+      std::cout << "Data size mismatch: " << data.size() << std::endl;
+      return;
+    }
+
+    auto image = img();
+    for (int v=0; v<h; ++v)
+      std::memcpy(image->getPixelAddress(x, y+v), data.data() + std::size_t(rowSize)*v, rowSize);
+    invalidate(rc);
+  }
+
+  void fillRect(int x, int y, int w, int h, int color) {
+    const gfx::Rect rc = gfx::Rect(x, y, w, h).createIntersection(img()->bounds());
+    if (rc.isEmpty())
+      return;
+
+    doc::fill_rect(img(), rc, color);
+    invalidate(rc);
+  }
+
+  void copyRect(script::ScriptObject* srcObj, int srcX, int srcY, int w, int h, int dstX, int dstY) {
+    auto src = toImage(srcObj);
+    auto dst = img();
+    if (!src || src->pixelFormat() != dst->pixelFormat()) {
+      std::cout << "The source must be an image with the same format" << std::endl;
+      return;
+    }
+
+    // Clip the rectangle to both images
+    gfx::Rect rc = gfx::Rect(srcX, srcY, w, h).createIntersection(src->bounds());
+    rc = gfx::Rect(rc).offset(dstX-srcX, dstY-srcY).createIntersection(dst->bounds());
+    if (rc.isEmpty() || !rectRowSize(rc.w))
+      return;
+
+    // memmove() because the source can be this image
+    const int rowSize = dst->getRowStrideSize(rc.w);
+    const int dy = dstY-srcY;
+    const int dx = dstX-srcX;
+    if (src == dst && dy > 0) {
+      for (int v=rc.h-1; v>=0; --v)
+        std::memmove(dst->getPixelAddress(rc.x, rc.y+v),
+                     src->getPixelAddress(rc.x-dx, rc.y+v-dy), rowSize);
+    }
+    else {
+      for (int v=0; v<rc.h; ++v)
+        std::memmove(dst->getPixelAddress(rc.x, rc.y+v),
+                     src->getPixelAddress(rc.x-dx, rc.y+v-dy), rowSize);
+    }
+    invalidate(rc);
+  }
+
+  void blit(script::ScriptObject* srcObj, int x, int y, int opacity, int blendMode) {
+    auto src = toImage(srcObj);
+    if (!src) {
+      std::cout << "The source must be an image" << std::endl;
+      return;
+    }
+
+    render::composite_image(img(), src, palette(), x, y,
+                            std::clamp(opacity, 0, 255),
+                            static_cast<doc::BlendMode>(blendMode));
+    invalidate(gfx::Rect(x, y, src->width(), src->height()).createIntersection(img()->bounds()));
+  }
+
+  void remap(script::Value::Buffer& table) {
+    auto image = img();
+    const int bytesPerPixel = rectRowSize(1);
+    if (!bytesPerPixel)
+      return;
+
+    if (table.size() != std::size_t(256*bytesPerPixel)) {
+      std::cout << "The table must have " << 256*bytesPerPixel << " entries" << std::endl;
+      return;
+    }
+
+    const uint8_t* lut = table.data();
+    const int rowSize = image->getRowStrideSize();
+    for (int y=0; y<image->height(); ++y) {
+      uint8_t* p = image->getPixelAddress(0, y);
+      for (int i=0; i<rowSize; ++i, ++p)
+        *p = lut[256*(i % bytesPerPixel) + *p];
+    }
+    invalidate(image->bounds());
+  }
+
+  void convolve(script::Value::Buffer& kernel, int size) {
+    auto image = img();
+    if (image->pixelFormat() != doc::IMAGE_RGB &&
+        image->pixelFormat() != doc::IMAGE_GRAYSCALE) {
+      std::cout << "Only RGB and grayscale images can be convolved" << std::endl;
+      return;
+    }
+    if (size < 1 || (size & 1) == 0 ||
+        kernel.size() != std::size_t(size*size)*sizeof(float)) {
+      std::cout << "The kernel must have size*size weights (size must be odd)" << std::endl;
+      return;
+    }
+
+    std::vector<float> weights(size*size);
+    std::memcpy(&weights[0], kernel.data(), kernel.size());
+
+    // Each byte of a pixel is a channel (RGBA or value+alpha)
+    const int channels = image->getRowStrideSize(1);
+    const int w = image->width();
+    const int h = image->height();
+    const int r = size/2;
+    std::unique_ptr<doc::Image> src(doc::Image::createCopy(image));
+
+    // Byte offset of each column (clamped to the edges) in a row
+    std::vector<int> columns(w + 2*r);
+    for (int i=0; i<int(columns.size()); ++i)
+      columns[i] = std::clamp(i-r, 0, w-1) * channels;
+
+    std::vector<const uint8_t*> rows(size);
+    std::vector<float> sums(channels);
+
+    for (int y=0; y<h; ++y) {
+      for (int k=0; k<size; ++k)
+        rows[k] = src->getPixelAddress(0, std::clamp(y+k-r, 0, h-1));
+
+      uint8_t* dst = image->getPixelAddress(0, y);
+      for (int x=0; x<w; ++x) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+
+        const float* weight = &weights[0];
+        for (int ky=0; ky<size; ++ky) {
+          for (int kx=0; kx<size; ++kx, ++weight) {
+            const uint8_t* p = rows[ky] + columns[x+kx];
+            for (int c=0; c<channels; ++c)
+              sums[c] += *weight * p[c];
+          }
+        }
+
+        for (int c=0; c<channels; ++c, ++dst)
+          *dst = uint8_t(std::clamp(std::lround(sums[c]), 0l, 255l));
+      }
+    }
+    invalidate(image->bounds());
+  }
 };
 
 static script::ScriptObject::Regular<ImageScriptObject> imageSO(typeid(doc::Image*).name());
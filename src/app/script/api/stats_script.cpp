@@ -0,0 +1,177 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#include "app/crash/session.h"
+#include "app/document.h"
+#include "app/tools/stroke_recorder.h"
+#include "app/ui_context.h"
+#include "doc/object.h"
+#include "script/engine.h"
+#include "script/profiler.h"
+#include "ui/latency.h"
+
+#include <cstdio>
+
+class ObjectRegistryStatsScriptObject : public script::ScriptObject {
+public:
+  ObjectRegistryStatsScriptObject() {
+    addProperty("shards", []{return doc::get_object_registry_stats().shards;})
+      .doc("read-only. Number of shards (independent locks) of the registry.");
+
+    addProperty("objects", []{return double(doc::get_object_registry_stats().objects);})
+      .doc("read-only. Number of objects in the registry.");
+
+    addProperty("lookups", []{return double(doc::get_object_registry_stats().lookups);})
+      .doc("read-only. Number of objects searched by ID.");
+
+    addProperty("inserts", []{return double(doc::get_object_registry_stats().inserts);})
+      .doc("read-only. Number of IDs assigned to objects.");
+
+    addProperty("removes", []{return double(doc::get_object_registry_stats().removes);})
+      .doc("read-only. Number of IDs released by objects.");
+
+    addProperty("contended", []{return double(doc::get_object_registry_stats().contended);})
+      .doc("read-only. Number of times that a thread had to wait for other thread to access the registry.");
+  }
+};
+
+static script::ScriptObject::Regular<ObjectRegistryStatsScriptObject> objectRegistryStats("objectRegistryStats");
+
+class LatencyStatsScriptObject : public script::ScriptObject {
+public:
+  LatencyStatsScriptObject() {
+    addMethod("report", &LatencyStatsScriptObject::report)
+      .doc("Returns the input latency percentiles (in microseconds) of each stage: "
+           "queue (OS event to UI message), dispatch (until the message is processed), "
+           "tool (until the tool modifies the sprite) and flip (until the screen is updated).");
+
+    addMethod("reset", &LatencyStatsScriptObject::reset)
+      .doc("Discards all the latency samples collected until now.");
+
+    addMethod("startRecording", &LatencyStatsScriptObject::startRecording)
+      .doc("Saves the pointer events of all strokes in the given file, to be replayed "
+           "later with the --replay-strokes command line option.");
+
+    addMethod("stopRecording", &LatencyStatsScriptObject::stopRecording)
+      .doc("Stops saving strokes started with startRecording().");
+  }
+
+  std::string report() {
+    return ui::latency_report();
+  }
+
+  void reset() {
+    ui::reset_latency_histograms();
+  }
+
+  void startRecording(const std::string& filename) {
+    app::tools::start_stroke_recording(filename);
+  }
+
+  void stopRecording() {
+    app::tools::stop_stroke_recording();
+  }
+};
+
+static script::ScriptObject::Regular<LatencyStatsScriptObject> latencyStats("latencyStats");
+
+class ProfilerScriptObject : public script::ScriptObject {
+public:
+  ProfilerScriptObject() {
+    addMethod("start", &ProfilerScriptObject::start)
+      .doc("Starts profiling all scripts: calls to native functions, value conversions, "
+           "and samples of the script call stack (taken when native functions are called).")
+      .docArg("interval", "minimum milliseconds between two samples of the call stack");
+
+    addMethod("stop", &ProfilerScriptObject::stop)
+      .doc("Stops profiling (the collected data is kept).");
+
+    addMethod("reset", &ProfilerScriptObject::reset)
+      .doc("Discards the collected data.");
+
+    addMethod("report", &ProfilerScriptObject::report)
+      .doc("Returns the native functions and script stacks where most time was spent.");
+
+    addMethod("save", &ProfilerScriptObject::save)
+      .doc("Saves the sampled stacks in the folded format used by flamegraph tools.")
+      .docArg("filename", "the output text file")
+      .docReturns("true if the file was saved");
+  }
+
+  void start(int interval) {
+    script::Profiler::instance().start(interval);
+  }
+
+  void stop() {
+    script::Profiler::instance().stop();
+  }
+
+  void reset() {
+    script::Profiler::instance().reset();
+  }
+
+  std::string report() {
+    return script::Profiler::instance().report();
+  }
+
+  bool save(const std::string& filename) {
+    return script::Profiler::instance().saveFoldedStacks(filename);
+  }
+};
+
+static script::ScriptObject::Regular<ProfilerScriptObject> profilerStats("profilerStats");
+
+class StatsScriptObject : public script::ScriptObject {
+public:
+  inject<ScriptObject> m_objects{"objectRegistryStats"};
+  inject<ScriptObject> m_latency{"latencyStats"};
+  inject<ScriptObject> m_profiler{"profilerStats"};
+
+  StatsScriptObject() {
+    addProperty("objects", [this]{return m_objects.get();})
+      .doc("read-only. Returns the counters of the document objects registry.");
+
+    addProperty("latency", [this]{return m_latency.get();})
+      .doc("read-only. Returns the input-to-screen latency statistics.");
+
+    addProperty("profiler", [this]{return m_profiler.get();})
+      .doc("read-only. Returns the script profiler.");
+
+    addMethod("documentLocks", &StatsScriptObject::documentLocks)
+      .doc("Returns how many times each open document was locked, how many "
+           "locks had to wait for other thread or failed, and the wait times (in microseconds).");
+
+    addMethod("backupDurations", &StatsScriptObject::backupDurations)
+      .doc("Returns the percentiles of the time used by the data recovery process to "
+           "backup each document, and how much of that time the document was locked.");
+
+    makeGlobal("stats");
+  }
+
+  std::string documentLocks() {
+    std::string result;
+    for (auto doc : app::UIContext::instance()->documents()) {
+      auto stats = static_cast<app::Document*>(doc)->lockStats();
+      char buf[256];
+      std::snprintf(buf, sizeof(buf),
+                    " locks=%llu contended=%llu timeouts=%llu wait=%llu max=%llu\n",
+                    (unsigned long long)stats.locks,
+                    (unsigned long long)stats.contended,
+                    (unsigned long long)stats.timeouts,
+                    (unsigned long long)stats.waitTime,
+                    (unsigned long long)stats.maxWaitTime);
+      result += doc->name() + ":" + buf;
+    }
+    return result;
+  }
+
+  std::string backupDurations() {
+    return app::crash::backup_duration_report();
+  }
+};
+
+static script::ScriptObject::Regular<StatsScriptObject> reg("StatsScriptObject", {"global"});
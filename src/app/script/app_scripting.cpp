@@ -14,7 +14,9 @@
 #include "app/document.h"
 #include "app/script/app_scripting.h"
 #include "app/task_manager.h"
+#include "app/resource_finder.h"
 #include "base/file_handle.h"
+#include "base/fs.h"
 #include "base/path.h"
 #include "base/range.h"
 #include "base/string.h"
@@ -28,6 +30,9 @@
 #include "ui/widget.h"
 #include "ui/manager.h"
 
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <map>
 #include <utility>
 #include <string>
@@ -194,8 +199,7 @@ namespace app {
   bool AppScripting::evalFile(const std::string& fileName) {
     m_fileName = fileName;
     std::cout << "Reading file " << fileName << std::endl;
-    std::ifstream ifs(fileName);
-    if (!ifs) {
+    if (!base::is_file(fileName)) {
       std::cout << "Could not open " << fileName << std::endl;
       return false;
     }
@@ -206,7 +210,15 @@ namespace app {
     engine = nullptr;
 
     AppScripting instance;
-    if (!instance.eval({std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()}))
+    instance.initEngine();
+    if (!engine) {
+      inject<script::EngineDelegate>{}->onConsolePrint("No compatible scripting engine.");
+      return false;
+    }
+
+    std::string cacheKey;
+    std::string cacheFile = getCacheFile(fileName, cacheKey);
+    if (!engine->evalFile(fileName, cacheFile, cacheKey))
       return false;
 
     engine->raiseEvent({"init"});
@@ -215,6 +227,50 @@ namespace app {
     return true;
   }
 
+  // The compiled version of each script is saved in the "scripts-cache"
+  // user directory, in a file named with a hash of the script path.
+  // The key is the modification time and size of the script.
+  std::string AppScripting::getCacheFile(const std::string& fileName, std::string& cacheKey) {
+    std::error_code ec;
+#ifdef _WIN32
+    const std::filesystem::path path(base::from_utf8(fileName));
+#else
+    const std::filesystem::path path(fileName);
+#endif
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+      return std::string();
+    auto time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    if (ec)
+      return std::string();
+    cacheKey = std::to_string(time) + ":" + std::to_string(size);
+
+    static std::string cacheDir;
+    if (cacheDir.empty()) {
+      ResourceFinder rf;
+      rf.includeUserDir(base::join_path("scripts-cache", ".").c_str());
+      cacheDir = base::get_file_path(rf.getFirstOrCreateDefault());
+      try {
+        if (!base::is_directory(cacheDir))
+          base::make_all_directories(cacheDir);
+      }
+      catch (const std::exception&) {
+        cacheDir.clear();
+        return std::string();
+      }
+    }
+
+    // FNV-1a hash of the script path
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char chr : fileName) {
+      hash ^= chr;
+      hash *= 0x100000001b3ull;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016llx.bin", (unsigned long long)hash);
+    return base::join_path(cacheDir, buf);
+  }
+
   void AppScripting::printLastResult() {
     if(engine)
       engine->printLastResult();
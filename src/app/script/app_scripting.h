@@ -19,6 +19,7 @@ namespace app {
 
   class AppScripting {
     void initEngine();
+    static std::string getCacheFile(const std::string& fileName, std::string& cacheKey);
     static std::string m_fileName;
 
   public:
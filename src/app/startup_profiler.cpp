@@ -0,0 +1,94 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/startup_profiler.h"
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace app {
+
+namespace {
+
+struct Phase {
+  std::string name;
+  std::thread::id thread;
+  int depth;
+  base::timestamp_t start;
+  base::timestamp_t end;
+};
+
+std::mutex g_mutex;
+bool g_enabled = false;
+std::vector<Phase> g_phases;
+const base::timestamp_t g_startupTime = base::current_timestamp();
+const std::thread::id g_mainThread = std::this_thread::get_id();
+thread_local int g_depth = 0;
+
+} // anonymous namespace
+
+StartupPhase::StartupPhase(const char* name)
+  : m_index(-1)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (!g_enabled)
+    return;
+
+  m_index = int(g_phases.size());
+  g_phases.push_back(Phase{ name, std::this_thread::get_id(), g_depth++,
+                            base::current_timestamp(), 0 });
+}
+
+StartupPhase::~StartupPhase()
+{
+  if (m_index < 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_phases[m_index].end = base::current_timestamp();
+  --g_depth;
+}
+
+void start_startup_profiler()
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_enabled = true;
+}
+
+std::string startup_report()
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_enabled = false;
+
+  std::string report = "    start(ms)      time(ms)  phase\n";
+  char buf[256];
+
+  for (const auto& phase : g_phases) {
+    const base::timestamp_t end = (phase.end ? phase.end: base::current_timestamp());
+    std::snprintf(buf, sizeof(buf), "%13.1f %13.1f  %*s%s%s%s\n",
+                  (phase.start - g_startupTime) / 1000.0,
+                  (end - phase.start) / 1000.0,
+                  2*phase.depth, "",
+                  phase.name.c_str(),
+                  (phase.thread != g_mainThread ? " (background)": ""),
+                  (phase.end ? "": " (running)"));
+    report += buf;
+  }
+
+  std::snprintf(buf, sizeof(buf), "%13.1f total\n",
+                (base::current_timestamp() - g_startupTime) / 1000.0);
+  report += buf;
+  return report;
+}
+
+} // namespace app
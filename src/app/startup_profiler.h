@@ -0,0 +1,39 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "base/disable_copying.h"
+#include "base/latency_histogram.h"
+
+#include <string>
+
+namespace app {
+
+  // Measures a phase of the program startup while it's alive. Phases
+  // can be nested and can run in other threads (e.g. resources loaded
+  // in background). Nothing is recorded if the profiler wasn't
+  // started.
+  class StartupPhase {
+  public:
+    StartupPhase(const char* name);
+    ~StartupPhase();
+
+  private:
+    int m_index;
+
+    DISABLE_COPYING(StartupPhase);
+  };
+
+  // Starts recording phases (only with the --profile-startup option).
+  void start_startup_profiler();
+
+  // Stops recording phases (the startup is over) and returns a table
+  // with the start time and duration of each phase.
+  std::string startup_report();
+
+} // namespace app
@@ -118,6 +118,10 @@ namespace app {
     std::array<std::shared_ptr<detail::Task>, std::tuple_size<decltype(threads)>::value> processing;
     std::mutex processingMutex;
 
+    // Number of tasks taken from "pending" that are not in "ready"
+    // yet. Used to stop m_timer when there is nothing to do.
+    std::atomic<int> busy{0};
+
     TaskManager() {
       m_timer.Tick.connect(&TaskManager::onTick, this);
       for (std::size_t i = 0; i < threads.size(); ++i) {
@@ -154,6 +158,7 @@ namespace app {
           }
           task = pending.front();
           pending.pop_front();
+          ++busy;
         }
 
         if (task->isAlive) {
@@ -185,6 +190,7 @@ namespace app {
           }
 
         }
+        --busy;
 
       }
     }
@@ -219,6 +225,18 @@ namespace app {
         }
         task->funcCallback(data);
       }
+
+      // Stop the timer (so the UI thread can sleep) when there are no
+      // more tasks. "busy" is read with pendingMutex locked because
+      // workers take a task from "pending" and increment "busy" with
+      // that same mutex locked (so a task cannot be in neither
+      // place). Tasks are added to "ready" before they stop being busy.
+      {
+        std::lock_guard<std::mutex> pendingGuard(pendingMutex);
+        std::lock_guard<std::recursive_mutex> readyGuard(readyMutex);
+        if (busy == 0 && pending.empty() && ready.empty())
+          m_timer.stop();
+      }
     }
 
     static inline TaskManager* manager;
@@ -0,0 +1,292 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/thumbnail_cache.h"
+
+#include "base/fstream_path.h"
+#include "base/path.h"
+#include "base/serialization.h"
+#include "base/string.h"
+#include "doc/image.h"
+#include "doc/image_io.h"
+#include "doc/string_io.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace app {
+
+using namespace base::serialization;
+using namespace base::serialization::little_endian;
+
+namespace {
+
+const uint32_t kThumbnailMagic = 0x48544C53; // "SLTH"
+const char* kThumbnailExtension = ".thumb";
+
+std::filesystem::path fs_path(const std::string& path)
+{
+#ifdef _WIN32
+  return std::filesystem::path(base::from_utf8(path));
+#else
+  return std::filesystem::path(path);
+#endif
+}
+
+// What we know about the original file when its thumbnail is saved.
+struct FileKey {
+  uint64_t size;
+  uint64_t time;
+};
+
+bool get_file_key(const std::string& filename, FileKey& key)
+{
+  std::error_code ec;
+  const auto path = fs_path(filename);
+  key.size = std::filesystem::file_size(path, ec);
+  if (ec)
+    return false;
+
+  key.time = uint64_t(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+  return !ec;
+}
+
+// FNV-1a hash of the file path
+std::string entry_name(const std::string& filename)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char chr : filename) {
+    hash ^= chr;
+    hash *= 0x100000001b3ull;
+  }
+
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+  return buf + std::string(kThumbnailExtension);
+}
+
+void write64(std::ostream& os, uint64_t value)
+{
+  write32(os, uint32_t(value));
+  write32(os, uint32_t(value >> 32));
+}
+
+uint64_t read64(std::istream& is)
+{
+  uint64_t lo = read32(is);
+  uint64_t hi = read32(is);
+  return lo | (hi << 32);
+}
+
+} // anonymous namespace
+
+ThumbnailCache::ThumbnailCache(const std::string& dir, std::size_t maxSize)
+  : m_dir(dir)
+  , m_maxSize(maxSize)
+  , m_size(0)
+  , m_loaded(false)
+{
+}
+
+doc::Image* ThumbnailCache::load(const std::string& filename)
+{
+  FileKey key;
+  if (!get_file_key(filename, key))
+    return nullptr;
+
+  const std::string name = entry_name(filename);
+  std::unique_ptr<doc::Image> image;
+  bool found = false;
+  {
+    std::ifstream s(FSTREAM_PATH(entryPath(name)), std::ifstream::binary);
+    if (!s)
+      return nullptr;
+
+    found = true;
+    try {
+      if (read32(s) == kThumbnailMagic &&
+          doc::read_string(s) == filename &&
+          read64(s) == key.size &&
+          read64(s) == key.time &&
+          s.good()) {
+        image.reset(doc::read_image(s, false));
+      }
+    }
+    catch (const std::exception&) {
+      // Invalid or truncated file
+      image.reset();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  loadEntries();
+
+  if (image) {
+    std::error_code ec;
+    const auto path = fs_path(entryPath(name));
+    std::size_t size = std::filesystem::file_size(path, ec);
+    if (!ec) {
+      // The modification time of the entry is used to restore the LRU
+      // order in the next session.
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+      touch(name, size);
+    }
+  }
+  // The original file was modified, this thumbnail is useless now.
+  else if (found)
+    remove(name);
+
+  return image.release();
+}
+
+void ThumbnailCache::save(const std::string& filename, const doc::Image* thumbnail)
+{
+  FileKey key;
+  if (!get_file_key(filename, key))
+    return;
+
+  // Compress the image before locking the cache
+  std::ostringstream os(std::ios::binary);
+  write32(os, kThumbnailMagic);
+  doc::write_string(os, filename);
+  write64(os, key.size);
+  write64(os, key.time);
+  doc::write_image(os, thumbnail);
+  const std::string data = os.str();
+  const std::string name = entry_name(filename);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (data.size() > m_maxSize)
+    return;
+
+  loadEntries();
+
+  std::error_code ec;
+  std::filesystem::create_directories(fs_path(m_dir), ec);
+
+  std::ofstream s(FSTREAM_PATH(entryPath(name)), std::ofstream::binary);
+  if (!s.write(data.c_str(), data.size()))
+    return;
+  s.close();
+
+  touch(name, data.size());
+  shrink();
+}
+
+std::size_t ThumbnailCache::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size;
+}
+
+std::size_t ThumbnailCache::maxSize() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_maxSize;
+}
+
+void ThumbnailCache::setMaxSize(std::size_t maxSize)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_maxSize = maxSize;
+  if (m_loaded)
+    shrink();
+}
+
+std::string ThumbnailCache::entryPath(const std::string& name) const
+{
+  return base::join_path(m_dir, name);
+}
+
+// Lists the thumbnails saved in previous sessions the first time the
+// cache is used (from a thumbnail generator thread), so it doesn't
+// slow down the program startup or the UI thread.
+void ThumbnailCache::loadEntries()
+{
+  if (m_loaded)
+    return;
+
+  m_loaded = true;
+
+  struct Item {
+    std::filesystem::file_time_type time;
+    std::string name;
+    std::size_t size;
+  };
+  std::vector<Item> items;
+
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(fs_path(m_dir), ec)) {
+    if (!entry.is_regular_file(ec) ||
+        entry.path().extension() != kThumbnailExtension)
+      continue;
+
+    Item item;
+    item.time = entry.last_write_time(ec);
+    item.size = entry.file_size(ec);
+    item.name = entry.path().filename().string();
+    if (!ec)
+      items.push_back(item);
+  }
+
+  std::sort(items.begin(), items.end(),
+            [](const Item& a, const Item& b) {
+              return a.time > b.time;
+            });
+
+  for (const auto& item : items) {
+    m_lru.push_back(Entry{item.name, item.size});
+    m_entries[item.name] = std::prev(m_lru.end());
+    m_size += item.size;
+  }
+
+  shrink();
+}
+
+void ThumbnailCache::touch(const std::string& name, std::size_t size)
+{
+  auto it = m_entries.find(name);
+  if (it != m_entries.end()) {
+    m_size -= it->second->size;
+    m_lru.erase(it->second);
+  }
+
+  m_lru.push_front(Entry{name, size});
+  m_entries[name] = m_lru.begin();
+  m_size += size;
+}
+
+void ThumbnailCache::remove(const std::string& name)
+{
+  std::error_code ec;
+  std::filesystem::remove(fs_path(entryPath(name)), ec);
+
+  auto it = m_entries.find(name);
+  if (it != m_entries.end()) {
+    m_size -= it->second->size;
+    m_lru.erase(it->second);
+    m_entries.erase(it);
+  }
+}
+
+void ThumbnailCache::shrink()
+{
+  while (m_size > m_maxSize && !m_lru.empty())
+    remove(m_lru.back().name);
+}
+
+} // namespace app
@@ -0,0 +1,69 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace doc {
+  class Image;
+}
+
+namespace app {
+
+  // Thumbnails of the file selector saved on disk between sessions.
+  //
+  // Each thumbnail is a small file in the cache directory named with
+  // a hash of the original file path. It stays valid while the
+  // original file keeps the same modification time and size. When the
+  // cache gets bigger than its size limit, the least recently used
+  // thumbnails are deleted.
+  //
+  // All member functions can be called from any thread.
+  class ThumbnailCache {
+  public:
+    ThumbnailCache(const std::string& dir, std::size_t maxSize);
+
+    // Returns the thumbnail of the given file, or nullptr if it isn't
+    // in the cache or the file was modified after saving it.
+    doc::Image* load(const std::string& filename);
+
+    void save(const std::string& filename, const doc::Image* thumbnail);
+
+    // Total size of the thumbnails in bytes.
+    std::size_t size() const;
+    std::size_t maxSize() const;
+    void setMaxSize(std::size_t maxSize);
+
+  private:
+    struct Entry {
+      std::string name;
+      std::size_t size;
+    };
+    typedef std::list<Entry> Entries;
+
+    std::string entryPath(const std::string& name) const;
+    void loadEntries();
+    void touch(const std::string& name, std::size_t size);
+    void remove(const std::string& name);
+    void shrink();
+
+    std::string m_dir;
+    std::size_t m_maxSize;
+    std::size_t m_size;
+    bool m_loaded;
+    // Most recently used entries first.
+    Entries m_lru;
+    std::unordered_map<std::string, Entries::iterator> m_entries;
+    mutable std::mutex m_mutex;
+  };
+
+} // namespace app
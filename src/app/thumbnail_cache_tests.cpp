@@ -0,0 +1,120 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#include "tests/test.h"
+
+#include "app/thumbnail_cache.h"
+#include "base/fs.h"
+#include "base/path.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+
+#include <fstream>
+#include <memory>
+
+using namespace app;
+using namespace doc;
+
+static std::string make_file(const std::string& fn, const std::string& content)
+{
+  std::ofstream(fn, std::ofstream::binary) << content;
+  return fn;
+}
+
+static void clear_dir(const std::string& dir)
+{
+  if (!base::is_directory(dir))
+    return;
+
+  for (const auto& fn : base::list_files(dir))
+    base::delete_file(base::join_path(dir, fn));
+  base::remove_directory(dir);
+}
+
+static Image* make_thumbnail(color_t color)
+{
+  Image* image = Image::create(IMAGE_RGB, 32, 16);
+  clear_image(image, color);
+  put_pixel(image, 3, 4, rgba(1, 2, 3, 255));
+  return image;
+}
+
+TEST(ThumbnailCache, SaveAndLoad)
+{
+  clear_dir("_thumbs");
+  std::string fn = make_file("_thumbs_a.png", "a");
+  std::unique_ptr<Image> thumb(make_thumbnail(rgba(255, 0, 0, 255)));
+
+  {
+    ThumbnailCache cache("_thumbs", 1024*1024);
+    EXPECT_EQ(nullptr, cache.load(fn));
+    cache.save(fn, thumb.get());
+    EXPECT_LT(0u, cache.size());
+  }
+
+  // A new cache (next session) finds the thumbnail on disk
+  ThumbnailCache cache("_thumbs", 1024*1024);
+  std::unique_ptr<Image> loaded(cache.load(fn));
+  ASSERT_NE(nullptr, loaded.get());
+  EXPECT_EQ(32, loaded->width());
+  EXPECT_EQ(16, loaded->height());
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(loaded.get(), 0, 0));
+  EXPECT_EQ(rgba(1, 2, 3, 255), get_pixel(loaded.get(), 3, 4));
+
+  base::delete_file(fn);
+  clear_dir("_thumbs");
+}
+
+TEST(ThumbnailCache, ModifiedFile)
+{
+  clear_dir("_thumbs");
+  std::string fn = make_file("_thumbs_b.png", "b");
+  std::unique_ptr<Image> thumb(make_thumbnail(rgba(0, 255, 0, 255)));
+
+  ThumbnailCache cache("_thumbs", 1024*1024);
+  cache.save(fn, thumb.get());
+
+  // Different size means a different file
+  make_file(fn, "bigger file");
+  EXPECT_EQ(nullptr, cache.load(fn));
+  EXPECT_EQ(0u, cache.size());
+
+  base::delete_file(fn);
+  clear_dir("_thumbs");
+}
+
+TEST(ThumbnailCache, LeastRecentlyUsedAreDeleted)
+{
+  clear_dir("_thumbs");
+  std::string a = make_file("_thumbs_a.png", "a");
+  std::string b = make_file("_thumbs_b.png", "b");
+  std::string c = make_file("_thumbs_c.png", "c");
+  std::unique_ptr<Image> thumb(make_thumbnail(rgba(0, 0, 255, 255)));
+
+  ThumbnailCache cache("_thumbs", 1024*1024);
+  cache.save(a, thumb.get());
+  const std::size_t entrySize = cache.size();
+
+  // Space for two thumbnails only
+  cache.setMaxSize(2*entrySize + entrySize/2);
+  cache.save(b, thumb.get());
+  delete cache.load(a);         // "a" is more recent than "b" now
+  cache.save(c, thumb.get());
+
+  std::unique_ptr<Image> imageA(cache.load(a));
+  std::unique_ptr<Image> imageB(cache.load(b));
+  std::unique_ptr<Image> imageC(cache.load(c));
+  EXPECT_NE(nullptr, imageA.get());
+  EXPECT_EQ(nullptr, imageB.get());
+  EXPECT_NE(nullptr, imageC.get());
+  EXPECT_GE(cache.maxSize(), cache.size());
+
+  base::delete_file(a);
+  base::delete_file(b);
+  base::delete_file(c);
+  clear_dir("_thumbs");
+}
@@ -16,9 +16,11 @@
 #include "app/document.h"
 #include "app/file/file.h"
 #include "app/file_system.h"
+#include "app/pref/preferences.h"
+#include "app/resource_finder.h"
+#include "app/thumbnail_cache.h"
 #include "base/bind.h"
-#include "base/scoped_lock.h"
-#include "base/thread.h"
+#include "base/path.h"
 #include "doc/algorithm/rotate.h"
 #include "doc/conversion_she.h"
 #include "doc/image.h"
@@ -27,32 +29,73 @@
 #include "doc/sprite.h"
 #include "she/system.h"
 
+#include <algorithm>
+
 #define MAX_THUMBNAIL_SIZE              128
 
 namespace app {
 
+static void set_thumbnail(IFileItem* fileitem, const Image* image, const Palette* palette)
+{
+  she::Surface* thumbnail = she::instance()->createRgbaSurface(
+    image->width(),
+    image->height());
+
+  convert_image_to_surface(image, palette, thumbnail,
+    0, 0, 0, 0, image->width(), image->height());
+
+  fileitem->setThumbnail(thumbnail);
+}
+
 class ThumbnailGenerator::Worker {
 public:
-  Worker(FileOp* fop, IFileItem* fileitem)
+  Worker(FileOp* fop, IFileItem* fileitem, ThumbnailCache* cache,
+         int priority, int order)
     : m_fop(fop)
     , m_fileitem(fileitem)
+    , m_cache(cache)
     , m_thumbnail(nullptr)
     , m_palette(nullptr)
-    , m_thread(base::Bind<void>(&Worker::loadBgThread, this)) {
-  }
-
-  ~Worker() {
-    m_fop->stop();
-    m_thread.join();
+    , m_priority(priority)
+    , m_order(order)
+    , m_running(false) {
   }
 
   IFileItem* getFileItem() { return m_fileitem; }
   bool isDone() const { return m_fop->isDone(); }
+  bool isStop() const { return m_fop->isStop(); }
   double getProgress() const { return m_fop->progress(); }
+  void stop() { m_fop->stop(); }
+
+  // These fields are protected by the ThumbnailGenerator mutex.
+  int priority() const { return m_priority; }
+  void setPriority(int priority) { m_priority = priority; }
+  bool isRunning() const { return m_running; }
+  void setRunning(bool running) { m_running = running; }
+
+  // Returns true if this worker must be processed before the other one.
+  bool goesBefore(const Worker* other) const {
+    return (m_priority > other->m_priority ||
+            (m_priority == other->m_priority && m_order < other->m_order));
+  }
 
-private:
-  void loadBgThread() {
+  void run() {
     try {
+      // Canceled before starting
+      if (m_fop->isStop()) {
+        m_fop->done();
+        return;
+      }
+
+      // Thumbnail generated in a previous session (the cache is read
+      // here so the UI thread doesn't wait for the disk)
+      std::unique_ptr<Image> cached(m_cache->load(m_fileitem->fileName()));
+      if (cached) {
+        set_thumbnail(m_fileitem, cached.get(), nullptr);
+        m_fop->done();
+        return;
+      }
+
       m_fop->operate(nullptr);
 
       // Post load
@@ -98,16 +141,11 @@ private:
       // Close file
       delete m_fop->releaseDocument();
 
-      // Set the thumbnail of the file-item.
+      // Set the thumbnail of the file-item and save it for the next
+      // session.
       if (m_thumbnail) {
-        she::Surface* thumbnail = she::instance()->createRgbaSurface(
-          m_thumbnail->width(),
-          m_thumbnail->height());
-
-        convert_image_to_surface(m_thumbnail.get(), m_palette.get(), thumbnail,
-          0, 0, 0, 0, m_thumbnail->width(), m_thumbnail->height());
-
-        m_fileitem->setThumbnail(thumbnail);
+        set_thumbnail(m_fileitem, m_thumbnail.get(), m_palette.get());
+        m_cache->save(m_fileitem->fileName(), m_thumbnail.get());
       }
     }
     catch (const std::exception& e) {
@@ -116,11 +154,15 @@ private:
     m_fop->done();
   }
 
+private:
   std::unique_ptr<FileOp> m_fop;
   IFileItem* m_fileitem;
+  ThumbnailCache* m_cache;
   std::unique_ptr<Image> m_thumbnail;
   std::shared_ptr<Palette> m_palette;
-  base::thread m_thread;
+  int m_priority;
+  int m_order;
+  bool m_running;
 };
 
 static void delete_singleton(ThumbnailGenerator* singleton)
@@ -128,6 +170,37 @@ static void delete_singleton(ThumbnailGenerator* singleton)
   delete singleton;
 }
 
+ThumbnailGenerator::ThumbnailGenerator()
+  : m_shutdown(false)
+  , m_order(0)
+{
+  ResourceFinder rf;
+  rf.includeUserDir(base::join_path("thumbnails", ".").c_str());
+  std::string dir = base::get_file_path(rf.getFirstOrCreateDefault());
+
+  int sizeMB = MAX(0, Preferences::instance().general.thumbnailCacheSize());
+  m_cache.reset(new ThumbnailCache(dir, std::size_t(sizeMB) * 1024 * 1024));
+}
+
+ThumbnailGenerator::~ThumbnailGenerator()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+    for (Worker* worker : m_workers)
+      worker->stop();
+  }
+  m_queueCondition.notify_all();
+
+  // Workers save thumbnails in the cache, so they must finish before
+  // the cache is destroyed.
+  for (auto& thread : m_threads)
+    thread.join();
+
+  for (Worker* worker : m_workers)
+    delete worker;
+}
+
 ThumbnailGenerator* ThumbnailGenerator::instance()
 {
   static ThumbnailGenerator* singleton = NULL;
@@ -140,12 +213,11 @@ ThumbnailGenerator* ThumbnailGenerator::instance()
 
 ThumbnailGenerator::WorkerStatus ThumbnailGenerator::getWorkerStatus(IFileItem* fileitem, double& progress)
 {
-  base::scoped_lock hold(m_workersAccess);
+  std::lock_guard<std::mutex> lock(m_mutex);
 
-  for (WorkerList::iterator
-         it=m_workers.begin(), end=m_workers.end(); it!=end; ++it) {
-    Worker* worker = *it;
-    if (worker->getFileItem() == fileitem) {
+  for (Worker* worker : m_workers) {
+    // Canceled workers don't count, they will be destroyed soon
+    if (worker->getFileItem() == fileitem && !worker->isStop()) {
       if (worker->isDone())
         return ThumbnailIsDone;
       else {
@@ -159,12 +231,12 @@ ThumbnailGenerator::WorkerStatus ThumbnailGenerator::getWorkerStatus(IFileItem*
 
 bool ThumbnailGenerator::checkWorkers()
 {
-  base::scoped_lock hold(m_workersAccess);
+  std::lock_guard<std::mutex> lock(m_mutex);
   bool doingWork = !m_workers.empty();
 
   for (WorkerList::iterator
          it=m_workers.begin(); it != m_workers.end(); ) {
-    if ((*it)->isDone()) {
+    if ((*it)->isDone() && !(*it)->isRunning()) {
       delete *it;
       it = m_workers.erase(it);
     }
@@ -176,55 +248,121 @@ bool ThumbnailGenerator::checkWorkers()
   return doingWork;
 }
 
-void ThumbnailGenerator::addWorkerToGenerateThumbnail(IFileItem* fileitem)
+void ThumbnailGenerator::addWorkerToGenerateThumbnail(IFileItem* fileitem, int priority)
 {
-  double progress;
-
   if (fileitem->isBrowsable() ||
-      fileitem->getThumbnail() != NULL ||
-      getWorkerStatus(fileitem, progress) != WithoutWorker)
+      fileitem->getThumbnail() != NULL)
     return;
 
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Worker* worker : m_workers) {
+      if (worker->getFileItem() == fileitem && !worker->isStop()) {
+        if (!worker->isRunning())
+          worker->setPriority(priority);
+        return;
+      }
+    }
+  }
+
   std::unique_ptr<FileOp> fop(
     FileOp::createLoadDocumentOperation(
       nullptr,
       fileitem->fileName().c_str(),
       FILE_LOAD_SEQUENCE_NONE |
-      FILE_LOAD_ONE_FRAME));
+      FILE_LOAD_THUMBNAIL));
   if (!fop)
     return;
 
   if (fop->hasError())
     return;
 
-  Worker* worker = new Worker(fop.release(), fileitem);
-  try {
-    base::scoped_lock hold(m_workersAccess);
+  fop->setThumbnailSize(MAX_THUMBNAIL_SIZE);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Start the threads the first time they're needed
+    if (m_threads.empty()) {
+      int n = MID(1, int(std::thread::hardware_concurrency())/2, 4);
+      for (int i=0; i<n; ++i)
+        m_threads.emplace_back(&ThumbnailGenerator::threadProc, this);
+    }
+
+    Worker* worker = new Worker(fop.release(), fileitem, m_cache.get(),
+                                priority, m_order++);
     m_workers.push_back(worker);
+    m_queue.push_back(worker);
   }
-  catch (...) {
-    delete worker;
-    throw;
-  }
+  m_queueCondition.notify_one();
+}
+
+void ThumbnailGenerator::stopWorkersExcept(const std::vector<IFileItem*>& fileitems)
+{
+  stopWorkers(&fileitems);
 }
 
 void ThumbnailGenerator::stopAllWorkers()
 {
-  base::thread* ptr = new base::thread(base::Bind<void>(&ThumbnailGenerator::stopAllWorkersBackground, this));
-  m_stopThread.reset(ptr);
+  stopWorkers(nullptr);
 }
 
-void ThumbnailGenerator::stopAllWorkersBackground()
+void ThumbnailGenerator::stopWorkers(const std::vector<IFileItem*>* except)
 {
-  WorkerList workersCopy;
-  {
-    base::scoped_lock hold(m_workersAccess);
-    workersCopy = m_workers;
-    m_workers.clear();
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (WorkerList::iterator
+         it=m_workers.begin(); it != m_workers.end(); ) {
+    Worker* worker = *it;
+    if (except &&
+        std::find(except->begin(), except->end(),
+                  worker->getFileItem()) != except->end()) {
+      ++it;
+      continue;
+    }
+
+    worker->stop();
+
+    // Running workers will finish as soon as possible, the others
+    // can be destroyed right now.
+    if (!worker->isRunning()) {
+      auto queueIt = std::find(m_queue.begin(), m_queue.end(), worker);
+      if (queueIt != m_queue.end())
+        m_queue.erase(queueIt);
+
+      delete worker;
+      it = m_workers.erase(it);
+    }
+    else
+      ++it;
   }
+}
+
+void ThumbnailGenerator::threadProc()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_queueCondition.wait(lock, [this]{
+      return m_shutdown || !m_queue.empty();
+    });
+    if (m_shutdown)
+      break;
+
+    auto it = std::min_element(
+      m_queue.begin(), m_queue.end(),
+      [](const Worker* a, const Worker* b) {
+        return a->goesBefore(b);
+      });
+    Worker* worker = *it;
+    m_queue.erase(it);
+    worker->setRunning(true);
 
-  for (auto it=workersCopy.begin(), end=workersCopy.end(); it!=end; ++it)
-    delete *it;
+    lock.unlock();
+    worker->run();
+    lock.lock();
+
+    worker->setRunning(false);
+  }
 }
 
 } // namespace app
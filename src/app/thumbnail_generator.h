@@ -7,27 +7,32 @@
 
 #pragma once
 
-#include "base/mutex.h"
-
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
-namespace base {
-  class thread;
-}
-
 namespace app {
   class IFileItem;
+  class ThumbnailCache;
 
+  // Generates thumbnails of files in a fixed number of background
+  // threads. Requests with higher priority are processed first.
   class ThumbnailGenerator {
   public:
     enum WorkerStatus { WithoutWorker, WorkingOnThumbnail, ThumbnailIsDone };
 
+    ThumbnailGenerator();
+    ~ThumbnailGenerator();
+
     static ThumbnailGenerator* instance();
 
-    // Generate a thumbnail for the given file-item.  It must be called
-    // from the GUI thread.
-    void addWorkerToGenerateThumbnail(IFileItem* fileitem);
+    // Generate a thumbnail for the given file-item. Items with higher
+    // priority are generated first (if the item is already waiting
+    // for a thread, its priority is updated). It must be called from
+    // the GUI thread.
+    void addWorkerToGenerateThumbnail(IFileItem* fileitem, int priority = 0);
 
     // Returns the status of the worker that is generating the thumbnail
     // for the given file.
@@ -35,23 +40,35 @@ namespace app {
 
     // Checks the status of workers. If there are workers that already
     // done its job, we've to destroy them. This function must be called
-    // from the GUI thread (because a thread is joint to it).
+    // from the GUI thread.
     // Returns true if there are workers generating thumbnails.
     bool checkWorkers();
 
+    // Cancels the thumbnails of all file-items that aren't in the
+    // given list (e.g. items that aren't visible anymore).
+    void stopWorkersExcept(const std::vector<IFileItem*>& fileitems);
+
     // Stops all workers generating thumbnails. This is an non-blocking
-    // operation. The cancelation of all workers is done in a background
-    // thread.
+    // operation, running workers are destroyed later by
+    // checkWorkers().
     void stopAllWorkers();
 
   private:
-    void stopAllWorkersBackground();
-
     class Worker;
     typedef std::vector<Worker*> WorkerList;
 
+    void threadProc();
+    void stopWorkers(const std::vector<IFileItem*>* except);
+
+    // All workers (waiting, running, or done)
     WorkerList m_workers;
-    base::mutex m_workersAccess;
-    std::unique_ptr<base::thread> m_stopThread;
+    // Workers waiting for a thread
+    WorkerList m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_queueCondition;
+    std::vector<std::thread> m_threads;
+    bool m_shutdown;
+    int m_order;
+    std::unique_ptr<ThumbnailCache> m_cache;
   };
 } // namespace app
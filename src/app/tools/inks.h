@@ -313,7 +313,7 @@ public:
 class SelectionInk : public Ink {
   bool m_modify_selection;
   Mask m_mask;
-  Rect m_maxBounds;
+  Mask m_shape;                 // Pixels drawn with the tool
 
 public:
   SelectionInk() { m_modify_selection = false; }
@@ -327,17 +327,7 @@ public:
 
   void inkHline(int x1, int y, int x2, ToolLoop* loop) override {
     if (m_modify_selection) {
-      int modifiers = int(loop->getModifiers());
-
-      if ((modifiers & (int(ToolLoopModifiers::kReplaceSelection) |
-                        int(ToolLoopModifiers::kAddSelection))) != 0) {
-        m_mask.add(gfx::Rect(x1, y, x2-x1+1, 1));
-      }
-      else if ((modifiers & int(ToolLoopModifiers::kSubtractSelection)) != 0) {
-        m_mask.subtract(gfx::Rect(x1, y, x2-x1+1, 1));
-      }
-
-      m_maxBounds |= gfx::Rect(x1, y, x2-x1+1, 1);
+      m_shape.add(gfx::Rect(x1, y, x2-x1+1, 1));
     }
     // TODO show the selection-preview with a XOR color or something like that
     else {
@@ -350,18 +340,24 @@ public:
     m_modify_selection = state;
 
     if (state) {
-      m_maxBounds = loop->getMask()->bounds();
-
-      m_mask.copyFrom(loop->getMask());
-      m_mask.freeze();
-      m_mask.reserve(loop->sprite()->bounds());
+      m_shape.freeze();
+      m_shape.reserve(loop->sprite()->bounds());
     }
     else {
-      // We can intersect the used bounds in inkHline() calls to
-      // reduce the shrink computation.
-      m_mask.intersect(m_maxBounds);
+      // Shrink the shape to the drawn pixels
+      m_shape.unfreeze();
 
-      m_mask.unfreeze();
+      // Add or subtract the whole shape to/from the selection
+      int modifiers = int(loop->getModifiers());
+      m_mask.copyFrom(loop->getMask());
+      if ((modifiers & (int(ToolLoopModifiers::kReplaceSelection) |
+                        int(ToolLoopModifiers::kAddSelection))) != 0) {
+        m_mask.add(m_shape);
+      }
+      else if ((modifiers & int(ToolLoopModifiers::kSubtractSelection)) != 0) {
+        m_mask.subtract(m_shape);
+      }
+      m_shape.clear();
 
       loop->setMask(&m_mask);
       loop->getDocument()->setTransformation(
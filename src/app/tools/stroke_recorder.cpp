@@ -0,0 +1,91 @@
+// LibreSprite | Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/tools/stroke_recorder.h"
+
+#include "base/exception.h"
+#include "base/fstream_path.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace app {
+namespace tools {
+
+// Each line of the file is "type x y pressure button", e.g.
+// "move 10 20 0.5 1"
+static const char* type_names[] = { "press", "move", "release" };
+
+static std::unique_ptr<std::ofstream> recording;
+
+void start_stroke_recording(const std::string& filename)
+{
+  recording.reset(new std::ofstream(FSTREAM_PATH(filename)));
+  if (!*recording) {
+    recording.reset();
+    throw base::Exception("Error creating file %s", filename.c_str());
+  }
+}
+
+void stop_stroke_recording()
+{
+  recording.reset();
+}
+
+bool is_recording_strokes()
+{
+  return (recording != nullptr);
+}
+
+void record_pointer(RecordedPointer::Type type, const Pointer& pointer)
+{
+  if (!recording)
+    return;
+
+  *recording << type_names[type] << ' '
+             << pointer.point().x << ' '
+             << pointer.point().y << ' '
+             << pointer.pressure() << ' '
+             << int(pointer.button()) << '\n';
+}
+
+RecordedPointers load_recorded_pointers(const std::string& filename)
+{
+  std::ifstream file(FSTREAM_PATH(filename));
+  if (!file)
+    throw base::Exception("Error loading file %s", filename.c_str());
+
+  RecordedPointers pointers;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream s(line);
+    std::string typeName;
+    gfx::Point pt;
+    float pressure = 0;
+    int button = 0;
+    if (!(s >> typeName >> pt.x >> pt.y >> pressure >> button))
+      continue;
+
+    for (int type=0; type<3; ++type) {
+      if (typeName == type_names[type]) {
+        pointers.push_back(
+          RecordedPointer{
+            RecordedPointer::Type(type),
+            Pointer(pt, Pointer::Button(button), pressure) });
+        break;
+      }
+    }
+  }
+  return pointers;
+}
+
+} // namespace tools
+} // namespace app
@@ -0,0 +1,42 @@
+// LibreSprite | Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "app/tools/pointer.h"
+
+#include <string>
+#include <vector>
+
+namespace app {
+  namespace tools {
+
+    // A pointer event received by a ToolLoopManager (the point is in
+    // sprite coordinates).
+    struct RecordedPointer {
+      enum Type { Press, Movement, Release };
+      Type type;
+      Pointer pointer;
+    };
+
+    typedef std::vector<RecordedPointer> RecordedPointers;
+
+    // Starts/stops saving all pointer events received by
+    // ToolLoopManagers in the given text file, so they can be replayed
+    // later (see replay_strokes()).
+    void start_stroke_recording(const std::string& filename);
+    void stop_stroke_recording();
+    bool is_recording_strokes();
+
+    // Called by ToolLoopManager
+    void record_pointer(RecordedPointer::Type type, const Pointer& pointer);
+
+    // Loads a file saved with start_stroke_recording(). Throws an
+    // exception if the file cannot be read.
+    RecordedPointers load_recorded_pointers(const std::string& filename);
+
+  } // namespace tools
+} // namespace app
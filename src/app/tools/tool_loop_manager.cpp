@@ -17,12 +17,14 @@
 #include "app/tools/ink.h"
 #include "app/tools/intertwine.h"
 #include "app/tools/point_shape.h"
+#include "app/tools/stroke_recorder.h"
 #include "app/tools/symmetry.h"
 #include "app/tools/tool_loop.h"
 #include "doc/image.h"
 #include "doc/primitives.h"
 #include "doc/sprite.h"
 #include "gfx/region.h"
+#include "ui/latency.h"
 
 #include <climits>
 
@@ -71,6 +73,7 @@ void ToolLoopManager::notifyToolLoopModifiersChange()
 void ToolLoopManager::pressButton(const Pointer& pointer)
 {
   m_lastPointer = pointer;
+  record_pointer(RecordedPointer::Press, pointer);
 
   if (isCanceled())
     return;
@@ -96,11 +99,14 @@ void ToolLoopManager::pressButton(const Pointer& pointer)
   m_toolLoop->updateStatusBar(statusText.c_str());
 
   doLoopStep(false);
+
+  ui::record_latency(ui::LatencyStage::Tool, ui::current_input_timestamp());
 }
 
 bool ToolLoopManager::releaseButton(const Pointer& pointer)
 {
   m_lastPointer = pointer;
+  record_pointer(RecordedPointer::Release, pointer);
 
   if (isCanceled())
     return false;
@@ -122,6 +128,7 @@ bool ToolLoopManager::releaseButton(const Pointer& pointer)
 void ToolLoopManager::movement(const Pointer& pointer)
 {
   m_lastPointer = pointer;
+  record_pointer(RecordedPointer::Movement, pointer);
 
   if (isCanceled())
     return;
@@ -140,6 +147,8 @@ void ToolLoopManager::movement(const Pointer& pointer)
   m_toolLoop->updateStatusBar(statusText.c_str());
 
   doLoopStep(false);
+
+  ui::record_latency(ui::LatencyStage::Tool, ui::current_input_timestamp());
 }
 
 void ToolLoopManager::doLoopStep(bool last_step)
@@ -16,6 +16,7 @@
 #include "app/cmd/clear_mask.h"
 #include "app/cmd/deselect_mask.h"
 #include "app/cmd/trim_cel.h"
+#include "app/cmd/unlink_cel.h"
 #include "app/commands/commands.h"
 #include "app/console.h"
 #include "app/context_access.h"
@@ -520,6 +521,8 @@ bool DocumentView::onClear(Context* ctx)
 
   {
     Transaction transaction(writer.context(), "Clear");
+    if (writer.cel()->isCopyOnWrite())
+      transaction.execute(new cmd::UnlinkCel(writer.cel()));
     transaction.execute(new cmd::ClearMask(writer.cel()));
 
     // If the cel wasn't deleted by cmd::ClearMask, we trim it.
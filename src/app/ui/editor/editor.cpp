@@ -37,6 +37,7 @@
 #include "app/ui/editor/moving_pixels_state.h"
 #include "app/ui/editor/pixels_movement.h"
 #include "app/ui/editor/play_state.h"
+#include "app/ui/editor/playback_buffer.h"
 #include "app/ui/editor/standby_state.h"
 #include "app/ui/main_window.h"
 #include "app/ui/skin/skin_theme.h"
@@ -168,6 +169,7 @@ Editor::Editor(Document* document, EditorFlags flags)
   , m_flags(flags)
   , m_secondaryButton(false)
   , m_aniSpeed(1.0)
+  , m_playbackBuffer(nullptr)
 {
   // Add the first state into the history.
   m_statesHistory.push(m_state);
@@ -196,7 +198,7 @@ Editor::Editor(Document* document, EditorFlags flags)
   m_gridConn = m_docPref.grid.AfterChange.connect(base::Bind<void>(&Editor::invalidate, this));
   m_pixelGridConn = m_docPref.pixelGrid.AfterChange.connect(base::Bind<void>(&Editor::invalidate, this));
   m_bgConn = m_docPref.bg.AfterChange.connect(base::Bind<void>(&Editor::invalidate, this));
-  m_onionskinConn = m_docPref.onionskin.AfterChange.connect(base::Bind<void>(&Editor::invalidate, this));
+  m_onionskinConn = m_docPref.onionskin.AfterChange.connect(base::Bind<void>(&Editor::onOnionskinChange, this));
   m_symmetryModeConn = Preferences::instance().symmetryMode.enabled.AfterChange.connect(base::Bind<void>(&Editor::invalidateIfActive, this));
   m_showExtrasConnDoc = m_docPref.show.AfterChange.connect(
       base::Bind<void>(&Editor::onShowExtrasChange, this));
@@ -469,32 +471,7 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g, const gfx::Rect& sprite
     // Create a temporary RGB bitmap to draw all to it
     rendered.reset(Image::create(IMAGE_RGB, rc.w, rc.h, m_renderBuffer));
     m_renderEngine.setupBackground(m_document, rendered->pixelFormat());
-    m_renderEngine.disableOnionskin();
-
-    if ((m_flags & kShowOnionskin) == kShowOnionskin) {
-      if (m_docPref.onionskin.active()) {
-        OnionskinOptions opts(
-          (m_docPref.onionskin.type() == app::gen::OnionskinType::MERGE ?
-           render::OnionskinType::MERGE:
-           (m_docPref.onionskin.type() == app::gen::OnionskinType::RED_BLUE_TINT ?
-            render::OnionskinType::RED_BLUE_TINT:
-            render::OnionskinType::NONE)));
-
-        opts.position(m_docPref.onionskin.position());
-        opts.prevFrames(m_docPref.onionskin.prevFrames());
-        opts.nextFrames(m_docPref.onionskin.nextFrames());
-        opts.opacityBase(m_docPref.onionskin.opacityBase());
-        opts.opacityStep(m_docPref.onionskin.opacityStep());
-        opts.layer(m_docPref.onionskin.currentLayer() ? m_layer: nullptr);
-
-        FrameTag* tag = nullptr;
-        if (m_docPref.onionskin.loopTag())
-          tag = m_sprite->frameTags().innerTag(m_frame);
-        opts.loopTag(tag);
-
-        m_renderEngine.setOnionskin(opts);
-      }
-    }
+    m_renderEngine.setOnionskin(onionskinOptions(m_frame));
 
     ExtraCelRef extraCel = m_document->extraCel();
     if (extraCel && extraCel->type() != render::ExtraType::NONE) {
@@ -506,8 +483,24 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g, const gfx::Rect& sprite
         m_layer, m_frame);
     }
 
-    m_renderEngine.renderSprite(rendered.get(), m_sprite, m_frame,
-      gfx::Clip(0, 0, rc), m_zoom);
+    // The frame was already rendered in background (while the
+    // animation is played), we only need to scale it.
+    const Image* playbackFrame =
+      (m_playbackBuffer ? m_playbackBuffer->frame(m_frame): nullptr);
+    if (playbackFrame) {
+      if (m_renderEngine.bgType() == render::BgType::CHECKED)
+        m_renderEngine.renderBackground(rendered.get(), gfx::Clip(0, 0, rc), m_zoom);
+      else
+        clear_image(rendered.get(), 0);
+
+      m_renderEngine.renderImage(rendered.get(), playbackFrame,
+        m_sprite->palette(m_frame), -rc.x, -rc.y, m_zoom,
+        255, BlendMode::NORMAL);
+    }
+    else {
+      m_renderEngine.renderSprite(rendered.get(), m_sprite, m_frame,
+        gfx::Clip(0, 0, rc), m_zoom);
+    }
 
     m_renderEngine.removeExtraImage();
   }
@@ -741,8 +734,15 @@ void Editor::drawMask(Graphics* g)
   int x = m_padding.x;
   int y = m_padding.y;
 
-  for (const auto& seg : *m_document->getMaskBoundaries()) {
-    CheckedDrawMode checked(g, m_antsOffset);
+  // Only segments in the clipping area are drawn (the area is
+  // enlarged one pixel because closed segments are drawn one pixel
+  // to the left/top).
+  gfx::Rect area = g->getClipBounds();
+  area.offset(-x, -y);
+  area = m_zoom.remove(area).enlarge(1);
+
+  CheckedDrawMode checked(g, m_antsOffset);
+  m_document->getMaskBoundaries()->forEachSegment(area, [&](const MaskBoundaries::Segment& seg) {
     gfx::Rect bounds = m_zoom.apply(seg.bounds());
 
     if (m_zoom.scale() >= 1.0) {
@@ -757,7 +757,7 @@ void Editor::drawMask(Graphics* g)
       g->drawVLine(gfx::rgba(0, 0, 0), x+bounds.x, y+bounds.y, bounds.h);
     else
       g->drawHLine(gfx::rgba(0, 0, 0), x+bounds.x, y+bounds.y, bounds.w);
-  }
+  });
 }
 
 void Editor::drawMaskSafe()
@@ -1395,6 +1395,24 @@ void Editor::onShowExtrasChange()
   invalidate();
 }
 
+// The cached onion skin frames of the sprite can be outdated after
+// modifying pixels directly (without creating a new image version).
+void Editor::onGeneralUpdate(doc::DocumentEvent& ev)
+{
+  if (m_sprite)
+    m_renderEngine.invalidateOnionskinCache(m_sprite);
+
+  // E.g. the visibility of a layer was changed from the timeline
+  if (m_playbackBuffer)
+    m_playbackBuffer->invalidate();
+}
+
+void Editor::onSpritePixelsModified(doc::DocumentEvent& ev)
+{
+  if (ev.sprite() == m_sprite)
+    m_renderEngine.invalidateOnionskinCache(ev.sprite(), ev.frame());
+}
+
 void Editor::onExposeSpritePixels(doc::DocumentEvent& ev)
 {
   if (m_state && ev.sprite() == m_sprite)
@@ -1601,6 +1619,48 @@ bool Editor::isPlaying() const
   return (dynamic_cast<PlayState*>(m_state.get()) != nullptr);
 }
 
+void Editor::setPlaybackBuffer(PlaybackBuffer* buffer)
+{
+  m_playbackBuffer = buffer;
+}
+
+void Editor::onOnionskinChange()
+{
+  if (m_playbackBuffer)
+    m_playbackBuffer->setOnionskin(onionskinOptions(m_frame),
+                                   m_docPref.onionskin.loopTag());
+  invalidate();
+}
+
+render::OnionskinOptions Editor::onionskinOptions(frame_t frame) const
+{
+  OnionskinOptions opts(render::OnionskinType::NONE);
+
+  if ((m_flags & kShowOnionskin) == kShowOnionskin &&
+      m_docPref.onionskin.active()) {
+    opts.type(
+      (m_docPref.onionskin.type() == app::gen::OnionskinType::MERGE ?
+       render::OnionskinType::MERGE:
+       (m_docPref.onionskin.type() == app::gen::OnionskinType::RED_BLUE_TINT ?
+        render::OnionskinType::RED_BLUE_TINT:
+        render::OnionskinType::NONE)));
+
+    opts.position(m_docPref.onionskin.position());
+    opts.prevFrames(m_docPref.onionskin.prevFrames());
+    opts.nextFrames(m_docPref.onionskin.nextFrames());
+    opts.opacityBase(m_docPref.onionskin.opacityBase());
+    opts.opacityStep(m_docPref.onionskin.opacityStep());
+    opts.layer(m_docPref.onionskin.currentLayer() ? m_layer: nullptr);
+
+    FrameTag* tag = nullptr;
+    if (m_docPref.onionskin.loopTag())
+      tag = m_sprite->frameTags().innerTag(frame);
+    opts.loopTag(tag);
+  }
+
+  return opts;
+}
+
 void Editor::showAnimationSpeedMultiplierPopup(Option<bool>& playOnce,
                                                bool withStopBehaviorOptions)
 {
@@ -48,6 +48,7 @@ namespace app {
   class Context;
   class DocumentView;
   class EditorCustomizationDelegate;
+  class PlaybackBuffer;
   class PixelsMovement;
 
   namespace tools {
@@ -204,6 +205,14 @@ namespace app {
     void stop();
     bool isPlaying() const;
 
+    // Frames rendered in background used while the animation is
+    // played (it can be nullptr).
+    void setPlaybackBuffer(PlaybackBuffer* buffer);
+
+    // Onion skin configuration of the document preferences to render
+    // the given frame (the type is NONE if it's disabled).
+    render::OnionskinOptions onionskinOptions(frame_t frame) const;
+
     // Shows a popup menu to change the editor animation speed.
     void showAnimationSpeedMultiplierPopup(Option<bool>& playOnce,
                                            bool withStopBehaviorOptions);
@@ -235,6 +244,9 @@ namespace app {
     void onFgColorChange();
     void onContextBarBrushChange();
     void onShowExtrasChange();
+    void onOnionskinChange();
+    void onGeneralUpdate(doc::DocumentEvent& ev) override;
+    void onSpritePixelsModified(doc::DocumentEvent& ev) override;
     void onExposeSpritePixels(doc::DocumentEvent& ev) override;
 
     // ActiveToolObserver impl
@@ -328,6 +340,8 @@ namespace app {
     // Animation speed multiplier.
     double m_aniSpeed;
 
+    PlaybackBuffer* m_playbackBuffer;
+
     static doc::ImageBufferPtr m_renderBuffer;
 
     // The render engine must be shared between all editors so when a
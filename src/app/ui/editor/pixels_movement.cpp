@@ -16,6 +16,7 @@
 #include "app/cmd/deselect_mask.h"
 #include "app/cmd/set_mask.h"
 #include "app/cmd/trim_cel.h"
+#include "app/cmd/unlink_cel.h"
 #include "app/console.h"
 #include "app/document.h"
 #include "app/document_api.h"
@@ -44,6 +45,17 @@
 
 namespace app {
 
+namespace {
+
+// Result of the background task that calculates the RotSprite
+// preview.
+struct RotSpritePreview {
+  std::shared_ptr<doc::algorithm::RotSpriteSource> source;
+  std::shared_ptr<Image> image;
+};
+
+} // anonymous namespace
+
 template<typename T>
 static inline const base::Vector2d<double> point2Vector(const gfx::PointT<T>& pt) {
   return base::Vector2d<double>(pt.x, pt.y);
@@ -68,6 +80,8 @@ PixelsMovement::PixelsMovement(
   , m_originalImage(Image::createCopy(moveThis))
   , m_opaque(false)
   , m_maskColor(m_sprite->transparentColor())
+  , m_rotSpritePreviewId(std::make_shared<int>(0))
+  , m_rotSpritePending(false)
 {
   Transformation transform(mask->bounds());
   set_pivot_from_preferences(transform);
@@ -126,6 +140,8 @@ PixelsMovement::PixelsMovement(
 
 PixelsMovement::~PixelsMovement()
 {
+  cancelRotSpritePreview();
+
   delete m_originalImage;
   delete m_initialMask;
   delete m_currentMask;
@@ -147,6 +163,10 @@ void PixelsMovement::flipImage(doc::algorithm::FlipType flipType)
     gfx::Rect(gfx::Point(0, 0), m_initialMask->bounds().size()),
     flipType);
 
+  // The scaled sources for RotSprite aren't valid anymore.
+  m_rotSpriteImage.reset();
+  m_rotSpriteMask.reset();
+
   {
     ContextWriter writer(m_reader, 1000);
 
@@ -179,6 +199,8 @@ void PixelsMovement::cutMask()
   {
     ContextWriter writer(m_reader, 1000);
     if (writer.cel()) {
+      if (writer.cel()->isCopyOnWrite())
+        m_transaction.execute(new cmd::UnlinkCel(writer.cel()));
       m_transaction.execute(new cmd::ClearMask(writer.cel()));
 
       ASSERT(writer.cel());
@@ -479,6 +501,14 @@ void PixelsMovement::getDraggedImageCopy(std::unique_ptr<Image>& outputImage,
 
 void PixelsMovement::stampImage()
 {
+  // If the extra cel is still showing the fast rotation (the
+  // RotSprite preview is not ready yet), we have to render the final
+  // image before we stamp it.
+  if (m_rotSpritePending) {
+    ContextWriter writer(m_reader, 1000);
+    redrawExtraImage();
+  }
+
   const Cel* cel = m_extraCel->cel();
   const Image* image = m_extraCel->image();
 
@@ -679,7 +709,20 @@ void PixelsMovement::drawImage(doc::Image* dst, const gfx::Point& pt, bool rende
   }
   m_originalImage->setMaskColor(maskColor);
 
-  drawParallelogram(dst, m_originalImage, m_initialMask, corners, pt);
+  tools::RotationAlgorithm rotAlgo = getRotationAlgorithm(m_originalImage);
+  if (renderOriginalLayer) {
+    cancelRotSpritePreview();
+
+    // While the user is dragging we show the fast rotation and the
+    // RotSprite version is calculated in background.
+    if (m_isDragging &&
+        rotAlgo == tools::RotationAlgorithm::ROTSPRITE) {
+      startRotSpritePreview(dst, corners, pt);
+      rotAlgo = tools::RotationAlgorithm::FAST;
+    }
+  }
+
+  drawParallelogram(dst, m_originalImage, m_initialMask, corners, pt, rotAlgo);
 }
 
 void PixelsMovement::drawMask(doc::Mask* mask, bool shrink)
@@ -695,7 +738,8 @@ void PixelsMovement::drawMask(doc::Mask* mask, bool shrink)
   drawParallelogram(mask->bitmap(),
                     m_initialMask->bitmap(),
                     nullptr,
-                    corners, bounds.origin());
+                    corners, bounds.origin(),
+                    getRotationAlgorithm(m_initialMask->bitmap()));
   if (shrink)
     mask->unfreeze();
 }
@@ -703,18 +747,9 @@ void PixelsMovement::drawMask(doc::Mask* mask, bool shrink)
 void PixelsMovement::drawParallelogram(
   doc::Image* dst, const doc::Image* src, const doc::Mask* mask,
   const Transformation::Corners& corners,
-  const gfx::Point& leftTop)
+  const gfx::Point& leftTop,
+  tools::RotationAlgorithm rotAlgo)
 {
-  tools::RotationAlgorithm rotAlgo = Preferences::instance().selection.rotationAlgorithm();
-
-  // If the angle and the scale weren't modified, we should use the
-  // fast rotation algorithm, as it's pixel-perfect match with the
-  // original selection when just a translation is applied.
-  if (m_currentData.angle() == 0.0 &&
-      gfx::Rect(m_currentData.bounds()).size() == src->size()) {
-    rotAlgo = tools::RotationAlgorithm::FAST;
-  }
-
 retry:;      // In case that we don't have enough memory for RotSprite
              // we can try with the fast algorithm anyway.
 
@@ -736,7 +771,7 @@ retry:;      // In case that we don't have enough memory for RotSprite
     case tools::RotationAlgorithm::ROTSPRITE:
       try {
         doc::algorithm::rotsprite_image(
-          dst, src, (mask ? mask->bitmap(): nullptr),
+          dst, *getRotSpriteSource(src, mask),
           int(corners.leftTop().x-leftTop.x),
           int(corners.leftTop().y-leftTop.y),
           int(corners.rightTop().x-leftTop.x),
@@ -758,6 +793,137 @@ retry:;      // In case that we don't have enough memory for RotSprite
   }
 }
 
+tools::RotationAlgorithm PixelsMovement::getRotationAlgorithm(const doc::Image* src) const
+{
+  // If the angle and the scale weren't modified, we should use the
+  // fast rotation algorithm, as it's pixel-perfect match with the
+  // original selection when just a translation is applied.
+  if (m_currentData.angle() == 0.0 &&
+      gfx::Rect(m_currentData.bounds()).size() == src->size()) {
+    return tools::RotationAlgorithm::FAST;
+  }
+
+  return Preferences::instance().selection.rotationAlgorithm();
+}
+
+std::shared_ptr<doc::algorithm::RotSpriteSource> PixelsMovement::getRotSpriteSource(
+  const doc::Image* src, const doc::Mask* mask)
+{
+  ASSERT(src == m_originalImage || src == m_initialMask->bitmap());
+
+  std::shared_ptr<doc::algorithm::RotSpriteSource>& source =
+    (src == m_originalImage ? m_rotSpriteImage: m_rotSpriteMask);
+
+  // The mask color of the original image changes depending on the
+  // "opaque" option, in that case we need a new scaled version.
+  if (!source || source->maskColor() != src->maskColor())
+    source = std::make_shared<doc::algorithm::RotSpriteSource>(
+      src, (mask ? mask->bitmap(): nullptr));
+
+  return source;
+}
+
+void PixelsMovement::startRotSpritePreview(
+  const doc::Image* dst,
+  const Transformation::Corners& corners,
+  const gfx::Point& leftTop)
+{
+  // Copy of the destination image with the original layer already
+  // rendered, the RotSprite result is drawn over it.
+  std::shared_ptr<Image> background(Image::createCopy(dst));
+
+  // If we don't have the scaled source yet, it's created in the
+  // background task from a copy of the original image/mask.
+  std::shared_ptr<doc::algorithm::RotSpriteSource> source;
+  std::shared_ptr<Image> original;
+  std::shared_ptr<Image> originalMask;
+  if (m_rotSpriteImage &&
+      m_rotSpriteImage->maskColor() == m_originalImage->maskColor()) {
+    source = m_rotSpriteImage;
+  }
+  else {
+    original.reset(Image::createCopy(m_originalImage));
+    originalMask.reset(Image::createCopy(m_initialMask->bitmap()));
+  }
+
+  const int x1 = int(corners.leftTop().x-leftTop.x);
+  const int y1 = int(corners.leftTop().y-leftTop.y);
+  const int x2 = int(corners.rightTop().x-leftTop.x);
+  const int y2 = int(corners.rightTop().y-leftTop.y);
+  const int x3 = int(corners.rightBottom().x-leftTop.x);
+  const int y3 = int(corners.rightBottom().y-leftTop.y);
+  const int x4 = int(corners.leftBottom().x-leftTop.x);
+  const int y4 = int(corners.leftBottom().y-leftTop.y);
+
+  const int previewId = ++(*m_rotSpritePreviewId);
+  std::weak_ptr<int> currentPreviewId(m_rotSpritePreviewId);
+  m_rotSpritePending = true;
+
+  m_rotSpriteTask = TaskManager::instance().addTask<RotSpritePreview>(
+    [=](std::atomic_bool& isAlive) -> RotSpritePreview {
+      RotSpritePreview result;
+      result.source = source;
+      if (!result.source && isAlive)
+        result.source = std::make_shared<doc::algorithm::RotSpriteSource>(
+          original.get(), originalMask.get());
+
+      // Only if the preview wasn't canceled in the meantime
+      if (result.source && isAlive) {
+        doc::algorithm::rotsprite_image(
+          background.get(), *result.source,
+          x1, y1, x2, y2, x3, y3, x4, y4);
+        result.image = background;
+      }
+
+      // Run this task just one time
+      isAlive = false;
+      return result;
+    },
+    [this, previewId, currentPreviewId](RotSpritePreview&& result) {
+      // This PixelsMovement was already destroyed
+      auto id = currentPreviewId.lock();
+      if (!id)
+        return;
+
+      // Keep the scaled source for next previews (even if this
+      // preview is too old to be displayed).
+      if (!m_rotSpriteImage &&
+          result.source &&
+          result.source->maskColor() == m_originalImage->maskColor()) {
+        m_rotSpriteImage = result.source;
+      }
+
+      if (*id != previewId || !result.image)
+        return;
+
+      try {
+        ContextWriter writer(m_reader, 1000);
+        Image* dst = m_extraCel->image();
+        ASSERT(dst->size() == result.image->size());
+        dst->copy(result.image.get(), gfx::Clip(dst->bounds()));
+        m_rotSpritePending = false;
+      }
+      catch (const LockedDocumentException&) {
+        // The document is being read from other thread. The preview
+        // is still pending, so it's rendered again in the next
+        // movement or when the image is stamped.
+        return;
+      }
+
+      m_document->notifySpritePixelsModified(
+        m_sprite, gfx::Region(getImageBounds()), m_site.frame());
+    });
+}
+
+void PixelsMovement::cancelRotSpritePreview()
+{
+  // Results of previous previews will be ignored
+  ++(*m_rotSpritePreviewId);
+  m_rotSpriteTask.abort();
+  m_rotSpriteTask = TaskHandle();
+  m_rotSpritePending = false;
+}
+
 void PixelsMovement::onPivotChange()
 {
   set_pivot_from_preferences(m_currentData);
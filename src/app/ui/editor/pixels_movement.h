@@ -9,6 +9,8 @@
 
 #include "app/context_access.h"
 #include "app/extra_cel.h"
+#include "app/task_manager.h"
+#include "app/tools/rotation_algorithm.h"
 #include "app/transaction.h"
 #include "app/ui/editor/handle_type.h"
 #include "base/connection.h"
@@ -17,10 +19,15 @@
 #include "doc/site.h"
 #include "gfx/size.h"
 
+#include <memory>
+
 namespace doc {
   class Image;
   class Mask;
   class Sprite;
+  namespace algorithm {
+    class RotSpriteSource;
+  }
 }
 
 namespace app {
@@ -102,8 +109,16 @@ namespace app {
     void drawImage(doc::Image* dst, const gfx::Point& pos, bool renderOriginalLayer);
     void drawMask(doc::Mask* dst, bool shrink);
     void drawParallelogram(doc::Image* dst, const doc::Image* src, const doc::Mask* mask,
+      const Transformation::Corners& corners,
+      const gfx::Point& leftTop,
+      tools::RotationAlgorithm rotAlgo);
+    tools::RotationAlgorithm getRotationAlgorithm(const doc::Image* src) const;
+    std::shared_ptr<doc::algorithm::RotSpriteSource> getRotSpriteSource(
+      const doc::Image* src, const doc::Mask* mask);
+    void startRotSpritePreview(const doc::Image* dst,
       const Transformation::Corners& corners,
       const gfx::Point& leftTop);
+    void cancelRotSpritePreview();
     void updateDocumentMask();
 
     const ContextReader m_reader;
@@ -128,6 +143,20 @@ namespace app {
     base::ScopedConnection m_pivotPosConn;
     base::ScopedConnection m_rotAlgoConn;
     ExtraCelRef m_extraCel;
+
+    // Scaled versions of m_originalImage and m_initialMask used by
+    // RotSprite. They are kept for the whole transformation (and
+    // discarded if the original image/mask is modified, e.g. flipped).
+    std::shared_ptr<doc::algorithm::RotSpriteSource> m_rotSpriteImage;
+    std::shared_ptr<doc::algorithm::RotSpriteSource> m_rotSpriteMask;
+
+    // While the user drags a handle, the RotSprite result is
+    // calculated in a background task and the extra cel shows the
+    // fast rotation until it's ready. m_rotSpritePreviewId identifies
+    // the last requested preview (older results are discarded).
+    TaskHandle m_rotSpriteTask;
+    std::shared_ptr<int> m_rotSpritePreviewId;
+    bool m_rotSpritePending;
   };
 
   inline PixelsMovement::MoveModifier& operator|=(PixelsMovement::MoveModifier& a,
@@ -28,6 +28,9 @@ namespace app {
 
 using namespace ui;
 
+// Memory used to render frames ahead of time
+static const std::size_t kPlaybackBufferSize = 128*1024*1024;
+
 PlayState::PlayState(bool playOnce)
   : m_editor(nullptr)
   , m_playOnce(playOnce)
@@ -77,6 +80,9 @@ void PlayState::onEnterState(Editor* editor)
   // running.
   if (!m_playTimer.isRunning())
     m_playTimer.start();
+
+  if (!m_buffer)
+    startPlaybackBuffer();
 }
 
 EditorState::LeaveAction PlayState::onLeaveState(Editor* editor, EditorState* newState)
@@ -88,6 +94,7 @@ EditorState::LeaveAction PlayState::onLeaveState(Editor* editor, EditorState* ne
     // We don't stop the timer if we are going to the ScrollingState
     // (we keep playing the animation).
     m_playTimer.stop();
+    stopPlaybackBuffer();
   }
   return KeepState;
 }
@@ -184,6 +191,8 @@ void PlayState::onPlaybackTick()
       m_pingPongForward);
 
     m_editor->setFrame(frame);
+    if (m_buffer)
+      m_buffer->seek(frame, m_pingPongForward);
     m_nextFrameTime += getNextFrameTime();
     m_editor->invalidate();
   }
@@ -220,6 +229,31 @@ void PlayState::onBeforeCommandExecution(CommandExecutionEvent& ev)
   m_editor->stop();
 }
 
+void PlayState::startPlaybackBuffer()
+{
+  doc::Sprite* sprite = m_editor->sprite();
+  if (sprite->totalFrames() < 2)
+    return;
+
+  m_buffer.reset(
+    PlaybackBuffer::create(
+      m_editor->document(),
+      m_editor->frame(),
+      get_animation_tag(sprite, m_refFrame),
+      m_editor->onionskinOptions(m_editor->frame()),
+      m_editor->docPref().onionskin.loopTag(),
+      kPlaybackBufferSize));
+
+  m_editor->setPlaybackBuffer(m_buffer.get());
+}
+
+void PlayState::stopPlaybackBuffer()
+{
+  if (m_editor)
+    m_editor->setPlaybackBuffer(nullptr);
+  m_buffer.reset();
+}
+
 double PlayState::getNextFrameTime()
 {
   return
@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include "app/ui/editor/playback_buffer.h"
 #include "app/ui/editor/state_with_wheel_behavior.h"
 #include "base/connection.h"
 #include "base/time.h"
 #include "doc/frame.h"
 #include "ui/timer.h"
 
+#include <memory>
+
 namespace app {
 
   class CommandExecutionEvent;
@@ -36,6 +39,8 @@ namespace app {
     void onBeforeCommandExecution(CommandExecutionEvent& ev);
 
     double getNextFrameTime();
+    void startPlaybackBuffer();
+    void stopPlaybackBuffer();
 
     Editor* m_editor;
     bool m_playOnce;
@@ -51,6 +56,9 @@ namespace app {
     doc::frame_t m_refFrame;
 
     base::ScopedConnection m_ctxConn;
+
+    // Next frames rendered in background
+    std::unique_ptr<PlaybackBuffer> m_buffer;
   };
 
 } // namespace app
@@ -0,0 +1,227 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/ui/editor/playback_buffer.h"
+
+#include "app/document.h"
+#include "app/document_access.h"
+#include "doc/frame_tag.h"
+#include "doc/frame_tags.h"
+#include "doc/handle_anidir.h"
+#include "doc/image.h"
+#include "doc/sprite.h"
+
+#include <algorithm>
+
+namespace app {
+
+using namespace doc;
+
+namespace {
+
+// Frames rendered ahead of time (more frames only use more memory)
+const int kMaxSlots = 64;
+const int kMaxThreads = 4;
+
+// Milliseconds to wait the document (e.g. if it's locked by a
+// background job)
+const int kLockTimeout = 500;
+
+} // anonymous namespace
+
+// static
+PlaybackBuffer* PlaybackBuffer::create(Document* document,
+                                       frame_t frame,
+                                       FrameTag* tag,
+                                       const render::OnionskinOptions& onionskin,
+                                       bool onionskinLoopTag,
+                                       std::size_t maxSize)
+{
+  const Sprite* sprite = document->sprite();
+  const std::size_t frameSize = std::size_t(sprite->width()) * sprite->height() * 4;
+  const int threads = std::clamp(int(std::thread::hardware_concurrency()) / 2, 1, kMaxThreads);
+
+  // Each thread renders in its own image, the rest of the memory is
+  // used for the ring.
+  const int slots = std::min(int(maxSize / std::max<std::size_t>(frameSize, 1)) - threads,
+                             kMaxSlots);
+  if (slots < 2)
+    return nullptr;
+
+  return new PlaybackBuffer(document, frame, tag, onionskin, onionskinLoopTag,
+                            slots, threads);
+}
+
+PlaybackBuffer::PlaybackBuffer(Document* document,
+                               frame_t frame,
+                               FrameTag* tag,
+                               const render::OnionskinOptions& onionskin,
+                               bool onionskinLoopTag,
+                               int slots, int threads)
+  : m_document(document)
+  , m_sprite(document->sprite())
+  , m_tag(tag)
+  , m_onionskin(onionskin)
+  , m_onionskinLoopTag(onionskinLoopTag)
+  , m_slots(slots)
+  , m_head(0)
+  , m_count(0)
+  , m_nextFrame(frame)
+  , m_pingPongForward(true)
+  , m_tickets(0)
+  , m_shutdown(false)
+{
+  for (int i=0; i<threads; ++i)
+    m_threads.emplace_back([this]{ threadProc(); });
+}
+
+PlaybackBuffer::~PlaybackBuffer()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_condition.notify_all();
+  }
+
+  for (auto& thread : m_threads)
+    thread.join();
+}
+
+void PlaybackBuffer::seek(frame_t frame, bool pingPongForward)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Discard the frames that were already shown (or skipped)
+  while (m_count > 0 && m_slots[m_head].frame != frame) {
+    m_head = (m_head+1) % m_slots.size();
+    --m_count;
+  }
+
+  // This frame isn't in the sequence
+  if (m_count == 0 &&
+      (m_nextFrame != frame || m_pingPongForward != pingPongForward))
+    restart(frame, pingPongForward);
+
+  m_condition.notify_all();
+}
+
+const Image* PlaybackBuffer::frame(frame_t frame)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_count == 0)
+    return nullptr;
+
+  const Slot& slot = m_slots[m_head];
+  return (slot.frame == frame && slot.ready ? slot.image.get(): nullptr);
+}
+
+void PlaybackBuffer::invalidate()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  restart(m_count > 0 ? m_slots[m_head].frame: m_nextFrame,
+          m_pingPongForward);
+  m_condition.notify_all();
+}
+
+void PlaybackBuffer::setOnionskin(const render::OnionskinOptions& onionskin,
+                                  bool onionskinLoopTag)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onionskin = onionskin;
+    m_onionskinLoopTag = onionskinLoopTag;
+  }
+  invalidate();
+}
+
+void PlaybackBuffer::restart(frame_t frame, bool pingPongForward)
+{
+  // Frames being rendered for the old sequence are ignored because
+  // their slots get new tickets.
+  m_count = 0;
+  m_nextFrame = frame;
+  m_pingPongForward = pingPongForward;
+}
+
+void PlaybackBuffer::threadProc()
+{
+  std::unique_ptr<Image> image;
+
+  // Each thread uses the same render::Render for all its frames.
+  render::Render render;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_shutdown) {
+    if (m_count == m_slots.size()) {
+      m_condition.wait(lock);
+      continue;
+    }
+    lock.unlock();
+
+    try {
+      // The document is locked before taking the next frame because
+      // the sequence depends on the sprite frames and the tag.
+      const DocumentReader reader(m_document, kLockTimeout);
+
+      lock.lock();
+      if (m_shutdown || m_count == m_slots.size())
+        continue;
+
+      // Take the next frame of the sequence
+      Slot& slot = m_slots[(m_head + m_count) % m_slots.size()];
+      const frame_t frame = m_nextFrame;
+      const uint64_t ticket = ++m_tickets;
+      slot.frame = frame;
+      slot.ticket = ticket;
+      slot.ready = false;
+      ++m_count;
+
+      m_nextFrame = calculate_next_frame(
+        m_sprite, m_nextFrame, frame_t(1), m_tag,
+        m_pingPongForward);
+
+      const render::OnionskinOptions onionskin = m_onionskin;
+      const bool onionskinLoopTag = m_onionskinLoopTag;
+      lock.unlock();
+
+      if (!image)
+        image.reset(Image::create(IMAGE_RGB, m_sprite->width(), m_sprite->height()));
+      renderFrame(render, onionskin, onionskinLoopTag, frame, image.get());
+
+      lock.lock();
+      if (slot.ticket == ticket) {
+        std::swap(slot.image, image);
+        slot.ready = true;
+      }
+    }
+    catch (const std::exception&) {
+      // The document is locked by other thread, or the frame couldn't
+      // be rendered (in this case the editor will render it).
+      if (!lock.owns_lock())
+        lock.lock();
+    }
+  }
+}
+
+void PlaybackBuffer::renderFrame(render::Render& render,
+                                 const render::OnionskinOptions& onionskin,
+                                 bool onionskinLoopTag,
+                                 frame_t frame, Image* image)
+{
+  render::OnionskinOptions opts = onionskin;
+  if (onionskinLoopTag)
+    opts.loopTag(m_sprite->frameTags().innerTag(frame));
+
+  render.setOnionskin(opts);
+  render.renderSprite(image, m_sprite, frame);
+}
+
+} // namespace app
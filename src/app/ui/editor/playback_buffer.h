@@ -0,0 +1,116 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "base/disable_copying.h"
+#include "doc/frame.h"
+#include "render/render.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace doc {
+  class FrameTag;
+  class Image;
+  class Sprite;
+}
+
+namespace app {
+  class Document;
+
+  // Renders the next frames of the animation in background threads
+  // while it's being played, so the editor only has to scale an image
+  // that is already rendered when the frame changes.
+  //
+  // Frames are rendered in the same order they are played (following
+  // the direction of the animation tag) in a ring of RGB images with
+  // a limited size. Each thread renders one frame at a time locking
+  // the document to read (the next frame of the sequence is
+  // calculated with the document locked too).
+  class PlaybackBuffer {
+  public:
+    // Returns nullptr if one frame doesn't fit in "maxSize" bytes.
+    static PlaybackBuffer* create(Document* document,
+                                  doc::frame_t frame,
+                                  doc::FrameTag* tag,
+                                  const render::OnionskinOptions& onionskin,
+                                  bool onionskinLoopTag,
+                                  std::size_t maxSize);
+    ~PlaybackBuffer();
+
+    // Called when the given frame is shown. The frames that were
+    // before it are discarded, and if the frame isn't in the sequence
+    // (e.g. the user changed the current frame) the buffer is
+    // restarted from it. It must be called from the GUI thread.
+    void seek(doc::frame_t frame, bool pingPongForward);
+
+    // Returns the rendered frame (without background), or nullptr if
+    // it isn't ready yet. It must be called from the GUI thread.
+    const doc::Image* frame(doc::frame_t frame);
+
+    // Discards the rendered frames (e.g. when the visibility of a
+    // layer changes) and renders them again from the next frame to
+    // be shown. It must be called from the GUI thread.
+    void invalidate();
+
+    // Changes the onion skin options and invalidates the frames.
+    void setOnionskin(const render::OnionskinOptions& onionskin,
+                      bool onionskinLoopTag);
+
+  private:
+    struct Slot {
+      doc::frame_t frame;
+      uint64_t ticket;
+      bool ready;
+      std::unique_ptr<doc::Image> image;
+    };
+
+    PlaybackBuffer(Document* document,
+                   doc::frame_t frame,
+                   doc::FrameTag* tag,
+                   const render::OnionskinOptions& onionskin,
+                   bool onionskinLoopTag,
+                   int slots, int threads);
+
+    void restart(doc::frame_t frame, bool pingPongForward);
+    void threadProc();
+    void renderFrame(render::Render& render,
+                     const render::OnionskinOptions& onionskin,
+                     bool onionskinLoopTag,
+                     doc::frame_t frame, doc::Image* image);
+
+    Document* m_document;
+    doc::Sprite* m_sprite;
+    doc::FrameTag* m_tag;
+    render::OnionskinOptions m_onionskin;
+    bool m_onionskinLoopTag;
+
+    std::vector<Slot> m_slots;
+    // Slot of the next frame to be shown
+    std::size_t m_head;
+    // Slots with a frame assigned (being rendered or ready)
+    std::size_t m_count;
+    // Next frame of the sequence to be assigned to a slot
+    doc::frame_t m_nextFrame;
+    bool m_pingPongForward;
+    uint64_t m_tickets;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::thread> m_threads;
+    bool m_shutdown;
+
+    DISABLE_COPYING(PlaybackBuffer);
+  };
+
+} // namespace app
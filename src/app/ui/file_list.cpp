@@ -331,11 +331,19 @@ void FileList::onPaint(ui::PaintEvent& ev)
 
   g->fillRect(theme->colors.background(), bounds);
 
+  View* view = View::getView(this);
+  gfx::Rect vp = (view ? view->viewportBounds(): gfx::Rect());
+  std::vector<IFileItem*> visibleItems;
+
   // rows
   m_thumbnail = nullptr;
   for (IFileItem* fi : m_list) {
     gfx::Size itemSize = getFileItemSize(fi);
 
+    if (vp.intersects(gfx::Rect(bounds.x, y, bounds.w, itemSize.h)
+                      .offset(this->bounds().origin())))
+      visibleItems.push_back(fi);
+
     if (fi == m_selected) {
       fgcolor = theme->colors.filelistSelectedRowText();
       bgcolor = theme->colors.filelistSelectedRowFace();
@@ -392,6 +400,13 @@ void FileList::onPaint(ui::PaintEvent& ev)
     evenRow ^= 1;
   }
 
+  // Generate thumbnails of the new visible items when the user stops
+  // scrolling
+  if (visibleItems != m_visibleItems) {
+    m_visibleItems = visibleItems;
+    m_generateThumbnailTimer.start();
+  }
+
   // Draw the thumbnail
   if (m_thumbnail) {
     gfx::Rect tbounds = thumbnailBounds();
@@ -464,9 +479,26 @@ void FileList::onGenerateThumbnailTick()
 {
   m_generateThumbnailTimer.stop();
 
+  ThumbnailGenerator* generator = ThumbnailGenerator::instance();
   IFileItem* fileitem = m_itemToGenerateThumbnail;
+
+  // Items that were scrolled away don't need a thumbnail now
+  std::vector<IFileItem*> items = m_visibleItems;
+  if (fileitem)
+    items.push_back(fileitem);
+  generator->stopWorkersExcept(items);
+
+  // The selected item goes first, then visible items from top to
+  // bottom
+  int priority = int(m_visibleItems.size());
   if (fileitem)
-    ThumbnailGenerator::instance()->addWorkerToGenerateThumbnail(fileitem);
+    generator->addWorkerToGenerateThumbnail(fileitem, priority);
+
+  for (IFileItem* fi : m_visibleItems) {
+    --priority;
+    if (!fi->isFolder())
+      generator->addWorkerToGenerateThumbnail(fi, priority);
+  }
 }
 
 gfx::Size FileList::getFileItemSize(IFileItem* fi) const
@@ -14,6 +14,7 @@
 #include "ui/widget.h"
 
 #include <string>
+#include <vector>
 
 namespace she {
   class Surface;
@@ -84,6 +85,10 @@ namespace app {
     // thumbnail to generate when the m_generateThumbnailTimer ticks.
     IFileItem* m_itemToGenerateThumbnail;
 
+    // Items that were visible in the last onPaint(). Their thumbnails
+    // are generated too (after the selected one).
+    std::vector<IFileItem*> m_visibleItems;
+
     she::Surface* m_thumbnail;
   };
 
@@ -20,6 +20,7 @@
 #include "app/console.h"
 #include "app/context_access.h"
 #include "app/document.h"
+#include "app/document_access.h"
 #include "app/document_api.h"
 #include "app/document_range_ops.h"
 #include "app/document_undo.h"
@@ -27,6 +28,7 @@
 #include "app/modules/editors.h"
 #include "app/modules/gfx.h"
 #include "app/modules/gui.h"
+#include "app/task_manager.h"
 #include "app/transaction.h"
 #include "app/ui/app_menuitem.h"
 #include "app/ui/configure_timeline_popup.h"
@@ -52,6 +54,7 @@
 #include "ui/ui.h"
 
 #include <cstdio>
+#include <vector>
 
 // Size of the thumbnail in the screen (width x height), the really
 // size of the thumbnail bitmap is specified in the
@@ -82,6 +85,12 @@ using namespace gfx;
 using namespace doc;
 using namespace ui;
 
+// Milliseconds to wait the document lock to change the visibility of
+// layers from the timeline, and number of times that it's tried again
+// later if the document is still locked.
+static const int kLayerFlagsLockTimeout = 250;
+static const int kLayerFlagsLockRetries = 4;
+
 enum {
   PART_NOTHING = 0,
   PART_TOP,
@@ -106,6 +115,43 @@ enum {
   PART_FRAME_TAG,
 };
 
+// Changes the visibility of the given layers. Layers can be read from
+// other threads (e.g. to render frames while the animation is
+// played), so if the document cannot be locked now, it's tried again
+// later instead of ignoring the click.
+static void set_layers_visibility(ObjectId docId,
+                                  const std::vector<ObjectId>& layers,
+                                  bool state, int retries)
+{
+  auto document = doc::get<app::Document>(docId);
+  if (!document)                // The document was closed
+    return;
+
+  try {
+    const DocumentWriter writer(document, kLayerFlagsLockTimeout);
+    for (ObjectId layerId : layers) {
+      if (auto layer = doc::get<Layer>(layerId))
+        layer->setVisible(state);
+    }
+  }
+  catch (const LockedDocumentException&) {
+    if (retries > 0) {
+      TaskManager::instance().delayed(
+        [docId, layers, state, retries]{
+          set_layers_visibility(docId, layers, state, retries-1);
+        });
+    }
+    else {
+      StatusBar::instance()->showTip(1000,
+        "The sprite is busy, try again");
+    }
+    return;
+  }
+
+  // Redraw all views.
+  document->notifyGeneralUpdate();
+}
+
 struct Timeline::DrawCelData {
   CelIterator begin;
   CelIterator end;
@@ -571,11 +617,12 @@ bool Timeline::onProcessMessage(Message* msg)
 
           case PART_HEADER_EYE: {
             bool newVisibleState = !allLayersVisible();
+            std::vector<ObjectId> layers;
             for (size_t i=0; i<m_layers.size(); i++)
-              m_layers[i]->setVisible(newVisibleState);
+              layers.push_back(m_layers[i]->id());
 
-            // Redraw all views.
-            m_document->notifyGeneralUpdate();
+            set_layers_visibility(m_document->id(), layers,
+                                  newVisibleState, kLayerFlagsLockRetries);
             break;
           }
 
@@ -658,10 +705,8 @@ bool Timeline::onProcessMessage(Message* msg)
             if (m_hot.layer == m_clk.layer && validLayer(m_hot.layer)) {
               Layer* layer = m_layers[m_clk.layer];
               ASSERT(layer != NULL);
-              layer->setVisible(!layer->isVisible());
-
-              // Redraw all views.
-              m_document->notifyGeneralUpdate();
+              set_layers_visibility(m_document->id(), { layer->id() },
+                                    !layer->isVisible(), kLayerFlagsLockRetries);
             }
             break;
 
@@ -9,103 +9,45 @@
 #include "config.h"
 #endif
 
-#include "doc/image.h"
-#include "doc/mask.h"
-#include "doc/sprite.h"
 #include "app/util/autocrop.h"
 
+#include "doc/algorithm/shrink_bounds.h"
+#include "doc/image.h"
+#include "gfx/rect.h"
+
 namespace app {
 
 using namespace doc;
 
+// Both functions use the row-major bounds finder of
+// doc::algorithm::shrink_bounds(), returning inclusive coordinates.
+
 bool get_shrink_rect(int *x1, int *y1, int *x2, int *y2,
                      Image *image, color_t refpixel)
 {
-#define SHRINK_SIDE(u_begin, u_op, u_final, u_add,              \
-                    v_begin, v_op, v_final, v_add, U, V, var)   \
-  do {                                                          \
-    for (u = u_begin; u u_op u_final; u u_add) {                \
-      for (v = v_begin; v v_op v_final; v v_add) {              \
-        if (image->getPixel(U, V) != refpixel)                  \
-          break;                                                \
-      }                                                         \
-      if (v == v_final)                                         \
-        var;                                                    \
-      else                                                      \
-        break;                                                  \
-    }                                                           \
-  } while (0)
-
-  int u, v;
-
-  *x1 = 0;
-  *y1 = 0;
-  *x2 = image->width()-1;
-  *y2 = image->height()-1;
-
-  SHRINK_SIDE(0, <, image->width(), ++,
-              0, <, image->height(), ++, u, v, (*x1)++);
-
-  SHRINK_SIDE(0, <, image->height(), ++,
-              0, <, image->width(), ++, v, u, (*y1)++);
-
-  SHRINK_SIDE(image->width()-1, >, 0, --,
-              0, <, image->height(), ++, u, v, (*x2)--);
-
-  SHRINK_SIDE(image->height()-1, >, 0, --,
-              0, <, image->width(), ++, v, u, (*y2)--);
-
-  if ((*x1 > *x2) || (*y1 > *y2))
+  gfx::Rect bounds;
+  if (!algorithm::shrink_bounds(image, bounds, refpixel))
     return false;
-  else
-    return true;
 
-#undef SHRINK_SIDE
+  *x1 = bounds.x;
+  *y1 = bounds.y;
+  *x2 = bounds.x2()-1;
+  *y2 = bounds.y2()-1;
+  return true;
 }
 
 bool get_shrink_rect2(int *x1, int *y1, int *x2, int *y2,
                       Image *image, Image *refimage)
 {
-#define SHRINK_SIDE(u_begin, u_op, u_final, u_add,              \
-                    v_begin, v_op, v_final, v_add, U, V, var)   \
-  do {                                                          \
-    for (u = u_begin; u u_op u_final; u u_add) {                \
-      for (v = v_begin; v v_op v_final; v v_add) {              \
-        if (image->getPixel(U, V) != refimage->getPixel(U, V))  \
-          break;                                                \
-      }                                                         \
-      if (v == v_final)                                         \
-        var;                                                    \
-      else                                                      \
-        break;                                                  \
-    }                                                           \
-  } while (0)
-
-  int u, v;
-
-  *x1 = 0;
-  *y1 = 0;
-  *x2 = image->width()-1;
-  *y2 = image->height()-1;
-
-  SHRINK_SIDE(0, <, image->width(), ++,
-              0, <, image->height(), ++, u, v, (*x1)++);
-
-  SHRINK_SIDE(0, <, image->height(), ++,
-              0, <, image->width(), ++, v, u, (*y1)++);
-
-  SHRINK_SIDE(image->width()-1, >, 0, --,
-              0, <, image->height(), ++, u, v, (*x2)--);
-
-  SHRINK_SIDE(image->height()-1, >, 0, --,
-              0, <, image->width(), ++, v, u, (*y2)--);
-
-  if ((*x1 > *x2) || (*y1 > *y2))
+  gfx::Rect bounds;
+  if (!algorithm::shrink_bounds2(image, refimage, image->bounds(), bounds))
     return false;
-  else
-    return true;
 
-#undef SHRINK_SIDE
+  *x1 = bounds.x;
+  *y1 = bounds.y;
+  *x2 = bounds.x2()-1;
+  *y2 = bounds.y2()-1;
+  return true;
 }
 
 } // namespace app
@@ -13,6 +13,7 @@
 #include "app/cmd/clear_mask.h"
 #include "app/cmd/deselect_mask.h"
 #include "app/cmd/trim_cel.h"
+#include "app/cmd/unlink_cel.h"
 #include "app/console.h"
 #include "app/context_access.h"
 #include "app/document.h"
@@ -222,6 +223,8 @@ void cut(ContextWriter& writer)
   else {
     {
       Transaction transaction(writer.context(), "Cut");
+      if (writer.cel()->isCopyOnWrite())
+        transaction.execute(new cmd::UnlinkCel(writer.cel()));
       transaction.execute(new cmd::ClearMask(writer.cel()));
 
       ASSERT(writer.cel());
@@ -16,6 +16,7 @@
 #include "app/cmd/clear_cel.h"
 #include "app/cmd/copy_region.h"
 #include "app/cmd/patch_cel.h"
+#include "app/cmd/unlink_cel.h"
 #include "app/context.h"
 #include "app/document.h"
 #include "app/transaction.h"
@@ -23,13 +24,20 @@
 #include "doc/algorithm/shrink_bounds.h"
 #include "doc/cel.h"
 #include "doc/image.h"
+#include "doc/images_diff.h"
 #include "doc/layer.h"
 #include "doc/primitives.h"
 #include "doc/site.h"
 #include "doc/sprite.h"
 
+#include <vector>
+
 namespace {
 
+// Modified pixels of a row separated by less than this number of
+// equal pixels are saved in the same rectangle of the undo patch.
+const int kPatchRegionGap = 8;
+
 // We cannot have two ExpandCelCanvas instances at the same time
 // (because we share ImageBuffers between them).
 static app::ExpandCelCanvas* singleton = nullptr;
@@ -46,7 +54,9 @@ static void destroy_buffers()
 static void create_buffers()
 {
   if (!src_buffer) {
-    app::App::instance()->Exit.connect(&destroy_buffers);
+    // There is no App in unit tests
+    if (app::App* app = app::App::instance())
+      app->Exit.connect(&destroy_buffers);
 
     src_buffer.reset(new doc::ImageBuffer(1));
     dst_buffer.reset(new doc::ImageBuffer(1));
@@ -117,6 +127,9 @@ ExpandCelCanvas::ExpandCelCanvas(
   // draw this cel).
   m_cel->setPosition(m_bounds.x, m_bounds.y);
 
+  m_validSrcTiles.reset(m_bounds.size());
+  m_validDstTiles.reset(m_bounds.size());
+
   if (m_celCreated) {
     getDestCanvas();
     m_cel->data()->setImage(m_dstImage);
@@ -182,28 +195,47 @@ void ExpandCelCanvas::commit()
 
     ASSERT(m_cel->image() == m_celImage.get());
 
-    gfx::Region* regionToPatch = &m_validDstRegion;
-    gfx::Region reduced;
+    // Only touched tiles are patched
+    std::vector<gfx::Rect> validRects = m_validDstTiles.validRects();
+    gfx::Region regionToPatch;
 
     if (m_canCompareSrcVsDst) {
-      ASSERT(gfx::Region().createSubtraction(m_validDstRegion, m_validSrcRegion).isEmpty());
+#ifdef _DEBUG
+      for (const gfx::Rect& rc : validRects)
+        m_validDstTiles.forEachTile(rc, [this](int tx, int ty, const gfx::Rect&) {
+          ASSERT(m_validSrcTiles.isValid(tx, ty));
+        });
+#endif
 
-      for (gfx::Rect rc : m_validDstRegion) {
-        if (algorithm::shrink_bounds2(getSourceCanvas(),
-                                      getDestCanvas(), rc, rc)) {
-          reduced |= gfx::Region(rc);
+      // Only the modified pixels are patched. Different pixels close
+      // to each other are saved in the same rectangle, as each
+      // rectangle has its own overhead in the undo history.
+      ImagesDiff diff(ImagesDiff::kRegion);
+      diff.setRegionGap(kPatchRegionGap);
+
+      std::vector<gfx::Rect> rects;
+      for (const gfx::Rect& rc : validRects) {
+        if (diff.compare(getSourceCanvas(), getDestCanvas(), rc)) {
+          for (const gfx::Rect& diffRc : diff.region())
+            rects.push_back(diffRc);
         }
       }
-
-      regionToPatch = &reduced;
+      regionToPatch = gfx::Region(rects);
     }
+    else
+      regionToPatch = gfx::Region(validRects);
+
+    // Identical cels that share the image to save memory must keep
+    // their pixels, so this cel gets its own copy of the image.
+    if (!regionToPatch.isEmpty() && m_cel->isCopyOnWrite())
+      m_transaction.execute(new cmd::UnlinkCel(m_cel));
 
     if (m_layer->isBackground()) {
       m_transaction.execute(
         new cmd::CopyRegion(
           m_cel->image(),
           m_dstImage.get(),
-          *regionToPatch,
+          regionToPatch,
           m_bounds.origin()));
     }
     else {
@@ -211,7 +243,7 @@ void ExpandCelCanvas::commit()
         new cmd::PatchCel(
           m_cel,
           m_dstImage.get(),
-          *regionToPatch,
+          regionToPatch,
           m_bounds.origin()));
     }
   }
@@ -268,101 +300,85 @@ void ExpandCelCanvas::validateSourceCanvas(const gfx::Region& rgn)
 {
   getSourceCanvas();
 
-  gfx::Region rgnToValidate(rgn);
-  rgnToValidate.offset(-m_bounds.origin());
-  rgnToValidate.createSubtraction(rgnToValidate, m_validSrcRegion);
-  rgnToValidate.createIntersection(rgnToValidate, gfx::Region(m_srcImage->bounds()));
-
-  if (m_celImage) {
-    gfx::Region rgnToClear;
-    rgnToClear.createSubtraction(rgnToValidate,
-      gfx::Region(m_celImage->bounds()
-        .offset(m_origCelPos)
-        .offset(-m_bounds.origin())));
-    for (const auto& rc : rgnToClear)
-      fill_rect(m_srcImage.get(), rc, m_srcImage->maskColor());
-
-    for (const auto& rc : rgnToValidate)
-      m_srcImage->copy(m_celImage.get(),
-        gfx::Clip(rc.x, rc.y,
-          rc.x+m_bounds.x-m_origCelPos.x,
-          rc.y+m_bounds.y-m_origCelPos.y, rc.w, rc.h));
-  }
-  else {
-    for (const auto& rc : rgnToValidate)
-      fill_rect(m_srcImage.get(), rc, m_srcImage->maskColor());
+  const gfx::Point celPos = m_origCelPos - m_bounds.origin();
+  for (gfx::Rect rc : rgn) {
+    rc.offset(-m_bounds.origin());
+    m_validSrcTiles.forEachTile(
+      rc, [this, &celPos](int tx, int ty, const gfx::Rect& tile) {
+        if (!m_validSrcTiles.isValid(tx, ty)) {
+          copyOriginalPixels(m_srcImage.get(), m_celImage.get(), celPos, tile);
+          m_validSrcTiles.setValid(tx, ty, true);
+        }
+      });
   }
-
-  m_validSrcRegion.createUnion(m_validSrcRegion, rgnToValidate);
 }
 
 void ExpandCelCanvas::validateDestCanvas(const gfx::Region& rgn)
 {
   Image* src;
-  int src_x, src_y;
+  gfx::Point srcPos;
   if ((m_flags & NeedsSource) == NeedsSource) {
     validateSourceCanvas(rgn);
     src = m_srcImage.get();
-    src_x = m_bounds.x;
-    src_y = m_bounds.y;
   }
   else {
     src = m_celImage.get();
-    src_x = m_origCelPos.x;
-    src_y = m_origCelPos.y;
+    srcPos = m_origCelPos - m_bounds.origin();
   }
 
   getDestCanvas();
 
-  gfx::Region rgnToValidate(rgn);
-  rgnToValidate.offset(-m_bounds.origin());
-  rgnToValidate.createSubtraction(rgnToValidate, m_validDstRegion);
-  rgnToValidate.createIntersection(rgnToValidate, gfx::Region(m_dstImage->bounds()));
-
-  if (src) {
-    gfx::Region rgnToClear;
-    rgnToClear.createSubtraction(rgnToValidate,
-      gfx::Region(src->bounds()
-        .offset(src_x, src_y)
-        .offset(-m_bounds.origin())));
-    for (const auto& rc : rgnToClear)
-      fill_rect(m_dstImage.get(), rc, m_dstImage->maskColor());
-
-    for (const auto& rc : rgnToValidate)
-      m_dstImage->copy(src,
-        gfx::Clip(rc.x, rc.y,
-          rc.x+m_bounds.x-src_x,
-          rc.y+m_bounds.y-src_y, rc.w, rc.h));
-  }
-  else {
-    for (const auto& rc : rgnToValidate)
-      fill_rect(m_dstImage.get(), rc, m_dstImage->maskColor());
+  for (gfx::Rect rc : rgn) {
+    rc.offset(-m_bounds.origin());
+    m_validDstTiles.forEachTile(
+      rc, [this, src, &srcPos](int tx, int ty, const gfx::Rect& tile) {
+        if (!m_validDstTiles.isValid(tx, ty)) {
+          copyOriginalPixels(m_dstImage.get(), src, srcPos, tile);
+          m_validDstTiles.setValid(tx, ty, true);
+        }
+      });
   }
-
-  m_validDstRegion.createUnion(m_validDstRegion, rgnToValidate);
 }
 
 void ExpandCelCanvas::invalidateDestCanvas()
 {
-  m_validDstRegion.clear();
+  m_validDstTiles.clear();
 }
 
 void ExpandCelCanvas::invalidateDestCanvas(const gfx::Region& rgn)
 {
-  gfx::Region rgnToInvalidate(rgn);
-  rgnToInvalidate.offset(-m_bounds.origin());
-  m_validDstRegion.createSubtraction(m_validDstRegion, rgnToInvalidate);
+  for (gfx::Rect rc : rgn) {
+    rc.offset(-m_bounds.origin());
+    m_validDstTiles.forEachTile(
+      rc, [this, &rc](int tx, int ty, const gfx::Rect& tile) {
+        if (!m_validDstTiles.isValid(tx, ty))
+          return;
+
+        // Tiles are invalidated only when they are completely
+        // inside the area, in other case the pixels of the area are
+        // restored right now (the rest of the tile is still valid).
+        if (rc.contains(tile))
+          m_validDstTiles.setValid(tx, ty, false);
+        else
+          restoreDestCanvas(rc.createIntersection(tile));
+      });
+  }
 }
 
 void ExpandCelCanvas::copyValidDestToSourceCanvas(const gfx::Region& rgn)
 {
-  gfx::Region rgn2(rgn);
-  rgn2.offset(-m_bounds.origin());
-  rgn2.createIntersection(rgn2, m_validSrcRegion);
-  rgn2.createIntersection(rgn2, m_validDstRegion);
-  for (const auto& rc : rgn2)
-    m_srcImage->copy(m_dstImage.get(),
-      gfx::Clip(rc.x, rc.y, rc.x, rc.y, rc.w, rc.h));
+  for (gfx::Rect rc : rgn) {
+    rc.offset(-m_bounds.origin());
+    m_validDstTiles.forEachTile(
+      rc, [this, &rc](int tx, int ty, const gfx::Rect& tile) {
+        if (m_validSrcTiles.isValid(tx, ty) &&
+            m_validDstTiles.isValid(tx, ty)) {
+          const gfx::Rect r = rc.createIntersection(tile);
+          m_srcImage->copy(m_dstImage.get(),
+            gfx::Clip(r.x, r.y, r.x, r.y, r.w, r.h));
+        }
+      });
+  }
 
   // We cannot compare src vs dst in this case (e.g. on tools like
   // spray and jumble that updated the source image form the modified
@@ -370,6 +386,39 @@ void ExpandCelCanvas::copyValidDestToSourceCanvas(const gfx::Region& rgn)
   m_canCompareSrcVsDst = false;
 }
 
+// Copies the pixels of the original cel image "src" (located at
+// "srcPos") to the given bounds of "dst". Pixels outside "src" are
+// cleared.
+void ExpandCelCanvas::copyOriginalPixels(Image* dst, const Image* src,
+                                         const gfx::Point& srcPos,
+                                         const gfx::Rect& bounds) const
+{
+  gfx::Rect srcBounds;
+  if (src)
+    srcBounds = bounds.createIntersection(
+      gfx::Rect(srcPos, src->size()));
+
+  if (srcBounds != bounds)
+    fill_rect(dst, bounds, dst->maskColor());
+
+  if (!srcBounds.isEmpty())
+    dst->copy(src,
+      gfx::Clip(srcBounds.x, srcBounds.y,
+                srcBounds.x-srcPos.x, srcBounds.y-srcPos.y,
+                srcBounds.w, srcBounds.h));
+}
+
+// Copies the original pixels in the given bounds of m_dstImage.
+void ExpandCelCanvas::restoreDestCanvas(const gfx::Rect& bounds)
+{
+  if ((m_flags & NeedsSource) == NeedsSource)
+    copyOriginalPixels(m_dstImage.get(), m_srcImage.get(),
+                       gfx::Point(0, 0), bounds);
+  else
+    copyOriginalPixels(m_dstImage.get(), m_celImage.get(),
+                       m_origCelPos - m_bounds.origin(), bounds);
+}
+
 gfx::Rect ExpandCelCanvas::getTrimDstImageBounds() const
 {
   if (m_layer->isBackground())
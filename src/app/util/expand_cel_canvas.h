@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "app/util/valid_tiles.h"
 #include "doc/frame.h"
 #include "doc/image_ref.h"
 #include "filters/tiled_mode.h"
@@ -71,6 +72,10 @@ namespace app {
   private:
     gfx::Rect getTrimDstImageBounds() const;
     ImageRef trimDstImage(const gfx::Rect& bounds) const;
+    void copyOriginalPixels(Image* dst, const Image* src,
+                            const gfx::Point& srcPos,
+                            const gfx::Rect& bounds) const;
+    void restoreDestCanvas(const gfx::Rect& bounds);
 
     Document* m_document;
     Sprite* m_sprite;
@@ -87,8 +92,11 @@ namespace app {
     bool m_closed;
     bool m_committed;
     Transaction& m_transaction;
-    gfx::Region m_validSrcRegion;
-    gfx::Region m_validDstRegion;
+
+    // Tiles of m_srcImage/m_dstImage that were already copied from
+    // the original cel.
+    ValidTiles m_validSrcTiles;
+    ValidTiles m_validDstTiles;
 
     // True if we can compare src image with dst image to patch the
     // cel. This is false when dst is copied to the src, so we cannot
@@ -0,0 +1,145 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#include "tests/test.h"
+
+#include "app/context.h"
+#include "app/document.h"
+#include "app/transaction.h"
+#include "app/util/expand_cel_canvas.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+#include "doc/test_context.h"
+#include "gfx/region.h"
+
+#include <memory>
+
+using namespace app;
+using namespace doc;
+
+typedef std::unique_ptr<app::Document> DocumentPtr;
+
+static const color_t kPainted = rgba(255, 255, 255, 255);
+
+static color_t original_color(int x, int y)
+{
+  return rgba(x, y, 128, 255);
+}
+
+// Checks that the pixels inside "restored" have the original color,
+// and the others are still painted.
+static void expect_restored(const Image* image, const gfx::Region& restored)
+{
+  int wrong = 0;
+  for (int y=0; y<image->height(); ++y) {
+    for (int x=0; x<image->width(); ++x) {
+      const color_t expected =
+        (restored.contains(gfx::Point(x, y)) ? original_color(x, y): kPainted);
+      if (get_pixel(image, x, y) != expected)
+        ++wrong;
+    }
+  }
+  EXPECT_EQ(0, wrong);
+}
+
+TEST(ExpandCelCanvas, InvalidatePartOfTiles)
+{
+  TestContextT<app::Context> ctx;
+  DocumentPtr doc(static_cast<app::Document*>(ctx.documents().add(64, 64)));
+  LayerImage* layer = static_cast<LayerImage*>(doc->sprite()->folder()->getFirstLayer());
+
+  Image* image = layer->cel(frame_t(0))->image();
+  for (int y=0; y<image->height(); ++y)
+    for (int x=0; x<image->width(); ++x)
+      put_pixel(image, x, y, original_color(x, y));
+
+  for (ExpandCelCanvas::Flags flags : { ExpandCelCanvas::None,
+                                        ExpandCelCanvas::NeedsSource }) {
+    Transaction transaction(&ctx, "");
+    ExpandCelCanvas expand(ctx.activeSite(), layer, TiledMode::NONE,
+                           transaction, flags);
+
+    // Paint all the canvas (2x2 tiles)
+    const gfx::Region all(gfx::Rect(0, 0, 64, 64));
+    expand.validateDestCanvas(all);
+    Image* dst = expand.getDestCanvas();
+    clear_image(dst, kPainted);
+
+    // Rectangle inside one tile, and other one that crosses two
+    // tiles: only the pixels inside them are restored (the rest of
+    // the tiles are still valid and keep the painted pixels)
+    gfx::Region restored;
+    restored |= gfx::Region(gfx::Rect(4, 6, 10, 8));
+    restored |= gfx::Region(gfx::Rect(20, 40, 20, 5));
+    expand.invalidateDestCanvas(restored);
+    expect_restored(dst, restored);
+
+    expand.validateDestCanvas(all);
+    expect_restored(dst, restored);
+
+    // A complete tile is invalidated, and it's restored when it's
+    // validated again
+    const gfx::Region tile(gfx::Rect(32, 0, 32, 32));
+    expand.invalidateDestCanvas(tile);
+    expand.validateDestCanvas(all);
+    restored |= tile;
+    expect_restored(dst, restored);
+
+    expand.rollback();
+  }
+}
+
+// Paints a rectangle in the cel of the first frame
+static void paint_first_frame(app::Context& ctx, LayerImage* layer)
+{
+  Transaction transaction(&ctx, "");
+  {
+    ExpandCelCanvas expand(ctx.activeSite(), layer, TiledMode::NONE,
+                           transaction, ExpandCelCanvas::None);
+    const gfx::Rect rc(2, 3, 10, 20);
+    expand.validateDestCanvas(gfx::Region(rc));
+    fill_rect(expand.getDestCanvas(), rc, kPainted);
+    expand.commit();
+  }
+  transaction.commit();
+}
+
+TEST(ExpandCelCanvas, UnlinkCopyOnWriteCels)
+{
+  for (bool copyOnWrite : { true, false }) {
+    TestContextT<app::Context> ctx;
+    DocumentPtr doc(static_cast<app::Document*>(ctx.documents().add(32, 32)));
+    Sprite* sprite = doc->sprite();
+    LayerImage* layer = static_cast<LayerImage*>(sprite->folder()->getFirstLayer());
+
+    auto cel0 = layer->cel(frame_t(0));
+    clear_image(cel0->image(), original_color(0, 0));
+
+    sprite->setTotalFrames(frame_t(2));
+    auto cel1 = Cel::createLink(cel0);
+    cel1->setFrame(frame_t(1));
+    layer->addCel(cel1);
+    cel0->data()->setCopyOnWrite(copyOnWrite);
+    EXPECT_EQ(copyOnWrite, cel0->isCopyOnWrite());
+
+    paint_first_frame(ctx, layer);
+    EXPECT_EQ(kPainted, get_pixel(cel0->image(), 2, 3));
+
+    if (copyOnWrite) {
+      // Only the painted cel is modified (it has its own image now)
+      EXPECT_NE(cel0->data(), cel1->data());
+      EXPECT_FALSE(cel0->isCopyOnWrite());
+      EXPECT_EQ(original_color(0, 0), get_pixel(cel1->image(), 2, 3));
+    }
+    else {
+      // Cels linked by the user are modified together
+      EXPECT_EQ(cel0->data(), cel1->data());
+      EXPECT_EQ(kPainted, get_pixel(cel1->image(), 2, 3));
+    }
+  }
+}
@@ -0,0 +1,297 @@
+// LibreSprite | Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/util/replay_strokes.h"
+
+#include "app/app.h"
+#include "app/color_target.h"
+#include "app/color_utils.h"
+#include "app/context.h"
+#include "app/document.h"
+#include "app/pref/preferences.h"
+#include "app/tools/controller.h"
+#include "app/tools/ink.h"
+#include "app/tools/intertwine.h"
+#include "app/tools/point_shape.h"
+#include "app/tools/tool.h"
+#include "app/tools/tool_box.h"
+#include "app/tools/tool_loop.h"
+#include "app/tools/tool_loop_manager.h"
+#include "app/transaction.h"
+#include "app/util/expand_cel_canvas.h"
+#include "base/exception.h"
+#include "doc/brush.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/mask.h"
+#include "doc/site.h"
+#include "doc/sprite.h"
+#include "render/render.h"
+
+#include <memory>
+
+namespace app {
+
+using namespace doc;
+
+namespace {
+
+// A tool loop to draw in the active site of a context without an
+// Editor. It's like the ToolLoopImpl of the Editor, but all the
+// settings come from the preferences.
+class HeadlessToolLoop : public tools::ToolLoop {
+  Context* m_context;
+  tools::Tool* m_tool;
+  Document* m_document;
+  Sprite* m_sprite;
+  Site m_site;
+  Layer* m_layer;
+  frame_t m_frame;
+  RgbMap* m_rgbMap;
+  DocumentPreferences& m_docPref;
+  ToolPreferences& m_toolPref;
+  BrushRef m_brush;
+  render::Zoom m_zoom;
+  tools::ToolLoop::Button m_button;
+  std::unique_ptr<tools::Ink> m_ink;
+  tools::Controller* m_controller;
+  tools::PointShape* m_pointShape;
+  tools::Intertwine* m_intertwine;
+  tools::TracePolicy m_tracePolicy;
+  ColorTarget m_colorTarget;
+  color_t m_fgColor;
+  color_t m_bgColor;
+  color_t m_primaryColor;
+  color_t m_secondaryColor;
+  gfx::Point m_celOrigin;
+  gfx::Point m_speed;
+  gfx::Region m_dirtyArea;
+  bool m_filled;
+  bool m_canceled;
+  Transaction m_transaction;
+  std::unique_ptr<ExpandCelCanvas> m_expandCelCanvas;
+
+public:
+  HeadlessToolLoop(Context* context, tools::Tool* tool)
+    : m_context(context)
+    , m_tool(tool)
+    , m_document(context->activeDocument())
+    , m_sprite(m_document->sprite())
+    , m_site(context->activeSite())
+    , m_layer(m_site.layer())
+    , m_frame(m_site.frame())
+    , m_rgbMap(nullptr)
+    , m_docPref(Preferences::instance().document(m_document))
+    , m_toolPref(Preferences::instance().tool(m_tool))
+    , m_brush(new Brush(static_cast<BrushType>(m_toolPref.brush.type()),
+                        m_toolPref.brush.size(),
+                        m_toolPref.brush.angle()))
+    , m_zoom(1, 1)
+    , m_button(tools::ToolLoop::Left)
+    , m_ink(m_tool->getInk(m_button)->clone())
+    , m_controller(m_tool->getController(m_button))
+    , m_pointShape(m_tool->getPointShape(m_button))
+    , m_intertwine(m_tool->getIntertwine(m_button))
+    , m_tracePolicy(m_tool->getTracePolicy(m_button))
+    , m_colorTarget(m_layer)
+    , m_fgColor(color_utils::color_for_target_mask(Preferences::instance().colorBar.fgColor(), m_colorTarget))
+    , m_bgColor(color_utils::color_for_target_mask(Preferences::instance().colorBar.bgColor(), m_colorTarget))
+    , m_primaryColor(m_fgColor)
+    , m_secondaryColor(m_bgColor)
+    , m_canceled(false)
+    , m_transaction(m_context, m_tool->getText().c_str(), ModifyDocument)
+  {
+    // Freehand tools use the default freehand algorithm
+    if (m_tracePolicy == tools::TracePolicy::Accumulate ||
+        m_tracePolicy == tools::TracePolicy::AccumulateUpdateLast) {
+      m_intertwine = App::instance()->toolBox()->getIntertwinerById(
+        tools::WellKnownIntertwiners::AsLines);
+      m_tracePolicy = tools::TracePolicy::Accumulate;
+    }
+
+    switch (m_tool->getFill(m_button)) {
+      case tools::FillNone: m_filled = false; break;
+      case tools::FillAlways: m_filled = true; break;
+      case tools::FillOptional: m_filled = m_toolPref.filled(); break;
+    }
+
+    m_expandCelCanvas.reset(new ExpandCelCanvas(
+      m_site, m_layer,
+      m_docPref.tiled.mode(),
+      m_transaction,
+      ExpandCelCanvas::Flags(
+        ExpandCelCanvas::NeedsSource |
+        (m_controller->isFreehand() ?
+         ExpandCelCanvas::UseModifiedRegionAsUndoInfo:
+         ExpandCelCanvas::None))));
+
+    m_celOrigin = m_expandCelCanvas->getCel()->position();
+  }
+
+  void dispose() override {
+    if (!m_canceled && m_ink->isPaint()) {
+      m_expandCelCanvas->commit();
+      m_transaction.commit();
+    }
+    else
+      m_expandCelCanvas->rollback();
+  }
+
+  tools::Tool* getTool() override { return m_tool; }
+  Brush* getBrush() override { return m_brush.get(); }
+  Document* getDocument() override { return m_document; }
+  Sprite* sprite() override { return m_sprite; }
+  Layer* getLayer() override { return m_layer; }
+  frame_t getFrame() override { return m_frame; }
+  const Image* getSrcImage() override { return m_expandCelCanvas->getSourceCanvas(); }
+  const Image* getFloodFillSrcImage() override { return getSrcImage(); }
+  Image* getDstImage() override { return m_expandCelCanvas->getDestCanvas(); }
+  void validateSrcImage(const gfx::Region& rgn) override {
+    m_expandCelCanvas->validateSourceCanvas(rgn);
+  }
+  void validateDstImage(const gfx::Region& rgn) override {
+    m_expandCelCanvas->validateDestCanvas(rgn);
+  }
+  void invalidateDstImage() override {
+    m_expandCelCanvas->invalidateDestCanvas();
+  }
+  void invalidateDstImage(const gfx::Region& rgn) override {
+    m_expandCelCanvas->invalidateDestCanvas(rgn);
+  }
+  void copyValidDstToSrcImage(const gfx::Region& rgn) override {
+    m_expandCelCanvas->copyValidDestToSourceCanvas(rgn);
+  }
+  RgbMap* getRgbMap() override {
+    if (!m_rgbMap)
+      m_rgbMap = m_sprite->rgbMap(m_frame);
+    return m_rgbMap;
+  }
+  bool useMask() override { return false; }
+  Mask* getMask() override { return m_document->mask(); }
+  void setMask(Mask* newMask) override { }
+  gfx::Point getMaskOrigin() override { return gfx::Point(0, 0); }
+  const render::Zoom& zoom() override { return m_zoom; }
+  Button getMouseButton() override { return m_button; }
+  color_t getFgColor() override { return m_fgColor; }
+  color_t getBgColor() override { return m_bgColor; }
+  color_t getPrimaryColor() override { return m_primaryColor; }
+  void setPrimaryColor(color_t color) override { m_primaryColor = color; }
+  color_t getSecondaryColor() override { return m_secondaryColor; }
+  void setSecondaryColor(color_t color) override { m_secondaryColor = color; }
+  int getOpacity() override { return m_toolPref.opacity(); }
+  int getTolerance() override { return m_toolPref.tolerance(); }
+  bool getContiguous() override { return m_toolPref.contiguous(); }
+  tools::ToolLoopModifiers getModifiers() override { return tools::ToolLoopModifiers::kNone; }
+  filters::TiledMode getTiledMode() override { return m_docPref.tiled.mode(); }
+  bool getGridVisible() override { return false; }
+  bool getSnapToGrid() override { return false; }
+  bool getStopAtGrid() override { return false; }
+  gfx::Rect getGridBounds() override { return m_docPref.grid.bounds(); }
+  bool getFilled() override { return m_filled; }
+  bool getPreviewFilled() override { return m_toolPref.filledPreview(); }
+  int getSprayWidth() override { return m_toolPref.spray.width(); }
+  int getSpraySpeed() override { return m_toolPref.spray.speed(); }
+  gfx::Point getCelOrigin() override { return m_celOrigin; }
+  void setSpeed(const gfx::Point& speed) override { m_speed = speed; }
+  gfx::Point getSpeed() override { return m_speed; }
+  tools::Ink* getInk() override { return m_ink.get(); }
+  tools::Controller* getController() override { return m_controller; }
+  tools::PointShape* getPointShape() override { return m_pointShape; }
+  tools::Intertwine* getIntertwine() override { return m_intertwine; }
+  tools::TracePolicy getTracePolicy() override { return m_tracePolicy; }
+  tools::Symmetry* getSymmetry() override { return nullptr; }
+  const Remap* getShadingRemap() override { return nullptr; }
+  void cancel() override { m_canceled = true; }
+  bool isCanceled() override { return m_canceled; }
+  gfx::Region& getDirtyArea() override { return m_dirtyArea; }
+  void updateDirtyArea() override { }
+  void updateStatusBar(const char* text) override { }
+};
+
+} // anonymous namespace
+
+ReplayStrokesStats replay_strokes(Context* ctx,
+                                  const tools::RecordedPointers& pointers,
+                                  const std::string& toolId)
+{
+  tools::Tool* tool = App::instance()->toolBox()->getToolById(toolId);
+  if (!tool)
+    throw base::Exception("Tool '%s' not found", toolId.c_str());
+
+  Site site = ctx->activeSite();
+  if (!site.document() || !site.layer() || !site.layer()->isImage())
+    throw base::Exception("An image layer is needed to replay strokes");
+
+  ReplayStrokesStats stats;
+  std::unique_ptr<HeadlessToolLoop> loop;
+  std::unique_ptr<tools::ToolLoopManager> manager;
+  render::Render render;
+  ImageRef screen;
+
+  const base::timestamp_t start = base::current_timestamp();
+
+  for (const auto& recorded : pointers) {
+    const base::timestamp_t t0 = base::current_timestamp();
+
+    switch (recorded.type) {
+      case tools::RecordedPointer::Press:
+        if (!loop) {
+          loop.reset(new HeadlessToolLoop(ctx, tool));
+          manager.reset(new tools::ToolLoopManager(loop.get()));
+          manager->prepareLoop(recorded.pointer);
+
+          // The destination image is the preview of the layer while
+          // we are drawing (like DrawingState does in the Editor)
+          render.setPreviewImage(
+            loop->getLayer(), loop->getFrame(),
+            loop->getDstImage(), loop->getCelOrigin(),
+            static_cast<LayerImage*>(loop->getLayer())->blendMode());
+          ++stats.strokes;
+        }
+        manager->pressButton(recorded.pointer);
+        break;
+      case tools::RecordedPointer::Movement:
+        if (manager)
+          manager->movement(recorded.pointer);
+        break;
+      case tools::RecordedPointer::Release:
+        if (manager && !manager->releaseButton(recorded.pointer)) {
+          render.removePreviewImage();
+          loop->dispose();
+          manager.reset();
+          loop.reset();
+        }
+        break;
+    }
+
+    // Render the modified area like the Editor would do
+    if (loop && !loop->getDirtyArea().isEmpty()) {
+      gfx::Rect bounds = loop->getDirtyArea().bounds();
+      if (!screen || screen->width() < bounds.w || screen->height() < bounds.h)
+        screen.reset(Image::create(IMAGE_RGB, bounds.w, bounds.h));
+      render.renderSprite(screen.get(), site.sprite(), site.frame(),
+                          gfx::Clip(0, 0, bounds));
+    }
+
+    stats.frames.add(base::current_timestamp() - t0);
+  }
+
+  // Finish an incomplete stroke
+  if (loop) {
+    render.removePreviewImage();
+    loop->dispose();
+  }
+
+  stats.total = base::current_timestamp() - start;
+  return stats;
+}
+
+} // namespace app
@@ -0,0 +1,34 @@
+// LibreSprite | Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "app/tools/stroke_recorder.h"
+#include "base/latency_histogram.h"
+
+#include <string>
+
+namespace app {
+  class Context;
+  class Document;
+
+  struct ReplayStrokesStats {
+    int strokes = 0;
+    base::timestamp_t total = 0;
+
+    // Time to process each pointer event (apply the tool and render
+    // the modified area) in microseconds.
+    base::LatencyHistogram frames;
+  };
+
+  // Replays recorded pointer events (see start_stroke_recording()) in
+  // the active layer/frame of the active document of the context,
+  // using the given tool (e.g. "pencil"), without a UI.
+  ReplayStrokesStats replay_strokes(Context* ctx,
+                                    const tools::RecordedPointers& pointers,
+                                    const std::string& toolId);
+
+} // namespace app
@@ -0,0 +1,94 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "gfx/point.h"
+#include "gfx/rect.h"
+#include "gfx/size.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace app {
+
+  // Bitmap with one bit for each tile of kTileSize x kTileSize pixels
+  // of an image, to know which parts of the image are valid (e.g.
+  // already copied from other image). Tiles are marked as valid one
+  // by one, so there is no region arithmetic involved.
+  class ValidTiles {
+  public:
+    enum { kTileSize = 32 };
+
+    ValidTiles() : m_cols(0), m_rows(0) { }
+
+    // Starts with all tiles invalid for an image of the given size.
+    void reset(const gfx::Size& size) {
+      m_size = size;
+      m_cols = (size.w + kTileSize - 1) / kTileSize;
+      m_rows = (size.h + kTileSize - 1) / kTileSize;
+      m_bits.assign(m_cols * m_rows, false);
+    }
+
+    // Invalidates all tiles.
+    void clear() {
+      std::fill(m_bits.begin(), m_bits.end(), false);
+    }
+
+    bool isValid(int tx, int ty) const {
+      return m_bits[ty*m_cols + tx];
+    }
+
+    void setValid(int tx, int ty, bool valid) {
+      m_bits[ty*m_cols + tx] = valid;
+    }
+
+    // Bounds of the tile (clipped to the image bounds).
+    gfx::Rect tileBounds(int tx, int ty) const {
+      return gfx::Rect(tx*kTileSize, ty*kTileSize, kTileSize, kTileSize)
+        .createIntersection(gfx::Rect(m_size));
+    }
+
+    // Calls func(tx, ty, tileBounds) for each tile that intersects
+    // the given rectangle.
+    template<typename Func>
+    void forEachTile(const gfx::Rect& bounds, Func func) const {
+      const gfx::Rect rc = bounds.createIntersection(gfx::Rect(m_size));
+      if (rc.isEmpty())
+        return;
+
+      for (int ty=rc.y/kTileSize; ty<=(rc.y2()-1)/kTileSize; ++ty)
+        for (int tx=rc.x/kTileSize; tx<=(rc.x2()-1)/kTileSize; ++tx)
+          func(tx, ty, tileBounds(tx, ty));
+    }
+
+    // Returns the valid area as rectangles (valid tiles of the same
+    // row are joined in one rectangle).
+    std::vector<gfx::Rect> validRects() const {
+      std::vector<gfx::Rect> rects;
+      for (int ty=0; ty<m_rows; ++ty) {
+        for (int tx=0; tx<m_cols; ++tx) {
+          if (!isValid(tx, ty))
+            continue;
+
+          const int begin = tx;
+          while (tx+1 < m_cols && isValid(tx+1, ty))
+            ++tx;
+
+          rects.push_back(tileBounds(begin, ty) | tileBounds(tx, ty));
+        }
+      }
+      return rects;
+    }
+
+  private:
+    gfx::Size m_size;
+    int m_cols, m_rows;
+    std::vector<bool> m_bits;
+  };
+
+} // namespace app
@@ -0,0 +1,141 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#include "tests/test.h"
+
+#include "app/util/valid_tiles.h"
+
+#include <vector>
+
+using namespace app;
+
+// 70x40 pixels: 3x2 tiles, the last column/row of tiles is smaller
+static const gfx::Size kSize(70, 40);
+
+TEST(ValidTiles, Reset)
+{
+  ValidTiles tiles;
+  tiles.reset(kSize);
+  for (int ty=0; ty<2; ++ty)
+    for (int tx=0; tx<3; ++tx)
+      EXPECT_FALSE(tiles.isValid(tx, ty));
+  EXPECT_TRUE(tiles.validRects().empty());
+}
+
+TEST(ValidTiles, TileBoundsAreClipped)
+{
+  ValidTiles tiles;
+  tiles.reset(kSize);
+  EXPECT_EQ(gfx::Rect(0, 0, 32, 32), tiles.tileBounds(0, 0));
+  EXPECT_EQ(gfx::Rect(64, 0, 6, 32), tiles.tileBounds(2, 0));
+  EXPECT_EQ(gfx::Rect(32, 32, 32, 8), tiles.tileBounds(1, 1));
+  EXPECT_EQ(gfx::Rect(64, 32, 6, 8), tiles.tileBounds(2, 1));
+}
+
+TEST(ValidTiles, ForEachTile)
+{
+  ValidTiles tiles;
+  tiles.reset(kSize);
+
+  struct Item {
+    int tx, ty;
+    gfx::Rect bounds;
+  };
+  std::vector<Item> items;
+  auto collect = [&items](int tx, int ty, const gfx::Rect& bounds) {
+    items.push_back(Item{ tx, ty, bounds });
+  };
+
+  // Rectangle that goes outside the image (it's clipped to the
+  // right/bottom edge tiles)
+  tiles.forEachTile(gfx::Rect(60, 30, 100, 100), collect);
+  ASSERT_EQ(4, int(items.size()));
+  EXPECT_EQ(1, items[0].tx); EXPECT_EQ(0, items[0].ty);
+  EXPECT_EQ(2, items[1].tx); EXPECT_EQ(0, items[1].ty);
+  EXPECT_EQ(1, items[2].tx); EXPECT_EQ(1, items[2].ty);
+  EXPECT_EQ(2, items[3].tx); EXPECT_EQ(1, items[3].ty);
+  EXPECT_EQ(gfx::Rect(64, 32, 6, 8), items[3].bounds);
+
+  // The last pixel of a tile doesn't touch the next tile
+  items.clear();
+  tiles.forEachTile(gfx::Rect(31, 31, 1, 1), collect);
+  ASSERT_EQ(1, int(items.size()));
+  EXPECT_EQ(0, items[0].tx); EXPECT_EQ(0, items[0].ty);
+
+  // The first pixel of a tile
+  items.clear();
+  tiles.forEachTile(gfx::Rect(32, 32, 1, 1), collect);
+  ASSERT_EQ(1, int(items.size()));
+  EXPECT_EQ(1, items[0].tx); EXPECT_EQ(1, items[0].ty);
+
+  // Negative coordinates are clipped too
+  items.clear();
+  tiles.forEachTile(gfx::Rect(-10, -10, 12, 12), collect);
+  ASSERT_EQ(1, int(items.size()));
+  EXPECT_EQ(0, items[0].tx); EXPECT_EQ(0, items[0].ty);
+
+  // Rectangles outside the image or empty
+  items.clear();
+  tiles.forEachTile(gfx::Rect(70, 0, 10, 10), collect);
+  tiles.forEachTile(gfx::Rect(0, -20, 10, 20), collect);
+  tiles.forEachTile(gfx::Rect(10, 10, 0, 0), collect);
+  EXPECT_TRUE(items.empty());
+}
+
+TEST(ValidTiles, ValidRectsJoinRows)
+{
+  ValidTiles tiles;
+  tiles.reset(kSize);
+
+  // First row: all tiles, second row: first and last tiles
+  tiles.setValid(0, 0, true);
+  tiles.setValid(1, 0, true);
+  tiles.setValid(2, 0, true);
+  tiles.setValid(0, 1, true);
+  tiles.setValid(2, 1, true);
+
+  std::vector<gfx::Rect> rects = tiles.validRects();
+  ASSERT_EQ(3, int(rects.size()));
+  EXPECT_EQ(gfx::Rect(0, 0, 70, 32), rects[0]);
+  EXPECT_EQ(gfx::Rect(0, 32, 32, 8), rects[1]);
+  EXPECT_EQ(gfx::Rect(64, 32, 6, 8), rects[2]);
+
+  // Rows aren't joined vertically
+  tiles.setValid(1, 1, true);
+  rects = tiles.validRects();
+  ASSERT_EQ(2, int(rects.size()));
+  EXPECT_EQ(gfx::Rect(0, 0, 70, 32), rects[0]);
+  EXPECT_EQ(gfx::Rect(0, 32, 70, 8), rects[1]);
+
+  tiles.setValid(1, 0, false);
+  rects = tiles.validRects();
+  ASSERT_EQ(3, int(rects.size()));
+  EXPECT_EQ(gfx::Rect(0, 0, 32, 32), rects[0]);
+  EXPECT_EQ(gfx::Rect(64, 0, 6, 32), rects[1]);
+  EXPECT_EQ(gfx::Rect(0, 32, 70, 8), rects[2]);
+}
+
+TEST(ValidTiles, Clear)
+{
+  ValidTiles tiles;
+  tiles.reset(kSize);
+  tiles.setValid(1, 0, true);
+  tiles.setValid(2, 1, true);
+  EXPECT_EQ(2, int(tiles.validRects().size()));
+
+  tiles.clear();
+  for (int ty=0; ty<2; ++ty)
+    for (int tx=0; tx<3; ++tx)
+      EXPECT_FALSE(tiles.isValid(tx, ty));
+  EXPECT_TRUE(tiles.validRects().empty());
+
+  // The size is the same after clear()
+  tiles.setValid(2, 1, true);
+  std::vector<gfx::Rect> rects = tiles.validRects();
+  ASSERT_EQ(1, int(rects.size()));
+  EXPECT_EQ(gfx::Rect(64, 32, 6, 8), rects[0]);
+}
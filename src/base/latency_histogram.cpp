@@ -0,0 +1,133 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "base/latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace base {
+
+namespace {
+
+// Values in [0, kSubBuckets) have their own bucket, the rest are
+// divided in kSubBuckets buckets for each power of two.
+const int kSubBits = 3;
+const int kSubBuckets = (1 << kSubBits);
+const int kMaxExponent = 40;    // ~12 days in microseconds
+const int kBuckets = kSubBuckets + (kMaxExponent - kSubBits + 1) * kSubBuckets;
+
+int bucket_index(timestamp_t value)
+{
+  if (value < kSubBuckets)
+    return int(std::max<timestamp_t>(0, value));
+
+  int exp = 63;
+  while (!(uint64_t(value) & (uint64_t(1) << exp)))
+    --exp;
+  if (exp > kMaxExponent)
+    return kBuckets-1;
+
+  int sub = int(value >> (exp - kSubBits)) & (kSubBuckets-1);
+  return kSubBuckets + (exp - kSubBits)*kSubBuckets + sub;
+}
+
+// Middle value of the given bucket
+timestamp_t bucket_value(int index)
+{
+  if (index < kSubBuckets)
+    return index;
+
+  int exp = (index - kSubBuckets) / kSubBuckets + kSubBits;
+  int sub = (index - kSubBuckets) % kSubBuckets;
+  timestamp_t width = timestamp_t(1) << (exp - kSubBits);
+  return timestamp_t(kSubBuckets + sub) * width + width/2;
+}
+
+std::string format_duration(timestamp_t us)
+{
+  char buf[32];
+  if (us < 1000)
+    std::snprintf(buf, sizeof(buf), "%dus", int(us));
+  else
+    std::snprintf(buf, sizeof(buf), "%.2fms", double(us) / 1000.0);
+  return buf;
+}
+
+} // anonymous namespace
+
+timestamp_t current_timestamp()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LatencyHistogram::LatencyHistogram()
+  : m_buckets(kBuckets, 0)
+{
+  reset();
+}
+
+void LatencyHistogram::add(timestamp_t value)
+{
+  value = std::max<timestamp_t>(0, value);
+
+  ++m_buckets[bucket_index(value)];
+  if (m_count == 0 || value < m_min) m_min = value;
+  if (m_count == 0 || value > m_max) m_max = value;
+  m_sum += double(value);
+  ++m_count;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(m_buckets.begin(), m_buckets.end(), 0);
+  m_count = 0;
+  m_min = 0;
+  m_max = 0;
+  m_sum = 0.0;
+}
+
+double LatencyHistogram::mean() const
+{
+  return (m_count > 0 ? m_sum / double(m_count): 0.0);
+}
+
+timestamp_t LatencyHistogram::percentile(double p) const
+{
+  if (m_count == 0)
+    return 0;
+
+  int64_t target = int64_t(std::ceil(std::clamp(p, 0.0, 1.0) * double(m_count)));
+  target = std::max<int64_t>(1, target);
+  if (target >= m_count)
+    return m_max;
+
+  int64_t accum = 0;
+  for (int i=0; i<kBuckets; ++i) {
+    accum += m_buckets[i];
+    if (accum >= target)
+      return std::clamp(bucket_value(i), m_min, m_max);
+  }
+  return m_max;
+}
+
+std::string LatencyHistogram::summary() const
+{
+  return
+    "n=" + std::to_string(m_count) +
+    " p50=" + format_duration(percentile(0.5)) +
+    " p99=" + format_duration(percentile(0.99)) +
+    " max=" + format_duration(m_max);
+}
+
+} // namespace base
@@ -0,0 +1,53 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace base {
+
+  // Microseconds from an unspecified point in time (it's a monotonic
+  // clock, so it can be used only to measure intervals).
+  typedef int64_t timestamp_t;
+
+  timestamp_t current_timestamp();
+
+  // Histogram of durations (in microseconds) to calculate
+  // percentiles. Values are grouped in logarithmic buckets (8 buckets
+  // for each power of two), so percentiles have an error of ~6% and
+  // adding a value is O(1) without allocating memory.
+  class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    void add(timestamp_t value);
+    void reset();
+
+    int64_t count() const { return m_count; }
+    timestamp_t min() const { return m_min; }
+    timestamp_t max() const { return m_max; }
+    double mean() const;
+
+    // Returns the approximated value below which the "p" fraction of
+    // values are (e.g. p=0.5 is the median, p=0.99 is the 99th
+    // percentile). Returns 0 if the histogram is empty.
+    timestamp_t percentile(double p) const;
+
+    // Returns a line of text like "n=10 p50=1.2ms p99=3.4ms max=3.5ms"
+    std::string summary() const;
+
+  private:
+    std::vector<int64_t> m_buckets;
+    int64_t m_count;
+    timestamp_t m_min;
+    timestamp_t m_max;
+    double m_sum;
+  };
+
+} // namespace base
@@ -0,0 +1,62 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "base/latency_histogram.h"
+
+using namespace base;
+
+TEST(LatencyHistogram, Empty)
+{
+  LatencyHistogram h;
+  EXPECT_EQ(0, h.count());
+  EXPECT_EQ(0, h.percentile(0.5));
+  EXPECT_EQ(0.0, h.mean());
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact)
+{
+  LatencyHistogram h;
+  for (int i=1; i<=5; ++i)
+    h.add(i);
+
+  EXPECT_EQ(5, h.count());
+  EXPECT_EQ(1, h.min());
+  EXPECT_EQ(5, h.max());
+  EXPECT_EQ(3.0, h.mean());
+  EXPECT_EQ(3, h.percentile(0.5));
+  EXPECT_EQ(5, h.percentile(1.0));
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+  LatencyHistogram h;
+  for (int i=1; i<=10000; ++i)
+    h.add(i);
+
+  EXPECT_NEAR(5000, h.percentile(0.5), 5000*0.07);
+  EXPECT_NEAR(9900, h.percentile(0.99), 9900*0.07);
+  EXPECT_EQ(10000, h.percentile(1.0));
+  EXPECT_EQ(1, h.percentile(0.0));
+}
+
+TEST(LatencyHistogram, Reset)
+{
+  LatencyHistogram h;
+  h.add(1000);
+  h.reset();
+  EXPECT_EQ(0, h.count());
+  h.add(20);
+  EXPECT_EQ(20, h.min());
+  EXPECT_EQ(20, h.max());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+  // Returns the number of threads that parallel_for() can use.
+  inline int parallel_for_threads() {
+    return std::max(1, int(std::thread::hardware_concurrency()));
+  }
+
+  namespace details {
+    // True in threads that are running chunks of a parallel_for()
+    inline thread_local bool inside_parallel_for = false;
+  }
+
+  // Divides the [begin, end) range in chunks of "grain" items and
+  // calls func(chunkBegin, chunkEnd) for each one of them using
+  // several threads (the calling thread is one of them). Chunks must
+  // be independent of each other. It returns when all chunks are
+  // processed. If func() throws, the first exception is rethrown in
+  // the calling thread (the remaining chunks are skipped).
+  //
+  // As chunks don't depend on the number of threads, the result of an
+  // algorithm that uses parallel_for() doesn't depend on the machine.
+  //
+  // Nested calls (a parallel_for() called from func()) process their
+  // chunks in the calling thread, so an algorithm that uses
+  // parallel_for() internally can be called from a parallel loop
+  // without creating more threads than cores.
+  template<typename Func>
+  void parallel_for(int begin, int end, int grain, const Func& func) {
+    if (begin >= end)
+      return;
+
+    grain = std::max(1, grain);
+    const int chunks = (end - begin + grain - 1) / grain;
+    const int nthreads = std::min(chunks, parallel_for_threads());
+
+    // Nothing to parallelize
+    if (nthreads == 1 || details::inside_parallel_for) {
+      for (int i=begin; i<end; i+=grain)
+        func(i, std::min(end, i + grain));
+      return;
+    }
+
+    std::atomic<int> nextChunk(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+      const bool wasInside = details::inside_parallel_for;
+      details::inside_parallel_for = true;
+
+      int chunk;
+      while ((chunk = nextChunk++) < chunks) {
+        const int chunkBegin = begin + chunk*grain;
+        const int chunkEnd = std::min(end, chunkBegin + grain);
+        try {
+          func(chunkBegin, chunkEnd);
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (!error)
+            error = std::current_exception();
+          nextChunk = chunks;
+        }
+      }
+
+      details::inside_parallel_for = wasInside;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads-1);
+    for (int i=0; i<nthreads-1; ++i)
+      threads.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : threads)
+      thread.join();
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+} // namespace base
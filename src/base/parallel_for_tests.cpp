@@ -0,0 +1,84 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "base/parallel_for.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+TEST(ParallelFor, EmptyRange)
+{
+  int calls = 0;
+  parallel_for(5, 5, 1, [&](int, int) { ++calls; });
+  EXPECT_EQ(0, calls);
+}
+
+TEST(ParallelFor, VisitsEachItemOnce)
+{
+  std::vector<std::atomic<int>> items(1000);
+  for (auto& item : items)
+    item = 0;
+
+  parallel_for(0, int(items.size()), 7, [&](int begin, int end) {
+    EXPECT_LE(end - begin, 7);
+    for (int i=begin; i<end; ++i)
+      ++items[i];
+  });
+
+  for (auto& item : items)
+    EXPECT_EQ(1, item);
+}
+
+TEST(ParallelFor, SingleChunk)
+{
+  int b = -1, e = -1;
+  parallel_for(3, 10, 100, [&](int begin, int end) {
+    b = begin;
+    e = end;
+  });
+  EXPECT_EQ(3, b);
+  EXPECT_EQ(10, e);
+}
+
+TEST(ParallelFor, RethrowsExceptions)
+{
+  EXPECT_THROW(
+    parallel_for(0, 100, 1, [](int begin, int) {
+      if (begin == 50)
+        throw std::runtime_error("error");
+    }),
+    std::runtime_error);
+}
+
+TEST(ParallelFor, NestedCallsUseCallingThread)
+{
+  std::vector<std::atomic<int>> items(64);
+  for (auto& item : items)
+    item = 0;
+
+  parallel_for(0, 8, 1, [&](int begin, int) {
+    const std::thread::id thread = std::this_thread::get_id();
+    parallel_for(begin*8, begin*8+8, 1, [&](int i, int) {
+      EXPECT_EQ(thread, std::this_thread::get_id());
+      ++items[i];
+    });
+  });
+
+  for (auto& item : items)
+    EXPECT_EQ(1, item);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
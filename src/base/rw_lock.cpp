@@ -0,0 +1,221 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "base/rw_lock.h"
+
+#include "base/debug.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace base {
+
+using namespace std::chrono;
+
+RWLock::RWLock()
+  : m_writeLock(false)
+  , m_upgrading(false)
+  , m_waitingReaders(0)
+  , m_waitingWriters(0)
+  , m_readersTurn(0)
+{
+}
+
+RWLock::~RWLock()
+{
+  ASSERT(!m_writeLock);
+  ASSERT(m_readers.empty());
+}
+
+bool RWLock::lock(LockType lockType, int timeout)
+{
+  const auto start = steady_clock::now();
+  const auto deadline = start + milliseconds(std::max(0, timeout));
+  const auto thread = std::this_thread::get_id();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  bool waited = false;
+
+  switch (lockType) {
+
+    case ReadLock: {
+      auto canRead = [&]{
+        if (m_writeLock)
+          return false;
+        // Nested read locks don't wait for other threads
+        if (isReader(thread))
+          return true;
+        if (m_upgrading)
+          return false;
+        return (m_readersTurn > 0 || m_waitingWriters == 0);
+      };
+
+      if (!canRead()) {
+        waited = true;
+        ++m_waitingReaders;
+        bool ok = m_condition.wait_until(lock, deadline, canRead);
+        --m_waitingReaders;
+
+        if (m_readersTurn > 0)
+          --m_readersTurn;
+        if (m_waitingReaders == 0)
+          m_readersTurn = 0;
+
+        if (!ok) {
+          addWait(waited, false, start);
+          m_condition.notify_all();
+          return false;
+        }
+      }
+
+      m_readers.push_back(thread);
+      break;
+    }
+
+    case WriteLock: {
+      auto canWrite = [&]{
+        return (!m_writeLock &&
+                !m_upgrading &&
+                m_readers.empty() &&
+                m_readersTurn == 0);
+      };
+
+      if (!canWrite()) {
+        waited = true;
+        ++m_waitingWriters;
+        bool ok = m_condition.wait_until(lock, deadline, canWrite);
+        --m_waitingWriters;
+
+        if (!ok) {
+          addWait(waited, false, start);
+          // Readers blocked by this writer can continue
+          m_condition.notify_all();
+          return false;
+        }
+      }
+
+      m_writeLock = true;
+      break;
+    }
+  }
+
+  addWait(waited, true, start);
+  return true;
+}
+
+bool RWLock::upgradeToWrite(int timeout)
+{
+  const auto start = steady_clock::now();
+  const auto deadline = start + milliseconds(std::max(0, timeout));
+  const auto thread = std::this_thread::get_id();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  ASSERT(!m_writeLock);
+  ASSERT(isReader(thread));
+
+  // Two threads waiting to upgrade would wait for each other
+  if (m_upgrading || m_writeLock || !isReader(thread)) {
+    addWait(false, false, start);
+    return false;
+  }
+
+  bool waited = false;
+  auto canUpgrade = [&]{ return (m_readers.size() == 1); };
+
+  if (!canUpgrade()) {
+    waited = true;
+    m_upgrading = true;
+    bool ok = m_condition.wait_until(lock, deadline, canUpgrade);
+    m_upgrading = false;
+
+    if (!ok) {
+      addWait(waited, false, start);
+      m_condition.notify_all();
+      return false;
+    }
+  }
+
+  m_readers.clear();
+  m_writeLock = true;
+  addWait(waited, true, start);
+  return true;
+}
+
+void RWLock::downgradeToRead()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ASSERT(m_writeLock);
+  ASSERT(m_readers.empty());
+
+  m_writeLock = false;
+  m_readers.push_back(std::this_thread::get_id());
+  m_readersTurn = m_waitingReaders;
+  m_condition.notify_all();
+}
+
+void RWLock::unlock()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_writeLock) {
+    m_writeLock = false;
+
+    // Readers that are waiting right now go before the next writer
+    m_readersTurn = m_waitingReaders;
+  }
+  else if (!m_readers.empty()) {
+    removeReader(std::this_thread::get_id());
+  }
+  else {
+    ASSERT(false);
+    return;
+  }
+
+  m_condition.notify_all();
+}
+
+RWLock::Stats RWLock::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+bool RWLock::isReader(std::thread::id thread) const
+{
+  return (std::find(m_readers.begin(), m_readers.end(), thread) != m_readers.end());
+}
+
+void RWLock::removeReader(std::thread::id thread)
+{
+  auto it = std::find(m_readers.begin(), m_readers.end(), thread);
+  // A read lock must be released by the thread that locked it (if
+  // not, we could remove the entry of another reader).
+  ASSERT(it != m_readers.end());
+  if (it != m_readers.end())
+    m_readers.erase(it);
+}
+
+void RWLock::addWait(bool waited, bool locked,
+                     steady_clock::time_point start)
+{
+  if (locked)
+    ++m_stats.locks;
+  else
+    ++m_stats.timeouts;
+
+  if (waited) {
+    uint64_t t = duration_cast<microseconds>(steady_clock::now() - start).count();
+    ++m_stats.contended;
+    m_stats.waitTime += t;
+    m_stats.maxWaitTime = std::max(m_stats.maxWaitTime, t);
+  }
+}
+
+} // namespace base
@@ -0,0 +1,88 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include "base/disable_copying.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+  // A readers/writer lock with timeouts. Several threads can read at
+  // the same time, but only one thread can write (and nobody can read
+  // while it's writing).
+  //
+  // It's fair: a waiting writer blocks new readers, and when a writer
+  // unlocks, all the readers that were waiting at that moment go
+  // before the next writer. A thread that already has a read lock can
+  // lock to read again without waiting for writers (so nested readers
+  // don't deadlock).
+  class RWLock {
+  public:
+    enum LockType {
+      ReadLock,
+      WriteLock
+    };
+
+    struct Stats {
+      uint64_t locks = 0;       // Successful locks (including upgrades)
+      uint64_t contended = 0;   // Locks that had to wait for other thread
+      uint64_t timeouts = 0;    // Locks that failed
+      uint64_t waitTime = 0;    // Total time waiting (microseconds)
+      uint64_t maxWaitTime = 0; // Longest wait (microseconds)
+    };
+
+    RWLock();
+    ~RWLock();
+
+    // Locks to read or write waiting up to "timeout" milliseconds
+    // (0 means don't wait). Returns false if it wasn't possible.
+    bool lock(LockType lockType, int timeout);
+
+    // Converts the read lock of the calling thread into a write lock
+    // waiting up to "timeout" milliseconds until all other readers
+    // unlock. While it waits new readers and writers are blocked. Only
+    // one thread can be upgrading at the same time (other threads
+    // fail immediately to avoid a deadlock).
+    bool upgradeToWrite(int timeout);
+
+    // Converts the write lock into a read lock.
+    void downgradeToRead();
+
+    // Releases a read lock or the write lock.
+    void unlock();
+
+    Stats stats() const;
+
+  private:
+    bool isReader(std::thread::id thread) const;
+    void removeReader(std::thread::id thread);
+    void addWait(bool waited, bool locked,
+                 std::chrono::steady_clock::time_point start);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_writeLock;
+    bool m_upgrading;
+    int m_waitingReaders;
+    int m_waitingWriters;
+    // Number of readers that can lock before waiting writers (readers
+    // that were waiting when the last writer unlocked).
+    int m_readersTurn;
+    // One entry for each read lock
+    std::vector<std::thread::id> m_readers;
+    Stats m_stats;
+
+    DISABLE_COPYING(RWLock);
+  };
+
+} // namespace base
@@ -0,0 +1,137 @@
+// LibreSprite Base Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "base/rw_lock.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+TEST(RWLock, ReadersAndWriters)
+{
+  RWLock a;
+  EXPECT_TRUE(a.lock(RWLock::ReadLock, 0));
+  EXPECT_TRUE(a.lock(RWLock::ReadLock, 0));
+  EXPECT_FALSE(a.lock(RWLock::WriteLock, 0));
+  a.unlock();
+  a.unlock();
+
+  EXPECT_TRUE(a.lock(RWLock::WriteLock, 0));
+  EXPECT_FALSE(a.lock(RWLock::ReadLock, 0));
+  EXPECT_FALSE(a.lock(RWLock::WriteLock, 0));
+  a.unlock();
+
+  RWLock::Stats stats = a.stats();
+  EXPECT_EQ(3, stats.locks);
+  EXPECT_EQ(3, stats.timeouts);
+}
+
+TEST(RWLock, UpgradeAndDowngrade)
+{
+  RWLock a;
+  EXPECT_TRUE(a.lock(RWLock::ReadLock, 0));
+  EXPECT_TRUE(a.upgradeToWrite(0));
+  EXPECT_FALSE(a.lock(RWLock::ReadLock, 0));
+  a.downgradeToRead();
+  EXPECT_TRUE(a.lock(RWLock::ReadLock, 0));
+  EXPECT_FALSE(a.upgradeToWrite(0)); // Two read locks
+  a.unlock();
+  a.unlock();
+}
+
+TEST(RWLock, WriterWakesUpWhenReadersUnlock)
+{
+  RWLock a;
+  ASSERT_TRUE(a.lock(RWLock::ReadLock, 0));
+
+  std::atomic<bool> locked(false);
+  std::thread writer([&]{
+    locked = a.lock(RWLock::WriteLock, 5000);
+    a.unlock();
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(locked);
+  a.unlock();
+  writer.join();
+  EXPECT_TRUE(locked);
+
+  RWLock::Stats stats = a.stats();
+  EXPECT_EQ(1, stats.contended);
+  // It didn't wait for a timer quantum after the unlock
+  EXPECT_LT(stats.maxWaitTime, 1000000);
+}
+
+TEST(RWLock, WaitingWriterBlocksNewReaders)
+{
+  RWLock a;
+  ASSERT_TRUE(a.lock(RWLock::ReadLock, 0));
+
+  std::thread writer([&]{
+    EXPECT_TRUE(a.lock(RWLock::WriteLock, 5000));
+    a.unlock();
+  });
+
+  // Give some time to the writer to start waiting
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Other thread cannot read now, but this thread (already a reader) can
+  std::thread reader([&]{
+    EXPECT_FALSE(a.lock(RWLock::ReadLock, 0));
+  });
+  reader.join();
+  EXPECT_TRUE(a.lock(RWLock::ReadLock, 0));
+  a.unlock();
+
+  a.unlock();
+  writer.join();
+}
+
+TEST(RWLock, Threads)
+{
+  RWLock a;
+  std::atomic<int> readers(0);
+  std::atomic<int> writers(0);
+  int value = 0;
+
+  std::vector<std::thread> threads;
+  for (int i=0; i<8; ++i) {
+    threads.emplace_back([&, i]{
+      for (int j=0; j<500; ++j) {
+        if ((i+j) % 4 == 0) {
+          ASSERT_TRUE(a.lock(RWLock::WriteLock, 10000));
+          EXPECT_EQ(0, readers);
+          EXPECT_EQ(1, ++writers);
+          ++value;
+          --writers;
+          a.unlock();
+        }
+        else {
+          ASSERT_TRUE(a.lock(RWLock::ReadLock, 10000));
+          ++readers;
+          EXPECT_EQ(0, writers);
+          --readers;
+          a.unlock();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(8*500/4, value);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
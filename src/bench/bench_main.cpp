@@ -0,0 +1,39 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// The "she" library defines the real main() (see tests/test.h). In
+// headless machines the SDL2 backend needs SDL_VIDEODRIVER=dummy.
+#ifdef LINKED_WITH_SHE
+  #define main app_main
+#endif
+
+// Results are printed as JSON by default (so they can be compared
+// between releases). The format can be changed with the
+// --benchmark_format and --benchmark_out_format options.
+int main(int argc, char* argv[])
+{
+  std::vector<char*> args(argv, argv+argc);
+  char jsonFormat[] = "--benchmark_format=json";
+  args.insert(args.begin()+1, jsonFormat);
+
+  int nargs = int(args.size());
+  benchmark::Initialize(&nargs, &args[0]);
+  if (benchmark::ReportUnrecognizedArguments(nargs, &args[0]))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
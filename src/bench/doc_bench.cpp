@@ -0,0 +1,135 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include "bench/synthetic.h"
+#include "doc/algorithm/floodfill.h"
+#include "doc/algorithm/resize_image.h"
+#include "doc/algorithm/rotsprite.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+#include "gfx/rect.h"
+
+#include <cmath>
+#include <memory>
+
+using namespace doc;
+
+namespace {
+
+// Resizes a 256x256 image to the given percentage of its size.
+void BM_ResizeImage(benchmark::State& state)
+{
+  const auto method = algorithm::ResizeMethod(state.range(0));
+  const int size = 256 * int(state.range(1)) / 100;
+  ImageRef src = bench::create_synthetic_image(IMAGE_RGB, 256, 256, 1);
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, size, size));
+
+  for (auto _ : state) {
+    algorithm::resize_image(src.get(), dst.get(), method,
+                            nullptr, nullptr, -1);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+// Corners of a size x size image rotated around the center of the
+// destination image.
+void rotated_corners(int size, int dstSize, double angle, int corners[8])
+{
+  const double c = std::cos(angle);
+  const double s = std::sin(angle);
+  const double h = size / 2.0;
+  const double pts[4][2] = { { -h, -h }, { h, -h }, { h, h }, { -h, h } };
+  for (int i=0; i<4; ++i) {
+    corners[i*2  ] = int(dstSize/2.0 + pts[i][0]*c - pts[i][1]*s);
+    corners[i*2+1] = int(dstSize/2.0 + pts[i][0]*s + pts[i][1]*c);
+  }
+}
+
+// Rotates a size x size image 30 degrees. With "reuse" the scaled
+// source is created only one time (like the transformation of a
+// selection while the user drags a handle).
+void BM_RotSprite(benchmark::State& state)
+{
+  const int size = int(state.range(0));
+  const bool reuse = (state.range(1) != 0);
+  const int dstSize = size * 3 / 2;
+  ImageRef src = bench::create_synthetic_image(IMAGE_RGB, size, size, 1);
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, dstSize, dstSize));
+  std::unique_ptr<algorithm::RotSpriteSource> source;
+  if (reuse)
+    source.reset(new algorithm::RotSpriteSource(src.get(), nullptr));
+
+  int p[8];
+  rotated_corners(size, dstSize, 3.14159265358979 / 6.0, p);
+
+  for (auto _ : state) {
+    clear_image(dst.get(), 0);
+    if (source)
+      algorithm::rotsprite_image(dst.get(), *source,
+                                 p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+    else
+      algorithm::rotsprite_image(dst.get(), src.get(), nullptr,
+                                 p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * dstSize * dstSize);
+}
+
+void count_hline(int x1, int y, int x2, void* data)
+{
+  *((int*)data) += x2 - x1 + 1;
+}
+
+// Fills the transparent background of a 1024x1024 synthetic image.
+void BM_FloodFill(benchmark::State& state)
+{
+  const bool contiguous = (state.range(0) != 0);
+  ImageRef image = bench::create_synthetic_image(IMAGE_RGB, 1024, 1024, 1);
+  int pixels = 0;
+
+  for (auto _ : state) {
+    pixels = 0;
+    algorithm::floodfill(image.get(), nullptr, 0, 0, image->bounds(),
+                         0, contiguous, &pixels, count_hline);
+    benchmark::DoNotOptimize(pixels);
+  }
+
+  state.counters["pixels"] = pixels;
+  state.SetItemsProcessed(state.iterations() * pixels);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_ResizeImage)
+  ->ArgNames({ "method", "percent" })
+  ->ArgsProduct({ { algorithm::RESIZE_METHOD_NEAREST_NEIGHBOR,
+                    algorithm::RESIZE_METHOD_BILINEAR },
+                  { 50, 200, 400 } })
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ResizeImage)
+  ->ArgNames({ "method", "percent" })
+  ->ArgsProduct({ { algorithm::RESIZE_METHOD_ROTSPRITE },
+                  { 50, 200 } })
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_RotSprite)
+  ->ArgNames({ "size", "reuse" })
+  ->ArgsProduct({ { 64, 256 }, { 0, 1 } })
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_FloodFill)
+  ->ArgName("contiguous")->Arg(1)->Arg(0)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,134 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include "app/context.h"
+#include "app/document.h"
+#include "app/file/file.h"
+#include "base/fs.h"
+#include "base/path.h"
+#include "bench/synthetic.h"
+#include "doc/sprite.h"
+
+#include <memory>
+#include <string>
+
+using namespace doc;
+
+namespace {
+
+struct FileCase {
+  const char* extension;
+  PixelFormat format;
+  int frames;
+};
+
+// Each case is saved/loaded with a 256x256 sprite with 4 layers
+const FileCase kFileCases[] = {
+  { "ase", IMAGE_RGB, 8 },
+  { "ase", IMAGE_INDEXED, 8 },
+  { "png", IMAGE_RGB, 1 },
+  { "png", IMAGE_INDEXED, 1 },
+  { "gif", IMAGE_INDEXED, 8 },
+  { "gif", IMAGE_RGB, 8 },      // Colors are quantized on save
+};
+
+const int kFileCases_size = int(sizeof(kFileCases) / sizeof(kFileCases[0]));
+
+const char* format_name(PixelFormat format)
+{
+  switch (format) {
+    case IMAGE_RGB: return "rgb";
+    case IMAGE_GRAYSCALE: return "grayscale";
+    case IMAGE_INDEXED: return "indexed";
+    case IMAGE_BITMAP: return "bitmap";
+  }
+  return "";
+}
+
+std::string case_label(const FileCase& c)
+{
+  return std::string(c.extension) + "/" + format_name(c.format)
+    + "/" + std::to_string(c.frames) + " frames";
+}
+
+std::string case_filename(const FileCase& c)
+{
+  return base::join_path(base::get_temp_path(),
+                         std::string("libresprite-bench-")
+                         + format_name(c.format) + "." + c.extension);
+}
+
+std::unique_ptr<app::Document> create_document(const FileCase& c)
+{
+  std::unique_ptr<app::Document> doc(
+    new app::Document(
+      bench::create_synthetic_sprite(c.format, 256, 256, 4, c.frames)));
+  doc->setFilename(case_filename(c));
+  return doc;
+}
+
+void BM_SaveDocument(benchmark::State& state)
+{
+  const FileCase& c = kFileCases[state.range(0)];
+  app::Context ctx;
+  std::unique_ptr<app::Document> doc = create_document(c);
+
+  for (auto _ : state) {
+    if (app::save_document(&ctx, doc.get()) != 0) {
+      state.SkipWithError("Error saving the file");
+      break;
+    }
+  }
+
+  state.SetLabel(case_label(c));
+  state.SetBytesProcessed(state.iterations() * base::file_size(doc->filename()));
+  base::delete_file(doc->filename());
+}
+
+void BM_LoadDocument(benchmark::State& state)
+{
+  const FileCase& c = kFileCases[state.range(0)];
+  app::Context ctx;
+  std::string filename;
+  {
+    std::unique_ptr<app::Document> doc = create_document(c);
+    if (app::save_document(&ctx, doc.get()) != 0) {
+      state.SkipWithError("Error saving the file");
+      return;
+    }
+    filename = doc->filename();
+  }
+
+  for (auto _ : state) {
+    std::unique_ptr<app::Document> doc(
+      app::load_document(&ctx, filename.c_str()));
+    if (!doc) {
+      state.SkipWithError("Error loading the file");
+      break;
+    }
+    doc->close();
+  }
+
+  state.SetLabel(case_label(c));
+  state.SetBytesProcessed(state.iterations() * base::file_size(filename));
+  base::delete_file(filename);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_SaveDocument)
+  ->ArgName("case")->DenseRange(0, kFileCases_size-1)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_LoadDocument)
+  ->ArgName("case")->DenseRange(0, kFileCases_size-1)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,61 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include "gfx/packing_rects.h"
+#include "gfx/size.h"
+
+namespace {
+
+// Rectangles of different sizes (like the frames of a sprite sheet
+// with trimmed cels).
+void add_rects(gfx::PackingRects& pr, int n)
+{
+  for (int i=0; i<n; ++i)
+    pr.add(gfx::Size(8 + (i*7) % 57, 8 + (i*13) % 41));
+}
+
+// Packs the rectangles in the smallest texture where they fit.
+void BM_PackingRectsPack(benchmark::State& state)
+{
+  const int n = int(state.range(0));
+  gfx::PackingRects pr;
+  add_rects(pr, n);
+  const gfx::Size size = pr.bestFit();
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(pr.pack(size));
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Searches the smallest texture (several calls to pack()).
+void BM_PackingRectsBestFit(benchmark::State& state)
+{
+  const int n = int(state.range(0));
+  gfx::PackingRects pr;
+  add_rects(pr, n);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(pr.bestFit());
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_PackingRectsPack)
+  ->ArgName("rects")->RangeMultiplier(2)->Range(8, 32)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PackingRectsBestFit)
+  ->ArgName("rects")->RangeMultiplier(2)->Range(8, 32)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,110 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include "bench/synthetic.h"
+#include "doc/image.h"
+#include "doc/sprite.h"
+#include "render/quantization.h"
+#include "render/render.h"
+
+#include <memory>
+
+using namespace doc;
+
+namespace {
+
+const int kSpriteSize = 512;
+
+template<PixelFormat format>
+void BM_RenderSprite(benchmark::State& state)
+{
+  const int layers = int(state.range(0));
+  std::unique_ptr<Sprite> sprite(
+    bench::create_synthetic_sprite(format, kSpriteSize, kSpriteSize, layers, 1));
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, kSpriteSize, kSpriteSize));
+  render::Render render;
+
+  for (auto _ : state) {
+    render.renderSprite(dst.get(), sprite.get(), frame_t(0));
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * layers * kSpriteSize * kSpriteSize);
+}
+
+void BM_RenderBlendMode(benchmark::State& state)
+{
+  const BlendMode blendMode = BlendMode(state.range(0));
+  std::unique_ptr<Sprite> sprite(
+    bench::create_synthetic_sprite(IMAGE_RGB, kSpriteSize, kSpriteSize, 4, 1,
+                                   blendMode));
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, kSpriteSize, kSpriteSize));
+  render::Render render;
+
+  for (auto _ : state) {
+    render.renderSprite(dst.get(), sprite.get(), frame_t(0));
+    benchmark::ClobberMemory();
+  }
+
+  state.SetLabel(blend_mode_to_string(blendMode));
+  state.SetItemsProcessed(state.iterations() * 4 * kSpriteSize * kSpriteSize);
+}
+
+template<PixelFormat srcFormat, PixelFormat dstFormat>
+void BM_ConvertPixelFormat(benchmark::State& state)
+{
+  const DitheringMethod ditheringMethod = DitheringMethod(state.range(0));
+  std::unique_ptr<Sprite> sprite(
+    bench::create_synthetic_sprite(IMAGE_INDEXED, kSpriteSize, kSpriteSize, 1, 1));
+  ImageRef src = bench::create_synthetic_image(srcFormat, kSpriteSize, kSpriteSize, 1);
+  std::unique_ptr<Image> dst(Image::create(dstFormat, kSpriteSize, kSpriteSize));
+  const Palette* palette = sprite->palette(frame_t(0));
+  const RgbMap* rgbmap = sprite->rgbMap(frame_t(0));
+
+  for (auto _ : state) {
+    render::convert_pixel_format(src.get(), dst.get(), dstFormat,
+                                 ditheringMethod, rgbmap, palette,
+                                 false, 0);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kSpriteSize * kSpriteSize);
+}
+
+} // anonymous namespace
+
+BENCHMARK_TEMPLATE(BM_RenderSprite, IMAGE_RGB)
+  ->ArgName("layers")->RangeMultiplier(2)->Range(1, 64)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RenderSprite, IMAGE_INDEXED)
+  ->ArgName("layers")->RangeMultiplier(2)->Range(1, 64)
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_RenderBlendMode)
+  ->ArgName("blend")
+  ->DenseRange(int(BlendMode::NORMAL), int(BlendMode::HSL_LUMINOSITY))
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_ConvertPixelFormat, IMAGE_RGB, IMAGE_INDEXED)
+  ->ArgName("dithering")
+  ->DenseRange(int(DitheringMethod::NONE), int(DitheringMethod::ATKINSON))
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConvertPixelFormat, IMAGE_RGB, IMAGE_GRAYSCALE)
+  ->ArgName("dithering")->Arg(int(DitheringMethod::NONE))
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConvertPixelFormat, IMAGE_INDEXED, IMAGE_RGB)
+  ->ArgName("dithering")->Arg(int(DitheringMethod::NONE))
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConvertPixelFormat, IMAGE_GRAYSCALE, IMAGE_INDEXED)
+  ->ArgName("dithering")->Arg(int(DitheringMethod::NONE))
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
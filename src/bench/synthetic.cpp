@@ -0,0 +1,121 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bench/synthetic.h"
+
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/palette.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace bench {
+
+using namespace doc;
+
+namespace {
+
+// Small linear congruential generator, so the synthetic content
+// doesn't depend on the std::rand() implementation.
+class Random {
+public:
+  explicit Random(int seed) : m_state(uint32_t(seed) * 2654435761u + 1) { }
+
+  int next(int n) {
+    m_state = m_state * 1664525u + 1013904223u;
+    return int((m_state >> 8) % uint32_t(n));
+  }
+
+private:
+  uint32_t m_state;
+};
+
+color_t random_color(PixelFormat format, Random& random)
+{
+  switch (format) {
+    case IMAGE_RGB:
+      return rgba(random.next(256), random.next(256), random.next(256),
+                  128 + random.next(128));
+    case IMAGE_GRAYSCALE:
+      return graya(random.next(256), 128 + random.next(128));
+    case IMAGE_INDEXED:
+      return 1 + random.next(255);
+    case IMAGE_BITMAP:
+      return 1;
+  }
+  return 0;
+}
+
+} // anonymous namespace
+
+ImageRef create_synthetic_image(PixelFormat format,
+                                int width, int height,
+                                int seed)
+{
+  Random random(seed);
+  ImageRef image(Image::create(format, width, height));
+  clear_image(image.get(), 0);
+
+  // Solid rectangles
+  const int rects = std::max(1, width * height / 1024);
+  for (int i=0; i<rects; ++i) {
+    const int w = 1 + random.next(std::max(1, width/4));
+    const int h = 1 + random.next(std::max(1, height/4));
+    const int x = random.next(width);
+    const int y = random.next(height);
+    fill_rect(image.get(), x, y, x+w-1, y+h-1, random_color(format, random));
+  }
+
+  // Noise in the bottom-right corner
+  for (int y=height*3/4; y<height; ++y)
+    for (int x=width*3/4; x<width; ++x)
+      put_pixel(image.get(), x, y, random_color(format, random));
+
+  return image;
+}
+
+Sprite* create_synthetic_sprite(PixelFormat format,
+                                int width, int height,
+                                int layers, int frames,
+                                BlendMode blendMode)
+{
+  std::unique_ptr<Sprite> sprite(new Sprite(format, width, height, 256));
+  sprite->setTotalFrames(frame_t(frames));
+
+  if (format == IMAGE_INDEXED) {
+    Random random(0);
+    auto palette = Palette::create(256);
+    for (int i=0; i<palette->size(); ++i)
+      palette->setEntry(i, rgba(random.next(256), random.next(256),
+                                random.next(256), 255));
+    sprite->setPalette(*palette, true);
+  }
+
+  for (int i=0; i<layers; ++i) {
+    LayerImage* layer = new LayerImage(sprite.get());
+    layer->setBlendMode(blendMode);
+    sprite->folder()->addLayer(layer);
+
+    for (frame_t frame=0; frame<frames; ++frame) {
+      ImageRef image = create_synthetic_image(format, width, height,
+                                              i*frames + frame + 1);
+      layer->addCel(std::make_shared<Cel>(frame, image));
+    }
+  }
+
+  return sprite.release();
+}
+
+} // namespace bench
@@ -0,0 +1,36 @@
+// LibreSprite
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation.
+
+#pragma once
+
+#include "doc/blend_mode.h"
+#include "doc/image_ref.h"
+#include "doc/pixel_format.h"
+
+namespace doc {
+  class Sprite;
+}
+
+namespace bench {
+
+  // Creates an image with deterministic content (the same seed
+  // generates the same pixels in every run): rectangles of solid
+  // colors over a transparent background (like a pixel-art sprite)
+  // and a small area of noise.
+  doc::ImageRef create_synthetic_image(doc::PixelFormat format,
+                                       int width, int height,
+                                       int seed);
+
+  // Creates a sprite where each cel of each layer has a different
+  // synthetic image. Indexed sprites get a palette with 256
+  // different colors.
+  doc::Sprite* create_synthetic_sprite(doc::PixelFormat format,
+                                       int width, int height,
+                                       int layers, int frames,
+                                       doc::BlendMode blendMode = doc::BlendMode::NORMAL);
+
+} // namespace bench
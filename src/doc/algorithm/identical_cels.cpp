@@ -0,0 +1,175 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "doc/algorithm/identical_cels.h"
+
+#include "base/parallel_for.h"
+#include "doc/cel.h"
+#include "doc/cel_data.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/layers_range.h"
+#include "doc/sprite.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace doc {
+namespace algorithm {
+
+namespace {
+
+struct UniqueData {
+  CelData* data;
+  LayerImage* layer;
+  std::vector<std::shared_ptr<Cel>> cels; // Cels that use this data
+  uint64_t hash;
+};
+
+uint64_t hash_bytes(uint64_t hash, const uint8_t* bytes, std::size_t n)
+{
+  const uint64_t k = 0x9e3779b97f4a7c15ull;
+
+  for (; n >= 8; n -= 8, bytes += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes, 8);
+    hash = (hash ^ word) * k;
+    hash ^= (hash >> 32);
+  }
+  for (; n > 0; --n, ++bytes)
+    hash = (hash ^ *bytes) * k;
+
+  return hash;
+}
+
+uint64_t hash_cel_data(const CelData* data)
+{
+  const Image* image = data->image();
+  uint64_t hash = 0;
+  const int header[] = {
+    data->position().x, data->position().y, data->opacity(),
+    image->pixelFormat(), image->width(), image->height() };
+  hash = hash_bytes(hash, (const uint8_t*)header, sizeof(header));
+
+  const int rowBytes = image->getRowStrideSize();
+  for (int y=0; y<image->height(); ++y)
+    hash = hash_bytes(hash, image->getPixelAddress(0, y), rowBytes);
+
+  return hash;
+}
+
+bool is_same_cel_data(const CelData* a, const CelData* b)
+{
+  const Image* imageA = a->image();
+  const Image* imageB = b->image();
+
+  if (a->position() != b->position() ||
+      a->opacity() != b->opacity() ||
+      a->userData() != b->userData() ||
+      imageA->pixelFormat() != imageB->pixelFormat() ||
+      imageA->width() != imageB->width() ||
+      imageA->height() != imageB->height() ||
+      imageA->maskColor() != imageB->maskColor())
+    return false;
+
+  if (imageA == imageB)
+    return true;
+
+  const int rowBytes = imageA->getRowStrideSize();
+  for (int y=0; y<imageA->height(); ++y)
+    if (std::memcmp(imageA->getPixelAddress(0, y),
+                    imageB->getPixelAddress(0, y), rowBytes) != 0)
+      return false;
+
+  return true;
+}
+
+} // anonymous namespace
+
+std::vector<IdenticalCel> find_identical_cels(const Sprite* sprite)
+{
+  // Different CelData of each layer (linked cels share the same
+  // CelData), in frame order
+  std::vector<UniqueData> datas;
+  for (Layer* layer : sprite->layers()) {
+    if (!layer->isImage())
+      continue;
+
+    LayerImage* layerImage = static_cast<LayerImage*>(layer);
+    std::unordered_map<CelData*, std::size_t> indexes;
+    for (auto it=layerImage->getCelBegin(); it!=layerImage->getCelEnd(); ++it) {
+      CelData* data = (*it)->data();
+      auto index = indexes.find(data);
+      if (index == indexes.end()) {
+        indexes[data] = datas.size();
+        datas.push_back(UniqueData{ data, layerImage, { *it }, 0 });
+      }
+      else
+        datas[index->second].cels.push_back(*it);
+    }
+  }
+
+  base::parallel_for(
+    0, int(datas.size()), 1,
+    [&datas](int begin, int end) {
+      for (int i=begin; i<end; ++i)
+        datas[i].hash = hash_cel_data(datas[i].data);
+    });
+
+  std::vector<IdenticalCel> result;
+  std::unordered_multimap<uint64_t, const UniqueData*> previous;
+  const LayerImage* layer = nullptr;
+
+  for (const UniqueData& item : datas) {
+    if (item.layer != layer) {
+      layer = item.layer;
+      previous.clear();
+    }
+
+    // Cels linked by the user are kept as they are (editing one of
+    // them must modify the others)
+    if (item.cels.size() > 1 && !item.data->isCopyOnWrite())
+      continue;
+
+    const UniqueData* original = nullptr;
+    auto range = previous.equal_range(item.hash);
+    for (auto it=range.first; it!=range.second; ++it)
+      if (is_same_cel_data(it->second->data, item.data)) {
+        original = it->second;
+        break;
+      }
+
+    if (!original) {
+      previous.insert(std::make_pair(item.hash, &item));
+      continue;
+    }
+
+    // All cels that use this data are linked to the original cel
+    for (const auto& cel : item.cels)
+      result.push_back(IdenticalCel(cel, original->cels.front()));
+  }
+
+  return result;
+}
+
+int link_identical_cels(Sprite* sprite)
+{
+  std::vector<IdenticalCel> cels = find_identical_cels(sprite);
+  for (auto& item : cels) {
+    item.second->data()->setCopyOnWrite(true);
+    item.first->setDataRef(item.second->dataRef());
+  }
+  return int(cels.size());
+}
+
+} // namespace algorithm
+} // namespace doc
@@ -0,0 +1,39 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace doc {
+  class Cel;
+  class Sprite;
+
+  namespace algorithm {
+
+    // A cel and the cel that it can be linked to.
+    typedef std::pair<std::shared_ptr<Cel>,
+                      std::shared_ptr<Cel>> IdenticalCel;
+
+    // Finds cels with the same content (pixels, position, opacity
+    // and user data) as a previous cel of the same layer that aren't
+    // linked to it yet. Images are compared by a hash of their pixels
+    // (calculated in parallel) and then pixel by pixel. Each cel is
+    // returned with the first cel of its layer with the same content.
+    // Cels linked by the user are ignored.
+    std::vector<IdenticalCel> find_identical_cels(const Sprite* sprite);
+
+    // Links the cels found by find_identical_cels() to share the same
+    // copy-on-write CelData (and image), so a cel is unlinked when
+    // it's modified (see Cel::isCopyOnWrite()). It doesn't generate
+    // undo information, so it's used on documents that are being
+    // loaded. Returns the number of cels that were linked.
+    int link_identical_cels(Sprite* sprite);
+
+  } // algorithm
+} // doc
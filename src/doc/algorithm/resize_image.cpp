@@ -10,6 +10,7 @@
 
 #include "doc/algorithm/resize_image.h"
 
+#include "base/parallel_for.h"
 #include "doc/algorithm/rotsprite.h"
 #include "doc/image_impl.h"
 #include "doc/palette.h"
@@ -39,6 +40,110 @@ void resize_image_nearest(const Image* src, Image* dst)
   }
 }
 
+// Rows of the destination image resized by each thread in the
+// bilinear method
+static const int kBilinearRows = 32;
+
+// Resizes the rows [y1, y2) of "dst" with the bilinear method.
+static void resize_image_bilinear_rows(const Image* src, Image* dst,
+                                       const Palette* pal, const RgbMap* rgbmap,
+                                       color_t maskColor, int y1, int y2)
+{
+  uint32_t color[4], dst_color = 0;
+  double u, v, du, dv;
+  int u_floor, u_floor2;
+  int v_floor, v_floor2;
+  int x, y;
+
+  // Each row and column is calculated from its index (instead of
+  // accumulating du/dv) so any band of rows can be resized alone.
+  du = (dst->width() > 1 ? (src->width()-1) * 1.0 / (dst->width()-1): 0.0);
+  dv = (dst->height() > 1 ? (src->height()-1) * 1.0 / (dst->height()-1): 0.0);
+  for (y=y1; y<y2; ++y) {
+    v = y * dv;
+    for (x=0; x<dst->width(); ++x) {
+      u = x * du;
+      u_floor = (int)floor(u);
+      v_floor = (int)floor(v);
+
+      if (u_floor > src->width()-1) {
+        u_floor = src->width()-1;
+        u_floor2 = src->width()-1;
+      }
+      else if (u_floor == src->width()-1)
+        u_floor2 = u_floor;
+      else
+        u_floor2 = u_floor+1;
+
+      if (v_floor > src->height()-1) {
+        v_floor = src->height()-1;
+        v_floor2 = src->height()-1;
+      }
+      else if (v_floor == src->height()-1)
+        v_floor2 = v_floor;
+      else
+        v_floor2 = v_floor+1;
+
+      // get the four colors
+      color[0] = src->getPixel(u_floor,  v_floor);
+      color[1] = src->getPixel(u_floor2, v_floor);
+      color[2] = src->getPixel(u_floor,  v_floor2);
+      color[3] = src->getPixel(u_floor2, v_floor2);
+
+      // calculate the interpolated color
+      double u1 = u - u_floor;
+      double v1 = v - v_floor;
+      double u2 = 1 - u1;
+      double v2 = 1 - v1;
+
+      switch (dst->pixelFormat()) {
+        case IMAGE_RGB: {
+          int r = int((rgba_getr(color[0])*u2 + rgba_getr(color[1])*u1)*v2 +
+                      (rgba_getr(color[2])*u2 + rgba_getr(color[3])*u1)*v1);
+          int g = int((rgba_getg(color[0])*u2 + rgba_getg(color[1])*u1)*v2 +
+                      (rgba_getg(color[2])*u2 + rgba_getg(color[3])*u1)*v1);
+          int b = int((rgba_getb(color[0])*u2 + rgba_getb(color[1])*u1)*v2 +
+                      (rgba_getb(color[2])*u2 + rgba_getb(color[3])*u1)*v1);
+          int a = int((rgba_geta(color[0])*u2 + rgba_geta(color[1])*u1)*v2 +
+                      (rgba_geta(color[2])*u2 + rgba_geta(color[3])*u1)*v1);
+          dst_color = rgba(r, g, b, a);
+          break;
+        }
+        case IMAGE_GRAYSCALE: {
+          int v = int((graya_getv(color[0])*u2 + graya_getv(color[1])*u1)*v2 +
+                      (graya_getv(color[2])*u2 + graya_getv(color[3])*u1)*v1);
+          int a = int((graya_geta(color[0])*u2 + graya_geta(color[1])*u1)*v2 +
+                      (graya_geta(color[2])*u2 + graya_geta(color[3])*u1)*v1);
+          dst_color = graya(v, a);
+          break;
+        }
+        case IMAGE_INDEXED: {
+          // Convert index to RGBA values
+          for (int i=0; i<4; ++i) {
+            if (color[i] == maskColor)
+              color[i] = pal->getEntry(color[i]) & rgba_rgb_mask; // Set alpha = 0
+            else
+              color[i] = pal->getEntry(color[i]);
+          }
+
+          int r = int((rgba_getr(color[0])*u2 + rgba_getr(color[1])*u1)*v2 +
+                      (rgba_getr(color[2])*u2 + rgba_getr(color[3])*u1)*v1);
+          int g = int((rgba_getg(color[0])*u2 + rgba_getg(color[1])*u1)*v2 +
+                      (rgba_getg(color[2])*u2 + rgba_getg(color[3])*u1)*v1);
+          int b = int((rgba_getb(color[0])*u2 + rgba_getb(color[1])*u1)*v2 +
+                      (rgba_getb(color[2])*u2 + rgba_getb(color[3])*u1)*v1);
+          int a = int((rgba_geta(color[0])*u2 + rgba_geta(color[1])*u1)*v2 +
+                      (rgba_geta(color[2])*u2 + rgba_geta(color[3])*u1)*v1);
+          dst_color = rgbmap->mapColor(r, g, b, a);
+          break;
+        }
+      }
+
+      dst->putPixel(x, y, dst_color);
+    }
+  }
+}
+
 void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palette* pal, const RgbMap* rgbmap, color_t maskColor)
 {
   switch (method) {
@@ -56,101 +161,12 @@ void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palet
       break;
     }
 
-    // TODO optimize this
     case RESIZE_METHOD_BILINEAR: {
-      uint32_t color[4], dst_color = 0;
-      double u, v, du, dv;
-      int u_floor, u_floor2;
-      int v_floor, v_floor2;
-      int x, y;
-
-      u = v = 0.0;
-      du = (src->width()-1) * 1.0 / (dst->width()-1);
-      dv = (src->height()-1) * 1.0 / (dst->height()-1);
-      for (y=0; y<dst->height(); ++y) {
-        for (x=0; x<dst->width(); ++x) {
-          u_floor = (int)floor(u);
-          v_floor = (int)floor(v);
-
-          if (u_floor > src->width()-1) {
-            u_floor = src->width()-1;
-            u_floor2 = src->width()-1;
-          }
-          else if (u_floor == src->width()-1)
-            u_floor2 = u_floor;
-          else
-            u_floor2 = u_floor+1;
-
-          if (v_floor > src->height()-1) {
-            v_floor = src->height()-1;
-            v_floor2 = src->height()-1;
-          }
-          else if (v_floor == src->height()-1)
-            v_floor2 = v_floor;
-          else
-            v_floor2 = v_floor+1;
-
-          // get the four colors
-          color[0] = src->getPixel(u_floor,  v_floor);
-          color[1] = src->getPixel(u_floor2, v_floor);
-          color[2] = src->getPixel(u_floor,  v_floor2);
-          color[3] = src->getPixel(u_floor2, v_floor2);
-
-          // calculate the interpolated color
-          double u1 = u - u_floor;
-          double v1 = v - v_floor;
-          double u2 = 1 - u1;
-          double v2 = 1 - v1;
-
-          switch (dst->pixelFormat()) {
-            case IMAGE_RGB: {
-              int r = int((rgba_getr(color[0])*u2 + rgba_getr(color[1])*u1)*v2 +
-                          (rgba_getr(color[2])*u2 + rgba_getr(color[3])*u1)*v1);
-              int g = int((rgba_getg(color[0])*u2 + rgba_getg(color[1])*u1)*v2 +
-                          (rgba_getg(color[2])*u2 + rgba_getg(color[3])*u1)*v1);
-              int b = int((rgba_getb(color[0])*u2 + rgba_getb(color[1])*u1)*v2 +
-                          (rgba_getb(color[2])*u2 + rgba_getb(color[3])*u1)*v1);
-              int a = int((rgba_geta(color[0])*u2 + rgba_geta(color[1])*u1)*v2 +
-                          (rgba_geta(color[2])*u2 + rgba_geta(color[3])*u1)*v1);
-              dst_color = rgba(r, g, b, a);
-              break;
-            }
-            case IMAGE_GRAYSCALE: {
-              int v = int((graya_getv(color[0])*u2 + graya_getv(color[1])*u1)*v2 +
-                          (graya_getv(color[2])*u2 + graya_getv(color[3])*u1)*v1);
-              int a = int((graya_geta(color[0])*u2 + graya_geta(color[1])*u1)*v2 +
-                          (graya_geta(color[2])*u2 + graya_geta(color[3])*u1)*v1);
-              dst_color = graya(v, a);
-              break;
-            }
-            case IMAGE_INDEXED: {
-              // Convert index to RGBA values
-              for (int i=0; i<4; ++i) {
-                if (color[i] == maskColor)
-                  color[i] = pal->getEntry(color[i]) & rgba_rgb_mask; // Set alpha = 0
-                else
-                  color[i] = pal->getEntry(color[i]);
-              }
-
-              int r = int((rgba_getr(color[0])*u2 + rgba_getr(color[1])*u1)*v2 +
-                          (rgba_getr(color[2])*u2 + rgba_getr(color[3])*u1)*v1);
-              int g = int((rgba_getg(color[0])*u2 + rgba_getg(color[1])*u1)*v2 +
-                          (rgba_getg(color[2])*u2 + rgba_getg(color[3])*u1)*v1);
-              int b = int((rgba_getb(color[0])*u2 + rgba_getb(color[1])*u1)*v2 +
-                          (rgba_getb(color[2])*u2 + rgba_getb(color[3])*u1)*v1);
-              int a = int((rgba_geta(color[0])*u2 + rgba_geta(color[1])*u1)*v2 +
-                          (rgba_geta(color[2])*u2 + rgba_geta(color[3])*u1)*v1);
-              dst_color = rgbmap->mapColor(r, g, b, a);
-              break;
-            }
-          }
-
-          dst->putPixel(x, y, dst_color);
-          u += du;
-        }
-        u = 0.0;
-        v += dv;
-      }
+      base::parallel_for(
+        0, dst->height(), kBilinearRows,
+        [&](int y1, int y2) {
+          resize_image_bilinear_rows(src, dst, pal, rgbmap, maskColor, y1, y2);
+        });
       break;
     }
 
@@ -11,6 +11,7 @@
 #include "config.h"
 #endif
 
+#include "base/parallel_for.h"
 #include "base/pi.h"
 #include "doc/blend_funcs.h"
 #include "doc/image_impl.h"
@@ -39,21 +40,23 @@ static void ase_rotate_scale_flip_coordinates(
   int h_flip, int v_flip,
   fixed xs[4], fixed ys[4]);
 
+// Scales the rows [v1, v2) of the destination rectangle.
 template<typename ImageTraits, typename BlendFunc>
-static void image_scale_tpl(
+static void image_scale_rows(
   Image* dst, const Image* src,
   int dst_x, int dst_y, int dst_w, int dst_h,
-  int src_x, int src_y, int src_w, int src_h, BlendFunc blend)
+  int src_x, int src_y, int src_w, int src_h, BlendFunc blend,
+  int v1, int v2)
 {
-  LockImageBits<ImageTraits> dst_bits(dst, gfx::Rect(dst_x, dst_y, dst_w, dst_h));
+  LockImageBits<ImageTraits> dst_bits(dst, gfx::Rect(dst_x, dst_y+v1, dst_w, v2-v1));
   typename LockImageBits<ImageTraits>::iterator dst_it = dst_bits.begin();
   fixed x, first_x = itofix(src_x);
-  fixed y = itofix(src_y);
   fixed dx = fixdiv(itofix(src_w-1), itofix(dst_w-1));
   fixed dy = fixdiv(itofix(src_h-1), itofix(dst_h-1));
+  fixed y = itofix(src_y) + v1*dy;
   int old_x, new_x;
 
-  for (int v=0; v<dst_h; ++v) {
+  for (int v=v1; v<v2; ++v) {
     old_x = fixtoi(x = first_x);
 
     const LockImageBits<ImageTraits> src_bits(src, gfx::Rect(src_x, fixtoi(y), src_w, 1));
@@ -74,8 +77,11 @@ static void image_scale_tpl(
           src_it += (new_x - old_x);
           old_x = new_x;
         }
-        else
+        else {
+          // Skip the rest of this row
+          dst_it += dst_w-u-1;
           break;
+        }
       }
     }
 
@@ -83,6 +89,24 @@ static void image_scale_tpl(
   }
 }
 
+template<typename ImageTraits, typename BlendFunc>
+static void image_scale_tpl(
+  Image* dst, const Image* src,
+  int dst_x, int dst_y, int dst_w, int dst_h,
+  int src_x, int src_y, int src_w, int src_h, BlendFunc blend)
+{
+  // Bands of ~64k pixels
+  base::parallel_for(
+    0, dst_h, MAX(1, 65536 / dst_w),
+    [&](int v1, int v2) {
+      image_scale_rows<ImageTraits>(
+        dst, src,
+        dst_x, dst_y, dst_w, dst_h,
+        src_x, src_y, src_w, src_h, blend,
+        v1, v2);
+    });
+}
+
 static color_t rgba_blender(color_t back, color_t front) {
   return rgba_blender_normal(back, front);
 }
@@ -337,12 +361,15 @@ public:
  *  and last point in which the horizontal line passing through the centre is
  *  at least partly covered by the sprite. This is useful for doing
  *  anti-aliased blending.
+ *  Only scanlines in the [clip_top_i, clip_bottom_limit) range are
+ *  drawn, so different bands of the bitmap can be drawn in parallel.
  */
 template<class Traits, class Delegate>
 static void ase_parallelogram_map(
   Image* bmp, const Image* spr, const Image* mask,
   fixed xs[4], fixed ys[4],
-  int sub_pixel_accuracy, Delegate delegate)
+  int sub_pixel_accuracy, Delegate delegate,
+  int clip_top_i, int clip_bottom_limit)
 {
   /* Index in xs[] and ys[] to topmost point. */
   int top_index;
@@ -467,6 +494,10 @@ static void ase_parallelogram_map(
 
   if (clip_bottom_i > bmp->height())
     clip_bottom_i = bmp->height();
+  if (clip_bottom_i > clip_bottom_limit)
+    clip_bottom_i = clip_bottom_limit;
+  if (clip_bottom_i <= clip_top_i)
+    return;
 
   /* Calculate y coordinate of first scanline. */
   if (sub_pixel_accuracy)
@@ -593,6 +624,13 @@ static void ase_parallelogram_map(
       r_bmp_y_bottom_i = clip_bottom_i;
     }
 
+    /* Scanlines above clip_top_i are drawn by another call (another
+       band), but the edges are updated anyway one scanline at a time
+       to get the same rounding errors as when all scanlines are
+       drawn at once. */
+    if (bmp_y_i < clip_top_i)
+      goto skip_draw;
+
     /* Make left bmp coordinate be an integer and clip it. */
     if (sub_pixel_accuracy)
       l_bmp_x_rounded = l_bmp_x;
@@ -738,6 +776,25 @@ static void ase_parallelogram_map(
   }
 }
 
+/* Calls ase_parallelogram_map() for bands of scanlines in parallel.
+ * Each band follows the edges from the top of the parallelogram, so
+ * the result is the same as drawing all the scanlines at once.
+ */
+template<class Traits, class Delegate>
+static void ase_parallelogram_map_bands(
+  Image* bmp, const Image* spr, const Image* mask,
+  fixed xs[4], fixed ys[4],
+  const Delegate& delegate)
+{
+  // Bands of ~64k pixels
+  base::parallel_for(
+    0, bmp->height(), MAX(1, 65536 / bmp->width()),
+    [&](int y1, int y2) {
+      ase_parallelogram_map<Traits, Delegate>(
+        bmp, spr, mask, xs, ys, false, delegate, y1, y2);
+    });
+}
+
 /* _parallelogram_map_standard:
  *  Helper function for calling _parallelogram_map() with the appropriate
  *  scanline drawer. I didn't want to include this in the
@@ -752,25 +809,25 @@ static void ase_parallelogram_map_standard(
 
     case IMAGE_RGB: {
       RgbDelegate delegate(sprite->maskColor());
-      ase_parallelogram_map<RgbTraits, RgbDelegate>(bmp, sprite, mask, xs, ys, false, delegate);
+      ase_parallelogram_map_bands<RgbTraits, RgbDelegate>(bmp, sprite, mask, xs, ys, delegate);
       break;
     }
 
     case IMAGE_GRAYSCALE: {
       GrayscaleDelegate delegate(sprite->maskColor());
-      ase_parallelogram_map<GrayscaleTraits, GrayscaleDelegate>(bmp, sprite, mask, xs, ys, false, delegate);
+      ase_parallelogram_map_bands<GrayscaleTraits, GrayscaleDelegate>(bmp, sprite, mask, xs, ys, delegate);
       break;
     }
 
     case IMAGE_INDEXED: {
       IndexedDelegate delegate(sprite->maskColor());
-      ase_parallelogram_map<IndexedTraits, IndexedDelegate>(bmp, sprite, mask, xs, ys, false, delegate);
+      ase_parallelogram_map_bands<IndexedTraits, IndexedDelegate>(bmp, sprite, mask, xs, ys, delegate);
       break;
     }
 
     case IMAGE_BITMAP: {
       BitmapDelegate delegate;
-      ase_parallelogram_map<BitmapTraits, BitmapDelegate>(bmp, sprite, mask, xs, ys, false, delegate);
+      ase_parallelogram_map_bands<BitmapTraits, BitmapDelegate>(bmp, sprite, mask, xs, ys, delegate);
       break;
     }
   }
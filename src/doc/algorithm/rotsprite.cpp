@@ -8,149 +8,120 @@
 #include "config.h"
 #endif
 
+#include "doc/algorithm/rotsprite.h"
+
 #include "base/base.h"
+#include "base/parallel_for.h"
 #include "doc/algorithm/rotate.h"
 #include "doc/image_impl.h"
 #include "doc/primitives.h"
+#include "doc/primitives_fast.h"
 
 #include <memory>
 
 namespace doc {
 namespace algorithm {
 
+// Returns "a" if "cond" is true, or "b" otherwise. It uses bit masks
+// instead of a branch so loops using it can be vectorized.
+template<typename T>
+static inline T select_pixel(bool cond, T a, T b)
+{
+  const T mask = T(0) - T(cond);
+  return (a & mask) | (b & ~mask);
+}
+
 // More information about EPX/Scale2x:
 // http://en.wikipedia.org/wiki/Pixel_art_scaling_algorithms#EPX.2FScale2.C3.97.2FAdvMAME2.C3.97
 // http://scale2x.sourceforge.net/algorithm.html
 // http://scale2x.sourceforge.net/scale2xandepx.html
-template<typename ImageTraits>
-static void image_scale2x_tpl(Image* dst, const Image* src, int src_w, int src_h)
+//
+// Neighbors of the P pixel:
+//   A
+// C P B
+//   D
+// d0 points to the two output pixels of the first row, and d1 to
+// the two output pixels of the second row.
+template<typename T>
+static inline void scale2x_pixel(T A, T B, T C, T D, T P, T* d0, T* d1)
 {
-#if 0      // TODO complete this implementation that should be faster
-           // than using a lot of get/put_pixel_fast calls.
-  int dst_w = src_w*2;
-  int dst_h = src_h*2;
-
-  LockImageBits<ImageTraits> dstBits(dst, Image::WriteLock, gfx::Rect(0, 0, dst_w, dst_h));
-  const LockImageBits<ImageTraits> srcBits(src);
-
-  LockImageBits<ImageTraits>::iterator dstRow0_it = dstBits.begin();
-  LockImageBits<ImageTraits>::iterator dstRow1_it = dstBits.begin();
-  LockImageBits<ImageTraits>::iterator dstRow0_end = dstBits.end();
-  LockImageBits<ImageTraits>::iterator dstRow1_end = dstBits.end();
-
-  // Iterators:
-  //   A
-  // C P B
-  //   D
-  //
-  // These iterators are displaced through src image and are modified in this way:
-  //
-  // P: is the simplest one, we just start from (0, 0) to srcEnd.
-  // A: starts from row 0 (so A = P in the first row), then we start
-  //    again from the row 0.
-  // B: It starts from (1, row) and in the last pixel we don't moved it.
-  // C: It starts from (0, 0) and then it is moved with a delay.
-  // D: It starts from row 1 and continues until we reach the last
-  //    row, in that case we start D iterator again.
-  //
-  LockImageBits<ImageTraits>::const_iterator itP, itA, itB, itC, itD, savedD;
-  LockImageBits<ImageTraits>::const_iterator srcEnd = srcBits.end();
-  color_t P, A, B, C, D;
-
-  // Adjust iterators
-  itP = itA = itB = itC = itD = savedD = srcBits.begin();
-  dstRow1_it += dst_w;
-  itD += src->width();
-
-  for (int y=0; y<src_h; ++y) {
-    if (y == 1) itA = srcBits.begin();
-    if (y == src_h-2) savedD = itD;
-    if (y == src_h-1) itD = savedD;
-    ++itB;
+  d0[0] = select_pixel((C == A) & (C != D) & (A != B), A, P);
+  d0[1] = select_pixel((A == B) & (A != C) & (B != D), B, P);
+  d1[0] = select_pixel((D == C) & (D != B) & (C != A), C, P);
+  d1[1] = select_pixel((B == D) & (B != A) & (D != C), D, P);
+}
 
-    for (int x=0; x<src_w; ++x) {
-      ASSERT(itP != srcEnd);
-      ASSERT(itA != srcEnd);
-      ASSERT(itB != srcEnd);
-      ASSERT(itC != srcEnd);
-      ASSERT(itD != srcEnd);
-      ASSERT(dstRow0_it != dstRow0_end);
-      ASSERT(dstRow1_it != dstRow1_end);
-
-      P = *itP;
-      A = *itA;                 // y-1
-      B = *itB;                 // x+1
-      C = *itC;                 // x-1
-      D = *itD;                 // y+1
-
-      *dstRow0_it = (C == A && C != D && A != B ? A: P);
-      ++dstRow0_it;
-      *dstRow0_it = (A == B && A != C && B != D ? B: P);
-      ++dstRow0_it;
-
-      *dstRow1_it = (D == C && D != B && C != A ? C: P);
-      ++dstRow1_it;
-      *dstRow1_it = (B == D && B != A && D != C ? D: P);
-      ++dstRow1_it;
-
-      ++itP;
-      ++itA;
-      if (x < src_w-2) ++itB;
-      if (x > 0) ++itC;
-      ++itD;
+// Scales the rows [y1, y2) of the src image. Each source row
+// generates two independent rows in dst, so several bands of rows
+// can be processed in parallel.
+template<typename ImageTraits>
+static void image_scale2x_rows(Image* dst, const Image* src, int src_w, int src_h, int y1, int y2)
+{
+  typedef typename ImageTraits::pixel_t pixel_t;
+
+  for (int y=y1; y<y2; ++y) {
+    const pixel_t* up = (const pixel_t*)src->getPixelAddress(0, (y > 0 ? y-1: y));
+    const pixel_t* cur = (const pixel_t*)src->getPixelAddress(0, y);
+    const pixel_t* down = (const pixel_t*)src->getPixelAddress(0, (y < src_h-1 ? y+1: y));
+    pixel_t* d0 = (pixel_t*)dst->getPixelAddress(0, 2*y);
+    pixel_t* d1 = (pixel_t*)dst->getPixelAddress(0, 2*y+1);
+
+    if (src_w == 1) {
+      scale2x_pixel(up[0], cur[0], cur[0], down[0], cur[0], d0, d1);
+      continue;
     }
 
-    // Adjust iterators for the next two rows.
-    ++itB;
-    ++itC;
-    dstRow0_it += dst_w;
-    if (y < src_h-1)
-      dstRow1_it += dst_w;
+    // Left border (C = P)
+    scale2x_pixel(up[0], cur[1], cur[0], down[0], cur[0], d0, d1);
+
+    // Inner pixels. This loop doesn't contain branches so the
+    // compiler can vectorize it.
+    const int last = src_w-1;
+    for (int x=1; x<last; ++x)
+      scale2x_pixel(up[x], cur[x+1], cur[x-1], down[x], cur[x], d0+2*x, d1+2*x);
+
+    // Right border (B = P)
+    scale2x_pixel(up[last], cur[last], cur[last-1], down[last], cur[last], d0+2*last, d1+2*last);
   }
+}
 
-  // ASSERT(itP == srcEnd);
-  // ASSERT(itA == srcEnd);
-  // ASSERT(itB == srcEnd);
-  // ASSERT(itC == srcEnd);
-  // ASSERT(itD == srcEnd);
-  ASSERT(dstRow0_it == dstRow0_end);
-  ASSERT(dstRow1_it == dstRow1_end);
-#else
-
-#define A c[0]
-#define B c[1]
-#define C c[2]
-#define D c[3]
-#define P c[4]
-
-  LockImageBits<ImageTraits> dstBits(dst, gfx::Rect(0, 0, src_w*2, src_h*2));
-  auto dstIt = dstBits.begin();
-  auto dstIt2 = dstIt;
-
-  color_t c[5];
-  for (int y=0; y<src_h; ++y) {
-    dstIt2 += src_w*2;
+// Bitmaps use 1 bit per pixel, so we cannot access pixels directly
+// from their address.
+template<>
+void image_scale2x_rows<BitmapTraits>(Image* dst, const Image* src, int src_w, int src_h, int y1, int y2)
+{
+  color_t c[5], out0[2], out1[2];
+
+  for (int y=y1; y<y2; ++y) {
     for (int x=0; x<src_w; ++x) {
-      P = get_pixel_fast<ImageTraits>(src, x, y);
-      A = (y > 0 ? get_pixel_fast<ImageTraits>(src, x, y-1): P);
-      B = (x < src_w-1 ? get_pixel_fast<ImageTraits>(src, x+1, y): P);
-      C = (x > 0 ? get_pixel_fast<ImageTraits>(src, x-1, y): P);
-      D = (y < src_h-1 ? get_pixel_fast<ImageTraits>(src, x, y+1): P);
-
-      *dstIt = (C == A && C != D && A != B ? A: P);
-      ++dstIt;
-      *dstIt = (A == B && A != C && B != D ? B: P);
-      ++dstIt;
-
-      *dstIt2 = (D == C && D != B && C != A ? C: P);
-      ++dstIt2;
-      *dstIt2 = (B == D && B != A && D != C ? D: P);
-      ++dstIt2;
+      c[4] = get_pixel_fast<BitmapTraits>(src, x, y);
+      c[0] = (y > 0 ? get_pixel_fast<BitmapTraits>(src, x, y-1): c[4]);
+      c[1] = (x < src_w-1 ? get_pixel_fast<BitmapTraits>(src, x+1, y): c[4]);
+      c[2] = (x > 0 ? get_pixel_fast<BitmapTraits>(src, x-1, y): c[4]);
+      c[3] = (y < src_h-1 ? get_pixel_fast<BitmapTraits>(src, x, y+1): c[4]);
+
+      scale2x_pixel(c[0], c[1], c[2], c[3], c[4], out0, out1);
+
+      put_pixel_fast<BitmapTraits>(dst, 2*x, 2*y, out0[0]);
+      put_pixel_fast<BitmapTraits>(dst, 2*x+1, 2*y, out0[1]);
+      put_pixel_fast<BitmapTraits>(dst, 2*x, 2*y+1, out1[0]);
+      put_pixel_fast<BitmapTraits>(dst, 2*x+1, 2*y+1, out1[1]);
     }
-    dstIt += src_w*2;
   }
+}
 
-#endif
+template<typename ImageTraits>
+static void image_scale2x_tpl(Image* dst, const Image* src, int src_w, int src_h)
+{
+  ASSERT(dst->width() >= src_w*2);
+  ASSERT(dst->height() >= src_h*2);
+
+  // Bands of ~64k pixels
+  base::parallel_for(
+    0, src_h, MAX(1, 65536 / src_w),
+    [=](int y1, int y2) {
+      image_scale2x_rows<ImageTraits>(dst, src, src_w, src_h, y1, y2);
+    });
 }
 
 static void image_scale2x(Image* dst, const Image* src, int src_w, int src_h)
@@ -163,16 +134,64 @@ static void image_scale2x(Image* dst, const Image* src, int src_w, int src_h)
   }
 }
 
+// Each scale2x pass doubles the size, we make three passes (8x).
+static const int kRotSpriteScale = 8;
+
+RotSpriteSource::RotSpriteSource(const Image* spr, const Image* mask)
+  : m_width(spr->width())
+  , m_height(spr->height())
+  , m_maskColor(spr->maskColor())
+{
+  const int scale = kRotSpriteScale;
+
+  // Three scale2x passes alternating two buffers (spr -> m_image ->
+  // tmp_copy -> m_image), each pass reads only the area written by
+  // the previous one.
+  m_image.reset(Image::create(spr->pixelFormat(), m_width*scale, m_height*scale));
+  std::unique_ptr<Image> tmp_copy(Image::create(spr->pixelFormat(), m_width*scale, m_height*scale));
+
+  m_image->setMaskColor(m_maskColor);
+  tmp_copy->setMaskColor(m_maskColor);
+
+  image_scale2x(m_image.get(), spr, m_width, m_height);
+  image_scale2x(tmp_copy.get(), m_image.get(), m_width*2, m_height*2);
+  image_scale2x(m_image.get(), tmp_copy.get(), m_width*4, m_height*4);
+
+  if (mask) {
+    // Free the temporary buffer before we allocate the mask
+    tmp_copy.reset();
+
+    m_mask.reset(Image::create(IMAGE_BITMAP, mask->width()*scale, mask->height()*scale));
+    clear_image(m_mask.get(), 0);
+    scale_image(m_mask.get(), mask,
+                0, 0, m_mask->width(), m_mask->height(),
+                0, 0, mask->width(), mask->height());
+  }
+}
+
+RotSpriteSource::~RotSpriteSource()
+{
+}
+
 void rotsprite_image(Image* bmp, const Image* spr, const Image* mask,
   int x1, int y1, int x2, int y2,
   int x3, int y3, int x4, int y4)
 {
-  static ImageBufferPtr buf[3]; // TODO non-thread safe
+  int xmin = MIN(x1, MIN(x2, MIN(x3, x4)));
+  int xmax = MAX(x1, MAX(x2, MAX(x3, x4)));
+  int ymin = MIN(y1, MIN(y2, MIN(y3, y4)));
+  int ymax = MAX(y1, MAX(y2, MAX(y3, y4)));
+  if (xmax == xmin || ymax == ymin)
+    return;
 
-  for (int i=0; i<3; ++i)
-    if (!buf[i])
-      buf[i].reset(new ImageBuffer(1));
+  RotSpriteSource source(spr, mask);
+  rotsprite_image(bmp, source, x1, y1, x2, y2, x3, y3, x4, y4);
+}
 
+void rotsprite_image(Image* bmp, const RotSpriteSource& src,
+  int x1, int y1, int x2, int y2,
+  int x3, int y3, int x4, int y4)
+{
   int xmin = MIN(x1, MIN(x2, MIN(x3, x4)));
   int xmax = MAX(x1, MAX(x2, MAX(x3, x4)));
   int ymin = MIN(y1, MIN(y2, MIN(y3, y4)));
@@ -183,43 +202,18 @@ void rotsprite_image(Image* bmp, const Image* spr, const Image* mask,
   if (rot_width == 0 || rot_height == 0)
     return;
 
-  int scale = 8;
-  std::unique_ptr<Image> bmp_copy(Image::create(bmp->pixelFormat(), rot_width*scale, rot_height*scale, buf[0]));
-  std::unique_ptr<Image> tmp_copy(Image::create(spr->pixelFormat(), spr->width()*scale, spr->height()*scale, buf[1]));
-  std::unique_ptr<Image> spr_copy(Image::create(spr->pixelFormat(), spr->width()*scale, spr->height()*scale, buf[2]));
-  std::unique_ptr<Image> msk_copy;
-
-  color_t maskColor = spr->maskColor();
-
-  bmp_copy->setMaskColor(maskColor);
-  tmp_copy->setMaskColor(maskColor);
-  spr_copy->setMaskColor(maskColor);
+  const int scale = kRotSpriteScale;
+  std::unique_ptr<Image> bmp_copy(Image::create(bmp->pixelFormat(), rot_width*scale, rot_height*scale));
 
-  spr_copy->clear(maskColor);
-  spr_copy->copy(spr, gfx::Clip(spr->bounds()));
-
-  for (int i=0; i<3; ++i) {
-    // clear_image(tmp_copy, maskColor);
-    image_scale2x(tmp_copy.get(), spr_copy.get(), spr->width()*(1<<i), spr->height()*(1<<i));
-    spr_copy->copy(tmp_copy.get(), gfx::Clip(tmp_copy->bounds()));
-  }
-
-  if (mask) {
-    // Same ImageBuffer than tmp_copy
-    msk_copy.reset(Image::create(IMAGE_BITMAP, mask->width()*scale, mask->height()*scale, buf[1]));
-    clear_image(msk_copy.get(), 0);
-    scale_image(msk_copy.get(), mask,
-                0, 0, msk_copy->width(), msk_copy->height(),
-                0, 0, mask->width(), mask->height());
-  }
+  bmp_copy->setMaskColor(src.maskColor());
 
-  clear_image(bmp_copy.get(), maskColor);
+  clear_image(bmp_copy.get(), src.maskColor());
   scale_image(bmp_copy.get(), bmp,
               0, 0, bmp_copy->width(), bmp_copy->height(),
               xmin, ymin, rot_width, rot_height);
 
   parallelogram(
-    bmp_copy.get(), spr_copy.get(), msk_copy.get(),
+    bmp_copy.get(), src.image(), src.mask(),
     (x1-xmin)*scale, (y1-ymin)*scale, (x2-xmin)*scale, (y2-ymin)*scale,
     (x3-xmin)*scale, (y3-ymin)*scale, (x4-xmin)*scale, (y4-ymin)*scale);
 
@@ -6,14 +6,53 @@
 
 #pragma once
 
+#include "doc/color.h"
+
+#include <memory>
+
 namespace doc {
   class Image;
 
   namespace algorithm {
 
+    // Source image (and optional mask) scaled 8x with three passes of
+    // the scale2x algorithm. This is the most expensive part of the
+    // RotSprite algorithm, so it can be calculated just one time and
+    // reused to rotate the same source several times (e.g. while the
+    // user drags a transformation handle).
+    //
+    // Once it's created this object is not modified, so it can be
+    // shared between threads.
+    class RotSpriteSource {
+    public:
+      RotSpriteSource(const Image* spr, const Image* mask);
+      ~RotSpriteSource();
+
+      // Size of the original (non-scaled) source.
+      int width() const { return m_width; }
+      int height() const { return m_height; }
+
+      // Mask color of the original source when this was created.
+      color_t maskColor() const { return m_maskColor; }
+
+      const Image* image() const { return m_image.get(); }
+      const Image* mask() const { return m_mask.get(); }
+
+    private:
+      int m_width;
+      int m_height;
+      color_t m_maskColor;
+      std::unique_ptr<Image> m_image;
+      std::unique_ptr<Image> m_mask;
+    };
+
     void rotsprite_image(Image* dst, const Image* src, const Image* mask,
       int x1, int y1, int x2, int y2,
       int x3, int y3, int x4, int y4);
 
+    void rotsprite_image(Image* dst, const RotSpriteSource& src,
+      int x1, int y1, int x2, int y2,
+      int x3, int y3, int x4, int y4);
+
   } // namespace algorithm
 } // namespace doc
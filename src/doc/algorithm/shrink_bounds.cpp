@@ -14,186 +14,230 @@
 #include "doc/image_impl.h"
 #include "doc/primitives_fast.h"
 
+#include <algorithm>
+
 namespace doc {
 namespace algorithm {
 
 namespace {
 
+// Pixels are compared in chunks (without branches inside a chunk) so
+// the compiler can compare several pixels with one instruction.
+const int kChunkSize = 32;
+
+// Returns a non-zero value for each pixel of the current row that
+// is different from the reference pixel. Transparent pixels are
+// equal in RGB and grayscale images.
 template<typename ImageTraits>
-bool is_same_pixel(color_t pixel1, color_t pixel2)
-{
-  static_assert(false && sizeof(ImageTraits), "No is_same_pixel impl");
-  return false;
-}
+class RefPixelRow {
+public:
+  typedef typename ImageTraits::pixel_t pixel_t;
 
-template<>
-bool is_same_pixel<RgbTraits>(color_t pixel1, color_t pixel2)
-{
-  return (rgba_geta(pixel1) == 0 && rgba_geta(pixel2) == 0) || (pixel1 == pixel2);
-}
+  RefPixelRow(const Image* image, color_t refpixel)
+    : m_image(image)
+    , m_row(nullptr)
+    , m_ref(pixel_t(refpixel))
+    , m_mask(pixel_t(~0)) {
+  }
+
+  void setRow(int y) {
+    m_row = (const pixel_t*)m_image->getPixelAddress(0, y);
+  }
+
+  pixel_t operator()(int x) const {
+    return (m_row[x] ^ m_ref) & m_mask;
+  }
+
+protected:
+  const Image* m_image;
+  const pixel_t* m_row;
+  pixel_t m_ref;
+  pixel_t m_mask;
+};
 
 template<>
-bool is_same_pixel<GrayscaleTraits>(color_t pixel1, color_t pixel2)
+RefPixelRow<RgbTraits>::RefPixelRow(const Image* image, color_t refpixel)
+  : m_image(image)
+  , m_row(nullptr)
+  , m_ref(refpixel)
+  , m_mask(rgba_geta(refpixel) == 0 ? rgba_a_mask: pixel_t(~0))
 {
-  return (graya_geta(pixel1) == 0 && graya_geta(pixel2) == 0) || (pixel1 == pixel2);
 }
 
 template<>
-bool is_same_pixel<IndexedTraits>(color_t pixel1, color_t pixel2)
+RefPixelRow<GrayscaleTraits>::RefPixelRow(const Image* image, color_t refpixel)
+  : m_image(image)
+  , m_row(nullptr)
+  , m_ref(pixel_t(refpixel))
+  , m_mask(graya_geta(refpixel) == 0 ? graya_a_mask: pixel_t(~0))
 {
-  return pixel1 == pixel2;
 }
 
+// Bitmaps have 8 pixels per byte
 template<>
-bool is_same_pixel<BitmapTraits>(color_t pixel1, color_t pixel2)
-{
-  return pixel1 == pixel2;
-}
+class RefPixelRow<BitmapTraits> {
+public:
+  typedef BitmapTraits::pixel_t pixel_t;
+
+  RefPixelRow(const Image* image, color_t refpixel)
+    : m_image(image), m_y(0), m_ref(pixel_t(refpixel)) {
+  }
 
+  void setRow(int y) { m_y = y; }
+
+  pixel_t operator()(int x) const {
+    return get_pixel_fast<BitmapTraits>(m_image, x, m_y) ^ m_ref;
+  }
+
+private:
+  const Image* m_image;
+  int m_y;
+  pixel_t m_ref;
+};
+
+// Returns a non-zero value for each pixel of the current row that
+// is different in both images.
 template<typename ImageTraits>
-bool shrink_bounds_templ(const Image* image, gfx::Rect& bounds, color_t refpixel)
-{
-  bool shrink;
-  int u, v;
-
-  // Shrink left side
-  for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-    shrink = true;
-    for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-      if (!is_same_pixel<ImageTraits>(
-            get_pixel_fast<ImageTraits>(image, u, v), refpixel)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
-      break;
-    ++bounds.x;
-    --bounds.w;
-  }
-
-  // Shrink right side
-  for (u=bounds.x+bounds.w-1; u>=bounds.x; --u) {
-    shrink = true;
-    for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-      if (!is_same_pixel<ImageTraits>(
-            get_pixel_fast<ImageTraits>(image, u, v), refpixel)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
-      break;
-    --bounds.w;
+class ImagesDiffRow {
+public:
+  typedef typename ImageTraits::pixel_t pixel_t;
+
+  ImagesDiffRow(const Image* a, const Image* b)
+    : m_a(a), m_b(b), m_rowA(nullptr), m_rowB(nullptr) {
   }
 
-  // Shrink top side
-  for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-    shrink = true;
-    for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-      if (!is_same_pixel<ImageTraits>(
-            get_pixel_fast<ImageTraits>(image, u, v), refpixel)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
-      break;
-    ++bounds.y;
-    --bounds.h;
+  void setRow(int y) {
+    m_rowA = (const pixel_t*)m_a->getPixelAddress(0, y);
+    m_rowB = (const pixel_t*)m_b->getPixelAddress(0, y);
   }
 
-  // Shrink bottom side
-  for (v=bounds.y+bounds.h-1; v>=bounds.y; --v) {
-    shrink = true;
-    for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-      if (!is_same_pixel<ImageTraits>(
-            get_pixel_fast<ImageTraits>(image, u, v), refpixel)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
-      break;
-    --bounds.h;
+  pixel_t operator()(int x) const {
+    return m_rowA[x] ^ m_rowB[x];
   }
 
-  return (!bounds.isEmpty());
-}
+private:
+  const Image* m_a;
+  const Image* m_b;
+  const pixel_t* m_rowA;
+  const pixel_t* m_rowB;
+};
 
-template<typename ImageTraits>
-bool shrink_bounds_templ2(const Image* a, const Image* b, gfx::Rect& bounds)
+template<>
+class ImagesDiffRow<BitmapTraits> {
+public:
+  typedef BitmapTraits::pixel_t pixel_t;
+
+  ImagesDiffRow(const Image* a, const Image* b)
+    : m_a(a), m_b(b), m_y(0) {
+  }
+
+  void setRow(int y) { m_y = y; }
+
+  pixel_t operator()(int x) const {
+    return (get_pixel_fast<BitmapTraits>(m_a, x, m_y) ^
+            get_pixel_fast<BitmapTraits>(m_b, x, m_y));
+  }
+
+private:
+  const Image* m_a;
+  const Image* m_b;
+  int m_y;
+};
+
+// Returns the first different pixel in [begin, end) or "end"
+template<typename Row>
+int first_diff(const Row& row, int begin, int end)
 {
-  bool shrink;
-  int u, v;
-
-  // Shrink left side
-  for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-    shrink = true;
-    for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-      if (get_pixel_fast<ImageTraits>(a, u, v) !=
-          get_pixel_fast<ImageTraits>(b, u, v)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
+  int x = begin;
+  for (; x+kChunkSize <= end; x += kChunkSize) {
+    typename Row::pixel_t diff = 0;
+    for (int i=0; i<kChunkSize; ++i)
+      diff |= row(x+i);
+    if (diff)
       break;
-    ++bounds.x;
-    --bounds.w;
-  }
-
-  // Shrink right side
-  for (u=bounds.x+bounds.w-1; u>=bounds.x; --u) {
-    shrink = true;
-    for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-      if (get_pixel_fast<ImageTraits>(a, u, v) !=
-          get_pixel_fast<ImageTraits>(b, u, v)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
+  }
+  for (; x<end; ++x) {
+    if (row(x))
+      return x;
+  }
+  return end;
+}
+
+// Returns the last different pixel in [begin, end) or "begin-1"
+template<typename Row>
+int last_diff(const Row& row, int begin, int end)
+{
+  int x = end;
+  for (; x-kChunkSize >= begin; x -= kChunkSize) {
+    typename Row::pixel_t diff = 0;
+    for (int i=x-kChunkSize; i<x; ++i)
+      diff |= row(i);
+    if (diff)
       break;
-    --bounds.w;
   }
+  while (--x >= begin) {
+    if (row(x))
+      return x;
+  }
+  return begin-1;
+}
+
+// Finds the bounds of the different pixels reading the image row by
+// row (instead of column by column, which is slow for wide images).
+// The top and bottom rows are found first, and then the rows between
+// them are checked only until the first/last known different pixel.
+template<typename Row>
+bool shrink_bounds_templ(Row& row, gfx::Rect& bounds)
+{
+  const int x1 = bounds.x;
+  const int x2 = bounds.x+bounds.w;
+  int top = bounds.y;
+  int bottom = bounds.y+bounds.h-1;
+  int left = x2;
+  int right = x1-1;
 
   // Shrink top side
-  for (v=bounds.y; v<bounds.y+bounds.h; ++v) {
-    shrink = true;
-    for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-      if (get_pixel_fast<ImageTraits>(a, u, v) !=
-          get_pixel_fast<ImageTraits>(b, u, v)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
+  for (; top<=bottom; ++top) {
+    row.setRow(top);
+    left = first_diff(row, x1, x2);
+    if (left < x2) {
+      right = last_diff(row, left, x2);
       break;
-    ++bounds.y;
-    --bounds.h;
+    }
+  }
+
+  // All pixels are equal
+  if (top > bottom) {
+    bounds.x += bounds.w;
+    bounds.y += bounds.h;
+    bounds.w = bounds.h = 0;
+    return false;
   }
 
   // Shrink bottom side
-  for (v=bounds.y+bounds.h-1; v>=bounds.y; --v) {
-    shrink = true;
-    for (u=bounds.x; u<bounds.x+bounds.w; ++u) {
-      if (get_pixel_fast<ImageTraits>(a, u, v) !=
-          get_pixel_fast<ImageTraits>(b, u, v)) {
-        shrink = false;
-        break;
-      }
-    }
-    if (!shrink)
+  for (; bottom>top; --bottom) {
+    row.setRow(bottom);
+    const int x = first_diff(row, x1, x2);
+    if (x < x2) {
+      left = std::min(left, x);
+      right = std::max(right, last_diff(row, x, x2));
       break;
-    --bounds.h;
+    }
   }
 
-  return (!bounds.isEmpty());
-}
+  // Shrink left and right sides
+  for (int y=top+1; y<bottom && (left > x1 || right < x2-1); ++y) {
+    row.setRow(y);
+    left = first_diff(row, x1, left);
+    right = std::max(right, last_diff(row, right+1, x2));
+  }
 
+  bounds = gfx::Rect(left, top, right-left+1, bottom-top+1);
+  return true;
 }
 
+} // anonymous namespace
+
 bool shrink_bounds(const Image* image,
                    const gfx::Rect& start_bounds,
                    gfx::Rect& bounds,
@@ -201,10 +245,22 @@ bool shrink_bounds(const Image* image,
 {
   bounds = (start_bounds & image->bounds());
   switch (image->pixelFormat()) {
-    case IMAGE_RGB:       return shrink_bounds_templ<RgbTraits>(image, bounds, refpixel);
-    case IMAGE_GRAYSCALE: return shrink_bounds_templ<GrayscaleTraits>(image, bounds, refpixel);
-    case IMAGE_INDEXED:   return shrink_bounds_templ<IndexedTraits>(image, bounds, refpixel);
-    case IMAGE_BITMAP:    return shrink_bounds_templ<BitmapTraits>(image, bounds, refpixel);
+    case IMAGE_RGB: {
+      RefPixelRow<RgbTraits> row(image, refpixel);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_GRAYSCALE: {
+      RefPixelRow<GrayscaleTraits> row(image, refpixel);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_INDEXED: {
+      RefPixelRow<IndexedTraits> row(image, refpixel);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_BITMAP: {
+      RefPixelRow<BitmapTraits> row(image, refpixel);
+      return shrink_bounds_templ(row, bounds);
+    }
   }
   ASSERT(false);
   return false;
@@ -225,10 +281,22 @@ bool shrink_bounds2(const Image* a, const Image* b,
   bounds = (start_bounds & a->bounds());
 
   switch (a->pixelFormat()) {
-    case IMAGE_RGB:       return shrink_bounds_templ2<RgbTraits>(a, b, bounds);
-    case IMAGE_GRAYSCALE: return shrink_bounds_templ2<GrayscaleTraits>(a, b, bounds);
-    case IMAGE_INDEXED:   return shrink_bounds_templ2<IndexedTraits>(a, b, bounds);
-    case IMAGE_BITMAP:    return shrink_bounds_templ2<BitmapTraits>(a, b, bounds);
+    case IMAGE_RGB: {
+      ImagesDiffRow<RgbTraits> row(a, b);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_GRAYSCALE: {
+      ImagesDiffRow<GrayscaleTraits> row(a, b);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_INDEXED: {
+      ImagesDiffRow<IndexedTraits> row(a, b);
+      return shrink_bounds_templ(row, bounds);
+    }
+    case IMAGE_BITMAP: {
+      ImagesDiffRow<BitmapTraits> row(a, b);
+      return shrink_bounds_templ(row, bounds);
+    }
   }
   ASSERT(false);
   return false;
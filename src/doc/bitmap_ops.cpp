@@ -0,0 +1,209 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "doc/bitmap_ops.h"
+
+#include "base/debug.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace doc {
+
+namespace {
+
+inline uint64_t low_bits(int n)
+{
+  return (n >= 64 ? ~uint64_t(0): (uint64_t(1) << n) - 1);
+}
+
+// Loads 8 bytes as a little-endian word (compilers generate only one
+// load in little-endian platforms)
+inline uint64_t load8(const uint8_t* p)
+{
+  uint64_t v = 0;
+  for (int i=0; i<8; ++i)
+    v |= uint64_t(p[i]) << (8*i);
+  return v;
+}
+
+inline void store8(uint8_t* p, uint64_t v)
+{
+  for (int i=0; i<8; ++i)
+    p[i] = uint8_t(v >> (8*i));
+}
+
+// Returns "n" pixels (1 <= n <= 64) starting at "x" as the lowest
+// bits of the returned word. It doesn't read bytes outside the range.
+inline uint64_t read_bits(const uint8_t* row, int x, int n)
+{
+  const uint8_t* p = row + (x >> 3);
+  const int shift = (x & 7);
+  const int nbytes = (shift + n + 7) >> 3;
+  uint64_t v;
+
+  if (nbytes >= 8) {
+    v = load8(p) >> shift;
+    if (nbytes > 8)
+      v |= uint64_t(p[8]) << (64 - shift);
+  }
+  else {
+    v = 0;
+    for (int i=0; i<nbytes; ++i)
+      v |= uint64_t(p[i]) << (8*i);
+    v >>= shift;
+  }
+  return v & low_bits(n);
+}
+
+// Writes the lowest "n" bits of "v" (1 <= n <= 64) as the pixels
+// starting at "x".
+inline void write_bits(uint8_t* row, int x, int n, uint64_t v)
+{
+  uint8_t* p = row + (x >> 3);
+  int shift = (x & 7);
+
+  if (shift == 0 && n == 64) {
+    store8(p, v);
+    return;
+  }
+
+  while (n > 0) {
+    const int k = std::min(8 - shift, n);
+    const uint8_t mask = uint8_t(((1 << k) - 1) << shift);
+    *p = uint8_t((*p & ~mask) | ((uint8_t(v) << shift) & mask));
+    v >>= k;
+    n -= k;
+    shift = 0;
+    ++p;
+  }
+}
+
+} // anonymous namespace
+
+uint64_t bitmap_row_bits(const uint8_t* row, int x, int n)
+{
+  ASSERT(n >= 1 && n <= 64);
+  return read_bits(row, x, n);
+}
+
+void bitmap_row_op(uint8_t* dst, int dstX,
+                   const uint8_t* src, int srcX,
+                   int w, BitmapOp op)
+{
+  while (w > 0) {
+    // After the first chunk "dstX" is aligned to a byte
+    const int n = std::min(w, 64 - (dstX & 7));
+    uint64_t v = read_bits(src, srcX, n);
+
+    switch (op) {
+      case BitmapOp::Copy: break;
+      case BitmapOp::Or: v = read_bits(dst, dstX, n) | v; break;
+      case BitmapOp::And: v = read_bits(dst, dstX, n) & v; break;
+      case BitmapOp::AndNot: v = read_bits(dst, dstX, n) & ~v; break;
+    }
+
+    write_bits(dst, dstX, n, v);
+    dstX += n;
+    srcX += n;
+    w -= n;
+  }
+}
+
+void bitmap_row_fill(uint8_t* row, int x, int w, bool value)
+{
+  if (w <= 0)
+    return;
+
+  const uint64_t bits = (value ? ~uint64_t(0): 0);
+
+  // Pixels until the next byte
+  const int head = std::min(w, (8 - (x & 7)) & 7);
+  if (head > 0) {
+    write_bits(row, x, head, bits);
+    x += head;
+    w -= head;
+  }
+
+  std::memset(row + (x >> 3), (value ? 0xff: 0), w >> 3);
+  x += (w & ~7);
+  w &= 7;
+
+  if (w > 0)
+    write_bits(row, x, w, bits);
+}
+
+void bitmap_row_invert(uint8_t* row, int w)
+{
+  const int bytes = (w >> 3);
+  for (int i=0; i<bytes; ++i)
+    row[i] = uint8_t(~row[i]);
+
+  if (w & 7)
+    row[bytes] ^= uint8_t((1 << (w & 7)) - 1);
+}
+
+int bitmap_row_count(const uint8_t* row, int w)
+{
+  int count = 0;
+  int x = 0;
+  for (; x+64 <= w; x += 64)
+    count += std::popcount(read_bits(row, x, 64));
+  if (x < w)
+    count += std::popcount(read_bits(row, x, w-x));
+  return count;
+}
+
+int bitmap_row_first(const uint8_t* row, int w)
+{
+  for (int x=0; x<w; x+=64) {
+    const uint64_t v = read_bits(row, x, std::min(64, w-x));
+    if (v)
+      return x + std::countr_zero(v);
+  }
+  return -1;
+}
+
+int bitmap_row_last(const uint8_t* row, int w)
+{
+  if (w <= 0)
+    return -1;
+
+  int x = ((w-1) / 64) * 64;
+  int n = w - x;
+  for (; x >= 0; x -= 64, n = 64) {
+    const uint64_t v = read_bits(row, x, n);
+    if (v)
+      return x + 63 - std::countl_zero(v);
+  }
+  return -1;
+}
+
+void bitmap_row_pack(uint8_t* row, const uint8_t* flags, int w)
+{
+  int x = 0;
+  for (; x+8 <= w; x += 8, flags += 8) {
+    ASSERT(flags[0] <= 1 && flags[7] <= 1);
+    row[x >> 3] = uint8_t(flags[0]        | (flags[1] << 1) |
+                          (flags[2] << 2) | (flags[3] << 3) |
+                          (flags[4] << 4) | (flags[5] << 5) |
+                          (flags[6] << 6) | (flags[7] << 7));
+  }
+
+  if (x < w) {
+    uint8_t byte = 0;
+    for (int i=0; x+i < w; ++i)
+      byte |= uint8_t(flags[i] << i);
+    row[x >> 3] = byte;
+  }
+}
+
+} // namespace doc
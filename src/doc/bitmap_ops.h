@@ -0,0 +1,52 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include <cstdint>
+
+namespace doc {
+
+  // Operations over rows of IMAGE_BITMAP images (1 bit per pixel, the
+  // pixel "x" is the bit "x%8" of the byte "x/8"). They process up to
+  // 64 pixels at the same time. The padding bits at the end of each
+  // row are never read, and they can be modified by these functions.
+
+  enum class BitmapOp {
+    Copy,                       // dst = src
+    Or,                         // dst = dst | src
+    And,                        // dst = dst & src
+    AndNot,                     // dst = dst & ~src
+  };
+
+  // Returns "n" pixels (1 <= n <= 64) starting at "x" as the lowest
+  // bits of the returned word (the pixel "x" is the bit 0).
+  uint64_t bitmap_row_bits(const uint8_t* row, int x, int n);
+
+  // Combines "w" pixels from the "src" row starting at "srcX" with
+  // "w" pixels of the "dst" row starting at "dstX".
+  void bitmap_row_op(uint8_t* dst, int dstX,
+                     const uint8_t* src, int srcX,
+                     int w, BitmapOp op);
+
+  // Sets "w" pixels starting at "x" to 1 or 0.
+  void bitmap_row_fill(uint8_t* row, int x, int w, bool value);
+
+  // Inverts the first "w" pixels of the row.
+  void bitmap_row_invert(uint8_t* row, int w);
+
+  // Returns the number of pixels with 1 in the first "w" pixels.
+  int bitmap_row_count(const uint8_t* row, int w);
+
+  // Returns the first/last pixel with 1 in the first "w" pixels, or
+  // -1 if all of them are 0.
+  int bitmap_row_first(const uint8_t* row, int w);
+  int bitmap_row_last(const uint8_t* row, int w);
+
+  // Packs "w" flags (0 or 1, one per byte) into the row.
+  void bitmap_row_pack(uint8_t* row, const uint8_t* flags, int w);
+
+} // namespace doc
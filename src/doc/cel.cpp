@@ -124,6 +124,11 @@ std::size_t Cel::links() const
   return links;
 }
 
+bool Cel::isCopyOnWrite() const
+{
+  return (m_data->isCopyOnWrite() && links() > 0);
+}
+
 gfx::Rect Cel::bounds() const
 {
   auto image = this->image();
@@ -46,6 +46,11 @@ namespace doc {
     std::size_t links() const;
     gfx::Rect bounds() const;
 
+    // Returns true if the cel shares a copy-on-write CelData with
+    // other cels, i.e. it has to be unlinked before modifying its
+    // image (other cels must keep the original pixels).
+    bool isCopyOnWrite() const;
+
     // You should change the frame only if the cel isn't member of a
     // layer. If the cel is already in a layer, you should use
     // LayerImage::moveCel() member function.
@@ -22,6 +22,7 @@ CelData::CelData(const ImageRef& image)
   , m_image(image)
   , m_position(0, 0)
   , m_opacity(255)
+  , m_copyOnWrite(false)
 {
 }
 
@@ -30,6 +31,7 @@ CelData::CelData(const CelData& celData)
   , m_image(celData.m_image)
   , m_position(celData.m_position)
   , m_opacity(celData.m_opacity)
+  , m_copyOnWrite(false)        // The copy isn't shared yet
 {
 }
 
@@ -20,6 +20,7 @@ namespace doc {
 
     const gfx::Point& position() const { return m_position; }
     int opacity() const { return m_opacity; }
+    bool isCopyOnWrite() const { return m_copyOnWrite; }
     Image* image() const { return const_cast<Image*>(m_image.get()); };
     ImageRef imageRef() const { return m_image; }
 
@@ -31,6 +32,12 @@ namespace doc {
     void setPosition(const gfx::Point& pos) { m_position = pos; }
     void setOpacity(int opacity) { m_opacity = opacity; }
 
+    // Cels that share a copy-on-write CelData aren't linked by the
+    // user, they share it only to save memory (see
+    // algorithm::link_identical_cels()). So a cel must be unlinked
+    // before its image is modified (see Cel::isCopyOnWrite()).
+    void setCopyOnWrite(bool state) { m_copyOnWrite = state; }
+
     virtual int getMemSize() const override {
       ASSERT(m_image);
       return sizeof(CelData) + m_image->getMemSize();
@@ -40,6 +47,7 @@ namespace doc {
     ImageRef m_image;
     gfx::Point m_position;      // X/Y screen position
     int m_opacity;              // Opacity level
+    bool m_copyOnWrite;
   };
 
   typedef base::SharedPtr<CelData> CelDataRef;
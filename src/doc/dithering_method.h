@@ -12,6 +12,11 @@ namespace doc {
   enum class DitheringMethod {
     NONE,
     ORDERED,
+
+    // Error diffusion methods (see render::ErrorDiffusionMatrix)
+    FLOYD_STEINBERG,
+    JARVIS_JUDICE_NINKE,
+    ATKINSON,
   };
 
 } // namespace doc
@@ -0,0 +1,136 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/algorithm/identical_cels.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/sprite.h"
+
+#include <memory>
+
+using namespace doc;
+
+static ImageRef create_image(int seed)
+{
+  ImageRef image(Image::create(IMAGE_RGB, 37, 21));
+  for (int y=0; y<image->height(); ++y)
+    for (int x=0; x<image->width(); ++x)
+      image->putPixel(x, y, rgba(x*seed, y*seed, x+y, 255));
+  return image;
+}
+
+static std::shared_ptr<Cel> add_cel(LayerImage* layer, frame_t frame,
+                                    const ImageRef& image,
+                                    int x = 0, int y = 0)
+{
+  auto cel = std::make_shared<Cel>(frame, image);
+  cel->setPosition(x, y);
+  layer->addCel(cel);
+  return cel;
+}
+
+// lay1 = A A' B A(moved) A'(linked by the user) B'
+// lay2 = A
+TEST(IdenticalCels, LinkSameContentInSameLayer)
+{
+  std::unique_ptr<Sprite> spr(new Sprite(IMAGE_RGB, 64, 64, 256));
+  spr->setTotalFrames(6);
+
+  LayerImage* lay1 = new LayerImage(spr.get());
+  LayerImage* lay2 = new LayerImage(spr.get());
+  spr->folder()->addLayer(lay1);
+  spr->folder()->addLayer(lay2);
+
+  auto cel0 = add_cel(lay1, 0, create_image(1));
+  auto cel1 = add_cel(lay1, 1, create_image(1));
+  auto cel2 = add_cel(lay1, 2, create_image(2));
+  auto cel3 = add_cel(lay1, 3, create_image(1), 1, 0);
+  auto cel4 = Cel::createLink(cel1);
+  cel4->setFrame(4);
+  lay1->addCel(cel4);
+  auto cel5 = add_cel(lay1, 5, create_image(2));
+  auto cel6 = add_cel(lay2, 0, create_image(1));
+
+  // Same pixels with different user data
+  cel3->data()->setPosition(0, 0);
+  UserData userData;
+  userData.setText("different");
+  cel3->data()->setUserData(userData);
+
+  // cel1 and cel4 are linked by the user, so they are kept as they are
+  std::vector<algorithm::IdenticalCel> cels = algorithm::find_identical_cels(spr.get());
+  ASSERT_EQ(1, cels.size());
+  EXPECT_EQ(cel5, cels[0].first);
+  EXPECT_EQ(cel2, cels[0].second);
+
+  EXPECT_EQ(1, algorithm::link_identical_cels(spr.get()));
+  EXPECT_EQ(cel2->data(), cel5->data());
+  EXPECT_EQ(cel1->data(), cel4->data());
+  EXPECT_NE(cel0->data(), cel1->data());
+  EXPECT_NE(cel0->data(), cel3->data());
+  EXPECT_NE(cel0->data(), cel6->data());
+
+  EXPECT_TRUE(cel2->isCopyOnWrite());
+  EXPECT_TRUE(cel5->isCopyOnWrite());
+  EXPECT_FALSE(cel1->isCopyOnWrite());
+  EXPECT_FALSE(cel4->isCopyOnWrite());
+  EXPECT_FALSE(cel0->isCopyOnWrite());
+
+  EXPECT_EQ(0, algorithm::find_identical_cels(spr.get()).size());
+}
+
+TEST(IdenticalCels, AddToCopyOnWriteCels)
+{
+  std::unique_ptr<Sprite> spr(new Sprite(IMAGE_RGB, 64, 64, 256));
+  spr->setTotalFrames(4);
+
+  LayerImage* lay = new LayerImage(spr.get());
+  spr->folder()->addLayer(lay);
+
+  auto cel0 = add_cel(lay, 0, create_image(4));
+  auto cel1 = add_cel(lay, 1, create_image(4));
+  EXPECT_EQ(1, algorithm::link_identical_cels(spr.get()));
+
+  // Copy-on-write cels can be linked with more identical cels
+  auto cel2 = add_cel(lay, 2, create_image(4));
+  auto cel3 = add_cel(lay, 3, create_image(5));
+  EXPECT_EQ(1, algorithm::link_identical_cels(spr.get()));
+  EXPECT_EQ(cel0->data(), cel1->data());
+  EXPECT_EQ(cel0->data(), cel2->data());
+  EXPECT_TRUE(cel2->isCopyOnWrite());
+  EXPECT_FALSE(cel3->isCopyOnWrite());
+
+  // A copy of the data (e.g. to unlink a cel) isn't copy-on-write
+  CelData copy(*cel0->data());
+  EXPECT_FALSE(copy.isCopyOnWrite());
+}
+
+TEST(IdenticalCels, DifferentPosition)
+{
+  std::unique_ptr<Sprite> spr(new Sprite(IMAGE_RGB, 64, 64, 256));
+  spr->setTotalFrames(2);
+
+  LayerImage* lay = new LayerImage(spr.get());
+  spr->folder()->addLayer(lay);
+
+  add_cel(lay, 0, create_image(3), 0, 0);
+  add_cel(lay, 1, create_image(3), 0, 1);
+
+  EXPECT_EQ(0, algorithm::link_identical_cels(spr.get()));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,7 +26,7 @@ using namespace base::serialization::little_endian;
 
 // TODO Create a zlib wrapper for iostreams
 
-void write_image(std::ostream& os, const Image* image)
+void write_image(std::ostream& os, const Image* image, int compressionLevel)
 {
   write32(os, image->id());
   write8(os, image->pixelFormat());    // Pixel format
@@ -49,7 +49,7 @@ void write_image(std::ostream& os, const Image* image)
     zstream.zalloc = (alloc_func)0;
     zstream.zfree  = (free_func)0;
     zstream.opaque = (voidpf)0;
-    int err = deflateInit(&zstream, Z_DEFAULT_COMPRESSION);
+    int err = deflateInit(&zstream, compressionLevel);
     if (err != Z_OK)
       throw base::Exception("ZLib error %d in deflateInit().", err);
 
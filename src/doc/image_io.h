@@ -12,7 +12,9 @@ namespace doc {
 
   class Image;
 
-  void write_image(std::ostream& os, const Image* image);
+  // The compression level goes from 1 (fastest) to 9 (smallest
+  // output), -1 is the zlib default.
+  void write_image(std::ostream& os, const Image* image, int compressionLevel = -1);
   Image* read_image(std::istream& is, bool setId = true);
 
 } // namespace doc
@@ -0,0 +1,326 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "doc/images_diff.h"
+
+#include "base/debug.h"
+#include "base/parallel_for.h"
+#include "doc/algorithm/shrink_bounds.h"
+#include "doc/image.h"
+#include "doc/image_impl.h"
+#include "doc/primitives_fast.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace doc {
+
+namespace {
+
+// Pixels compared without branches
+const int kChunkSize = 32;
+
+// Minimum number of pixels compared by each thread
+const int kPixelsPerTask = 64*1024;
+
+// Returns true for each pixel of the current row that is different
+// in both images.
+template<typename ImageTraits>
+class RowDiff {
+public:
+  typedef typename ImageTraits::pixel_t pixel_t;
+
+  RowDiff(const Image* a, const Image* b)
+    : m_a(a), m_b(b), m_rowA(nullptr), m_rowB(nullptr) {
+  }
+
+  void setRow(int y) {
+    m_rowA = (const pixel_t*)m_a->getPixelAddress(0, y);
+    m_rowB = (const pixel_t*)m_b->getPixelAddress(0, y);
+  }
+
+  bool operator()(int x) const {
+    return m_rowA[x] != m_rowB[x];
+  }
+
+private:
+  const Image* m_a;
+  const Image* m_b;
+  const pixel_t* m_rowA;
+  const pixel_t* m_rowB;
+};
+
+// Bitmaps have 8 pixels per byte
+template<>
+class RowDiff<BitmapTraits> {
+public:
+  RowDiff(const Image* a, const Image* b)
+    : m_a(a), m_b(b), m_y(0) {
+  }
+
+  void setRow(int y) { m_y = y; }
+
+  bool operator()(int x) const {
+    return (get_pixel_fast<BitmapTraits>(m_a, x, m_y) !=
+            get_pixel_fast<BitmapTraits>(m_b, x, m_y));
+  }
+
+private:
+  const Image* m_a;
+  const Image* m_b;
+  int m_y;
+};
+
+// Number of different pixels in [x, x+kChunkSize)
+template<typename Row>
+inline int count_chunk(const Row& row, int x)
+{
+  int n = 0;
+  for (int i=0; i<kChunkSize; ++i)
+    n += (row(x+i) ? 1: 0);
+  return n;
+}
+
+template<typename Row>
+bool any_diff(Row& row, const gfx::Rect& bounds)
+{
+  const int x2 = bounds.x2();
+  for (int y=bounds.y; y<bounds.y2(); ++y) {
+    row.setRow(y);
+
+    int x = bounds.x;
+    for (; x+kChunkSize <= x2; x += kChunkSize)
+      if (count_chunk(row, x))
+        return true;
+    for (; x<x2; ++x)
+      if (row(x))
+        return true;
+  }
+  return false;
+}
+
+// Results of a group of rows
+struct RowsDiff {
+  int count = 0;
+  int left = INT_MAX, top = INT_MAX;
+  int right = INT_MIN, bottom = INT_MIN;  // Inclusive
+  std::vector<gfx::Rect> rects;
+};
+
+template<typename Row>
+void diff_rows(Row& row, int x1, int x2, int y1, int y2,
+               bool positions, int gap, RowsDiff& result)
+{
+  // Runs of different pixels of the current row, and rectangles of
+  // previous rows that end in the current row (they are extended
+  // while the next rows have the same runs).
+  std::vector<gfx::Rect> runs;
+  std::vector<gfx::Rect> open;
+  int runStart = -1;
+  int runEnd = -1;
+
+  auto addPixels = [&](int u, int v) {
+    if (runStart >= 0 && u - runEnd < gap) {
+      runEnd = v;
+    }
+    else {
+      if (runStart >= 0)
+        runs.push_back(gfx::Rect(runStart, 0, runEnd-runStart, 1));
+      runStart = u;
+      runEnd = v;
+    }
+  };
+
+  for (int y=y1; y<y2; ++y) {
+    row.setRow(y);
+    runs.clear();
+    runStart = runEnd = -1;
+
+    int x = x1;
+    int rowCount = 0;
+    for (; x+kChunkSize <= x2; x += kChunkSize) {
+      const int n = count_chunk(row, x);
+      if (!n)
+        continue;
+
+      rowCount += n;
+      if (!positions)
+        continue;
+
+      if (n == kChunkSize)
+        addPixels(x, x+kChunkSize);
+      else {
+        for (int i=0; i<kChunkSize; ++i)
+          if (row(x+i))
+            addPixels(x+i, x+i+1);
+      }
+    }
+    for (; x<x2; ++x) {
+      if (row(x)) {
+        ++rowCount;
+        if (positions)
+          addPixels(x, x+1);
+      }
+    }
+    if (runStart >= 0)
+      runs.push_back(gfx::Rect(runStart, 0, runEnd-runStart, 1));
+
+    result.count += rowCount;
+    if (!positions)
+      continue;
+
+    if (!runs.empty()) {
+      result.left = std::min(result.left, runs.front().x);
+      result.right = std::max(result.right, runs.back().x2()-1);
+      result.top = std::min(result.top, y);
+      result.bottom = y;
+    }
+
+    // Extend the open rectangles if this row has the same runs
+    bool same = (runs.size() == open.size());
+    for (std::size_t i=0; same && i<runs.size(); ++i)
+      same = (runs[i].x == open[i].x && runs[i].w == open[i].w);
+
+    if (same) {
+      for (gfx::Rect& rc : open)
+        ++rc.h;
+    }
+    else {
+      result.rects.insert(result.rects.end(), open.begin(), open.end());
+      open = runs;
+      for (gfx::Rect& rc : open)
+        rc.y = y;
+    }
+  }
+
+  result.rects.insert(result.rects.end(), open.begin(), open.end());
+}
+
+template<typename ImageTraits>
+bool compare_templ(const Image* a, const Image* b,
+                   const gfx::Rect& bounds,
+                   int flags, int gap,
+                   int& count, gfx::Rect& diffBounds, gfx::Region& region)
+{
+  if (flags == ImagesDiff::kAny) {
+    RowDiff<ImageTraits> row(a, b);
+    return any_diff(row, bounds);
+  }
+
+  // Groups of rows compared by each thread
+  const int grain = std::max(1, kPixelsPerTask / bounds.w);
+  const bool positions = (flags & (ImagesDiff::kBounds |
+                                   ImagesDiff::kRegion)) != 0;
+  std::vector<RowsDiff> results((bounds.h + grain - 1) / grain);
+
+  base::parallel_for(
+    bounds.y, bounds.y2(), grain,
+    [&](int y1, int y2) {
+      RowDiff<ImageTraits> row(a, b);
+      diff_rows(row, bounds.x, bounds.x2(), y1, y2, positions, gap,
+                results[(y1 - bounds.y) / grain]);
+    });
+
+  RowsDiff all;
+  std::vector<gfx::Rect> rects;
+  for (const RowsDiff& result : results) {
+    all.count += result.count;
+    all.left = std::min(all.left, result.left);
+    all.top = std::min(all.top, result.top);
+    all.right = std::max(all.right, result.right);
+    all.bottom = std::max(all.bottom, result.bottom);
+    if (flags & ImagesDiff::kRegion)
+      rects.insert(rects.end(), result.rects.begin(), result.rects.end());
+  }
+
+  count = all.count;
+  if (positions && all.left <= all.right)
+    diffBounds = gfx::Rect(all.left, all.top,
+                           all.right - all.left + 1,
+                           all.bottom - all.top + 1);
+  if (flags & ImagesDiff::kRegion)
+    region = gfx::Region(rects);
+
+  return (all.count > 0);
+}
+
+} // anonymous namespace
+
+ImagesDiff::ImagesDiff(int flags)
+  : m_flags(flags)
+  , m_gap(1)
+  , m_empty(true)
+  , m_count(0)
+{
+}
+
+void ImagesDiff::setRegionGap(int gap)
+{
+  m_gap = std::max(1, gap);
+}
+
+bool ImagesDiff::compare(const Image* a, const Image* b)
+{
+  return compare(a, b, a->bounds());
+}
+
+bool ImagesDiff::compare(const Image* a, const Image* b, const gfx::Rect& bounds)
+{
+  ASSERT(a->pixelFormat() == b->pixelFormat());
+  ASSERT(a->bounds() == b->bounds());
+
+  m_empty = true;
+  m_count = 0;
+  m_bounds = gfx::Rect();
+  m_region.clear();
+
+  const gfx::Rect rc = (bounds & a->bounds());
+  if (rc.isEmpty())
+    return false;
+
+  // The fastest way to get only the bounds is to shrink them from
+  // the sides
+  if (m_flags == kBounds) {
+    if (algorithm::shrink_bounds2(a, b, rc, m_bounds))
+      m_empty = false;
+    else
+      m_bounds = gfx::Rect();
+    return !m_empty;
+  }
+
+  bool result = false;
+  switch (a->pixelFormat()) {
+    case IMAGE_RGB:
+      result = compare_templ<RgbTraits>(a, b, rc, m_flags, m_gap,
+                                        m_count, m_bounds, m_region);
+      break;
+    case IMAGE_GRAYSCALE:
+      result = compare_templ<GrayscaleTraits>(a, b, rc, m_flags, m_gap,
+                                              m_count, m_bounds, m_region);
+      break;
+    case IMAGE_INDEXED:
+      result = compare_templ<IndexedTraits>(a, b, rc, m_flags, m_gap,
+                                            m_count, m_bounds, m_region);
+      break;
+    case IMAGE_BITMAP:
+      result = compare_templ<BitmapTraits>(a, b, rc, m_flags, m_gap,
+                                           m_count, m_bounds, m_region);
+      break;
+    default:
+      ASSERT(false);
+      break;
+  }
+
+  m_empty = !result;
+  return result;
+}
+
+} // namespace doc
@@ -0,0 +1,57 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include "gfx/rect.h"
+#include "gfx/region.h"
+
+namespace doc {
+  class Image;
+
+  // Compares the pixels of two images with the same format and size.
+  // Rows are compared in chunks of pixels without branches (so the
+  // compiler can compare several pixels with one instruction), and
+  // chunks without differences are skipped. Only the requested
+  // results are calculated.
+  class ImagesDiff {
+  public:
+    enum Flags {
+      kAny    = 0,          // Stop in the first different pixel
+      kCount  = 1,          // Count the different pixels
+      kBounds = 2,          // Bounds of the different pixels
+      kRegion = 4,          // Region with the different pixels
+      kAll    = kCount | kBounds | kRegion
+    };
+
+    ImagesDiff(int flags = kAll);
+
+    // Different pixels of the same row separated by less than "gap"
+    // equal pixels are put in the same rectangle of the region (fewer
+    // and bigger rectangles). By default only contiguous pixels are
+    // joined (gap = 1).
+    void setRegionGap(int gap);
+
+    // Compares the pixels of "a" and "b" inside the given bounds.
+    // Returns true if there is at least one different pixel.
+    bool compare(const Image* a, const Image* b, const gfx::Rect& bounds);
+    bool compare(const Image* a, const Image* b);
+
+    bool isEmpty() const { return m_empty; }
+    int count() const { return m_count; }
+    const gfx::Rect& bounds() const { return m_bounds; }
+    const gfx::Region& region() const { return m_region; }
+
+  private:
+    int m_flags;
+    int m_gap;
+    bool m_empty;
+    int m_count;
+    gfx::Rect m_bounds;
+    gfx::Region m_region;
+  };
+
+} // namespace doc
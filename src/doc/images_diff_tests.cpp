@@ -0,0 +1,188 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/image.h"
+#include "doc/images_diff.h"
+#include "doc/primitives.h"
+#include "gfx/point.h"
+
+#include <cstdlib>
+#include <memory>
+
+using namespace doc;
+
+namespace gfx {
+
+  std::ostream& operator<<(std::ostream& os, const Rect& rect) {
+    return os << "("
+              << rect.x << ", "
+              << rect.y << ", "
+              << rect.w << ", "
+              << rect.h << ")";
+  }
+
+}
+
+static void expect_same_as_reference(const Image* a, const Image* b,
+                                     const gfx::Rect& bounds)
+{
+  int count = 0;
+  gfx::Rect diffBounds;
+  for (int y=bounds.y; y<bounds.y2(); ++y)
+    for (int x=bounds.x; x<bounds.x2(); ++x)
+      if (get_pixel(a, x, y) != get_pixel(b, x, y)) {
+        ++count;
+        diffBounds |= gfx::Rect(x, y, 1, 1);
+      }
+
+  ImagesDiff diff;
+  EXPECT_EQ(count > 0, diff.compare(a, b, bounds));
+  EXPECT_EQ(count, diff.count());
+  EXPECT_EQ(diffBounds, diff.bounds());
+  EXPECT_EQ(diffBounds, diff.region().bounds());
+
+  for (int y=0; y<a->height(); ++y)
+    for (int x=0; x<a->width(); ++x)
+      ASSERT_EQ(bounds.contains(gfx::Point(x, y)) &&
+                get_pixel(a, x, y) != get_pixel(b, x, y),
+                diff.region().contains(gfx::Point(x, y)))
+        << "(" << x << ", " << y << ")";
+
+  ImagesDiff any(ImagesDiff::kAny);
+  EXPECT_EQ(count > 0, any.compare(a, b, bounds));
+
+  ImagesDiff onlyCount(ImagesDiff::kCount);
+  onlyCount.compare(a, b, bounds);
+  EXPECT_EQ(count, onlyCount.count());
+
+  ImagesDiff onlyBounds(ImagesDiff::kBounds);
+  onlyBounds.compare(a, b, bounds);
+  EXPECT_EQ(diffBounds, onlyBounds.bounds());
+}
+
+TEST(ImagesDiff, SameAsReference)
+{
+  const PixelFormat formats[] = { IMAGE_RGB, IMAGE_GRAYSCALE,
+                                  IMAGE_INDEXED, IMAGE_BITMAP };
+
+  std::srand(1);
+  for (PixelFormat format : formats) {
+    std::unique_ptr<Image> a(Image::create(format, 101, 67));
+    std::unique_ptr<Image> b(Image::create(format, 101, 67));
+    clear_image(a.get(), 0);
+    clear_image(b.get(), 0);
+
+    // Equal images
+    expect_same_as_reference(a.get(), b.get(), a->bounds());
+
+    // A few different pixels and a filled rectangle
+    for (int i=0; i<40; ++i)
+      put_pixel(b.get(), std::rand() % 101, std::rand() % 67, 1);
+    fill_rect(b.get(), 20, 30, 90, 40, 1);
+
+    expect_same_as_reference(a.get(), b.get(), a->bounds());
+    expect_same_as_reference(a.get(), b.get(), gfx::Rect(3, 5, 70, 50));
+    expect_same_as_reference(a.get(), b.get(), gfx::Rect(50, 0, 200, 200));
+  }
+}
+
+TEST(ImagesDiff, RegionGap)
+{
+  std::unique_ptr<Image> a(Image::create(IMAGE_RGB, 64, 8));
+  std::unique_ptr<Image> b(Image::create(IMAGE_RGB, 64, 8));
+  clear_image(a.get(), 0);
+  clear_image(b.get(), 0);
+
+  // Every fourth pixel of the two first rows is different
+  for (int y=0; y<2; ++y)
+    for (int x=0; x<64; x+=4)
+      put_pixel(b.get(), x, y, rgba(255, 0, 0, 255));
+
+  ImagesDiff diff;
+  diff.compare(a.get(), b.get());
+  EXPECT_EQ(32, diff.count());
+  EXPECT_EQ(16, diff.region().size());
+
+  // Three equal pixels between different pixels
+  diff.setRegionGap(4);
+  diff.compare(a.get(), b.get());
+  ASSERT_EQ(1, diff.region().size());
+  EXPECT_EQ(gfx::Rect(0, 0, 61, 2), diff.region()[0]);
+}
+
+// Big images are compared by groups of rows in different threads
+// (each group has 64K pixels at least), and then the results of each
+// group are merged.
+TEST(ImagesDiff, DiffsBetweenGroupsOfRows)
+{
+  const PixelFormat formats[] = { IMAGE_RGB, IMAGE_GRAYSCALE,
+                                  IMAGE_INDEXED, IMAGE_BITMAP };
+  const int w = 600;
+  const int h = 520;
+
+  std::srand(2);
+  for (PixelFormat format : formats) {
+    std::unique_ptr<Image> a(Image::create(format, w, h));
+    std::unique_ptr<Image> b(Image::create(format, w, h));
+    clear_image(a.get(), 0);
+    clear_image(b.get(), 0);
+
+    // A rectangle that crosses all groups of rows
+    fill_rect(b.get(), 100, 5, 163, 514, 1);
+
+    ImagesDiff diff;
+    EXPECT_TRUE(diff.compare(a.get(), b.get()));
+    EXPECT_EQ(64*510, diff.count());
+    EXPECT_EQ(gfx::Rect(100, 5, 64, 510), diff.bounds());
+    ASSERT_EQ(1, diff.region().size());
+    EXPECT_EQ(gfx::Rect(100, 5, 64, 510), diff.region()[0]);
+
+    // Different pixels in all rows (one line crosses all groups,
+    // the others are in the first and last rows of each group)
+    for (int y=0; y<h; ++y) {
+      put_pixel(b.get(), std::rand() % w, y, 1);
+      put_pixel(b.get(), 300 + y/4, y, 1);
+    }
+    fill_rect(b.get(), 400, 100, 599, 120, 1);
+    fill_rect(b.get(), 0, 210, 50, 330, 1);
+
+    expect_same_as_reference(a.get(), b.get(), a->bounds());
+    expect_same_as_reference(a.get(), b.get(), gfx::Rect(7, 100, 550, 400));
+    expect_same_as_reference(a.get(), b.get(), gfx::Rect(0, 0, 600, 512));
+  }
+}
+
+TEST(ImagesDiff, CountDiffBetweenImages)
+{
+  std::unique_ptr<Image> a(Image::create(IMAGE_RGB, 300, 200));
+  std::unique_ptr<Image> b(Image::create(IMAGE_RGB, 300, 200));
+  std::unique_ptr<Image> c(Image::create(IMAGE_RGB, 200, 300));
+  clear_image(a.get(), rgba(0, 0, 0, 255));
+  clear_image(b.get(), rgba(0, 0, 0, 255));
+  clear_image(c.get(), rgba(0, 0, 0, 255));
+
+  EXPECT_TRUE(is_same_image(a.get(), b.get()));
+  EXPECT_EQ(0, count_diff_between_images(a.get(), b.get()));
+
+  fill_rect(b.get(), 10, 20, 109, 219, rgba(255, 0, 0, 255));
+  EXPECT_FALSE(is_same_image(a.get(), b.get()));
+  EXPECT_EQ(100*180, count_diff_between_images(a.get(), b.get()));
+
+  EXPECT_FALSE(is_same_image(a.get(), c.get()));
+  EXPECT_EQ(-1, count_diff_between_images(a.get(), c.get()));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
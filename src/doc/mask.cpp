@@ -12,13 +12,56 @@
 
 #include "base/base.h"
 #include "base/memory.h"
+#include "base/parallel_for.h"
+#include "doc/bitmap_ops.h"
 #include "doc/image_impl.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 namespace doc {
 
+namespace {
+
+// Functions to generate one flag per pixel (1 if the pixel matches
+// the color) for Mask::byColor(). A component "v" matches if
+// min <= v <= min+range, i.e. unsigned(v - min) <= range. The loops
+// don't have branches, so they can be vectorized.
+
+void rgb_row_flags(const RgbTraits::pixel_t* src, uint8_t* flags, int w,
+                   int min_r, int min_g, int min_b, int min_a,
+                   unsigned range)
+{
+  for (int x=0; x<w; ++x) {
+    const color_t c = src[x];
+    flags[x] = ((unsigned(int(rgba_getr(c)) - min_r) <= range) &
+                (unsigned(int(rgba_getg(c)) - min_g) <= range) &
+                (unsigned(int(rgba_getb(c)) - min_b) <= range) &
+                (unsigned(int(rgba_geta(c)) - min_a) <= range));
+  }
+}
+
+void grayscale_row_flags(const GrayscaleTraits::pixel_t* src, uint8_t* flags, int w,
+                         int min_k, int min_a, unsigned range)
+{
+  for (int x=0; x<w; ++x) {
+    const color_t c = src[x];
+    flags[x] = ((unsigned(int(graya_getv(c)) - min_k) <= range) &
+                (unsigned(int(graya_geta(c)) - min_a) <= range));
+  }
+}
+
+void indexed_row_flags(const IndexedTraits::pixel_t* src, uint8_t* flags, int w,
+                       int min, unsigned range)
+{
+  for (int x=0; x<w; ++x)
+    flags[x] = (unsigned(int(src[x]) - min) <= range);
+}
+
+} // anonymous namespace
+
 Mask::Mask()
   : Object(ObjectType::Mask)
 {
@@ -74,11 +117,8 @@ bool Mask::isRectangular() const
   if (!m_bitmap)
     return false;
 
-  LockImageBits<BitmapTraits> bits(m_bitmap.get());
-  LockImageBits<BitmapTraits>::iterator it = bits.begin(), end = bits.end();
-
-  for (; it != end; ++it) {
-    if (*it == 0)
+  for (int y=0; y<m_bounds.h; ++y) {
+    if (bitmap_row_count(m_bitmap->getPixelAddress(0, y), m_bounds.w) != m_bounds.w)
       return false;
   }
 
@@ -115,11 +155,8 @@ void Mask::invert()
   if (!m_bitmap)
     return;
 
-  LockImageBits<BitmapTraits> bits(m_bitmap.get());
-  LockImageBits<BitmapTraits>::iterator it = bits.begin(), end = bits.end();
-
-  for (; it != end; ++it)
-    *it = (*it ? 0: 1);
+  for (int y=0; y<m_bounds.h; ++y)
+    bitmap_row_invert(m_bitmap->getPixelAddress(0, y), m_bounds.w);
 
   shrink();
 }
@@ -134,7 +171,7 @@ void Mask::replace(const gfx::Rect& bounds)
 
 void Mask::add(const gfx::Rect& bounds)
 {
-  if (m_freeze_count == 0)
+  if (m_freeze_count == 0 || !m_bitmap)
     reserve(bounds);
 
   fill_rect(m_bitmap.get(),
@@ -181,104 +218,96 @@ void Mask::intersect(const gfx::Rect& bounds)
   shrink();
 }
 
+void Mask::add(const Mask& mask)
+{
+  if (!mask.bitmap())
+    return;
+
+  // A frozen mask is not enlarged (the area was reserved by the
+  // caller), so pixels outside m_bounds are discarded.
+  if (m_freeze_count == 0 || !m_bitmap)
+    reserve(mask.bounds());
+
+  const gfx::Rect area = m_bounds.createIntersection(mask.bounds());
+  for (int y=area.y; y<area.y+area.h; ++y) {
+    bitmap_row_op(m_bitmap->getPixelAddress(0, y-m_bounds.y), area.x-m_bounds.x,
+                  mask.bitmap()->getPixelAddress(0, y-mask.bounds().y), area.x-mask.bounds().x,
+                  area.w, BitmapOp::Or);
+  }
+}
+
+void Mask::subtract(const Mask& mask)
+{
+  if (!m_bitmap || !mask.bitmap())
+    return;
+
+  const gfx::Rect area = m_bounds.createIntersection(mask.bounds());
+  for (int y=area.y; y<area.y+area.h; ++y) {
+    bitmap_row_op(m_bitmap->getPixelAddress(0, y-m_bounds.y), area.x-m_bounds.x,
+                  mask.bitmap()->getPixelAddress(0, y-mask.bounds().y), area.x-mask.bounds().x,
+                  area.w, BitmapOp::AndNot);
+  }
+
+  shrink();
+}
+
 void Mask::byColor(const Image *src, int color, int fuzziness)
 {
   replace(src->bounds());
 
   Image* dst = m_bitmap.get();
+  const int w = src->width();
+
+  // Each band of rows generates one flag per pixel (1 if the pixel
+  // matches the color), which are packed in the bitmap. The flags
+  // loop doesn't have branches so it can be vectorized.
+  auto generate = [&](auto rowFlags) {
+    base::parallel_for(
+      0, src->height(), 32,
+      [&](int y1, int y2) {
+        std::vector<uint8_t> flags(w);
+        for (int y=y1; y<y2; ++y) {
+          rowFlags(y, &flags[0]);
+          bitmap_row_pack(dst->getPixelAddress(0, y), &flags[0], w);
+        }
+      });
+  };
+
+  const unsigned range = 2*fuzziness;
 
   switch (src->pixelFormat()) {
 
     case IMAGE_RGB: {
-      const LockImageBits<RgbTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<RgbTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      int src_r, src_g, src_b, src_a;
-      int dst_r, dst_g, dst_b, dst_a;
-      color_t c;
-
-      dst_r = rgba_getr(color);
-      dst_g = rgba_getg(color);
-      dst_b = rgba_getb(color);
-      dst_a = rgba_geta(color);
-
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
-
-        src_r = rgba_getr(c);
-        src_g = rgba_getg(c);
-        src_b = rgba_getb(c);
-        src_a = rgba_geta(c);
-
-        if (!((src_r >= dst_r-fuzziness) && (src_r <= dst_r+fuzziness) &&
-              (src_g >= dst_g-fuzziness) && (src_g <= dst_g+fuzziness) &&
-              (src_b >= dst_b-fuzziness) && (src_b <= dst_b+fuzziness) &&
-              (src_a >= dst_a-fuzziness) && (src_a <= dst_a+fuzziness)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
+      const int min_r = rgba_getr(color) - fuzziness;
+      const int min_g = rgba_getg(color) - fuzziness;
+      const int min_b = rgba_getb(color) - fuzziness;
+      const int min_a = rgba_geta(color) - fuzziness;
+
+      generate([=](int y, uint8_t* flags) {
+        rgb_row_flags((const RgbTraits::pixel_t*)src->getPixelAddress(0, y),
+                      flags, w, min_r, min_g, min_b, min_a, range);
+      });
       break;
     }
 
     case IMAGE_GRAYSCALE: {
-      const LockImageBits<GrayscaleTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<GrayscaleTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      int src_k, src_a;
-      int dst_k, dst_a;
-      color_t c;
-
-      dst_k = graya_getv(color);
-      dst_a = graya_geta(color);
-
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
-
-        src_k = graya_getv(c);
-        src_a = graya_geta(c);
+      const int min_k = graya_getv(color) - fuzziness;
+      const int min_a = graya_geta(color) - fuzziness;
 
-        if (!((src_k >= dst_k-fuzziness) && (src_k <= dst_k+fuzziness) &&
-              (src_a >= dst_a-fuzziness) && (src_a <= dst_a+fuzziness)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
+      generate([=](int y, uint8_t* flags) {
+        grayscale_row_flags((const GrayscaleTraits::pixel_t*)src->getPixelAddress(0, y),
+                            flags, w, min_k, min_a, range);
+      });
       break;
     }
 
     case IMAGE_INDEXED: {
-      const LockImageBits<IndexedTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<IndexedTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      color_t c, min, max;
-
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
-
-        if (color > fuzziness)
-          min = color-fuzziness;
-        else
-          min = 0;
-        max = color + fuzziness;
-
-        if (!((c >= min) && (c <= max)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
+      const int min = std::max(color - fuzziness, 0);
+
+      generate([=](int y, uint8_t* flags) {
+        indexed_row_flags((const IndexedTraits::pixel_t*)src->getPixelAddress(0, y),
+                          flags, w, min, color + fuzziness - min);
+      });
       break;
     }
   }
@@ -381,58 +410,47 @@ void Mask::shrink()
   if (m_freeze_count > 0)
     return;
 
-#define SHRINK_SIDE(u_begin, u_op, u_final, u_add,                      \
-                    v_begin, v_op, v_final, v_add, U, V, var)           \
-  {                                                                     \
-    for (u = u_begin; u u_op u_final; u u_add) {                        \
-      for (v = v_begin; v v_op v_final; v v_add) {                      \
-        if (get_pixel_fast<BitmapTraits>(m_bitmap.get(), U, V))         \
-          break;                                                        \
-      }                                                                 \
-      if (v == v_final)                                                 \
-        var;                                                            \
-      else                                                              \
-        break;                                                          \
-    }                                                                   \
+  if (!m_bitmap) {
+    clear();
+    return;
   }
 
-  int u, v, x1, y1, x2, y2;
-
-  x1 = m_bounds.x;
-  y1 = m_bounds.y;
-  x2 = m_bounds.x+m_bounds.w-1;
-  y2 = m_bounds.y+m_bounds.h-1;
+  const int w = m_bounds.w;
+  const int h = m_bounds.h;
+  auto row = [this](int y) -> const uint8_t* {
+    return m_bitmap->getPixelAddress(0, y);
+  };
 
-  SHRINK_SIDE(0, <, m_bounds.w, ++,
-              0, <, m_bounds.h, ++, u, v, x1++);
+  // Empty rows at the top and at the bottom
+  int y1 = 0;
+  while (y1 < h && bitmap_row_first(row(y1), w) < 0)
+    ++y1;
 
-  SHRINK_SIDE(0, <, m_bounds.h, ++,
-              0, <, m_bounds.w, ++, v, u, y1++);
-
-  SHRINK_SIDE(m_bounds.w-1, >, 0, --,
-              0, <, m_bounds.h, ++, u, v, x2--);
-
-  SHRINK_SIDE(m_bounds.h-1, >, 0, --,
-              0, <, m_bounds.w, ++, v, u, y2--);
-
-  if ((x1 > x2) || (y1 > y2)) {
+  if (y1 == h) {
     clear();
+    return;
   }
-  else if ((x1 != m_bounds.x) || (x2 != m_bounds.x+m_bounds.w-1) ||
-           (y1 != m_bounds.y) || (y2 != m_bounds.y+m_bounds.h-1)) {
-    u = m_bounds.x;
-    v = m_bounds.y;
 
-    m_bounds.x = x1;
-    m_bounds.y = y1;
-    m_bounds.w = x2 - x1 + 1;
-    m_bounds.h = y2 - y1 + 1;
+  int y2 = h-1;
+  while (y2 > y1 && bitmap_row_first(row(y2), w) < 0)
+    --y2;
+
+  // Empty columns (we only look for pixels before the current "x1")
+  int x1 = w, x2 = -1;
+  for (int y=y1; y<=y2; ++y) {
+    const int first = bitmap_row_first(row(y), x1);
+    if (first >= 0)
+      x1 = first;
+    x2 = std::max(x2, bitmap_row_last(row(y), w));
+  }
+  ASSERT(x1 <= x2);
 
-    Image* image = crop_image(m_bitmap.get(), m_bounds.x-u, m_bounds.y-v, m_bounds.w, m_bounds.h, 0);
+  if (x1 != 0 || x2 != w-1 || y1 != 0 || y2 != h-1) {
+    const gfx::Rect newBounds(m_bounds.x+x1, m_bounds.y+y1, x2-x1+1, y2-y1+1);
+    Image* image = crop_image(m_bitmap.get(), x1, y1, newBounds.w, newBounds.h, 0);
     m_bitmap.reset(image);
+    m_bounds = newBounds;
   }
-
-#undef SHRINK_SIDE
 }
 
 } // namespace doc
@@ -81,6 +81,11 @@ namespace doc {
     void add(const gfx::Rect& bounds);
     void subtract(const gfx::Rect& bounds);
     void intersect(const gfx::Rect& bounds);
+
+    // Adds or subtracts the pixels of other mask.
+    void add(const Mask& mask);
+    void subtract(const Mask& mask);
+
     void byColor(const Image* image, int color, int fuzziness);
     void crop(const Image* image);
 
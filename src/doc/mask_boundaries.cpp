@@ -10,330 +10,217 @@
 
 #include "doc/mask_boundaries.h"
 
-#include "doc/image_impl.h"
+#include "base/debug.h"
+#include "doc/bitmap_ops.h"
+#include "doc/image.h"
+#include "doc/mask.h"
+
+#include <algorithm>
+#include <bit>
 
 namespace doc {
 
-MaskBoundaries::MaskBoundaries(const Image* bitmap)
+static_assert(MaskBoundaries::kTileSize == 64,
+              "Each row of a tile must fit in a 64-bit word");
+
+namespace {
+
+// Returns "n" pixels (n <= 64) of the row "y" starting at "x" (both
+// relative to the bitmap), pixels outside the bitmap are 0.
+uint64_t row_bits(const Image* bitmap, int x, int y, int n)
 {
-  int x, y, w = bitmap->width(), h = bitmap->height();
+  if (y < 0 || y >= bitmap->height())
+    return 0;
 
-  const LockImageBits<BitmapTraits> bits(bitmap);
-  auto it = bits.begin();       // Current pixel iterator
-#if _DEBUG
-  auto prevIt = bits.begin();   // Previous row iterator (same X pos)
-#endif
+  const int x1 = std::max(x, 0);
+  const int x2 = std::min(x+n, bitmap->width());
+  if (x1 >= x2)
+    return 0;
+
+  return bitmap_row_bits(bitmap->getPixelAddress(0, y), x1, x2-x1) << (x1-x);
+}
 
-  // Vertical segments being expanded from the previous row.
-  std::vector<int> vertSegs(w+1, -1);
+// Adds one horizontal segment for each run of bits in "bits".
+void add_runs(uint64_t bits, bool open, int x0, int y,
+              MaskBoundaries::list_type& segs)
+{
+  while (bits) {
+    const int start = std::countr_zero(bits);
+    const uint64_t rest = ~(bits >> start);
+    const int n = (rest ? std::countr_zero(rest): 64-start);
 
-  // Horizontal segment being expanded from the previous column.
-  int horzSeg;
+    segs.push_back(MaskBoundaries::Segment(open, gfx::Rect(x0+start, y, n, 0)));
 
-#define new_hseg(open) {                                        \
-    m_segs.push_back(Segment(open, gfx::Rect(x, y, 1, 0)));     \
-    horzSeg = int(m_segs.size()-1);                             \
-  }
-#define new_vseg(open) {                                        \
-    m_segs.push_back(Segment(open, gfx::Rect(x, y, 0, 1)));     \
-    vertSegs[x] = int(m_segs.size()-1);                         \
+    if (start+n >= 64)
+      break;
+    bits &= ~(((uint64_t(1) << n) - 1) << start);
   }
-#define expand_hseg() { \
-    ASSERT(hseg);       \
-    ++hseg->m_bounds.w; \
-  }
-#define expand_vseg() { \
-    ASSERT(vseg);       \
-    ++vseg->m_bounds.h; \
+}
+
+uint64_t hash_words(uint64_t hash, uint64_t word)
+{
+  hash ^= word;
+  hash *= 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 32);
+}
+
+} // anonymous namespace
+
+MaskBoundaries::MaskBoundaries()
+  : m_segsDirty(false)
+{
+}
+
+MaskBoundaries::MaskBoundaries(const Image* bitmap)
+  : m_segsDirty(false)
+{
+  regenerate(bitmap, gfx::Point(0, 0));
+}
+
+void MaskBoundaries::regenerate(const Mask* mask)
+{
+  if (mask->isEmpty()) {
+    m_tiles.clear();
+    m_segs.clear();
+    m_segsDirty = false;
+    return;
   }
-#define stop_expanding_hseg() {                 \
-    horzSeg = -1;                               \
+
+  regenerate(mask->bitmap(), mask->bounds().origin());
+}
+
+void MaskBoundaries::regenerate(const Image* bitmap, const gfx::Point& origin)
+{
+  // The boundaries are in the lines between pixels, so the last lines
+  // are at x=width and y=height.
+  const int tx1 = tileIndex(origin.x);
+  const int ty1 = tileIndex(origin.y);
+  const int tx2 = tileIndex(origin.x + bitmap->width());
+  const int ty2 = tileIndex(origin.y + bitmap->height());
+
+  // Remove tiles outside the new bounds
+  for (auto it=m_tiles.begin(); it!=m_tiles.end(); ) {
+    const int tx = int32_t(uint32_t(it->first));
+    const int ty = int32_t(uint32_t(it->first >> 32));
+    if (tx < tx1 || tx > tx2 || ty < ty1 || ty > ty2) {
+      it = m_tiles.erase(it);
+      m_segsDirty = true;
+    }
+    else
+      ++it;
   }
-#define stop_expanding_vseg() {                 \
-    vertSegs[x] = -1;                           \
+
+  // Rows of the tile (plus the previous row), and the pixel at the
+  // left side of each row.
+  uint64_t rows[kTileSize+1];
+  uint64_t lefts[kTileSize+1];
+
+  for (int ty=ty1; ty<=ty2; ++ty) {
+    for (int tx=tx1; tx<=tx2; ++tx) {
+      const int x0 = tx*kTileSize;
+      const int y0 = ty*kTileSize;
+
+      uint64_t hash = 0;
+      for (int i=0; i<=kTileSize; ++i) {
+        const int y = y0-1+i - origin.y;
+        rows[i] = row_bits(bitmap, x0 - origin.x, y, kTileSize);
+        lefts[i] = row_bits(bitmap, x0-1 - origin.x, y, 1);
+        hash = hash_words(hash, rows[i]);
+        hash = hash_words(hash, lefts[i]);
+      }
+
+      Tile& tile = m_tiles[tileKey(tx, ty)];
+      if (tile.valid && tile.hash == hash)
+        continue;
+
+      tile.hash = hash;
+      tile.valid = true;
+      tile.segs.clear();
+      generateTile(rows, lefts, x0, y0, tile.segs);
+      m_segsDirty = true;
+    }
   }
+}
 
-  for (y=0; y<=h; ++y) {
-    bool prevColor = false;         // Previous color (X-1) same Y row
-    horzSeg = -1;
+// Generates the segments of the lines x=[x0,x0+kTileSize) and
+// y=[y0,y0+kTileSize). rows[i] contains the pixels of the row y0-1+i,
+// and lefts[i] the pixel x0-1 of the same row.
+void MaskBoundaries::generateTile(const uint64_t* rows, const uint64_t* lefts,
+                                  int x0, int y0, list_type& segs)
+{
+  // Horizontal segments: "open" ones enter into the selection (the
+  // pixel below is selected), "closed" ones leave the selection.
+  for (int i=0; i<kTileSize; ++i) {
+    const uint64_t above = rows[i];
+    const uint64_t below = rows[i+1];
+    add_runs(below & ~above, true, x0, y0+i, segs);
+    add_runs(above & ~below, false, x0, y0+i, segs);
+  }
 
-    for (x=0; x<=w; ++x) {
-      bool color = (x < w && y < h && *it ? true: false);
-#if _DEBUG
-      bool prevRowColor = (x < w && y > 0 && *prevIt ? true: false);
-#endif
-      Segment* hseg = (horzSeg >= 0 ? &m_segs[horzSeg]: nullptr);
-      Segment* vseg = (vertSegs[x] >= 0 ? &m_segs[vertSegs[x]]: nullptr);
-
-      //
-      // -   -
-      //
-      // -   1
-      //
-      if (color) {
-        //
-        // - | -
-        //   o
-        // -   1
-        //
-        if (vseg) {
-          //
-          // 0 | 1
-          //   o
-          // -   1
-          //
-          if (vseg->open()) {
-            ASSERT(prevRowColor);
-
-            //
-            // 0 | 1
-            // --x
-            // 1   1
-            //
-            if (hseg) {
-              ASSERT(hseg->open());
-              ASSERT(prevColor);
-              stop_expanding_hseg();
-              stop_expanding_vseg();
-            }
-            //
-            // 0 | 1
-            //   |
-            // 0 | 1
-            //   o
-            else {
-              ASSERT(!prevColor);
-              expand_vseg();
-            }
-          }
-          //
-          // 1 | 0
-          //   x--o
-          // -   1
-          //
-          else {
-            ASSERT(!prevRowColor);
-
-            //
-            // 1 | 0
-            // --x--o
-            // 0 | 1
-            //   o
-            if (hseg) {
-              ASSERT(!prevColor);
-              ASSERT(!hseg->open());
-              new_hseg(true);
-              new_vseg(true);
-            }
-            //
-            // 1 | 0
-            //   x--o
-            // 1   1
-            //
-            else {
-              ASSERT(prevColor);
-              new_hseg(true);
-			  stop_expanding_vseg();
-            }
-          }
+  // Vertical segments (the selected pixel is at the right side for
+  // "open" ones). Each segment grows one pixel per row while the
+  // same edge continues in the next row.
+  int openSegs[kTileSize];
+  int closedSegs[kTileSize];
+  uint64_t prevOpen = 0;
+  uint64_t prevClosed = 0;
+
+  for (int i=0; i<kTileSize; ++i) {
+    const uint64_t pixels = rows[i+1];
+    const uint64_t left = (pixels << 1) | lefts[i+1];
+    const uint64_t open = pixels & ~left;
+    const uint64_t closed = left & ~pixels;
+
+    for (int k=0; k<2; ++k) {
+      uint64_t bits = (k == 0 ? open: closed);
+      const uint64_t prev = (k == 0 ? prevOpen: prevClosed);
+      int* activeSegs = (k == 0 ? openSegs: closedSegs);
+
+      while (bits) {
+        const int x = std::countr_zero(bits);
+        bits &= bits-1;
+
+        if (prev & (uint64_t(1) << x)) {
+          ++segs[activeSegs[x]].m_bounds.h;
         }
-        //
-        // -   -  (there is no vertical segment in this row, both colors are equal)
-        //
-        // -   1
-        //
         else {
-          //
-          // -   -
-          // --o
-          // -   1
-          //
-          if (hseg) {
-            //
-            // 0   0
-            // -----o
-            // 1   1
-            //
-            if (hseg->open()) {
-              ASSERT(prevColor);
-              expand_hseg();
-            }
-            //
-            // 1   1
-            // --x
-            // 0 | 1
-            //   o
-            else {
-              ASSERT(!prevColor);
-              stop_expanding_hseg();
-              new_vseg(true);
-            }
-          }
-          else {
-            //
-            // 1   1
-            //
-            // 1   1
-            //
-            if (prevColor) {
-              // Do nothing, we are inside boundaries
-            }
-            //
-            // 0   0
-            //    --o
-            // 0 | 1
-            //   o
-            else {
-              // First two segments of a corner
-              new_hseg(true);
-              new_vseg(true);
-            }
-          }
+          activeSegs[x] = int(segs.size());
+          segs.push_back(Segment(k == 0, gfx::Rect(x0+x, y0+i, 0, 1)));
         }
       }
-      //
-      // -   -
-      //
-      // -   0
-      //
-      else {
-        //
-        // - | -
-        //   o
-        // -   0
-        //
-        if (vseg) {
-          //
-          // 0 | 1
-          //   o
-          // -   0
-          //
-          if (vseg->open()) {
-            ASSERT(prevRowColor);
-
-            //
-            // 0 | 1
-            // --x--o
-            // 1 | 0
-            //   o
-            if (hseg) {
-              ASSERT(hseg->open());
-              ASSERT(prevColor);
-              new_hseg(false);
-              new_vseg(false);
-            }
-            //
-            // 0 | 1
-            //   x--o
-            // 0   0
-            //
-            else {
-              ASSERT(!prevColor);
-              new_hseg(false);
-              stop_expanding_vseg();
-            }
-          }
-          //
-          // 1 | 0
-          //   o
-          // -   0
-          //
-          else {
-            ASSERT(!prevRowColor);
-
-            //
-            // 1 | 0
-            // --x
-            // 0   0
-            //
-            if (hseg) {
-              ASSERT(!prevColor);
-              stop_expanding_hseg();
-              stop_expanding_vseg();
-            }
-            //
-            // 1 | 0
-            //   |
-            // 1 | 0
-            //   o
-            else {
-              ASSERT(prevColor);
-              expand_vseg();
-            }
-          }
-        }
-        //
-        // -   -  (there is no vertical segment in this row, both colors are equal)
-        //
-        // -   0
-        //
-        else {
-          //
-          // -   -
-          // --o
-          // -   0
-          //
-          if (hseg) {
-            //
-            // 0   0
-            // --x
-            // 1 | 0
-            //   o
-            if (hseg->open()) {
-              ASSERT(prevColor);
-              stop_expanding_hseg();
-              new_vseg(false);
-            }
-            //
-            // 1   1
-            // -----o
-            // 0   0
-            //
-            else {
-              ASSERT(!prevColor);
-              expand_hseg();
-            }
-          }
-          else {
-            //
-            // 1   1
-            //    --o
-            // 1 | 0
-            //   o
-            if (prevColor) {
-              new_hseg(false);
-              new_vseg(false);
-            }
-            //
-            // 0   0
-            //
-            // 0   0
-            //
-            else {
-              // Do nothing, we are inside boundaries
-            }
-          }
-        }
-      }
-
-      prevColor = color;
-      if (x < w) {
-#if _DEBUG
-        if (y > 0) ++prevIt;
-#endif
-        if (y < h) ++it;
-      }
     }
-  }
 
-  ASSERT(it == bits.end());
-  ASSERT(prevIt == bits.end());
+    prevOpen = open;
+    prevClosed = closed;
+  }
 }
 
 void MaskBoundaries::offset(int x, int y)
 {
-  for (Segment& seg : m_segs)
+  // Move the segments to the tiles of their new positions (the
+  // hashes aren't valid anymore, so the next regenerate() will
+  // recalculate all tiles)
+  updateSegs();
+  m_tiles.clear();
+
+  for (Segment& seg : m_segs) {
     seg.offset(x, y);
+    Tile& tile = m_tiles[tileKey(tileIndex(seg.bounds().x),
+                                 tileIndex(seg.bounds().y))];
+    tile.segs.push_back(seg);
+  }
+}
+
+void MaskBoundaries::updateSegs() const
+{
+  if (!m_segsDirty)
+    return;
+
+  m_segs.clear();
+  for (const auto& tile : m_tiles)
+    m_segs.insert(m_segs.end(), tile.second.segs.begin(), tile.second.segs.end());
+
+  m_segsDirty = false;
 }
 
 } // namespace doc
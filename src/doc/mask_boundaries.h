@@ -6,15 +6,26 @@
 
 #pragma once
 
+#include "gfx/point.h"
 #include "gfx/rect.h"
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace doc {
   class Image;
+  class Mask;
 
+  // Segments of the boundaries of a mask (used to draw the marching
+  // ants). The segments are kept in tiles of kTileSize x kTileSize
+  // pixels, so regenerate() only recalculates the tiles where the
+  // mask was modified, and forEachSegment() only visits the tiles
+  // inside the given area.
   class MaskBoundaries {
   public:
+    enum { kTileSize = 64 };
+
     class Segment {
     public:
       Segment(bool open, const gfx::Rect& bounds)
@@ -36,20 +47,78 @@ namespace doc {
     };
 
     typedef std::vector<Segment> list_type;
-    typedef list_type::iterator iterator;
     typedef list_type::const_iterator const_iterator;
 
+    MaskBoundaries();
     MaskBoundaries(const Image* bitmap);
 
-    const_iterator begin() const { return m_segs.begin(); }
-    const_iterator end() const { return m_segs.end(); }
-    iterator begin() { return m_segs.begin(); }
-    iterator end() { return m_segs.end(); }
+    // Recalculates the boundaries for the given mask (the segments
+    // are in sprite coordinates). Tiles where the mask didn't change
+    // since the last call keep their segments.
+    void regenerate(const Mask* mask);
+
+    // Iterates all segments.
+    const_iterator begin() const { updateSegs(); return m_segs.begin(); }
+    const_iterator end() const { updateSegs(); return m_segs.end(); }
+
+    // Calls func(const Segment&) for each segment that touches the
+    // given bounds.
+    template<typename Func>
+    void forEachSegment(const gfx::Rect& bounds, Func func) const {
+      if (bounds.isEmpty())
+        return;
+
+      // A segment is in the tile where it starts, and it can be up to
+      // kTileSize pixels long.
+      const int tx1 = tileIndex(bounds.x - kTileSize);
+      const int ty1 = tileIndex(bounds.y - kTileSize);
+      const int tx2 = tileIndex(bounds.x2());
+      const int ty2 = tileIndex(bounds.y2());
+
+      for (int ty=ty1; ty<=ty2; ++ty) {
+        for (int tx=tx1; tx<=tx2; ++tx) {
+          auto it = m_tiles.find(tileKey(tx, ty));
+          if (it == m_tiles.end())
+            continue;
+
+          for (const Segment& seg : it->second.segs) {
+            const gfx::Rect& rc = seg.bounds();
+            if (rc.x <= bounds.x2() && rc.x2() >= bounds.x &&
+                rc.y <= bounds.y2() && rc.y2() >= bounds.y)
+              func(seg);
+          }
+        }
+      }
+    }
 
     void offset(int x, int y);
 
   private:
-    list_type m_segs;
+    struct Tile {
+      // Hash of the pixels used to generate the segments of the tile
+      uint64_t hash = 0;
+      bool valid = false;
+      list_type segs;
+    };
+
+    static int tileIndex(int u) {
+      return (u >= 0 ? u / kTileSize: -((-u + kTileSize - 1) / kTileSize));
+    }
+
+    static uint64_t tileKey(int tx, int ty) {
+      return (uint64_t(uint32_t(ty)) << 32) | uint32_t(tx);
+    }
+
+    void regenerate(const Image* bitmap, const gfx::Point& origin);
+    void generateTile(const uint64_t* rows, const uint64_t* lefts,
+                      int x0, int y0, list_type& segs);
+    void updateSegs() const;
+
+    std::unordered_map<uint64_t, Tile> m_tiles;
+
+    // All segments (only to iterate them with begin()/end())
+    mutable list_type m_segs;
+    mutable bool m_segsDirty;
   };
 
 } // namespace doc
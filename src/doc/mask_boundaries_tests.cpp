@@ -0,0 +1,158 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/mask.h"
+#include "doc/mask_boundaries.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+#include <vector>
+
+using namespace doc;
+
+// x, y, vertical, open
+typedef std::tuple<int, int, bool, bool> Edge;
+
+// Edges of one pixel between selected and non-selected pixels
+static std::vector<Edge> expected_edges(const Mask& mask)
+{
+  std::vector<Edge> edges;
+  if (mask.isEmpty())
+    return edges;
+
+  const gfx::Rect& b = mask.bounds();
+  for (int y=b.y; y<=b.y2(); ++y)
+    for (int x=b.x; x<=b.x2(); ++x) {
+      const bool pixel = mask.containsPoint(x, y);
+      if (x < b.x2() && pixel != mask.containsPoint(x, y-1))
+        edges.push_back(Edge(x, y, false, pixel));
+      if (y < b.y2() && pixel != mask.containsPoint(x-1, y))
+        edges.push_back(Edge(x, y, true, pixel));
+    }
+
+  std::sort(edges.begin(), edges.end());
+  return edges;
+}
+
+static void add_edges(const MaskBoundaries::Segment& seg, std::vector<Edge>& edges)
+{
+  const gfx::Rect& rc = seg.bounds();
+  if (seg.vertical()) {
+    for (int i=0; i<rc.h; ++i)
+      edges.push_back(Edge(rc.x, rc.y+i, true, seg.open()));
+  }
+  else {
+    for (int i=0; i<rc.w; ++i)
+      edges.push_back(Edge(rc.x+i, rc.y, false, seg.open()));
+  }
+}
+
+static std::vector<Edge> boundaries_edges(const MaskBoundaries& boundaries)
+{
+  std::vector<Edge> edges;
+  for (const auto& seg : boundaries)
+    add_edges(seg, edges);
+
+  std::sort(edges.begin(), edges.end());
+  return edges;
+}
+
+static void random_rects(Mask& mask, int n)
+{
+  for (int i=0; i<n; ++i) {
+    const gfx::Rect rc(std::rand() % 300 - 100, std::rand() % 300 - 100,
+                       1 + std::rand() % 90, 1 + std::rand() % 90);
+    if (std::rand() % 3 == 0)
+      mask.subtract(rc);
+    else
+      mask.add(rc);
+  }
+}
+
+TEST(MaskBoundaries, Edges)
+{
+  std::srand(1);
+  for (int i=0; i<30; ++i) {
+    Mask mask;
+    random_rects(mask, 1 + i % 8);
+
+    MaskBoundaries boundaries;
+    boundaries.regenerate(&mask);
+    EXPECT_EQ(expected_edges(mask), boundaries_edges(boundaries));
+  }
+}
+
+TEST(MaskBoundaries, Bitmap)
+{
+  Mask mask;
+  mask.add(gfx::Rect(0, 0, 70, 3));
+  mask.subtract(gfx::Rect(65, 1, 1, 1));
+
+  MaskBoundaries boundaries(mask.bitmap());
+  EXPECT_EQ(expected_edges(mask), boundaries_edges(boundaries));
+
+  boundaries.offset(-10, 100);
+  mask.offsetOrigin(-10, 100);
+  EXPECT_EQ(expected_edges(mask), boundaries_edges(boundaries));
+}
+
+TEST(MaskBoundaries, Incremental)
+{
+  std::srand(2);
+  Mask mask;
+  MaskBoundaries boundaries;
+
+  for (int i=0; i<50; ++i) {
+    random_rects(mask, 1);
+    boundaries.regenerate(&mask);
+    ASSERT_EQ(expected_edges(mask), boundaries_edges(boundaries));
+  }
+
+  mask.clear();
+  boundaries.regenerate(&mask);
+  EXPECT_TRUE(boundaries_edges(boundaries).empty());
+}
+
+TEST(MaskBoundaries, ForEachSegment)
+{
+  std::srand(3);
+  Mask mask;
+  random_rects(mask, 20);
+
+  MaskBoundaries boundaries;
+  boundaries.regenerate(&mask);
+
+  for (int i=0; i<100; ++i) {
+    const gfx::Rect area(std::rand() % 400 - 150, std::rand() % 400 - 150,
+                         1 + std::rand() % 200, 1 + std::rand() % 200);
+
+    std::vector<Edge> expected, result;
+    for (const auto& seg : boundaries) {
+      if (gfx::Rect(seg.bounds()).enlarge(1).intersects(area))
+        add_edges(seg, expected);
+    }
+    boundaries.forEachSegment(area, [&](const MaskBoundaries::Segment& seg) {
+        add_edges(seg, result);
+      });
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
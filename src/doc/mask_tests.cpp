@@ -0,0 +1,186 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/image.h"
+#include "doc/mask.h"
+#include "doc/primitives.h"
+#include "gfx/point.h"
+#include "gfx/rect.h"
+
+#include <cstdlib>
+#include <memory>
+
+using namespace doc;
+
+// Creates a mask with random pixels inside the given bounds
+static void random_mask(Mask& mask, const gfx::Rect& bounds)
+{
+  mask.clear();
+  mask.freeze();
+  mask.reserve(bounds);
+  for (int y=bounds.y; y<bounds.y+bounds.h; ++y)
+    for (int x=bounds.x; x<bounds.x+bounds.w; ++x)
+      if (std::rand() % 3 == 0)
+        mask.add(gfx::Rect(x, y, 1, 1));
+  mask.unfreeze();
+}
+
+static gfx::Rect random_rect()
+{
+  return gfx::Rect(std::rand() % 80 - 20, std::rand() % 20 - 5,
+                   1 + std::rand() % 100, 1 + std::rand() % 20);
+}
+
+static void expect_mask(const Mask& mask, const gfx::Rect& area,
+                        bool (*expected)(int x, int y, void* data), void* data)
+{
+  gfx::Rect bounds;
+  for (int y=area.y; y<area.y+area.h; ++y)
+    for (int x=area.x; x<area.x+area.w; ++x) {
+      const bool value = expected(x, y, data);
+      ASSERT_EQ(value, mask.containsPoint(x, y)) << "(" << x << ", " << y << ")";
+      if (value)
+        bounds |= gfx::Rect(x, y, 1, 1);
+    }
+
+  // The mask is shrunk
+  EXPECT_EQ(bounds, mask.bounds());
+  EXPECT_EQ(bounds.isEmpty(), mask.isEmpty());
+}
+
+struct Masks {
+  const Mask* a;
+  const Mask* b;
+};
+
+TEST(Mask, AddSubtract)
+{
+  const gfx::Rect area(-30, -10, 200, 50);
+
+  std::srand(1);
+  for (int i=0; i<50; ++i) {
+    Mask a, b;
+    random_mask(a, random_rect());
+    random_mask(b, random_rect());
+    Masks masks = { &a, &b };
+
+    Mask result(a);
+    result.add(b);
+    expect_mask(result, area, [](int x, int y, void* data) {
+        Masks* m = (Masks*)data;
+        return m->a->containsPoint(x, y) || m->b->containsPoint(x, y);
+      }, &masks);
+
+    result.copyFrom(&a);
+    result.subtract(b);
+    expect_mask(result, area, [](int x, int y, void* data) {
+        Masks* m = (Masks*)data;
+        return m->a->containsPoint(x, y) && !m->b->containsPoint(x, y);
+      }, &masks);
+  }
+}
+
+TEST(Mask, AddToFrozenMask)
+{
+  Mask big;
+  big.replace(gfx::Rect(0, 0, 40, 30));
+
+  // The frozen mask keeps its reserved bounds
+  Mask result;
+  result.freeze();
+  result.reserve(gfx::Rect(10, 5, 8, 6));
+  result.add(big);
+  result.unfreeze();
+  expect_mask(result, gfx::Rect(-10, -10, 60, 50), [](int x, int y, void*) {
+      return gfx::Rect(10, 5, 8, 6).contains(gfx::Point(x, y));
+    }, nullptr);
+
+  // An empty frozen mask is reserved with the bounds of the new mask
+  Mask empty;
+  empty.freeze();
+  empty.add(big);
+  empty.unfreeze();
+  expect_mask(empty, gfx::Rect(-10, -10, 60, 50), [](int x, int y, void*) {
+      return gfx::Rect(0, 0, 40, 30).contains(gfx::Point(x, y));
+    }, nullptr);
+}
+
+TEST(Mask, Invert)
+{
+  std::srand(2);
+  for (int i=0; i<50; ++i) {
+    Mask a;
+    random_mask(a, random_rect());
+    if (a.isEmpty())
+      continue;
+
+    const gfx::Rect bounds = a.bounds();
+    Mask result(a);
+    result.invert();
+
+    Masks masks = { &a, nullptr };
+    expect_mask(result, bounds, [](int x, int y, void* data) {
+        Masks* m = (Masks*)data;
+        return (m->a->bounds().contains(gfx::Point(x, y)) &&
+                !m->a->containsPoint(x, y));
+      }, &masks);
+  }
+
+  Mask rect;
+  rect.replace(gfx::Rect(3, 5, 70, 9));
+  EXPECT_TRUE(rect.isRectangular());
+  rect.subtract(gfx::Rect(72, 13, 1, 1));
+  EXPECT_FALSE(rect.isRectangular());
+}
+
+TEST(Mask, ByColor)
+{
+  const PixelFormat formats[] = { IMAGE_RGB, IMAGE_GRAYSCALE, IMAGE_INDEXED };
+
+  std::srand(3);
+  for (PixelFormat format : formats) {
+    std::unique_ptr<Image> image(Image::create(format, 77, 13));
+    for (int y=0; y<image->height(); ++y)
+      for (int x=0; x<image->width(); ++x) {
+        const int v = std::rand() % 8;
+        put_pixel(image.get(), x, y,
+                  format == IMAGE_RGB ? rgba(v, 0, 0, 255):
+                  format == IMAGE_GRAYSCALE ? graya(v, 255): v);
+      }
+
+    const color_t color =
+      (format == IMAGE_RGB ? rgba(4, 0, 0, 255):
+       format == IMAGE_GRAYSCALE ? graya(4, 255): 4);
+
+    Mask mask;
+    mask.byColor(image.get(), color, 1);
+
+    gfx::Rect bounds;
+    for (int y=0; y<image->height(); ++y)
+      for (int x=0; x<image->width(); ++x) {
+        const color_t c = get_pixel(image.get(), x, y);
+        const int v = (format == IMAGE_RGB ? rgba_getr(c):
+                       format == IMAGE_GRAYSCALE ? graya_getv(c): c);
+        const bool expected = (v >= 3 && v <= 5);
+        EXPECT_EQ(expected, mask.containsPoint(x, y));
+        if (expected)
+          bounds |= gfx::Rect(x, y, 1, 1);
+      }
+    EXPECT_EQ(bounds, mask.bounds());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
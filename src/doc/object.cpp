@@ -11,17 +11,84 @@
 #include "doc/object.h"
 
 #include "base/debug.h"
-#include "base/mutex.h"
-#include "base/scoped_lock.h"
 
-#include <map>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace doc {
 
-static base::mutex mutex;
-static ObjectId newId = 0;
-// TODO Profile this and see if an unordered_map is better
-static std::map<ObjectId, Object*> objects;
+namespace {
+
+// The registry of objects is divided in several shards (selected by
+// the ID), each one with its own mutex, so threads that register or
+// look up different objects (e.g. the UI thread, the backup thread,
+// and a file loading thread) don't wait for each other.
+const int kShards = 64;
+
+struct alignas(64) Shard {
+  std::mutex mutex;
+  std::unordered_map<ObjectId, Object*> objects;
+
+  // Statistics (see get_object_registry_stats())
+  std::atomic<uint64_t> lookups{0};
+  std::atomic<uint64_t> inserts{0};
+  std::atomic<uint64_t> removes{0};
+  std::atomic<uint64_t> contended{0};
+};
+
+// Locks the shard mutex counting the times we had to wait for other
+// thread to unlock it.
+class ShardLock {
+public:
+  ShardLock(Shard& shard) : m_shard(shard) {
+    if (!m_shard.mutex.try_lock()) {
+      m_shard.contended.fetch_add(1, std::memory_order_relaxed);
+      m_shard.mutex.lock();
+    }
+  }
+  ~ShardLock() {
+    m_shard.mutex.unlock();
+  }
+private:
+  Shard& m_shard;
+};
+
+Shard shards[kShards];
+
+// Last generated ID. IDs are never reused, so an old ID cannot be
+// resolved to a new object by get_object().
+std::atomic<ObjectId> newId(0);
+
+inline Shard& shard_for(ObjectId id)
+{
+  return shards[id % kShards];
+}
+
+void insert_object(ObjectId id, Object* obj)
+{
+  Shard& shard = shard_for(id);
+  shard.inserts.fetch_add(1, std::memory_order_relaxed);
+
+  ShardLock lock(shard);
+  ASSERT(shard.objects.find(id) == shard.objects.end());
+  shard.objects.insert(std::make_pair(id, obj));
+}
+
+void remove_object(ObjectId id, Object* obj)
+{
+  Shard& shard = shard_for(id);
+  shard.removes.fetch_add(1, std::memory_order_relaxed);
+
+  ShardLock lock(shard);
+  auto it = shard.objects.find(id);
+  ASSERT(it != shard.objects.end());
+  ASSERT(it->second == obj);
+  if (it != shard.objects.end())
+    shard.objects.erase(it);
+}
+
+} // anonymous namespace
 
 Object::Object(ObjectType type)
   : m_type(type)
@@ -53,30 +120,27 @@ const ObjectId Object::id() const
   // The first time the ID is request, we store the object in the
   // "objects" hash table.
   if (!m_id) {
-    base::scoped_unlock hold(mutex);
     m_id = ++newId;
-    objects.insert(std::make_pair(m_id, const_cast<Object*>(this)));
+    insert_object(m_id, const_cast<Object*>(this));
   }
   return m_id;
 }
 
 void Object::setId(ObjectId id)
 {
-  base::scoped_unlock hold(mutex);
-
-  if (m_id) {
-    auto it = objects.find(m_id);
-    ASSERT(it != objects.end());
-    ASSERT(it->second == this);
-    if (it != objects.end())
-      objects.erase(it);
-  }
+  if (m_id)
+    remove_object(m_id, this);
 
   m_id = id;
 
   if (m_id) {
-    ASSERT(objects.find(m_id) == objects.end());
-    objects.insert(std::make_pair(m_id, this));
+    // Avoid generating this ID in the future (e.g. the ID can come
+    // from a file that was just loaded).
+    ObjectId last = newId.load();
+    while (last < id && !newId.compare_exchange_weak(last, id))
+      ;
+
+    insert_object(m_id, this);
   }
 }
 
@@ -87,12 +151,32 @@ void Object::setVersion(ObjectVersion version)
 
 Object* get_object(ObjectId id)
 {
-  base::scoped_unlock hold(mutex);
-  auto it = objects.find(id);
-  if (it != objects.end())
+  Shard& shard = shard_for(id);
+  shard.lookups.fetch_add(1, std::memory_order_relaxed);
+
+  ShardLock lock(shard);
+  auto it = shard.objects.find(id);
+  if (it != shard.objects.end())
     return it->second;
   else
     return nullptr;
 }
 
+ObjectRegistryStats get_object_registry_stats()
+{
+  ObjectRegistryStats stats;
+  stats.shards = kShards;
+  for (Shard& shard : shards) {
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      stats.objects += shard.objects.size();
+    }
+    stats.lookups += shard.lookups.load(std::memory_order_relaxed);
+    stats.inserts += shard.inserts.load(std::memory_order_relaxed);
+    stats.removes += shard.removes.load(std::memory_order_relaxed);
+    stats.contended += shard.contended.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
 } // namespace doc
@@ -10,6 +10,9 @@
 #include "base/with_handle.h"
 #include "doc/object_id.h"
 #include "doc/object_type.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace doc {
@@ -52,6 +55,19 @@ namespace doc {
 
   Object* get_object(ObjectId id);
 
+  // Counters of the objects registry (used by get_object()) to
+  // diagnose lock contention between threads.
+  struct ObjectRegistryStats {
+    int shards = 0;
+    std::size_t objects = 0;  // Objects with an ID at this moment
+    uint64_t lookups = 0;     // Calls to get_object()
+    uint64_t inserts = 0;     // IDs assigned to objects
+    uint64_t removes = 0;     // IDs released by objects
+    uint64_t contended = 0;   // Times a thread had to wait for the lock
+  };
+
+  ObjectRegistryStats get_object_registry_stats();
+
   template<typename T>
   inline T* get(ObjectId id) {
     return static_cast<T*>(get_object(id));
@@ -0,0 +1,75 @@
+// Aseprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/object.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace doc;
+
+TEST(Object, GetObject)
+{
+  std::unique_ptr<Object> a(new Object(ObjectType::Image));
+  std::unique_ptr<Object> b(new Object(ObjectType::Image));
+  ObjectId idA = a->id();
+  ObjectId idB = b->id();
+
+  EXPECT_NE(idA, idB);
+  EXPECT_EQ(a.get(), get_object(idA));
+  EXPECT_EQ(b.get(), get_object(idB));
+
+  a.reset();
+  EXPECT_EQ(nullptr, get_object(idA));
+  EXPECT_EQ(b.get(), get_object(idB));
+}
+
+TEST(Object, SetIdIsNotReused)
+{
+  std::unique_ptr<Object> a(new Object(ObjectType::Image));
+  ObjectId id = a->id() + 1000;
+  a->setId(id);
+  EXPECT_EQ(a.get(), get_object(id));
+
+  std::unique_ptr<Object> b(new Object(ObjectType::Image));
+  EXPECT_GT(b->id(), id);
+}
+
+TEST(Object, Threads)
+{
+  ObjectRegistryStats before = get_object_registry_stats();
+
+  std::vector<std::thread> threads;
+  for (int i=0; i<4; ++i) {
+    threads.emplace_back([]{
+      for (int j=0; j<1000; ++j) {
+        Object obj(ObjectType::Image);
+        EXPECT_EQ(&obj, get_object(obj.id()));
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  ObjectRegistryStats after = get_object_registry_stats();
+  EXPECT_EQ(before.objects, after.objects);
+  EXPECT_EQ(before.inserts + 4000, after.inserts);
+  EXPECT_EQ(before.removes + 4000, after.removes);
+  EXPECT_EQ(before.lookups + 4000, after.lookups);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
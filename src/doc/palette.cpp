@@ -193,7 +193,7 @@ static uint32_t* col_diff_r;
 static uint32_t* col_diff_b;
 static uint32_t* col_diff_a;
 
-static void initBestfit()
+static bool initBestfit()
 {
   col_diff.resize(4*128, 0);
   col_diff_g = &col_diff[128*0];
@@ -208,6 +208,7 @@ static void initBestfit()
     col_diff_b[i] = col_diff_b[128-i] = k * 11 * 11;
     col_diff_a[i] = col_diff_a[128-i] = k * 8 * 8;
   }
+  return true;
 }
 
 int Palette::findBestfit(int r, int g, int b, int a, int mask_index) const
@@ -217,8 +218,10 @@ int Palette::findBestfit(int r, int g, int b, int a, int mask_index) const
   ASSERT(b >= 0 && b <= 255);
   ASSERT(a >= 0 && a <= 255);
 
-  if (col_diff.empty())
-    initBestfit();
+  // The tables are initialized only once even if the first calls
+  // come from several threads.
+  static const bool initialized = initBestfit();
+  (void)initialized;
 
   r >>= 3;
   g >>= 3;
@@ -13,6 +13,7 @@
 #include "doc/algo.h"
 #include "doc/brush.h"
 #include "doc/image_impl.h"
+#include "doc/images_diff.h"
 #include "doc/palette.h"
 #include "doc/remap.h"
 #include "doc/rgbmap.h"
@@ -293,45 +294,30 @@ void fill_ellipse(Image* image, int x1, int y1, int x2, int y2, color_t color)
   algo_ellipsefill(x1, y1, x2, y2, &data, (AlgoHLine)hline_for_image);
 }
 
-namespace {
-
-template<typename ImageTraits>
-int count_diff_between_images_templ(const Image* i1, const Image* i2)
+static bool same_format_and_size(const Image* i1, const Image* i2)
 {
-  int diff = 0;
-  const LockImageBits<ImageTraits> bits1(i1);
-  const LockImageBits<ImageTraits> bits2(i2);
-  typename LockImageBits<ImageTraits>::const_iterator it1, it2, end1, end2;
-  for (it1 = bits1.begin(), end1 = bits1.end(),
-       it2 = bits2.begin(), end2 = bits2.end();
-       it1 != end1 && it2 != end2; ++it1, ++it2) {
-    if (*it1 != *it2)
-      diff++;
-  }
-
-  ASSERT(it1 == end1);
-  ASSERT(it2 == end2);
-  return diff;
+  return (i1->pixelFormat() == i2->pixelFormat() &&
+          i1->width() == i2->width() &&
+          i1->height() == i2->height());
 }
 
-} // anonymous namespace
-
 int count_diff_between_images(const Image* i1, const Image* i2)
 {
-  if ((i1->pixelFormat() != i2->pixelFormat()) ||
-      (i1->width() != i2->width()) ||
-      (i1->height() != i2->height()))
+  if (!same_format_and_size(i1, i2))
     return -1;
 
-  switch (i1->pixelFormat()) {
-    case IMAGE_RGB:       return count_diff_between_images_templ<RgbTraits>(i1, i2);
-    case IMAGE_GRAYSCALE: return count_diff_between_images_templ<GrayscaleTraits>(i1, i2);
-    case IMAGE_INDEXED:   return count_diff_between_images_templ<IndexedTraits>(i1, i2);
-    case IMAGE_BITMAP:    return count_diff_between_images_templ<BitmapTraits>(i1, i2);
-  }
+  ImagesDiff diff(ImagesDiff::kCount);
+  diff.compare(i1, i2);
+  return diff.count();
+}
+
+bool is_same_image(const Image* i1, const Image* i2)
+{
+  if (!same_format_and_size(i1, i2))
+    return false;
 
-  ASSERT(false);
-  return -1;
+  ImagesDiff diff(ImagesDiff::kAny);
+  return !diff.compare(i1, i2);
 }
 
 void remap_image(Image* image, const Remap& remap)
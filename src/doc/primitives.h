@@ -37,8 +37,13 @@ namespace doc {
   void draw_ellipse(Image* image, int x1, int y1, int x2, int y2, color_t c);
   void fill_ellipse(Image* image, int x1, int y1, int x2, int y2, color_t c);
 
+  // Returns -1 if the images have different format or size.
   int count_diff_between_images(const Image* i1, const Image* i2);
 
+  // Returns true if the images have the same format, size and pixels
+  // (it stops in the first different pixel).
+  bool is_same_image(const Image* i1, const Image* i2);
+
   void remap_image(Image* image, const Remap& remap);
 
 } // namespace doc
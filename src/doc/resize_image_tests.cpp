@@ -10,11 +10,16 @@
 
 #include <gtest/gtest.h>
 
+#include "base/parallel_for.h"
 #include "doc/algorithm/resize_image.h"
 #include "doc/color.h"
 #include "doc/image.h"
 #include "doc/primitives.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
 using namespace std;
 using namespace doc;
 
@@ -94,6 +99,57 @@ TEST(ResizeImage, BilinearInterpRGBType)
 }
 #endif
 
+// Bilinear interpolation of one pixel of "dst" (calculated alone, so
+// the result doesn't depend on how rows are divided between threads)
+static color_t bilinear_pixel(const Image* src, const Image* dst, int x, int y)
+{
+  const double du = (src->width()-1) * 1.0 / (dst->width()-1);
+  const double dv = (src->height()-1) * 1.0 / (dst->height()-1);
+  const double u = x * du;
+  const double v = y * dv;
+  const int u1 = std::min(int(floor(u)), src->width()-1);
+  const int v1 = std::min(int(floor(v)), src->height()-1);
+  const int u2 = std::min(u1+1, src->width()-1);
+  const int v2 = std::min(v1+1, src->height()-1);
+  const double fu = u - u1;
+  const double fv = v - v1;
+
+  const color_t c[4] = { src->getPixel(u1, v1), src->getPixel(u2, v1),
+                         src->getPixel(u1, v2), src->getPixel(u2, v2) };
+  auto interp = [&](int (*get)(color_t)) {
+    return int((get(c[0])*(1-fu) + get(c[1])*fu)*(1-fv) +
+               (get(c[2])*(1-fu) + get(c[3])*fu)*fv);
+  };
+  return rgba(interp([](color_t c) -> int { return rgba_getr(c); }),
+              interp([](color_t c) -> int { return rgba_getg(c); }),
+              interp([](color_t c) -> int { return rgba_getb(c); }),
+              interp([](color_t c) -> int { return rgba_geta(c); }));
+}
+
+TEST(ResizeImage, BilinearInParallel)
+{
+  std::unique_ptr<Image> src(Image::create(IMAGE_RGB, 37, 53));
+  for (int y=0; y<src->height(); ++y)
+    for (int x=0; x<src->width(); ++x)
+      src->putPixel(x, y, rgba(x*7, y*5, (x*y) & 255, 255 - x - y));
+
+  // Expected result calculated pixel by pixel
+  std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, 300, 211));
+  for (int y=0; y<expected->height(); ++y)
+    for (int x=0; x<expected->width(); ++x)
+      expected->putPixel(x, y, bilinear_pixel(src.get(), expected.get(), x, y));
+
+  // Bands of rows resized by several threads (if there are several
+  // cores)
+  ASSERT_FALSE(base::details::inside_parallel_for);
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, 300, 211));
+  algorithm::resize_image(src.get(), dst.get(), algorithm::RESIZE_METHOD_BILINEAR, NULL, NULL, -1);
+
+  EXPECT_EQ(0, count_diff_between_images(dst.get(), expected.get()));
+  EXPECT_EQ(src->getPixel(0, 0), dst->getPixel(0, 0));
+  EXPECT_EQ(src->getPixel(36, 52), dst->getPixel(299, 210));
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,130 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "base/pi.h"
+#include "doc/algorithm/rotate.h"
+#include "doc/algorithm/rotsprite.h"
+#include "doc/color.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+#include "gfx/size.h"
+
+#include <cmath>
+#include <memory>
+
+using namespace doc;
+
+static Image* create_test_image(PixelFormat format, int width, int height)
+{
+  Image* image = Image::create(format, width, height);
+  for (int y=0; y<height; ++y)
+    for (int x=0; x<width; ++x)
+      image->putPixel(x, y, ((x*7 + y*3) % 5 == 0 ? 0: (x+y) % 3 + 1));
+  image->setMaskColor(0);
+  return image;
+}
+
+TEST(RotSprite, ReuseSource)
+{
+  for (PixelFormat format : { IMAGE_RGB, IMAGE_GRAYSCALE, IMAGE_INDEXED }) {
+    std::unique_ptr<Image> src(create_test_image(format, 64, 48));
+    algorithm::RotSpriteSource source(src.get(), nullptr);
+    EXPECT_EQ(64, source.width());
+    EXPECT_EQ(48, source.height());
+
+    for (int i=0; i<3; ++i) {
+      std::unique_ptr<Image> a(Image::create(format, 120, 120));
+      std::unique_ptr<Image> b(Image::create(format, 120, 120));
+      clear_image(a.get(), 0);
+      clear_image(b.get(), 0);
+
+      const int x1 = 30+i*5, y1 = 10;
+      const int x2 = 100, y2 = 30+i*7;
+      const int x3 = 80-i*3, y3 = 100;
+      const int x4 = x1+x3-x2, y4 = y1+y3-y2;
+
+      algorithm::rotsprite_image(a.get(), src.get(), nullptr,
+                                 x1, y1, x2, y2, x3, y3, x4, y4);
+      algorithm::rotsprite_image(b.get(), source,
+                                 x1, y1, x2, y2, x3, y3, x4, y4);
+
+      EXPECT_EQ(0, count_diff_between_images(a.get(), b.get()));
+    }
+  }
+}
+
+// The destination is drawn in bands of rows by several threads. A
+// 256x256 image is drawn in only one band, and a 1024x256 image in
+// several bands, so the result (the parallelogram is inside the
+// first 256 columns) must be the same in both cases.
+TEST(RotSprite, SameResultInBands)
+{
+  const gfx::Size sizes[] = { gfx::Size(16, 12), gfx::Size(37, 29),
+                              gfx::Size(64, 48), gfx::Size(150, 91) };
+  const double angles[] = { 0.0, 5.0, 30.0, 45.0, 60.0, 89.0,
+                            90.0, 135.0, 200.0, 333.0 };
+
+  for (PixelFormat format : { IMAGE_RGB, IMAGE_INDEXED }) {
+    for (const gfx::Size& size : sizes) {
+      std::unique_ptr<Image> src(create_test_image(format, size.w, size.h));
+
+      for (double angle : angles) {
+        // Corners of the rotated image around the center of the
+        // destination
+        const double a = angle * PI / 180.0;
+        const double c = std::cos(a), s = std::sin(a);
+        int xs[4], ys[4];
+        const double us[4] = { -1, 1, 1, -1 };
+        const double vs[4] = { -1, -1, 1, 1 };
+        for (int i=0; i<4; ++i) {
+          const double u = us[i] * size.w / 2.0;
+          const double v = vs[i] * size.h / 2.0;
+          xs[i] = int(std::round(128 + u*c - v*s));
+          ys[i] = int(std::round(128 + u*s + v*c));
+        }
+
+        for (int method=0; method<2; ++method) {
+          std::unique_ptr<Image> one(Image::create(format, 256, 256));
+          std::unique_ptr<Image> bands(Image::create(format, 1024, 256));
+          clear_image(one.get(), 0);
+          clear_image(bands.get(), 0);
+
+          for (Image* dst : { one.get(), bands.get() }) {
+            if (method == 0)
+              algorithm::rotsprite_image(dst, src.get(), nullptr,
+                                         xs[0], ys[0], xs[1], ys[1],
+                                         xs[2], ys[2], xs[3], ys[3]);
+            else
+              algorithm::parallelogram(dst, src.get(), nullptr,
+                                       xs[0], ys[0], xs[1], ys[1],
+                                       xs[2], ys[2], xs[3], ys[3]);
+          }
+
+          int diffs = 0;
+          for (int y=0; y<256; ++y)
+            for (int x=0; x<1024; ++x)
+              if (bands->getPixel(x, y) != (x < 256 ? one->getPixel(x, y): 0))
+                ++diffs;
+          EXPECT_EQ(0, diffs)
+            << (method == 0 ? "rotsprite ": "parallelogram ")
+            << size.w << "x" << size.h << " " << angle << " degrees";
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+// LibreSprite Document Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/algorithm/shrink_bounds.h"
+#include "doc/color.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+#include "gfx/rect.h"
+
+#include <cstdlib>
+#include <memory>
+
+using namespace doc;
+using namespace doc::algorithm;
+
+// Bounds of the pixels that are different in both images (checking
+// pixel by pixel)
+static gfx::Rect expected_bounds(const Image* a, const Image* b)
+{
+  gfx::Rect bounds;
+  for (int y=0; y<a->height(); ++y)
+    for (int x=0; x<a->width(); ++x)
+      if (get_pixel(a, x, y) != get_pixel(b, x, y))
+        bounds |= gfx::Rect(x, y, 1, 1);
+  return bounds;
+}
+
+TEST(ShrinkBounds, RefPixel)
+{
+  std::unique_ptr<Image> image(Image::create(IMAGE_RGB, 100, 40));
+  gfx::Rect bounds;
+
+  clear_image(image.get(), 0);
+  EXPECT_FALSE(shrink_bounds(image.get(), bounds, 0));
+
+  put_pixel(image.get(), 70, 3, rgba(255, 0, 0, 255));
+  put_pixel(image.get(), 2, 30, rgba(0, 255, 0, 255));
+  EXPECT_TRUE(shrink_bounds(image.get(), bounds, 0));
+  EXPECT_EQ(gfx::Rect(2, 3, 69, 28), bounds);
+
+  // Transparent pixels are equal to the transparent reference pixel
+  put_pixel(image.get(), 99, 39, rgba(255, 255, 255, 0));
+  EXPECT_TRUE(shrink_bounds(image.get(), bounds, 0));
+  EXPECT_EQ(gfx::Rect(2, 3, 69, 28), bounds);
+
+  // The start bounds are respected
+  EXPECT_TRUE(shrink_bounds(image.get(), gfx::Rect(50, 0, 50, 40), bounds, 0));
+  EXPECT_EQ(gfx::Rect(70, 3, 1, 1), bounds);
+}
+
+TEST(ShrinkBounds, AllFormatsAgainstPixelByPixel)
+{
+  const PixelFormat formats[] = {
+    IMAGE_RGB, IMAGE_GRAYSCALE, IMAGE_INDEXED, IMAGE_BITMAP
+  };
+
+  std::srand(1);
+  for (PixelFormat format : formats) {
+    const color_t color =
+      (format == IMAGE_RGB ? rgba(1, 2, 3, 255):
+       format == IMAGE_GRAYSCALE ? graya(4, 255): 1);
+
+    for (int i=0; i<50; ++i) {
+      const int w = 1 + std::rand() % 90;
+      const int h = 1 + std::rand() % 20;
+      std::unique_ptr<Image> a(Image::create(format, w, h));
+      std::unique_ptr<Image> b(Image::create(format, w, h));
+      clear_image(a.get(), 0);
+      clear_image(b.get(), 0);
+
+      const int n = std::rand() % 4;
+      for (int j=0; j<n; ++j)
+        put_pixel(b.get(), std::rand() % w, std::rand() % h, color);
+
+      const gfx::Rect expected = expected_bounds(a.get(), b.get());
+      gfx::Rect bounds;
+      EXPECT_EQ(!expected.isEmpty(), shrink_bounds(b.get(), bounds, 0));
+      if (!expected.isEmpty())
+        EXPECT_EQ(expected, bounds);
+
+      EXPECT_EQ(!expected.isEmpty(),
+                shrink_bounds2(a.get(), b.get(), a->bounds(), bounds));
+      if (!expected.isEmpty())
+        EXPECT_EQ(expected, bounds);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
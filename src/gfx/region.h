@@ -84,6 +84,9 @@ namespace gfx {
     Region();
     Region(const Region& copy);
     explicit Region(const Rect& rect);
+    // Creates the union of all the given rectangles at once (faster
+    // than adding them one by one).
+    explicit Region(const std::vector<Rect>& rects);
     Region& operator=(const Rect& rect);
     Region& operator=(const Region& copy);
     ~Region();
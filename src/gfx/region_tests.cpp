@@ -52,6 +52,21 @@ TEST(Region, Ctor)
   EXPECT_EQ(Rect(2, 3, 4, 5), Region(Rect(2, 3, 4, 5))[0]);
 }
 
+TEST(Region, CtorFromRects)
+{
+  EXPECT_TRUE(Region(std::vector<Rect>()).isEmpty());
+
+  std::vector<Rect> rects;
+  rects.push_back(Rect(6, 3, 4, 5));
+  rects.push_back(Rect(0, 0, 0, 0));
+  rects.push_back(Rect(2, 3, 4, 5));
+  rects.push_back(Rect(2, 8, 8, 1));
+  Region a(rects);
+  EXPECT_EQ(Rect(2, 3, 8, 6), a.bounds());
+  ASSERT_EQ(1, a.size());
+  EXPECT_EQ(Rect(2, 3, 8, 6), a[0]);
+}
+
 TEST(Region, Equal)
 {
   Region a;
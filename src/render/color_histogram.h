@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -75,6 +76,38 @@ namespace render {
       }
     }
 
+    // Adds all the samples of "other" histogram to this one. The
+    // result is the same as if the samples of "other" were added
+    // after the samples of this histogram (so histograms filled with
+    // consecutive parts of an image can be merged in order).
+    void merge(const ColorHistogram& other) {
+      for (std::size_t i=0; i<m_histogram.size(); ++i) {
+        const std::size_t count = other.m_histogram[i];
+        if (m_histogram[i] < std::numeric_limits<std::size_t>::max()-count) // Avoid overflow
+          m_histogram[i] += count;
+        else
+          m_histogram[i] = std::numeric_limits<std::size_t>::max();
+      }
+
+      if (!other.m_useHighPrecision)
+        m_useHighPrecision = false;
+
+      if (m_useHighPrecision) {
+        for (doc::color_t color : other.m_highPrecision) {
+          if (std::find(m_highPrecision.begin(), m_highPrecision.end(), color) != m_highPrecision.end())
+            continue;
+
+          if (m_highPrecision.size() < 256) {
+            m_highPrecision.push_back(color);
+          }
+          else {
+            m_useHighPrecision = false;
+            break;
+          }
+        }
+      }
+    }
+
     // Creates a set of entries for the given palette in the given range
     // with the more important colors in the histogram. Returns the
     // number of used entries in the palette (maybe the range [from,to]
@@ -0,0 +1,117 @@
+// LibreSprite Render Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "render/color_histogram.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace doc;
+using namespace render;
+
+typedef ColorHistogram<5, 6, 5, 5> Histogram;
+
+static color_t random_color()
+{
+  return rgba(std::rand() % 256, std::rand() % 256,
+              std::rand() % 256, std::rand() % 256);
+}
+
+TEST(ColorHistogram, SumsCountBoxes)
+{
+  typedef ColorHistogram<2, 3, 2, 2> SmallHistogram;
+  std::unique_ptr<SmallHistogram> histogram(new SmallHistogram);
+
+  std::srand(1);
+  for (int i=0; i<500; ++i)
+    histogram->addSamples(random_color(), 1 + std::rand() % 3);
+
+  HistogramSums<SmallHistogram> sums(*histogram);
+  for (int i=0; i<200; ++i) {
+    int lo[4], hi[4];
+    const int n[4] = {
+      SmallHistogram::RElements, SmallHistogram::GElements,
+      SmallHistogram::BElements, SmallHistogram::AElements
+    };
+    for (int j=0; j<4; ++j) {
+      lo[j] = std::rand() % n[j];
+      hi[j] = lo[j] + std::rand() % (n[j] - lo[j]);
+    }
+
+    std::size_t expected = 0;
+    for (int r=lo[0]; r<=hi[0]; ++r)
+      for (int g=lo[1]; g<=hi[1]; ++g)
+        for (int b=lo[2]; b<=hi[2]; ++b)
+          for (int a=lo[3]; a<=hi[3]; ++a)
+            expected += histogram->at(r, g, b, a);
+
+    EXPECT_EQ(expected, sums.count(lo[0], lo[1], lo[2], lo[3],
+                                   hi[0], hi[1], hi[2], hi[3]));
+  }
+}
+
+TEST(ColorHistogram, MedianCutFindsClusters)
+{
+  std::unique_ptr<Histogram> histogram(new Histogram);
+  const color_t colors[] = {
+    rgba(0, 0, 0, 255),
+    rgba(255, 0, 0, 255),
+    rgba(0, 255, 0, 255),
+    rgba(0, 0, 255, 255)
+  };
+  for (color_t color : colors)
+    histogram->addSamples(color, 100);
+
+  std::vector<uint32_t> result;
+  median_cut(*histogram, 4, result);
+  ASSERT_EQ(4, int(result.size()));
+  for (color_t color : colors)
+    EXPECT_NE(result.end(), std::find(result.begin(), result.end(), color));
+}
+
+TEST(ColorHistogram, MergeIsLikeAddingInOrder)
+{
+  // Less than 256 colors (high precision palette) and more colors
+  // (median cut)
+  for (int ncolors : { 100, 300, 5000 }) {
+    std::unique_ptr<Histogram> all(new Histogram);
+    std::unique_ptr<Histogram> first(new Histogram);
+    std::unique_ptr<Histogram> second(new Histogram);
+
+    std::srand(ncolors);
+    std::vector<color_t> colors;
+    for (int i=0; i<ncolors; ++i)
+      colors.push_back(random_color());
+
+    for (int i=0; i<ncolors*2; ++i) {
+      const color_t color = colors[std::rand() % ncolors];
+      all->addSamples(color);
+      (i < ncolors ? first: second)->addSamples(color);
+    }
+    first->merge(*second);
+
+    std::shared_ptr<Palette> expected = Palette::create(256);
+    std::shared_ptr<Palette> merged = Palette::create(256);
+    EXPECT_EQ(all->createOptimizedPalette(*expected),
+              first->createOptimizedPalette(*merged));
+    for (int i=0; i<256; ++i)
+      EXPECT_EQ(expected->getEntry(i), merged->getEntry(i));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
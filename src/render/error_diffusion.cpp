@@ -0,0 +1,200 @@
+// LibreSprite Render Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "render/error_diffusion.h"
+
+#include "base/debug.h"
+#include "base/parallel_for.h"
+#include "doc/color.h"
+#include "doc/image.h"
+#include "doc/image_traits.h"
+#include "doc/palette.h"
+#include "doc/rgbmap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace render {
+
+using namespace doc;
+
+// Number of pixels of a row processed between two updates of its
+// progress (each update can wake up the thread of the next row).
+static const int kProgressStep = 32;
+
+ErrorDiffusionMatrix::ErrorDiffusionMatrix(int divisor, std::initializer_list<Item> items)
+  : m_divisor(divisor)
+  , m_reach(0)
+  , m_rows(0)
+  , m_items(items)
+{
+  std::stable_sort(m_items.begin(), m_items.end(),
+                   [](const Item& a, const Item& b) { return a.dy < b.dy; });
+
+  for (const Item& item : m_items) {
+    ASSERT(item.dy > 0 || (item.dy == 0 && item.dx > 0));
+    m_reach = std::max(m_reach, std::abs(item.dx));
+    m_rows = std::max(m_rows, item.dy);
+  }
+}
+
+// static
+const ErrorDiffusionMatrix& ErrorDiffusionMatrix::floydSteinberg()
+{
+  static ErrorDiffusionMatrix matrix(
+    16, { {  1, 0, 7 },
+          { -1, 1, 3 }, { 0, 1, 5 }, { 1, 1, 1 } });
+  return matrix;
+}
+
+// static
+const ErrorDiffusionMatrix& ErrorDiffusionMatrix::jarvisJudiceNinke()
+{
+  static ErrorDiffusionMatrix matrix(
+    48, {                                         {  1, 0, 7 }, { 2, 0, 5 },
+          { -2, 1, 3 }, { -1, 1, 5 }, { 0, 1, 7 }, {  1, 1, 5 }, { 2, 1, 3 },
+          { -2, 2, 1 }, { -1, 2, 3 }, { 0, 2, 5 }, {  1, 2, 3 }, { 2, 2, 1 } });
+  return matrix;
+}
+
+// static
+const ErrorDiffusionMatrix& ErrorDiffusionMatrix::atkinson()
+{
+  // Only 6/8 of the error is distributed
+  static ErrorDiffusionMatrix matrix(
+    8, {                            { 1, 0, 1 }, { 2, 0, 1 },
+         { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 },
+                       { 0, 2, 1 } });
+  return matrix;
+}
+
+// static
+const ErrorDiffusionMatrix* ErrorDiffusionMatrix::fromMethod(DitheringMethod method)
+{
+  switch (method) {
+    case DitheringMethod::FLOYD_STEINBERG: return &floydSteinberg();
+    case DitheringMethod::JARVIS_JUDICE_NINKE: return &jarvisJudiceNinke();
+    case DitheringMethod::ATKINSON: return &atkinson();
+    default: return nullptr;
+  }
+}
+
+void ErrorDiffusionDither::ditherRgbImageToIndexed(
+  const Image* srcImage,
+  Image* dstImage,
+  const RgbMap* rgbmap,
+  const Palette* palette)
+{
+  ASSERT(srcImage->pixelFormat() == IMAGE_RGB);
+  ASSERT(dstImage->pixelFormat() == IMAGE_INDEXED);
+  ASSERT(rgbmap);
+
+  const int w = srcImage->width();
+  const int h = srcImage->height();
+  const int reach = m_matrix.reach();
+  const int divisor = m_matrix.divisor();
+  const auto& items = m_matrix.items();
+
+  // Accumulated errors (r, g, b) of each pixel multiplied by the
+  // divisor. There are "reach" extra pixels at both sides of each row
+  // so we don't need to check the bounds.
+  const int stride = 3*(w + 2*reach);
+
+  // Errors of the next rows are saved in a ring buffer of rows. A
+  // row starts when a thread finishes its previous row, and rows are
+  // finished in order, so when the row "y" starts all rows before
+  // y-threads are finished, and the slot of row y can be reused by
+  // row y+threads+rows().
+  const int slots = base::parallel_for_threads() + m_matrix.rows();
+  std::vector<int> errors(slots * stride, 0);
+
+  // Number of processed pixels of each row
+  std::vector<std::atomic<int>> progress(h);
+  for (auto& p : progress)
+    p.store(0, std::memory_order_relaxed);
+
+  // Each row is a chunk of parallel_for(), chunks are taken in order
+  // so the previous row is always being processed by other thread (or
+  // it was already processed).
+  base::parallel_for(
+    0, h, 1,
+    [&](int y, int) {
+      const uint32_t* src = (const uint32_t*)srcImage->getPixelAddress(0, y);
+      uint8_t* dst = (uint8_t*)dstImage->getPixelAddress(0, y);
+      int* rowErrors = &errors[(y % slots) * stride];
+
+      // Errors for the pixels at the right side in this same row (they
+      // cannot be added to "rowErrors" because the previous row can be
+      // adding its errors there at the same time)
+      std::vector<int> nextErrors(stride, 0);
+
+      // Items that don't go outside the image
+      const int maxDy = h-1-y;
+      int ready = (y > 0 ? progress[y-1].load(std::memory_order_acquire): w);
+
+      for (int x=0; x<w; ++x) {
+        // Wait the previous row to give us all the error for this
+        // pixel. It has to be "reach" pixels ahead of the pixels that
+        // this row modifies, so two rows never add errors to the same
+        // pixels of a next row at the same time.
+        const int needed = std::min(w, x+2*reach+1);
+        while (ready < needed) {
+          std::this_thread::yield();
+          ready = progress[y-1].load(std::memory_order_acquire);
+        }
+
+        const color_t c = src[x];
+        const int a = rgba_geta(c);
+        if (a == 0 && m_transparentIndex >= 0) {
+          dst[x] = m_transparentIndex;
+        }
+        else {
+          const int i = 3*(x+reach);
+          const int r = std::clamp(rgba_getr(c) + (rowErrors[i  ] + nextErrors[i  ]) / divisor, 0, 255);
+          const int g = std::clamp(rgba_getg(c) + (rowErrors[i+1] + nextErrors[i+1]) / divisor, 0, 255);
+          const int b = std::clamp(rgba_getb(c) + (rowErrors[i+2] + nextErrors[i+2]) / divisor, 0, 255);
+
+          const int index = rgbmap->mapColor(r, g, b, a);
+          const color_t nearest = palette->getEntry(index);
+          dst[x] = index;
+
+          const int er = r - rgba_getr(nearest);
+          const int eg = g - rgba_getg(nearest);
+          const int eb = b - rgba_getb(nearest);
+
+          for (const auto& item : items) {
+            if (item.dy > maxDy)
+              break;
+
+            int* e = (item.dy == 0 ? &nextErrors[0]:
+                      &errors[((y+item.dy) % slots) * stride]);
+            e += 3*(x+item.dx+reach);
+            e[0] += er * item.weight;
+            e[1] += eg * item.weight;
+            e[2] += eb * item.weight;
+          }
+        }
+
+        // The whole row (w) is notified only at the end, when the slot
+        // of this row is already cleared.
+        if (((x+1) % kProgressStep) == 0 && x+1 < w)
+          progress[y].store(x+1, std::memory_order_release);
+      }
+
+      // Clear the errors of this row so the slot can be reused (the
+      // previous row is already finished)
+      std::fill(rowErrors, rowErrors+stride, 0);
+
+      progress[y].store(w, std::memory_order_release);
+    });
+}
+
+} // namespace render
@@ -0,0 +1,81 @@
+// LibreSprite Render Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include "doc/dithering_method.h"
+
+#include <initializer_list>
+#include <vector>
+
+namespace doc {
+  class Image;
+  class Palette;
+  class RgbMap;
+}
+
+namespace render {
+
+  // Distribution of the quantization error of one pixel between the
+  // neighbor pixels that aren't processed yet: pixels at the right
+  // side in the same row (dy=0, dx>0) or in the next rows (dy>0).
+  class ErrorDiffusionMatrix {
+  public:
+    struct Item {
+      int dx, dy;
+      int weight;
+    };
+
+    ErrorDiffusionMatrix(int divisor, std::initializer_list<Item> items);
+
+    int divisor() const { return m_divisor; }
+    const std::vector<Item>& items() const { return m_items; }
+
+    // Maximum horizontal distance between a pixel and the pixels
+    // that receive its error.
+    int reach() const { return m_reach; }
+
+    // Number of rows below that receive the error of each pixel.
+    int rows() const { return m_rows; }
+
+    static const ErrorDiffusionMatrix& floydSteinberg();
+    static const ErrorDiffusionMatrix& jarvisJudiceNinke();
+    static const ErrorDiffusionMatrix& atkinson();
+
+    // Returns the matrix of the given method, or nullptr if it isn't
+    // an error diffusion method.
+    static const ErrorDiffusionMatrix* fromMethod(doc::DitheringMethod method);
+
+  private:
+    int m_divisor;
+    int m_reach;
+    int m_rows;
+    std::vector<Item> m_items;  // Sorted by dy
+  };
+
+  class ErrorDiffusionDither {
+  public:
+    ErrorDiffusionDither(const ErrorDiffusionMatrix& matrix,
+                         int transparentIndex = -1)
+      : m_matrix(matrix)
+      , m_transparentIndex(transparentIndex) {
+    }
+
+    // Converts the RGB image to indexed. Rows are processed by
+    // several threads at the same time: each row follows the previous
+    // one as soon as the pixels that give it their error are ready.
+    // The result doesn't depend on the number of threads.
+    void ditherRgbImageToIndexed(const doc::Image* srcImage,
+                                 doc::Image* dstImage,
+                                 const doc::RgbMap* rgbmap,
+                                 const doc::Palette* palette);
+
+  private:
+    const ErrorDiffusionMatrix& m_matrix;
+    int m_transparentIndex;
+  };
+
+} // namespace render
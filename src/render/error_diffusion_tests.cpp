@@ -0,0 +1,142 @@
+// LibreSprite Render Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/image.h"
+#include "doc/palette.h"
+#include "doc/rgbmap.h"
+#include "gfx/size.h"
+#include "render/error_diffusion.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace doc;
+using namespace render;
+
+// Straightforward implementation with one error per pixel
+static void reference_dither(const ErrorDiffusionMatrix& matrix,
+                             const Image* src, Image* dst,
+                             const RgbMap* rgbmap, const Palette* palette,
+                             int transparentIndex)
+{
+  const int w = src->width();
+  const int h = src->height();
+  std::vector<int> errors(3*w*h, 0);
+
+  for (int y=0; y<h; ++y)
+    for (int x=0; x<w; ++x) {
+      const color_t c = src->getPixel(x, y);
+      const int a = rgba_geta(c);
+      if (a == 0 && transparentIndex >= 0) {
+        dst->putPixel(x, y, transparentIndex);
+        continue;
+      }
+
+      const int* e = &errors[3*(y*w+x)];
+      const int r = std::clamp(rgba_getr(c) + e[0] / matrix.divisor(), 0, 255);
+      const int g = std::clamp(rgba_getg(c) + e[1] / matrix.divisor(), 0, 255);
+      const int b = std::clamp(rgba_getb(c) + e[2] / matrix.divisor(), 0, 255);
+      const int index = rgbmap->mapColor(r, g, b, a);
+      const color_t nearest = palette->getEntry(index);
+      dst->putPixel(x, y, index);
+
+      for (const auto& item : matrix.items()) {
+        const int u = x + item.dx;
+        const int v = y + item.dy;
+        if (u < 0 || u >= w || v >= h)
+          continue;
+
+        int* e2 = &errors[3*(v*w+u)];
+        e2[0] += (r - rgba_getr(nearest)) * item.weight;
+        e2[1] += (g - rgba_getg(nearest)) * item.weight;
+        e2[2] += (b - rgba_getb(nearest)) * item.weight;
+      }
+    }
+}
+
+TEST(ErrorDiffusion, SameAsReference)
+{
+  std::shared_ptr<Palette> palette = Palette::create(16);
+  for (int i=0; i<16; ++i)
+    palette->setEntry(i, rgba(i*17, 255-i*17, (i*5*17) & 255, 255));
+
+  RgbMap rgbmap;
+  rgbmap.regenerate(palette.get(), 0);
+
+  const ErrorDiffusionMatrix* matrices[] = {
+    &ErrorDiffusionMatrix::floydSteinberg(),
+    &ErrorDiffusionMatrix::jarvisJudiceNinke(),
+    &ErrorDiffusionMatrix::atkinson()
+  };
+
+  // Widths with and without a last partial group of pixels
+  const gfx::Size sizes[] = { gfx::Size(301, 157), gfx::Size(256, 90) };
+
+  std::srand(1);
+  for (const gfx::Size& size : sizes) {
+    for (const ErrorDiffusionMatrix* matrix : matrices) {
+      std::unique_ptr<Image> src(Image::create(IMAGE_RGB, size.w, size.h));
+      for (int y=0; y<src->height(); ++y)
+        for (int x=0; x<src->width(); ++x)
+          src->putPixel(x, y, rgba(x & 255, y, std::rand() & 255,
+                                   (std::rand() % 10) ? 255: 0));
+
+      std::unique_ptr<Image> expected(Image::create(IMAGE_INDEXED, src->width(), src->height()));
+      std::unique_ptr<Image> result(Image::create(IMAGE_INDEXED, src->width(), src->height()));
+
+      reference_dither(*matrix, src.get(), expected.get(), &rgbmap, palette.get(), 0);
+
+      ErrorDiffusionDither dither(*matrix, 0);
+      dither.ditherRgbImageToIndexed(src.get(), result.get(), &rgbmap, palette.get());
+
+      for (int y=0; y<src->height(); ++y)
+        for (int x=0; x<src->width(); ++x)
+          ASSERT_EQ(expected->getPixel(x, y), result->getPixel(x, y))
+            << "(" << x << ", " << y << ")";
+    }
+  }
+}
+
+TEST(ErrorDiffusion, KeepsAverageIntensity)
+{
+  std::shared_ptr<Palette> palette = Palette::create(2);
+  palette->setEntry(0, rgba(0, 0, 0, 255));
+  palette->setEntry(1, rgba(255, 255, 255, 255));
+
+  RgbMap rgbmap;
+  rgbmap.regenerate(palette.get(), -1);
+
+  const int levels[] = { 32, 64, 128, 192 };
+  for (int level : levels) {
+    std::unique_ptr<Image> src(Image::create(IMAGE_RGB, 64, 64));
+    std::unique_ptr<Image> dst(Image::create(IMAGE_INDEXED, 64, 64));
+    src->clear(rgba(level, level, level, 255));
+
+    ErrorDiffusionDither dither(ErrorDiffusionMatrix::floydSteinberg());
+    dither.ditherRgbImageToIndexed(src.get(), dst.get(), &rgbmap, palette.get());
+
+    int white = 0;
+    for (int y=0; y<64; ++y)
+      for (int x=0; x<64; ++x)
+        white += dst->getPixel(x, y);
+
+    EXPECT_NEAR(level * 64 * 64 / 255, white, 64) << "level " << level;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
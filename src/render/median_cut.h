@@ -10,19 +10,89 @@
 
 #include <list>
 #include <queue>
+#include <vector>
 
 namespace render {
 
+  // Cumulative (summed-area) table of a 4D histogram: each entry
+  // contains the number of points of all histogram entries with
+  // lesser or equal r, g, b, and a components. It's used to count the
+  // points inside any box in constant time.
   template<class Histogram>
-  class Box {
+  class HistogramSums {
+  public:
+    explicit HistogramSums(const Histogram& histogram)
+      : m_sums(std::size_t(Histogram::RElements) *
+               Histogram::GElements *
+               Histogram::BElements *
+               Histogram::AElements) {
+      std::size_t i = 0;
+      for (int a=0; a<Histogram::AElements; ++a)
+        for (int b=0; b<Histogram::BElements; ++b)
+          for (int g=0; g<Histogram::GElements; ++g)
+            for (int r=0; r<Histogram::RElements; ++r, ++i)
+              m_sums[i] = histogram.at(r, g, b, a);
+
+      // Accumulate along each axis (the inner loop goes through
+      // contiguous entries, so it can be vectorized)
+      const int sizes[4] = {
+        Histogram::RElements,
+        Histogram::GElements,
+        Histogram::BElements,
+        Histogram::AElements
+      };
+      std::size_t stride = 1;
+      for (int axis=0; axis<4; ++axis) {
+        const std::size_t block = stride * sizes[axis];
+        for (std::size_t base=0; base<m_sums.size(); base+=block) {
+          std::size_t* prev = &m_sums[base];
+          for (int k=1; k<sizes[axis]; ++k, prev+=stride) {
+            std::size_t* cur = prev + stride;
+            for (std::size_t j=0; j<stride; ++j)
+              cur[j] += prev[j];
+          }
+        }
+        stride = block;
+      }
+    }
+
+    // Returns the number of points inside the given box (both corners
+    // are included).
+    std::size_t count(int r1, int g1, int b1, int a1,
+                      int r2, int g2, int b2, int a2) const {
+      // Inclusion-exclusion of the 16 corners (unsigned arithmetic
+      // wraps around, so the intermediate sums can overflow).
+      std::size_t total = 0;
+      for (int corner=0; corner<16; ++corner) {
+        const int r = (corner & 1 ? r1-1: r2);
+        const int g = (corner & 2 ? g1-1: g2);
+        const int b = (corner & 4 ? b1-1: b2);
+        const int a = (corner & 8 ? a1-1: a2);
+        if (r < 0 || g < 0 || b < 0 || a < 0)
+          continue;
+
+        const std::size_t sum = at(r, g, b, a);
+        if (((corner & 1) + ((corner >> 1) & 1) + ((corner >> 2) & 1) + ((corner >> 3) & 1)) & 1)
+          total -= sum;
+        else
+          total += sum;
+      }
+      return total;
+    }
 
-    // These classes are used as parameters for some Box's generic
-    // member functions, so we can access to a different axis using
-    // the same generic function (i=Red channel in RAxisGetter, etc.).
-    struct RAxisGetter { static std::size_t at(const Histogram& h, int i, int j, int k, int l) { return h.at(i, j, k, l); } };
-    struct GAxisGetter { static std::size_t at(const Histogram& h, int i, int j, int k, int l) { return h.at(j, i, k, l); } };
-    struct BAxisGetter { static std::size_t at(const Histogram& h, int i, int j, int k, int l) { return h.at(j, k, i, l); } };
-    struct AAxisGetter { static std::size_t at(const Histogram& h, int i, int j, int k, int l) { return h.at(j, k, l, i); } };
+  private:
+    std::size_t at(int r, int g, int b, int a) const {
+      return m_sums[
+        ((std::size_t(a) * Histogram::BElements + b) * Histogram::GElements + g)
+        * Histogram::RElements + r];
+    }
+
+    std::vector<std::size_t> m_sums;
+  };
+
+  template<class Histogram>
+  class Box {
+    typedef HistogramSums<Histogram> Sums;
 
     // These classes are used as template parameter to split a Box
     // along an axis (see splitAlongAxis)
@@ -54,45 +124,47 @@ namespace render {
 
     // Shrinks each plane of the box to a position where there are
     // points in the histogram.
-    void shrink(const Histogram& histogram) {
-      axisShrink<RAxisGetter>(histogram, r1, r2, g1, g2, b1, b2, a1, a2);
-      axisShrink<GAxisGetter>(histogram, g1, g2, r1, r2, b1, b2, a1, a2);
-      axisShrink<BAxisGetter>(histogram, b1, b2, r1, r2, g1, g2, a1, a2);
-      axisShrink<AAxisGetter>(histogram, a1, a2, r1, r2, g1, g2, b1, b2);
+    void shrink(const Sums& sums) {
+      axisShrink<RAxisSplitter>(sums, r1, r2);
+      axisShrink<GAxisSplitter>(sums, g1, g2);
+      axisShrink<BAxisSplitter>(sums, b1, b2);
+      axisShrink<AAxisSplitter>(sums, a1, a2);
 
       // Calculate number of points inside the box (this is done by
       // first time here, because the Box ctor didn't calculate it).
-      points = countPoints(histogram);
+      points = countPoints(sums);
 
       // Recalculate the volume (used in operator<).
       volume = calculateVolume();
     }
 
-    bool split(const Histogram& histogram, std::priority_queue<Box>& boxes) const {
+    bool split(const Sums& sums, std::priority_queue<Box>& boxes) const {
       // Split along the largest dimension of the box.
       if ((r2-r1) >= (g2-g1) &&
           (r2-r1) >= (b2-b1) &&
           (r2-r1) >= (a2-a1)) {
-        return splitAlongAxis<RAxisGetter, RAxisSplitter>(histogram, boxes, r1, r2, g1, g2, b1, b2, a1, a2);
+        return splitAlongAxis<RAxisSplitter>(sums, boxes, r1, r2);
       }
 
       if ((g2-g1) >= (r2-r1) &&
           (g2-g1) >= (b2-b1) &&
           (g2-g1) >= (a2-a1)) {
-        return splitAlongAxis<GAxisGetter, GAxisSplitter>(histogram, boxes, g1, g2, r1, r2, b1, b2, a1, a2);
+        return splitAlongAxis<GAxisSplitter>(sums, boxes, g1, g2);
       }
 
       if ((b2-b1) >= (r2-r1) &&
           (b2-b1) >= (g2-g1) &&
           (b2-b1) >= (a2-a1)) {
-        return splitAlongAxis<BAxisGetter, BAxisSplitter>(histogram, boxes, b1, b2, r1, r2, g1, g2, a1, a2);
+        return splitAlongAxis<BAxisSplitter>(sums, boxes, b1, b2);
       }
 
-      return splitAlongAxis<AAxisGetter, AAxisSplitter>(histogram, boxes, a1, a2, r1, r2, g1, g2, b1, b2);
+      return splitAlongAxis<AAxisSplitter>(sums, boxes, a1, a2);
     }
 
     // Returns the color enclosed by the box calculating the mean of
-    // all histogram's points inside the box.
+    // all histogram's points inside the box. (It's called once for
+    // each resulting box, and as they don't overlap, all calls visit
+    // each histogram entry at most one time.)
     uint32_t meanColor(const Histogram& histogram) const {
       std::size_t r = 0, g = 0, b = 0, a = 0;
       std::size_t count = 0;
@@ -146,119 +218,85 @@ namespace render {
     }
 
     // Returns the number of histogram's points inside the box bounds.
-    std::size_t countPoints(const Histogram& histogram) const {
-      std::size_t count = 0;
-      int i, j, k, l;
-
-      for (i=r1; i<=r2; ++i)
-        for (j=g1; j<=g2; ++j)
-          for (k=b1; k<=b2; ++k)
-            for (l=a1; l<=a2; ++l)
-              count += histogram.at(i, j, k, l);
+    std::size_t countPoints(const Sums& sums) const {
+      return sums.count(r1, g1, b1, a1, r2, g2, b2, a2);
+    }
 
-      return count;
+    // Returns the number of points in the "i" plane of the box along
+    // the axis of the given AxisSplitter.
+    template<class AxisSplitter>
+    std::size_t planePoints(const Sums& sums, int i) const {
+      return AxisSplitter::box2(AxisSplitter::box1(*this, i), i).countPoints(sums);
     }
 
     // Reduces the specified side of the box (i1/i2) along the
-    // specified axis (if AxisGetter is RAxisGetter, then i1=r1,
-    // i2=r2; if AxisGetter is GAxisGetter, then i1=g1, i2=g2).
-    template<class AxisGetter>
-    static void axisShrink(const Histogram& histogram,
-                           int& i1, int& i2,
-                           const int& j1, const int& j2,
-                           const int& k1, const int& k2,
-                           const int& l1, const int& l2)
-    {
-      int j, k, l;
-
-      // Shrink i1.
-      for (; i1<i2; ++i1) {
-        for (j=j1; j<=j2; ++j) {
-          for (k=k1; k<=k2; ++k) {
-            for (l=l1; l<=l2; ++l) {
-              if (AxisGetter::at(histogram, i1, j, k, l) > 0)
-                goto doneA;
-            }
-          }
-        }
-      }
-
-    doneA:;
-
-      for (; i2>i1; --i2) {
-        for (j=j1; j<=j2; ++j) {
-          for (k=k1; k<=k2; ++k) {
-            for (l=l1; l<=l2; ++l) {
-              if (AxisGetter::at(histogram, i2, j, k, l) > 0)
-                goto doneB;
-            }
-          }
-        }
-      }
-
-    doneB:;
+    // specified axis (if AxisSplitter is RAxisSplitter, then i1=r1,
+    // i2=r2; if AxisSplitter is GAxisSplitter, then i1=g1, i2=g2).
+    template<class AxisSplitter>
+    void axisShrink(const Sums& sums, int& i1, int& i2) const {
+      while (i1 < i2 && planePoints<AxisSplitter>(sums, i1) == 0)
+        ++i1;
+      while (i2 > i1 && planePoints<AxisSplitter>(sums, i2) == 0)
+        --i2;
     }
 
     // Splits the box in two sub-boxes (if it's possible) along the
-    // specified axis by AxisGetter template parameter and "i1/i2"
+    // specified axis by AxisSplitter template parameter and "i1/i2"
     // arguments. Returns true if the split was done and the "boxes"
     // queue contains the new two sub-boxes resulting from the split
     // operation.
-    template<class AxisGetter, class AxisSplitter>
-    bool splitAlongAxis(const Histogram& histogram,
+    template<class AxisSplitter>
+    bool splitAlongAxis(const Sums& sums,
                         std::priority_queue<Box>& boxes,
-                        const int& i1, const int& i2,
-                        const int& j1, const int& j2,
-                        const int& k1, const int& k2,
-                        const int& l1, const int& l2) const {
-      // These two variables will be used to count how many points are
-      // in each side of the box if we split it in "i" position.
-      std::size_t totalPoints1 = 0;
-      std::size_t totalPoints2 = this->points;
-      int i, j, k, l;
+                        const int& i1, const int& i2) const {
+      // Number of points in the box1 side if we split it in "i"
+      // position (it grows with "i").
+      auto points1 = [&](int i) -> std::size_t {
+        return (i < i1 ? 0: AxisSplitter::box1(*this, i).countPoints(sums));
+      };
 
       // We will try to split the box along the "i" axis. Imagine a
-      // plane which its normal vector is "i" axis, so we will try to
-      // move this plane from "i1" to "i2" to find the median, where
-      // the number of points in both sides of the plane are
-      // approximated the same.
-      for (i=i1; i<=i2; ++i) {
-        std::size_t planePoints = 0;
-
-        // We count all points in "i" plane.
-        for (j=j1; j<=j2; ++j)
-          for (k=k1; k<=k2; ++k)
-            for (l=l1; l<=l2; ++l)
-              planePoints += AxisGetter::at(histogram, i, j, k, l);
-
-        // As we move the plane to split through "i" axis One side is getting more points,
-        totalPoints1 += planePoints;
-        totalPoints2 -= planePoints;
-
-        if (totalPoints1 > totalPoints2) {
-          if (totalPoints2 > 0) {
-            Box box1(AxisSplitter::box1(*this, i));
-            Box box2(AxisSplitter::box2(*this, i+1));
-            box1.points = totalPoints1;
-            box2.points = totalPoints2;
-            boxes.push(box1);
-            boxes.push(box2);
-            return true;
-          }
-          else if (totalPoints1-planePoints > 0) {
-            Box box1(AxisSplitter::box1(*this, i-1));
-            Box box2(AxisSplitter::box2(*this, i));
-            box1.points = totalPoints1-planePoints;
-            box2.points = totalPoints2+planePoints;
-            boxes.push(box1);
-            boxes.push(box2);
-            return true;
-          }
-          else
-            return false;
-        }
+      // plane which its normal vector is "i" axis, so we will move
+      // this plane from "i1" to "i2" to find the median, the first
+      // position where the box1 side has more points than the box2
+      // side (a binary search, as both sides are monotonic).
+      int lo = i1, hi = i2+1;
+      while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const std::size_t p1 = points1(mid);
+        if (p1 > this->points - p1)
+          hi = mid;
+        else
+          lo = mid+1;
+      }
+      if (lo > i2)
+        return false;
+
+      const int i = lo;
+      const std::size_t totalPoints1 = points1(i);
+      const std::size_t totalPoints2 = this->points - totalPoints1;
+      const std::size_t planePoints = totalPoints1 - points1(i-1);
+
+      if (totalPoints2 > 0) {
+        Box box1(AxisSplitter::box1(*this, i));
+        Box box2(AxisSplitter::box2(*this, i+1));
+        box1.points = totalPoints1;
+        box2.points = totalPoints2;
+        boxes.push(box1);
+        boxes.push(box2);
+        return true;
       }
-      return false;
+      else if (totalPoints1-planePoints > 0) {
+        Box box1(AxisSplitter::box1(*this, i-1));
+        Box box2(AxisSplitter::box2(*this, i));
+        box1.points = totalPoints1-planePoints;
+        box2.points = totalPoints2+planePoints;
+        boxes.push(box1);
+        boxes.push(box2);
+        return true;
+      }
+      else
+        return false;
     }
 
     int r1, g1, b1, a1;         // Min point (closest to origin)
@@ -275,6 +313,9 @@ namespace render {
     // We need a priority queue to split bigger boxes first (see Box::operator<).
     std::priority_queue<Box<Histogram> > boxes;
 
+    // Summed table to count the points of each box in constant time.
+    const HistogramSums<Histogram> sums(histogram);
+
     // First we start with one big box containing all histogram's samples.
     boxes.push(Box<Histogram>(0, 0, 0, 0,
                               Histogram::RElements-1,
@@ -291,10 +332,10 @@ namespace render {
 
       // Shrink the box to the minimum, to enclose the same points in
       // the histogram.
-      box.shrink(histogram);
+      box.shrink(sums);
 
       // Try to split the box along the largest axis.
-      if (!box.split(histogram, boxes)) {
+      if (!box.split(sums, boxes)) {
         // If we were not able to split the box (maybe because it is
         // too small or there are not enough points to split it), then
         // we add the box's color to the "result" vector directly (the
@@ -12,6 +12,7 @@
 #include "render/quantization.h"
 
 #include "base/base.h"
+#include "base/parallel_for.h"
 #include "doc/image_impl.h"
 #include "doc/images_collector.h"
 #include "doc/layer.h"
@@ -20,14 +21,15 @@
 #include "doc/remap.h"
 #include "doc/rgbmap.h"
 #include "doc/sprite.h"
-#include "gfx/hsv.h"
-#include "gfx/rgb.h"
+#include "render/error_diffusion.h"
 #include "render/ordered_dither.h"
 #include "render/render.h"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace render {
@@ -35,6 +37,10 @@ namespace render {
 using namespace doc;
 using namespace gfx;
 
+// Maximum number of frames histogrammed at the same time (each one
+// needs its own histogram)
+static const int kMaxQuantizationThreads = 4;
+
 std::shared_ptr<Palette> create_palette_from_sprite(
   const Sprite* sprite,
   frame_t fromFrame,
@@ -43,8 +49,6 @@ std::shared_ptr<Palette> create_palette_from_sprite(
   Palette* oldPalette,
   PaletteOptimizerDelegate* delegate)
 {
-  PaletteOptimizer optimizer;
-
   std::shared_ptr<Palette> palette;
 
   if (oldPalette) {
@@ -54,22 +58,55 @@ std::shared_ptr<Palette> create_palette_from_sprite(
     palette->setFrame(fromFrame);
   }
 
-  // Add a flat image with the current sprite's frame rendered
-  std::shared_ptr<Image> flat_image {Image::create(IMAGE_RGB, sprite->width(), sprite->height())};
+  // Frames are rendered and histogrammed in parallel in groups of
+  // consecutive frames, each group with its own flat image and
+  // optimizer. Each optimizer uses a big histogram, so the number of
+  // groups is limited.
+  const int frames = toFrame - fromFrame + 1;
+  const int groups = std::max(1, std::min({ frames, base::parallel_for_threads(), kMaxQuantizationThreads }));
+  const int framesPerGroup = (frames + groups - 1) / groups;
+  std::vector<std::unique_ptr<PaletteOptimizer>> optimizers(groups);
+
+  std::mutex delegateMutex;
+  std::atomic<bool> canceled(false);
+  int renderedFrames = 0;
+
+  base::parallel_for(
+    0, groups, 1,
+    [&](int group, int) {
+      optimizers[group].reset(new PaletteOptimizer);
+
+      std::unique_ptr<Image> flat_image(Image::create(IMAGE_RGB, sprite->width(), sprite->height()));
+      render::Render render;
+
+      const frame_t groupFrom = fromFrame + group*framesPerGroup;
+      const frame_t groupTo = std::min<frame_t>(groupFrom + framesPerGroup - 1, toFrame);
+      for (frame_t frame=groupFrom; frame<=groupTo && !canceled; ++frame) {
+        render.renderSprite(flat_image.get(), sprite, frame);
+        optimizers[group]->feedWithImage(flat_image.get(), withAlpha);
+
+        if (delegate) {
+          std::lock_guard<std::mutex> lock(delegateMutex);
+          if (!delegate->onPaletteOptimizerContinue()) {
+            canceled = true;
+            break;
+          }
 
-  // Feed the optimizer with all rendered frames
-  render::Render render;
-  for (frame_t frame=fromFrame; frame<=toFrame; ++frame) {
-    render.renderSprite(flat_image.get(), sprite, frame);
-    optimizer.feedWithImage(flat_image.get(), withAlpha);
+          delegate->onPaletteOptimizerProgress(
+            double(++renderedFrames) / double(frames));
+        }
+      }
+    });
 
-    if (delegate) {
-      if (!delegate->onPaletteOptimizerContinue())
-        return nullptr;
+  if (canceled)
+    return nullptr;
 
-      delegate->onPaletteOptimizerProgress(
-        double(frame-fromFrame+1) / double(toFrame-fromFrame+1));
-    }
+  // Merge the histograms in frames order (so the result is the same
+  // as feeding all frames with one optimizer)
+  PaletteOptimizer& optimizer = *optimizers[0];
+  for (int group=1; group<groups; ++group) {
+    optimizer.merge(*optimizers[group]);
+    optimizers[group].reset();
   }
 
   // Generate an optimized palette
@@ -83,6 +120,36 @@ std::shared_ptr<Palette> create_palette_from_sprite(
   return palette;
 }
 
+// Rows converted by each thread in convert_pixel_format()
+static const int kConvertRows = 16;
+
+// Converts each pixel of "src" to the same pixel of "dst" with
+// func(pixel, x, y), processing bands of rows in parallel. As func()
+// is inlined, simple conversions are vectorized by the compiler.
+template<typename SrcTraits, typename DstTraits, typename Func>
+static void convert_pixels(const Image* src, Image* dst, const Func& func)
+{
+  const int w = src->width();
+  base::parallel_for(
+    0, src->height(), kConvertRows,
+    [&](int y1, int y2) {
+      for (int y=y1; y<y2; ++y) {
+        auto srcPtr = (typename SrcTraits::const_address_t)src->getPixelAddress(0, y);
+        auto dstPtr = (typename DstTraits::address_t)dst->getPixelAddress(0, y);
+        for (int x=0; x<w; ++x)
+          dstPtr[x] = func(srcPtr[x], x, y);
+      }
+    });
+}
+
+// Same value as 255 * Hsv(Rgb(r, g, b)).valueInt() / 100 using only
+// integer operations.
+static inline int rgb_value(int r, int g, int b)
+{
+  const int v = std::max(r, std::max(g, b));
+  return 255 * ((200*v + 255) / 510) / 100;
+}
+
 Image* convert_pixel_format(
   const Image* image,
   Image* new_image,
@@ -103,19 +170,29 @@ Image* convert_pixel_format(
       ditheringMethod == DitheringMethod::ORDERED) {
     BayerMatrix<8> matrix;
     OrderedDither dither;
-    dither.ditherRgbImageToIndexed(matrix, image, new_image, 0, 0, rgbmap, palette);
+    convert_pixels<RgbTraits, IndexedTraits>(
+      image, new_image,
+      [&](color_t c, int x, int y) {
+        return dither.ditherRgbPixelToIndex(matrix, c, x, y, rgbmap, palette);
+      });
     return new_image;
   }
 
-  color_t c;
-  int r, g, b, a;
+  // RGB -> Indexed with error diffusion
+  if (image->pixelFormat() == IMAGE_RGB &&
+      pixelFormat == IMAGE_INDEXED) {
+    if (const ErrorDiffusionMatrix* matrix = ErrorDiffusionMatrix::fromMethod(ditheringMethod)) {
+      ErrorDiffusionDither dither(*matrix, new_mask_color);
+      dither.ditherRgbImageToIndexed(image, new_image, rgbmap, palette);
+      return new_image;
+    }
+  }
+
+  const color_t maskColor = image->maskColor();
 
   switch (image->pixelFormat()) {
 
     case IMAGE_RGB: {
-      const LockImageBits<RgbTraits> srcBits(image);
-      LockImageBits<RgbTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-
       switch (new_image->pixelFormat()) {
 
         // RGB -> RGB
@@ -124,81 +201,43 @@ Image* convert_pixel_format(
           break;
 
         // RGB -> Grayscale
-        case IMAGE_GRAYSCALE: {
-          LockImageBits<GrayscaleTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<GrayscaleTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<GrayscaleTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-
-            g = 255 * Hsv(Rgb(rgba_getr(c),
-                              rgba_getg(c),
-                              rgba_getb(c))).valueInt() / 100;
-
-            *dst_it = graya(g, rgba_geta(c));
-          }
-          ASSERT(dst_it == dst_end);
+        case IMAGE_GRAYSCALE:
+          convert_pixels<RgbTraits, GrayscaleTraits>(
+            image, new_image,
+            [](color_t c, int, int) -> uint16_t {
+              return graya(rgb_value(rgba_getr(c), rgba_getg(c), rgba_getb(c)),
+                           rgba_geta(c));
+            });
           break;
-        }
 
         // RGB -> Indexed
-        case IMAGE_INDEXED: {
-          LockImageBits<IndexedTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<IndexedTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<IndexedTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-
-            r = rgba_getr(c);
-            g = rgba_getg(c);
-            b = rgba_getb(c);
-            a = rgba_geta(c);
-
-            if (a == 0)
-              *dst_it = new_mask_color;
-            else
-              *dst_it = rgbmap->mapColor(r, g, b, a);
-          }
-          ASSERT(dst_it == dst_end);
+        case IMAGE_INDEXED:
+          convert_pixels<RgbTraits, IndexedTraits>(
+            image, new_image,
+            [&](color_t c, int, int) -> uint8_t {
+              const int a = rgba_geta(c);
+              if (a == 0)
+                return new_mask_color;
+              else
+                return rgbmap->mapColor(rgba_getr(c), rgba_getg(c), rgba_getb(c), a);
+            });
           break;
-        }
       }
       break;
     }
 
     case IMAGE_GRAYSCALE: {
-      const LockImageBits<GrayscaleTraits> srcBits(image);
-      LockImageBits<GrayscaleTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-
       switch (new_image->pixelFormat()) {
 
         // Grayscale -> RGB
-        case IMAGE_RGB: {
-          LockImageBits<RgbTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<RgbTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<RgbTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-
-            g = graya_getv(c);
-
-            *dst_it = rgba(g, g, g, graya_geta(c));
-          }
-          ASSERT(dst_it == dst_end);
+        case IMAGE_RGB:
+          convert_pixels<GrayscaleTraits, RgbTraits>(
+            image, new_image,
+            [](color_t c, int, int) -> uint32_t {
+              const int g = graya_getv(c);
+              return rgba(g, g, g, graya_geta(c));
+            });
           break;
-        }
 
         // Grayscale -> Grayscale
         case IMAGE_GRAYSCALE:
@@ -206,113 +245,63 @@ Image* convert_pixel_format(
           break;
 
         // Grayscale -> Indexed
-        case IMAGE_INDEXED: {
-          LockImageBits<IndexedTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<IndexedTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<IndexedTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-            a = graya_geta(c);
-            c = graya_getv(c);
-
-            if (a == 0)
-              *dst_it = new_mask_color;
-            else
-              *dst_it = rgbmap->mapColor(c, c, c, a);
-          }
-          ASSERT(dst_it == dst_end);
+        case IMAGE_INDEXED:
+          convert_pixels<GrayscaleTraits, IndexedTraits>(
+            image, new_image,
+            [&](color_t c, int, int) -> uint8_t {
+              const int a = graya_geta(c);
+              const int v = graya_getv(c);
+              if (a == 0)
+                return new_mask_color;
+              else
+                return rgbmap->mapColor(v, v, v, a);
+            });
           break;
-        }
       }
       break;
     }
 
     case IMAGE_INDEXED: {
-      const LockImageBits<IndexedTraits> srcBits(image);
-      LockImageBits<IndexedTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-
       switch (new_image->pixelFormat()) {
 
         // Indexed -> RGB
-        case IMAGE_RGB: {
-          LockImageBits<RgbTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<RgbTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<RgbTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-
-            if (!is_background && c == image->maskColor())
-              *dst_it = rgba(0, 0, 0, 0);
-            else
-              *dst_it = palette->getEntry(c);
-          }
-          ASSERT(dst_it == dst_end);
+        case IMAGE_RGB:
+          convert_pixels<IndexedTraits, RgbTraits>(
+            image, new_image,
+            [&](color_t c, int, int) -> uint32_t {
+              if (!is_background && c == maskColor)
+                return rgba(0, 0, 0, 0);
+              else
+                return palette->getEntry(c);
+            });
           break;
-        }
 
         // Indexed -> Grayscale
-        case IMAGE_GRAYSCALE: {
-          LockImageBits<GrayscaleTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<GrayscaleTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<GrayscaleTraits>::iterator dst_end = dstBits.end();
-#endif
-
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
+        case IMAGE_GRAYSCALE:
+          convert_pixels<IndexedTraits, GrayscaleTraits>(
+            image, new_image,
+            [&](color_t c, int, int) -> uint16_t {
+              if (!is_background && c == maskColor)
+                return graya(0, 0);
 
-            if (!is_background && c == image->maskColor())
-              *dst_it = graya(0, 0);
-            else {
               c = palette->getEntry(c);
-              r = rgba_getr(c);
-              g = rgba_getg(c);
-              b = rgba_getb(c);
-              a = rgba_geta(c);
-
-              g = 255 * Hsv(Rgb(r, g, b)).valueInt() / 100;
-              *dst_it = graya(g, a);
-            }
-          }
-          ASSERT(dst_it == dst_end);
+              return graya(rgb_value(rgba_getr(c), rgba_getg(c), rgba_getb(c)),
+                           rgba_geta(c));
+            });
           break;
-        }
 
         // Indexed -> Indexed
-        case IMAGE_INDEXED: {
-          LockImageBits<IndexedTraits> dstBits(new_image, Image::WriteLock);
-          LockImageBits<IndexedTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-          LockImageBits<IndexedTraits>::iterator dst_end = dstBits.end();
-#endif
+        case IMAGE_INDEXED:
+          convert_pixels<IndexedTraits, IndexedTraits>(
+            image, new_image,
+            [&](color_t c, int, int) -> uint8_t {
+              if (!is_background && c == maskColor)
+                return new_mask_color;
 
-          for (; src_it != src_end; ++src_it, ++dst_it) {
-            ASSERT(dst_it != dst_end);
-            c = *src_it;
-
-            if (!is_background && c == image->maskColor())
-              *dst_it = new_mask_color;
-            else {
               c = palette->getEntry(c);
-              r = rgba_getr(c);
-              g = rgba_getg(c);
-              b = rgba_getb(c);
-              a = rgba_geta(c);
-              *dst_it = rgbmap->mapColor(r, g, b, a);
-            }
-          }
-          ASSERT(dst_it == dst_end);
+              return rgbmap->mapColor(rgba_getr(c), rgba_getg(c), rgba_getb(c), rgba_geta(c));
+            });
           break;
-        }
 
       }
       break;
@@ -383,6 +372,11 @@ void PaletteOptimizer::feedWithRgbaColor(color_t color)
   m_histogram.addSamples(color, 1);
 }
 
+void PaletteOptimizer::merge(const PaletteOptimizer& other)
+{
+  m_histogram.merge(other.m_histogram);
+}
+
 void PaletteOptimizer::calculate(Palette& palette, int maskIndex,
                                  PaletteOptimizerDelegate* delegate)
 {
@@ -35,6 +35,8 @@ namespace render {
   public:
     void feedWithImage(Image* image, bool withAlpha);
     void feedWithRgbaColor(color_t color);
+    // Adds the samples of "other" optimizer after the samples of this one.
+    void merge(const PaletteOptimizer& other);
     void calculate(Palette& palette, int maskIndex, PaletteOptimizerDelegate* delegate);
 
   private:
@@ -19,6 +19,11 @@
 #include "gfx/clip.h"
 #include "gfx/region.h"
 
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
 namespace render {
 
 namespace {
@@ -433,8 +438,180 @@ CompositeImageFunc get_image_composition(PixelFormat dstFormat,
   return NULL;
 }
 
+// Merged onion skin frames that are kept in memory (in bytes)
+const std::size_t kOnionskinCacheSize = 128*1024*1024;
+
+void add_to_signature(uint64_t& signature, uint64_t value)
+{
+  // FNV-1a hash, one byte at a time
+  for (int i=0; i<8; ++i, value >>= 8) {
+    signature ^= (value & 0xff);
+    signature *= 0x100000001b3ull;
+  }
+}
+
+// Hashes all the things that are used to render the given layer in
+// the given frame (without reading pixels, the image versions are
+// used instead).
+void add_layer_signature(uint64_t& signature,
+                         const Layer* layer, frame_t frame,
+                         bool render_background)
+{
+  add_to_signature(signature, layer->id());
+  add_to_signature(signature, layer->isVisible());
+  if (!layer->isVisible())
+    return;
+
+  switch (layer->type()) {
+
+    case ObjectType::LayerImage: {
+      if (!render_background && layer->isBackground())
+        break;
+
+      const LayerImage* imgLayer = static_cast<const LayerImage*>(layer);
+      add_to_signature(signature, imgLayer->opacity());
+      add_to_signature(signature, int(imgLayer->blendMode()));
+
+      auto cel = layer->cel(frame);
+      if (cel) {
+        add_to_signature(signature, cel->id());
+        add_to_signature(signature, cel->x());
+        add_to_signature(signature, cel->y());
+        add_to_signature(signature, cel->opacity());
+        if (const Image* image = cel->image()) {
+          add_to_signature(signature, image->id());
+          add_to_signature(signature, image->version());
+        }
+      }
+      break;
+    }
+
+    case ObjectType::LayerFolder: {
+      LayerConstIterator it = static_cast<const LayerFolder*>(layer)->getLayerBegin();
+      LayerConstIterator end = static_cast<const LayerFolder*>(layer)->getLayerEnd();
+      for (; it != end; ++it)
+        add_layer_signature(signature, *it, frame, render_background);
+      break;
+    }
+  }
+}
+
 } // anonymous namespace
 
+// Onion skin frames merged in images with the pixel format of the
+// destination (without zoom). The least recently used ones are
+// deleted when the cache is full. There is only one cache for all
+// Render instances (see Render::onionskinCache()), so it can be
+// used from several threads at the same time.
+class Render::OnionskinCache {
+public:
+  struct Key {
+    const Sprite* sprite;
+    ObjectId spriteId;
+    frame_t frame;
+    const Layer* layer;
+    bool background;
+    int opacity;
+    BlendMode blendMode;
+    PixelFormat pixelFormat;
+    uint64_t signature;
+
+    bool operator==(const Key& other) const {
+      return (sprite == other.sprite &&
+              spriteId == other.spriteId &&
+              frame == other.frame &&
+              layer == other.layer &&
+              background == other.background &&
+              opacity == other.opacity &&
+              blendMode == other.blendMode &&
+              pixelFormat == other.pixelFormat &&
+              signature == other.signature);
+    }
+  };
+
+  OnionskinCache() : m_size(0) { }
+
+  std::shared_ptr<const Image> find(const Key& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it=m_entries.begin(); it!=m_entries.end(); ++it) {
+      if (it->key == key) {
+        m_entries.splice(m_entries.begin(), m_entries, it);
+        return m_entries.front().image;
+      }
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<const Image> add(const Key& key, Image* image) {
+    std::shared_ptr<const Image> ptr(image);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Old versions of this same frame are useless now
+    invalidateUnlocked([&key](const Key& other) {
+        return (other.sprite == key.sprite &&
+                other.frame == key.frame &&
+                other.layer == key.layer &&
+                other.background == key.background &&
+                other.opacity == key.opacity &&
+                other.blendMode == key.blendMode &&
+                other.pixelFormat == key.pixelFormat);
+      });
+
+    m_entries.push_front(Entry{ key, ptr });
+    m_size += imageSize(image);
+
+    // Images that are being drawn by other threads are kept alive by
+    // their shared_ptr.
+    while (m_size > kOnionskinCacheSize && m_entries.size() > 1) {
+      m_size -= imageSize(m_entries.back().image.get());
+      m_entries.pop_back();
+    }
+    return ptr;
+  }
+
+  template<typename Pred>
+  void invalidate(Pred pred) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    invalidateUnlocked(pred);
+  }
+
+private:
+  struct Entry {
+    Key key;
+    std::shared_ptr<const Image> image;
+  };
+
+  template<typename Pred>
+  void invalidateUnlocked(Pred pred) {
+    for (auto it=m_entries.begin(); it!=m_entries.end(); ) {
+      if (pred(it->key)) {
+        m_size -= imageSize(it->image.get());
+        it = m_entries.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+
+  static std::size_t imageSize(const Image* image) {
+    return std::size_t(image->getRowStrideSize()) * image->height();
+  }
+
+  std::mutex m_mutex;
+  // Most recently used entries first
+  std::list<Entry> m_entries;
+  std::size_t m_size;
+};
+
+// static
+Render::OnionskinCache& Render::onionskinCache()
+{
+  // Shared by all editors/previews so kOnionskinCacheSize is the
+  // limit for the whole program.
+  static OnionskinCache cache;
+  return cache;
+}
+
 Render::Render()
   : m_sprite(NULL)
   , m_currentLayer(NULL)
@@ -526,6 +703,22 @@ void Render::disableOnionskin()
   m_onionskin.type(OnionskinType::NONE);
 }
 
+void Render::invalidateOnionskinCache(const Sprite* sprite, frame_t frame)
+{
+  onionskinCache().invalidate(
+    [sprite, frame](const OnionskinCache::Key& key) {
+      return (key.sprite == sprite && key.frame == frame);
+    });
+}
+
+void Render::invalidateOnionskinCache(const Sprite* sprite)
+{
+  onionskinCache().invalidate(
+    [sprite](const OnionskinCache::Key& key) {
+      return (key.sprite == sprite);
+    });
+}
+
 void Render::renderSprite(
   Image* dstImage,
   const Sprite* sprite,
@@ -723,20 +916,96 @@ void Render::renderOnionskin(
         else if (m_onionskin.type() == OnionskinType::RED_BLUE_TINT)
           blendMode = (frameOut < frame ? BlendMode::RED_TINT: BlendMode::BLUE_TINT);
 
-        renderLayer(
-          onionLayer, dstImage,
-          area, frameIn, zoom, compositeImage,
-          // Render background only for "in-front" onion skinning and
-          // when opacity is < 255
+        // Render background only for "in-front" onion skinning and
+        // when opacity is < 255
+        const bool renderBackground =
           (m_globalOpacity < 255 &&
-           m_onionskin.position() == OnionskinPosition::INFRONT),
-          true,
-          blendMode);
+           m_onionskin.position() == OnionskinPosition::INFRONT);
+
+        if (!renderCachedOnionskin(
+              onionLayer, dstImage, area, frameIn, zoom,
+              renderBackground, blendMode)) {
+          renderLayer(
+            onionLayer, dstImage,
+            area, frameIn, zoom, compositeImage,
+            renderBackground,
+            true,
+            blendMode);
+        }
       }
     }
   }
 }
 
+// Draws the given onion skin frame from the cache (merging its
+// layers if it isn't there yet). Returns false if the frame cannot
+// be cached and must be rendered layer by layer.
+bool Render::renderCachedOnionskin(
+  const Layer* layer,
+  Image* dstImage,
+  const gfx::Clip& area,
+  frame_t frame, Zoom zoom,
+  bool render_background,
+  BlendMode blendMode)
+{
+  const PixelFormat pixelFormat = dstImage->pixelFormat();
+
+  // Indexed images cannot be merged with opacity, and the
+  // preview/extra images change all the time.
+  if (pixelFormat == IMAGE_INDEXED ||
+      (m_previewImage && m_selectedFrame == frame) ||
+      (m_extraImage && m_currentFrame == frame))
+    return false;
+
+  CompositeImageFunc compositeMerged =
+    get_image_composition(pixelFormat, pixelFormat, zoom);
+  CompositeImageFunc compositeLayers =
+    get_image_composition(pixelFormat, m_sprite->pixelFormat(), Zoom(1, 1));
+  if (!compositeMerged || !compositeLayers)
+    return false;
+
+  // The layers are merged in a transparent image with the same
+  // opacity/blend mode that renderLayer() would use to draw them in
+  // the destination, so the cached frame looks the same.
+  OnionskinCache::Key key;
+  key.sprite = m_sprite;
+  key.spriteId = m_sprite->id();
+  key.frame = frame;
+  key.layer = layer;
+  key.background = render_background;
+  key.opacity = m_globalOpacity;
+  key.blendMode = blendMode;
+  key.pixelFormat = pixelFormat;
+  key.signature = 0xcbf29ce484222325ull;
+  add_to_signature(key.signature, m_sprite->width());
+  add_to_signature(key.signature, m_sprite->height());
+  add_to_signature(key.signature, m_sprite->transparentColor());
+  if (const Palette* pal = m_sprite->palette(frame)) {
+    add_to_signature(key.signature, pal->id());
+    add_to_signature(key.signature, pal->getModifications());
+  }
+  add_layer_signature(key.signature, layer, frame, render_background);
+
+  OnionskinCache& cache = onionskinCache();
+  std::shared_ptr<const Image> merged = cache.find(key);
+  if (!merged) {
+    Image* image = Image::create(pixelFormat, m_sprite->width(), m_sprite->height());
+    clear_image(image, 0);
+
+    renderLayer(
+      layer, image, gfx::Clip(m_sprite->bounds()),
+      frame, Zoom(1, 1), compositeLayers,
+      render_background, true, blendMode);
+
+    merged = cache.add(key, image);
+  }
+
+  renderImage(
+    dstImage, merged.get(), m_sprite->palette(frame), 0, 0,
+    area, compositeMerged, 255, BlendMode::NORMAL, zoom);
+  return true;
+}
+
 void Render::renderBackground(Image* image,
   const gfx::Clip& area,
   Zoom zoom)
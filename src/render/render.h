@@ -101,6 +101,7 @@ namespace render {
     Render();
 
     // Background configuration
+    BgType bgType() const { return m_bgType; }
     void setBgType(BgType type);
     void setBgZoom(bool state);
     void setBgColor1(color_t color);
@@ -128,6 +129,14 @@ namespace render {
     void setOnionskin(const OnionskinOptions& options);
     void disableOnionskin();
 
+    // Onion skin frames are merged only once and kept in a cache
+    // (shared by all Render instances) while their cels/layers/images
+    // don't change (the version of each object is checked). Pixels
+    // modified without a new image version must be notified with
+    // these functions.
+    void invalidateOnionskinCache(const Sprite* sprite, frame_t frame);
+    void invalidateOnionskinCache(const Sprite* sprite);
+
     void renderSprite(
       Image* dstImage,
       const Sprite* sprite,
@@ -171,12 +180,23 @@ namespace render {
       int opacity, BlendMode blendMode);
 
   private:
+    class OnionskinCache;
+    static OnionskinCache& onionskinCache();
+
     void renderOnionskin(
       Image* image,
       const gfx::Clip& area,
       frame_t frame, Zoom zoom,
       CompositeImageFunc compositeImage);
 
+    bool renderCachedOnionskin(
+      const Layer* layer,
+      Image* image,
+      const gfx::Clip& area,
+      frame_t frame, Zoom zoom,
+      bool render_background,
+      BlendMode blendMode);
+
     void renderLayer(
       const Layer* layer,
       Image* image,
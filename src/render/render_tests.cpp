@@ -12,6 +12,7 @@
 
 #include "render/render.h"
 
+#include "doc/blend_internals.h"
 #include "doc/cel.h"
 #include "doc/context.h"
 #include "doc/document.h"
@@ -213,6 +214,148 @@ TEST(Render, ZoomAndDstBounds)
     0, 0, 0, 0);
 }
 
+TEST(Render, CachedOnionskin)
+{
+  Context ctx;
+  Document* doc = ctx.documents().add(2, 2, ColorMode::RGB);
+  Sprite* sprite = doc->sprite();
+  LayerImage* layer = static_cast<LayerImage*>(sprite->layer(0));
+  sprite->setTotalFrames(2);
+
+  const color_t red = rgba(255, 0, 0, 255);
+  const color_t green = rgba(0, 255, 0, 255);
+  const color_t blue = rgba(0, 0, 255, 255);
+
+  Image* prev = layer->cel(0)->image();
+  clear_image(prev, red);
+  ImageRef img(Image::create(IMAGE_RGB, 2, 2));
+  clear_image(img.get(), 0);
+  put_pixel(img.get(), 1, 1, blue);
+  layer->addCel(std::make_shared<Cel>(frame_t(1), img));
+
+  OnionskinOptions opts(OnionskinType::MERGE);
+  opts.prevFrames(1);
+  opts.opacityBase(255);
+  opts.opacityStep(0);
+
+  Render render;
+  render.setOnionskin(opts);
+
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, 2, 2));
+  render.renderSprite(dst.get(), sprite, frame_t(1));
+  EXPECT_2X2_PIXELS(dst.get(), red, red, red, blue);
+
+  // A new image version is detected
+  clear_image(prev, green);
+  prev->incrementVersion();
+  render.renderSprite(dst.get(), sprite, frame_t(1));
+  EXPECT_2X2_PIXELS(dst.get(), green, green, green, blue);
+
+  // Other changes must be notified
+  clear_image(prev, blue);
+  render.renderSprite(dst.get(), sprite, frame_t(1));
+  EXPECT_2X2_PIXELS(dst.get(), green, green, green, blue);
+
+  render.invalidateOnionskinCache(sprite, frame_t(0));
+  render.renderSprite(dst.get(), sprite, frame_t(1));
+  EXPECT_2X2_PIXELS(dst.get(), blue, blue, blue, blue);
+
+  // Layer properties are part of the cache key
+  layer->setVisible(false);
+  render.renderSprite(dst.get(), sprite, frame_t(1));
+  EXPECT_2X2_PIXELS(dst.get(), 0, 0, 0, 0);
+}
+
+// Onion skin frames with several layers must look the same when they
+// are merged in the cache as when each layer is drawn with the onion
+// skin opacity.
+TEST(Render, CachedOnionskinWithOverlappedLayers)
+{
+  Context ctx;
+  Document* doc = ctx.documents().add(4, 4, ColorMode::RGB);
+  Sprite* sprite = doc->sprite();
+  sprite->setTotalFrames(2);
+
+  LayerImage* layer1 = static_cast<LayerImage*>(sprite->layer(0));
+  LayerImage* layer2 = new LayerImage(sprite);
+  sprite->folder()->addLayer(layer2);
+  layer1->setOpacity(200);
+  layer2->setOpacity(220);
+
+  // Two semi-transparent cels in frame 0 that overlap in the two
+  // middle columns (frame 1 is empty)
+  auto cel1 = layer1->cel(0);
+  clear_image(cel1->image(), rgba(255, 64, 0, 160));
+  cel1->setPosition(-1, 0);
+
+  ImageRef img2(Image::create(IMAGE_RGB, 3, 4));
+  clear_image(img2.get(), rgba(0, 96, 255, 192));
+  auto cel2 = std::make_shared<Cel>(frame_t(0), img2);
+  cel2->setPosition(1, 0);
+  cel2->setOpacity(180);
+  layer2->addCel(cel2);
+
+  const int onionOpacity = 128;
+  const OnionskinType types[] = { OnionskinType::MERGE,
+                                  OnionskinType::RED_BLUE_TINT };
+  const BgType bgTypes[] = { BgType::TRANSPARENT, BgType::CHECKED };
+
+  for (OnionskinType type : types) {
+    for (BgType bgType : bgTypes) {
+      OnionskinOptions opts(type);
+      opts.prevFrames(1);
+      opts.opacityBase(onionOpacity);
+      opts.opacityStep(0);
+
+      Render render;
+      render.setBgType(bgType);
+      render.setBgColor1(rgba(255, 255, 255, 255));
+      render.setBgColor2(rgba(128, 128, 128, 255));
+      render.setBgCheckedSize(gfx::Size(1, 1));
+
+      // Expected result: each layer drawn with the onion skin opacity
+      std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, 4, 4));
+      render.renderSprite(expected.get(), sprite, frame_t(1));
+      const BlendMode blendMode =
+        (type == OnionskinType::MERGE ? BlendMode::NORMAL:
+                                        BlendMode::RED_TINT);
+      for (LayerImage* layer : { layer1, layer2 }) {
+        auto cel = layer->cel(0);
+        int t;
+        int opacity = MUL_UN8(cel->opacity(), layer->opacity(), t);
+        opacity = MUL_UN8(opacity, onionOpacity, t);
+        composite_image(expected.get(), cel->image(),
+                        sprite->palette(0), cel->x(), cel->y(),
+                        opacity, blendMode);
+      }
+
+      render.setOnionskin(opts);
+      render.invalidateOnionskinCache(sprite);
+
+      // The first time the frame is merged, the second time it comes
+      // from the cache.
+      for (int i=0; i<2; ++i) {
+        std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, 4, 4));
+        render.renderSprite(dst.get(), sprite, frame_t(1));
+
+        for (int y=0; y<4; ++y) {
+          for (int x=0; x<4; ++x) {
+            const color_t a = get_pixel(dst.get(), x, y);
+            const color_t b = get_pixel(expected.get(), x, y);
+            // The integer blending isn't associative, so there can
+            // be rounding differences over an opaque background.
+            const int tolerance = (bgType == BgType::TRANSPARENT ? 0: 1);
+            EXPECT_NEAR(int(rgba_getr(b)), int(rgba_getr(a)), tolerance) << x << "," << y;
+            EXPECT_NEAR(int(rgba_getg(b)), int(rgba_getg(a)), tolerance) << x << "," << y;
+            EXPECT_NEAR(int(rgba_getb(b)), int(rgba_getb(a)), tolerance) << x << "," << y;
+            EXPECT_NEAR(int(rgba_geta(b)), int(rgba_geta(a)), tolerance) << x << "," << y;
+          }
+        }
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
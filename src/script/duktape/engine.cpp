@@ -8,8 +8,15 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 
@@ -21,6 +28,7 @@
 #include "base/memory.h"
 #include "script/engine.h"
 #include "script/engine_delegate.h"
+#include "script/profiler.h"
 
 namespace {
   void on_fatal_handler(void* ctx, const char* msg) {
@@ -133,10 +141,33 @@ public:
   }
 
   bool eval(const std::string& code) override {
+    return run([&]{
+      return duk_peval_string(m_handle, code.c_str());
+    });
+  }
+
+  bool evalFile(const std::string& fileName,
+                const std::string& cacheFile,
+                const std::string& cacheKey) override {
+    return run([&]{
+      duk_int_t rc = 0;
+      if (!loadBytecode(cacheFile, cacheKey))
+        rc = compileFile(fileName, cacheFile, cacheKey);
+      if (rc == 0)
+        rc = duk_pcall(m_handle, 0);
+      return rc;
+    });
+  }
+
+private:
+  // Calls "func" to evaluate code, it must leave the result (or the
+  // error) on the stack.
+  template<typename Func>
+  bool run(Func&& func) {
     bool success = true;
     try {
       initGlobals();
-      if (duk_peval_string(m_handle, code.c_str()) != 0) {
+      if (func() != 0) {
         printLastResult();
         std::cout << "Error: [" << duk_safe_to_string(m_handle, -1) << "]" << std::endl;
         success = false;
@@ -158,6 +189,117 @@ public:
     execAfterEval(success);
     return success;
   }
+
+  // Compiles the file and pushes the compiled function, or pushes the
+  // error and returns non-zero. The bytecode is saved in the cache.
+  duk_int_t compileFile(const std::string& fileName,
+                        const std::string& cacheFile,
+                        const std::string& cacheKey) {
+    std::ifstream ifs(fileName, std::ifstream::binary);
+    if (!ifs) {
+      duk_push_string(m_handle, ("Could not open " + fileName).c_str());
+      return DUK_EXEC_ERROR;
+    }
+    std::string code{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+
+    duk_push_string(m_handle, fileName.c_str());
+    duk_int_t rc = duk_pcompile_lstring_filename(m_handle, 0, code.c_str(), code.size());
+    if (rc != 0)
+      return rc;
+
+#if defined(DUK_USE_BYTECODE_DUMP_SUPPORT)
+    if (!cacheFile.empty()) {
+      duk_dup_top(m_handle);
+      duk_dump_function(m_handle);
+      duk_size_t size = 0;
+      const char* data = (const char*)duk_get_buffer_data(m_handle, -1, &size);
+
+      std::ofstream ofs(cacheFile, std::ofstream::binary);
+      writeBytecodeHeader(ofs, cacheKey, uint32_t(size),
+                          bytecodeHash(data, size));
+      ofs.write(data, size);
+      ofs.close();
+      if (!ofs)
+        std::remove(cacheFile.c_str());
+
+      duk_pop(m_handle);
+    }
+#endif
+    return rc;
+  }
+
+  // Pushes the function saved in the cache file, returns false if
+  // the file doesn't exist, it's for other version of the script or
+  // of Duktape, or the bytecode is corrupted (in these cases the
+  // script is compiled again from its source).
+  bool loadBytecode(const std::string& cacheFile,
+                    const std::string& cacheKey) {
+#if defined(DUK_USE_BYTECODE_DUMP_SUPPORT)
+    if (cacheFile.empty())
+      return false;
+
+    std::ifstream ifs(cacheFile, std::ifstream::binary);
+    if (!ifs)
+      return false;
+
+    std::ostringstream expected;
+    writeBytecodeHeader(expected, cacheKey, 0, 0);
+    std::string header = expected.str();
+    header.resize(header.size() - sizeof(uint32_t) - sizeof(uint64_t)); // Without the size/hash
+
+    std::string fileHeader(header.size(), 0);
+    uint32_t size = 0;
+    uint64_t hash = 0;
+    if (!ifs.read(&fileHeader[0], fileHeader.size()) ||
+        fileHeader != header ||
+        !ifs.read((char*)&size, sizeof(size)) ||
+        !ifs.read((char*)&hash, sizeof(hash)))
+      return false;
+
+    // Duktape doesn't validate the bytecode (loading a corrupted
+    // function can crash), so we check its hash before loading it.
+    void* data = duk_push_fixed_buffer(m_handle, size);
+    if (!ifs.read((char*)data, size) ||
+        ifs.peek() != std::ifstream::traits_type::eof() ||
+        bytecodeHash(data, size) != hash) {
+      duk_pop(m_handle);
+      return false;
+    }
+
+    duk_load_function(m_handle);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  static void writeBytecodeHeader(std::ostream& os,
+                                  const std::string& cacheKey,
+                                  uint32_t size,
+                                  uint64_t hash) {
+    const uint32_t version = DUK_VERSION;
+    os.write("LSBC", 4);
+    os.write((const char*)&version, sizeof(version));
+    os << cacheKey;
+    os.put(0);
+    os.write((const char*)&size, sizeof(size));
+    os.write((const char*)&hash, sizeof(hash));
+  }
+
+  // FNV-1a hash of the Duktape version and the bytecode.
+  static uint64_t bytecodeHash(const void* data, std::size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash](const uint8_t* p, std::size_t n) {
+      for (std::size_t i=0; i<n; ++i) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+      }
+    };
+    const uint32_t version = DUK_VERSION;
+    add((const uint8_t*)&version, sizeof(version));
+    add((const uint8_t*)data, size);
+    return hash;
+  }
 };
 
 static Engine::Regular<DukEngine> registration("duk", {"js"});
@@ -166,6 +308,10 @@ static Engine::Regular<DukEngine> registration("duk", {"js"});
 
 class DukScriptObject : public InternalScriptObject {
   int m_refC = 0;
+  // Name of the object (its class or global name) and names of its
+  // functions and properties qualified with it, for the profiler.
+  std::string m_objectName;
+  std::unordered_map<std::string, std::string> m_nativeNames;
 
 public:
   static Value getValue(duk_context* ctx, int id) {
@@ -206,20 +352,73 @@ public:
     return {};
   }
 
+  // Returns the name of the given function or property qualified with
+  // the object name (e.g. "Image.width"). The string lives as long as
+  // this object, so it can be stored in the script function.
+  const std::string& qualifiedName(const std::string& name) {
+    auto it = m_nativeNames.find(name);
+    if (it == m_nativeNames.end())
+      it = m_nativeNames.emplace(name, Profiler::qualifiedName(m_objectName, name)).first;
+    return it->second;
+  }
+
+  // Name of the native function being called (for the profiler)
+  static const std::string& nativeName(duk_context* ctx) {
+    static const std::string unknown = "(native)";
+    duk_push_current_function(ctx);
+    duk_get_prop_string(ctx, -1, HIDDEN("name"));
+    auto name = reinterpret_cast<const std::string*>(duk_get_pointer(ctx, -1));
+    duk_pop_2(ctx);
+    return (name ? *name: unknown);
+  }
+
+  // Adds the script functions that called the native function to
+  // the profiler.
+  static void sampleCallStack(duk_context* ctx, const std::string& native) {
+#if DUK_VERSION >= 20000
+    std::vector<std::string> stack;
+    // -1 is the native function itself
+    for (int level = -2; level >= -64; --level) {
+      duk_inspect_callstack_entry(ctx, level);
+      if (duk_is_undefined(ctx, -1)) {
+        duk_pop(ctx);
+        break;
+      }
+      duk_get_prop_string(ctx, -1, "function");
+      duk_get_prop_string(ctx, -1, "name");
+      const char* name = duk_get_string(ctx, -1);
+      stack.push_back(name && *name ? name: "(anonymous)");
+      duk_pop_3(ctx);
+    }
+    std::reverse(stack.begin(), stack.end());
+    stack.push_back(native);
+    Profiler::instance().addSample(stack);
+#endif
+  }
+
   static duk_ret_t callFunc(duk_context* ctx) {
     int argc = duk_get_top(ctx);
     duk_push_current_function(ctx);
     duk_get_prop_string(ctx, -1, HIDDEN("func"));
     auto& func = *reinterpret_cast<script::Function*>(duk_get_pointer(ctx, -1));
-    for (int i = 0; i < argc; ++i) {
-      func.arguments.push_back(getValue(ctx, i));
+    const bool profiling = Profiler::instance().isRunning();
+    const std::string& name = (profiling ? nativeName(ctx): std::string());
+    if (profiling && Profiler::instance().shouldSample())
+      sampleCallStack(ctx, name);
+    {
+      Profiler::Conversion conversion;
+      for (int i = 0; i < argc; ++i) {
+        func.arguments.push_back(getValue(ctx, i));
+      }
     }
     func.result.makeUndefined();
     try {
-        func();
+      Profiler::NativeCall call(name);
+      func();
     } catch (const ObjectDestroyedException&) {
       std::cout << "Object Destroyed Exception" << std::endl;
     }
+    Profiler::Conversion conversion;
     return returnValue(ctx, func.result);
   }
 
@@ -251,6 +450,8 @@ public:
       duk_push_c_function(handle, callFunc, DUK_VARARGS);
       duk_push_pointer(handle, &entry.second);
       duk_put_prop_string(handle, -2, HIDDEN("func"));
+      duk_push_pointer(handle, (void*)&qualifiedName(entry.first));
+      duk_put_prop_string(handle, -2, HIDDEN("name"));
       duk_put_prop_string(handle, -2, entry.first.c_str());
     }
 
@@ -266,7 +467,15 @@ public:
     duk_push_current_function(ctx);
     duk_get_prop_string(ctx, -1, HIDDEN("func"));
     auto& prop = *reinterpret_cast<script::ObjectProperty*>(duk_get_pointer(ctx, -1));
-    prop.getter();
+    const bool profiling = Profiler::instance().isRunning();
+    const std::string name = (profiling ? Profiler::getterName(nativeName(ctx)): std::string());
+    if (profiling && Profiler::instance().shouldSample())
+      sampleCallStack(ctx, name);
+    {
+      Profiler::NativeCall call(name);
+      prop.getter();
+    }
+    Profiler::Conversion conversion;
     returnValue(ctx, prop.getter.result);
     return 1;
   }
@@ -275,7 +484,15 @@ public:
     duk_push_current_function(ctx);
     duk_get_prop_string(ctx, -1, HIDDEN("func"));
     auto& prop = *reinterpret_cast<script::ObjectProperty*>(duk_get_pointer(ctx, -1));
-    prop.setter.arguments.emplace_back(getValue(ctx, 0));
+    const bool profiling = Profiler::instance().isRunning();
+    const std::string name = (profiling ? Profiler::setterName(nativeName(ctx)): std::string());
+    if (profiling && Profiler::instance().shouldSample())
+      sampleCallStack(ctx, name);
+    {
+      Profiler::Conversion conversion;
+      prop.setter.arguments.emplace_back(getValue(ctx, 0));
+    }
+    Profiler::NativeCall call(name);
     prop.setter();
     return 0;
   }
@@ -293,19 +510,26 @@ public:
       duk_push_c_function(handle, getterFunc, 0);
       duk_push_pointer(handle, &prop);
       duk_put_prop_string(handle, -2, HIDDEN("func"));
+      duk_push_pointer(handle, (void*)&qualifiedName(entry.first));
+      duk_put_prop_string(handle, -2, HIDDEN("name"));
       --idx;
 
       flags |= DUK_DEFPROP_HAVE_SETTER;
       duk_push_c_function(handle, setterFunc, 1);
       duk_push_pointer(handle, &prop);
       duk_put_prop_string(handle, -2, HIDDEN("func"));
+      duk_push_pointer(handle, (void*)&qualifiedName(entry.first));
+      duk_put_prop_string(handle, -2, HIDDEN("name"));
       --idx;
 
       duk_def_prop(handle, idx, flags);
     }
   }
 
-  void makeLocal() {
+  void makeLocal(ScriptObject* object) {
+    if (m_objectName.empty())
+      m_objectName = Profiler::className(typeid(*object).name());
+
     auto handle = m_engine.get<DukEngine>()->m_handle;
     duk_push_object(handle);
     pushFunctions();
@@ -313,6 +537,8 @@ public:
   }
 
   void makeGlobal(const std::string& name) override {
+    m_objectName = name;
+
     auto handle = m_engine.get<DukEngine>()->m_handle;
     duk_push_global_object(handle);
     duk_push_object(handle);
@@ -342,7 +568,7 @@ static duk_ret_t returnValue(duk_context* ctx, const Value& value) {
 
     case Value::Type::OBJECT:
         if (auto object = static_cast<ScriptObject*>(value)) {
-            static_cast<DukScriptObject*>(object->getInternalScriptObject())->makeLocal();
+            static_cast<DukScriptObject*>(object->getInternalScriptObject())->makeLocal(object);
         } else {
             duk_push_null(ctx);
         }
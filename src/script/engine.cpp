@@ -0,0 +1,31 @@
+// LibreSprite Scripting Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "script/engine.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace script {
+
+bool Engine::evalFile(const std::string& fileName,
+                      const std::string& cacheFile,
+                      const std::string& cacheKey)
+{
+  std::ifstream ifs(fileName);
+  if (!ifs) {
+    std::cout << "Could not open " << fileName << std::endl;
+    return false;
+  }
+  return eval({std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()});
+}
+
+} // namespace script
@@ -53,6 +53,13 @@ namespace script {
     bool getPrintLastResult() {return m_printLastResult;}
 
     virtual bool eval(const std::string& code) = 0;
+
+    // Evaluates a script file. Engines that can compile scripts save
+    // the compiled code in "cacheFile" and reuse it while "cacheKey"
+    // (e.g. the modification time of the file) doesn't change.
+    virtual bool evalFile(const std::string& fileName,
+                          const std::string& cacheFile,
+                          const std::string& cacheKey);
     virtual bool raiseEvent(const std::vector<script::Value>& event) = 0;
 
     void afterEval(std::function<void(bool)>&& callback) {
@@ -0,0 +1,174 @@
+// LibreSprite Scripting Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "script/profiler.h"
+
+#include "base/fstream_path.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+
+namespace script {
+
+namespace {
+
+const std::size_t kReportLines = 20;
+
+template<typename Map, typename Key>
+std::vector<typename Map::const_iterator> sorted_by(const Map& map, Key key)
+{
+  std::vector<typename Map::const_iterator> items;
+  for (auto it=map.begin(); it!=map.end(); ++it)
+    items.push_back(it);
+  std::sort(items.begin(), items.end(),
+            [key](auto a, auto b) { return key(a) > key(b); });
+  return items;
+}
+
+} // anonymous namespace
+
+Profiler& Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+  : m_running(false)
+  , m_sampleInterval(std::chrono::milliseconds(1))
+  , m_conversions(0)
+  , m_conversionTime(0)
+{
+}
+
+std::string Profiler::className(const std::string& typeName)
+{
+  const std::string suffix = "ScriptObject";
+  std::size_t end = typeName.rfind(suffix);
+  if (end == std::string::npos || end == 0)
+    return typeName;
+
+  // Mangled names have the length of each identifier before it
+  // (e.g. "17ImageScriptObject"), other compilers add "class ".
+  std::size_t begin = end;
+  while (begin > 0 &&
+         (std::isalpha((unsigned char)typeName[begin-1]) ||
+          typeName[begin-1] == '_'))
+    --begin;
+  if (begin == end)
+    return typeName;
+  return typeName.substr(begin, end-begin);
+}
+
+void Profiler::start(int sampleInterval)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sampleInterval = std::chrono::milliseconds(std::max(0, sampleInterval));
+  m_lastSample = clock::now();
+  m_running = true;
+}
+
+void Profiler::stop()
+{
+  m_running = false;
+}
+
+void Profiler::reset()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lastSample = clock::now();
+  m_conversions = 0;
+  m_conversionTime = 0;
+  m_natives.clear();
+  m_stacks.clear();
+}
+
+bool Profiler::shouldSample()
+{
+  if (!m_running)
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return (clock::now() - m_lastSample >= m_sampleInterval);
+}
+
+void Profiler::addSample(const std::vector<std::string>& stack)
+{
+  std::string folded;
+  for (const auto& frame : stack) {
+    if (!folded.empty())
+      folded.push_back(';');
+    folded += frame;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto now = clock::now();
+  m_stacks[folded] += std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastSample).count();
+  m_lastSample = now;
+}
+
+void Profiler::addNativeCall(const std::string& name, int64_t time)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& stats = m_natives[name];
+  ++stats.calls;
+  stats.time += time;
+}
+
+void Profiler::addConversion(int64_t time)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_conversions;
+  m_conversionTime += time;
+}
+
+std::string Profiler::report() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string result;
+  char buf[256];
+
+  std::snprintf(buf, sizeof(buf), "Value conversions: %lld (%.3f ms)\n",
+                (long long)m_conversions, m_conversionTime / 1000.0);
+  result += buf;
+
+  result += "Native calls (calls, total ms, name):\n";
+  auto natives = sorted_by(m_natives, [](auto it){ return it->second.time; });
+  for (std::size_t i=0; i<natives.size() && i<kReportLines; ++i) {
+    std::snprintf(buf, sizeof(buf), "  %10lld %10.3f  ",
+                  (long long)natives[i]->second.calls,
+                  natives[i]->second.time / 1000.0);
+    result += buf + natives[i]->first + "\n";
+  }
+
+  result += "Sampled stacks (ms, stack):\n";
+  auto stacks = sorted_by(m_stacks, [](auto it){ return it->second; });
+  for (std::size_t i=0; i<stacks.size() && i<kReportLines; ++i) {
+    std::snprintf(buf, sizeof(buf), "  %10.3f  ", stacks[i]->second / 1000.0);
+    result += buf + stacks[i]->first + "\n";
+  }
+  return result;
+}
+
+bool Profiler::saveFoldedStacks(const std::string& filename) const
+{
+  std::ofstream f(FSTREAM_PATH(filename));
+  if (!f)
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const auto& stack : m_stacks)
+    f << stack.first << " " << stack.second << "\n";
+  return bool(f);
+}
+
+} // namespace script
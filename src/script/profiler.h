@@ -0,0 +1,132 @@
+// LibreSprite Scripting Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace script {
+
+  // Profiler for scripts. Engines report the calls to native
+  // functions (methods and properties of ScriptObjects), the time
+  // used to convert values between the engine and C++, and samples
+  // of the script call stack.
+  //
+  // Stacks are sampled when a native function is called and the
+  // sampling interval has elapsed. Each sample is weighted with the
+  // time since the previous one, so the folded stacks can be used to
+  // generate a flamegraph of the time spent in each script function.
+  class Profiler {
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    struct NativeStats {
+      int64_t calls = 0;
+      int64_t time = 0;         // Microseconds
+    };
+
+    static Profiler& instance();
+
+    void start(int sampleInterval);
+    void stop();
+    void reset();
+    bool isRunning() const { return m_running; }
+
+    // Returns true if the engine should call addSample() now.
+    bool shouldSample();
+    // Adds a sample of the call stack (outermost function first).
+    void addSample(const std::vector<std::string>& stack);
+    void addNativeCall(const std::string& name, int64_t time);
+    void addConversion(int64_t time);
+
+    // Names of the getter and setter of a property (e.g. "get width"
+    // and "set width"), so they are reported as different functions.
+    static std::string getterName(const std::string& property) {
+      return "get " + property;
+    }
+    static std::string setterName(const std::string& property) {
+      return "set " + property;
+    }
+
+    // Name of a function or property qualified with the name of the
+    // object that owns it (e.g. "Image.width"), so members with the
+    // same name in different objects aren't merged.
+    static std::string qualifiedName(const std::string& object,
+                                     const std::string& member) {
+      return object + "." + member;
+    }
+
+    // Returns the name of a ScriptObject class from its type name
+    // (typeid().name()) without the "ScriptObject" suffix, e.g.
+    // "Image" for ImageScriptObject.
+    static std::string className(const std::string& typeName);
+
+    // Returns a text with the most expensive native functions and
+    // script stacks.
+    std::string report() const;
+
+    // Saves the stacks in the "folded" format used by flamegraph tools
+    // (one "outer;inner;native count" line per stack, where "count"
+    // is in microseconds).
+    bool saveFoldedStacks(const std::string& filename) const;
+
+    // Measures a native call while it's alive.
+    class NativeCall {
+    public:
+      NativeCall(const std::string& name)
+        : m_name(instance().isRunning() ? &name: nullptr) {
+        if (m_name)
+          m_start = clock::now();
+      }
+      ~NativeCall() {
+        if (m_name)
+          instance().addNativeCall(*m_name, elapsed(m_start));
+      }
+    private:
+      const std::string* m_name;
+      clock::time_point m_start;
+    };
+
+    // Measures a conversion of values while it's alive.
+    class Conversion {
+    public:
+      Conversion() : m_running(instance().isRunning()) {
+        if (m_running)
+          m_start = clock::now();
+      }
+      ~Conversion() {
+        if (m_running)
+          instance().addConversion(elapsed(m_start));
+      }
+    private:
+      bool m_running;
+      clock::time_point m_start;
+    };
+
+  private:
+    Profiler();
+
+    static int64_t elapsed(clock::time_point start) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+    }
+
+    mutable std::mutex m_mutex;
+    std::atomic<bool> m_running;
+    clock::duration m_sampleInterval;
+    clock::time_point m_lastSample;
+    int64_t m_conversions;
+    int64_t m_conversionTime;
+    std::map<std::string, NativeStats> m_natives;
+    std::map<std::string, int64_t> m_stacks;
+  };
+
+} // namespace script
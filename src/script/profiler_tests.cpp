@@ -0,0 +1,196 @@
+// LibreSprite Scripting Library
+// Copyright (c) 2026 LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "base/fs.h"
+#include "base/path.h"
+#include "script/profiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace script;
+
+// Returns the line of the report with the given native function or
+// stack (an empty string if it's not in the report).
+static std::string report_line(const std::string& report,
+                               const std::string& name)
+{
+  // Names are separated from the numbers with two spaces
+  const std::string suffix = "  " + name;
+  std::istringstream lines(report);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.size() > suffix.size() &&
+        line.compare(line.size()-suffix.size(), suffix.size(), suffix) == 0)
+      return line;
+  }
+  return std::string();
+}
+
+// Returns the number of calls of a native function in the report
+static int report_calls(const std::string& report, const std::string& name)
+{
+  std::istringstream line(report_line(report, name));
+  int calls = 0;
+  line >> calls;
+  return calls;
+}
+
+class ProfilerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    profiler().stop();
+    profiler().reset();
+  }
+  void TearDown() override {
+    profiler().stop();
+    profiler().reset();
+  }
+  Profiler& profiler() { return Profiler::instance(); }
+};
+
+TEST_F(ProfilerTest, NothingIsRecordedWhenStopped)
+{
+  EXPECT_FALSE(profiler().isRunning());
+  EXPECT_FALSE(profiler().shouldSample());
+
+  {
+    const std::string name = "width";
+    Profiler::NativeCall call(name);
+    Profiler::Conversion conversion;
+  }
+
+  const std::string report = profiler().report();
+  EXPECT_EQ("", report_line(report, "width"));
+  EXPECT_NE(std::string::npos, report.find("Value conversions: 0 "));
+}
+
+TEST_F(ProfilerTest, NativeCalls)
+{
+  profiler().start(0);
+  EXPECT_TRUE(profiler().isRunning());
+
+  const std::string name = "open";
+  for (int i=0; i<3; ++i) {
+    Profiler::NativeCall call(name);
+  }
+  for (int i=0; i<2; ++i) {
+    Profiler::Conversion conversion;
+  }
+  profiler().stop();
+
+  // Not recorded after stop()
+  {
+    Profiler::NativeCall call(name);
+  }
+
+  const std::string report = profiler().report();
+  EXPECT_EQ(3, report_calls(report, "open"));
+  EXPECT_NE(std::string::npos, report.find("Value conversions: 2 "));
+
+  profiler().reset();
+  EXPECT_EQ("", report_line(profiler().report(), "open"));
+}
+
+TEST_F(ProfilerTest, GetterAndSetterAreDifferentCalls)
+{
+  EXPECT_EQ("get width", Profiler::getterName("width"));
+  EXPECT_EQ("set width", Profiler::setterName("width"));
+
+  const std::string getter = Profiler::getterName("width");
+  const std::string setter = Profiler::setterName("width");
+
+  profiler().start(0);
+  for (int i=0; i<4; ++i) {
+    Profiler::NativeCall call(getter);
+  }
+  {
+    Profiler::NativeCall call(setter);
+  }
+  profiler().stop();
+
+  const std::string report = profiler().report();
+  EXPECT_EQ(4, report_calls(report, "get width"));
+  EXPECT_EQ(1, report_calls(report, "set width"));
+  EXPECT_EQ("", report_line(report, "width"));
+}
+
+TEST_F(ProfilerTest, MembersOfDifferentObjectsAreDifferentCalls)
+{
+  EXPECT_EQ("Image", Profiler::className("17ImageScriptObject"));
+  EXPECT_EQ("Image", Profiler::className("N12_GLOBAL__N_117ImageScriptObjectE"));
+  EXPECT_EQ("ButtonWidget", Profiler::className("class ButtonWidgetScriptObject"));
+  EXPECT_EQ("Other", Profiler::className("Other"));
+  EXPECT_EQ("Image.width", Profiler::qualifiedName("Image", "width"));
+
+  const std::string image = Profiler::getterName(Profiler::qualifiedName("Image", "width"));
+  const std::string sprite = Profiler::getterName(Profiler::qualifiedName("Sprite", "width"));
+
+  profiler().start(0);
+  for (int i=0; i<3; ++i) {
+    Profiler::NativeCall call(image);
+  }
+  {
+    Profiler::NativeCall call(sprite);
+  }
+  profiler().stop();
+
+  const std::string report = profiler().report();
+  EXPECT_EQ(3, report_calls(report, "get Image.width"));
+  EXPECT_EQ(1, report_calls(report, "get Sprite.width"));
+}
+
+TEST_F(ProfilerTest, FoldedStacks)
+{
+  profiler().start(0);
+  EXPECT_TRUE(profiler().shouldSample());
+
+  const std::vector<std::string> stack = { "main", "draw", "get Image.width" };
+  profiler().addSample(stack);
+  profiler().addSample(stack);
+  profiler().addSample({ "main", "set Image.width" });
+  profiler().stop();
+
+  const std::string report = profiler().report();
+  EXPECT_NE("", report_line(report, "main;draw;get Image.width"));
+  EXPECT_NE("", report_line(report, "main;set Image.width"));
+
+  const std::string fn =
+    base::join_path(base::get_temp_path(), "libresprite-profiler-tests.txt");
+  ASSERT_TRUE(profiler().saveFoldedStacks(fn));
+
+  std::vector<std::string> stacks;
+  {
+    std::ifstream f(fn);
+    std::string line;
+    while (std::getline(f, line)) {
+      auto pos = line.rfind(' ');
+      ASSERT_NE(std::string::npos, pos);
+      // The count (microseconds) is a number
+      EXPECT_EQ(std::string::npos, line.find_first_not_of("0123456789", pos+1));
+      stacks.push_back(line.substr(0, pos));
+    }
+  }
+  base::delete_file(fn);
+
+  ASSERT_EQ(2, stacks.size());
+  EXPECT_EQ("main;draw;get Image.width", stacks[0]);
+  EXPECT_EQ("main;set Image.width", stacks[1]);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
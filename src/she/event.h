@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "base/latency_histogram.h"
 #include "gfx/point.h"
 #include "gfx/size.h"
 #include "she/keys.h"
@@ -59,7 +60,8 @@ namespace she {
               m_pointerType(PointerType::Unknown),
               m_button(NoneButton),
               m_magnification(0.0),
-              m_pressure(0.0) {
+              m_pressure(0.0),
+              m_timestamp(0) {
     }
 
     Type type() const { return m_type; }
@@ -83,6 +85,10 @@ namespace she {
     double magnification() const { return m_magnification; }
     double pressure() const { return m_pressure; }
 
+    // When the event was generated by the OS (see
+    // base::current_timestamp()), or 0 if it's unknown.
+    base::timestamp_t timestamp() const { return m_timestamp; }
+
     void setType(Type type) { m_type = type; }
     void setDisplay(Display* display) { m_display = display; }
     void setFiles(const Files& files) { m_files = files; }
@@ -98,6 +104,7 @@ namespace she {
     void setButton(MouseButton button) { m_button = button; }
     void setMagnification(double magnification) { m_magnification = magnification; }
     void setPressure(double pressure) { m_pressure = pressure; }
+    void setTimestamp(base::timestamp_t timestamp) { m_timestamp = timestamp; }
 
   private:
     Type m_type;
@@ -118,6 +125,8 @@ namespace she {
 
     // Pressure of stylus used in mouse-like events
     double m_pressure;
+
+    base::timestamp_t m_timestamp;
   };
 
 } // namespace she
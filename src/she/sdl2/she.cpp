@@ -39,6 +39,8 @@
 #include <memory>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 #define SDL_HINT_WINDOWS_DPI_AWARENESS "SDL_WINDOWS_DPI_AWARENESS"
@@ -360,9 +362,49 @@ namespace she {
 	getEventInternal(event, false);
     }
 
+    bool hasEvents() const {
+      return !m_events.empty();
+    }
+
+    // Blocks the calling thread (it must be the gfx thread) until
+    // there is a new SDL event or "timeout" milliseconds elapse (-1 to
+    // wait indefinitely). The event stays in the SDL queue.
+    void wait(int timeout) {
+      if (timeout < 0)
+        SDL_WaitEvent(nullptr);
+      else
+        SDL_WaitEventTimeout(nullptr, timeout);
+    }
+
+    // Wakes up the gfx thread if it's waiting in wait(). It can be
+    // called from any thread.
+    static void wakeup() {
+#if !defined(__EMSCRIPTEN__)
+      static Uint32 wakeupEventType = SDL_RegisterEvents(1);
+      if (wakeupEventType == (Uint32)-1)
+        return;
+
+      SDL_Event sdlEvent;
+      SDL_zero(sdlEvent);
+      sdlEvent.type = wakeupEventType;
+      SDL_PushEvent(&sdlEvent);
+#else
+      // The emscripten main loop runs each animation frame, it
+      // doesn't need to be woken up.
+#endif
+    }
+
     void getEventInternal(Event& event, bool) {
       SDL_Event sdlEvent;
       while (SDL_PollEvent(&sdlEvent)) {
+        if (sdlEvent.type >= SDL_USEREVENT)
+          continue;
+
+        // SDL timestamps are milliseconds since SDL_Init()
+        base::timestamp_t timestamp = base::current_timestamp() -
+          base::timestamp_t(Uint32(SDL_GetTicks() - sdlEvent.common.timestamp)) * 1000;
+        event.setTimestamp(timestamp);
+
         switch (sdlEvent.type) {
         case SDL_APP_DIDENTERFOREGROUND:
           SDL2Surface::textureGen++;
@@ -600,6 +642,7 @@ namespace she {
           base::utf8_const_iterator end{textString.end()};
           Event event;
           event.setModifiers(getSheModifiers());
+          event.setTimestamp(timestamp);
           for (auto it = begin; it != end; ++it) {
             event.setType(Event::KeyDown);
             event.setUnicodeChar(*it);
@@ -633,6 +676,8 @@ namespace she {
 
     void queueEvent(const Event& event) override {
       m_events.push(event);
+      if (!she::instance()->isGfxThread())
+        wakeup();
     }
 
   private:
@@ -651,8 +696,13 @@ namespace she {
     }
 
     ~SDL2System() {
-      shutdown = true;
-      sleeping = false;
+      {
+	std::lock_guard<std::mutex> lock(gfxMutex);
+	shutdown = true;
+	sleeping = false;
+      }
+      gfxCondition.notify_all();
+      SDL2EventQueue::wakeup();
       if (mainThread.joinable())
 	mainThread.join();
       IMG_Quit();
@@ -660,12 +710,35 @@ namespace she {
       g_instance = nullptr;
     }
 
-    bool shutdown{false};
+    std::atomic<bool> shutdown{false};
     std::thread mainThread;
     std::thread::id mainThreadId;
     std::thread::id gfxThreadId;
+
+    // Functions that other threads (producers) want to run in the gfx
+    // thread (the only consumer). "sleeping" is true when the main
+    // thread is waiting the gfx thread to run them and present a new
+    // frame. Both are protected by gfxMutex.
     std::vector<std::function<void()>> gfxQueue;
-    std::atomic<bool> sleeping{false};
+    bool sleeping{false};
+    std::mutex gfxMutex;
+    std::condition_variable gfxCondition;
+
+    // Last time that the main thread was woken up (to pace the frames
+    // generated by timers).
+    std::chrono::steady_clock::time_point lastWakeup;
+
+    // Minimum time between two frames generated by timers. It's the
+    // refresh rate of the display (or 60Hz if it's unknown).
+    std::chrono::milliseconds frameTime() const {
+      int rate = 0;
+      for (auto& entry : sdl::windowIdToDisplay) {
+	SDL_DisplayMode mode;
+	if (SDL_GetWindowDisplayMode(entry.second->m_window, &mode) == 0)
+	  rate = std::max(rate, mode.refresh_rate);
+      }
+      return std::chrono::milliseconds(1000 / (rate > 0 ? rate: 60));
+    }
 
     bool isGfxThread() override {
       return std::this_thread::get_id() == gfxThreadId;
@@ -680,38 +753,70 @@ namespace she {
 	func();
 	return;
       }
-      gfxQueue.emplace_back(std::move(func));
+      {
+	std::lock_guard<std::mutex> lock(gfxMutex);
+	gfxQueue.emplace_back(std::move(func));
+      }
+      SDL2EventQueue::wakeup();
       if (sleep)
-	this->sleep();
+	this->sleep(0);
     }
 
-    using Timestamp = std::chrono::high_resolution_clock::time_point;
-    Timestamp start = std::chrono::high_resolution_clock::now();
+    // Runs the functions queued with gfx() (in the gfx thread).
+    void runGfxQueue() {
+      std::vector<std::function<void()>> queue;
+      {
+	std::lock_guard<std::mutex> lock(gfxMutex);
+	queue.swap(gfxQueue);
+      }
+      for (auto& func : queue)
+	func();
+    }
+
+    void sleep(int timeout) override {
+      using Clock = std::chrono::steady_clock;
+
+      // Even when the main thread is idle, it's woken up each 1
+      // second just in case.
+      const int kMaxTimeout = 1000;
 
-    void sleep() override {
-      using namespace std::chrono_literals;
       if (shutdown)
 	return;
 
+      auto queue = static_cast<SDL2EventQueue*>(EventQueue::instance());
+      if (timeout < 0 || timeout > kMaxTimeout)
+	timeout = kMaxTimeout;
+
       if (mainThreadId == gfxThreadId) {
-	refresh();
-	auto now = std::chrono::high_resolution_clock::now();
+	runGfxQueue();
+	queue->refresh();
+	if (timeout == 0 || queue->hasEvents())
+	  return;
 
-	// If the dispatching of messages was faster than 10 milliseconds,
-	// it means that the process is not using a lot of CPU, so we can
-	// wait the difference to cover those 10 milliseconds
-	// sleeping. With this code we can avoid 100% CPU usage.
-	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
-	start = now;
+	// Timers don't need to generate frames faster than the display
+	// refresh rate. Input events wake us up immediately anyway.
+	auto now = Clock::now();
+	auto minTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+	  lastWakeup + frameTime() - now).count();
+	if (timeout < minTimeout)
+	  timeout = int(minTimeout);
 
-	if (elapsed < 15ms)
-	  std::this_thread::sleep_for(15ms - elapsed);
+	queue->wait(timeout);
+	lastWakeup = Clock::now();
       } else if (isMainThread()) {
+	auto deadline = Clock::now() + std::chrono::milliseconds(timeout);
+	std::unique_lock<std::mutex> lock(gfxMutex);
+
+	// Wait the gfx thread to run the gfx() queue and present a new
+	// frame.
 	sleeping = true;
-	while (sleeping) {
-	  using namespace std::chrono_literals;
-	  std::this_thread::sleep_for(10ms);
-	}
+	SDL2EventQueue::wakeup();
+	gfxCondition.wait(lock, [this]{ return !sleeping || shutdown; });
+
+	// Then wait until there are new events or the timeout elapses.
+	gfxCondition.wait_until(lock, deadline, [this, queue]{
+	  return shutdown || queue->hasEvents();
+	});
       }
     }
 
@@ -728,7 +833,8 @@ namespace she {
         mainThreadId = std::this_thread::get_id();
 	m_func();
       }};
-      while (!shutdown)(
+      while (!shutdown) {
+	static_cast<SDL2EventQueue*>(EventQueue::instance())->wait(-1);
 	refresh();
       }
       #else
@@ -784,9 +890,25 @@ namespace she {
       return 0;
     }
 
+    // Called in the gfx thread each frame when the main thread runs
+    // in its own thread.
     void refresh() {
-      if (!sleeping) {
-	static_cast<SDL2EventQueue*>(EventQueue::instance())->refresh();
+      bool wakeMainThread;
+      {
+	std::lock_guard<std::mutex> lock(gfxMutex);
+	wakeMainThread = sleeping;
+      }
+      // Surfaces can be presented only while the main thread is
+      // waiting (it's not drawing on them).
+      if (!wakeMainThread) {
+	auto queue = static_cast<SDL2EventQueue*>(EventQueue::instance());
+	queue->refresh();
+	if (queue->hasEvents()) {
+	  // Lock the mutex so the main thread cannot miss the
+	  // notification between checking for events and waiting.
+	  { std::lock_guard<std::mutex> lock(gfxMutex); }
+	  gfxCondition.notify_all();
+	}
 	return;
       }
       #ifdef __EMSCRIPTEN__
@@ -808,17 +930,16 @@ namespace she {
 	}
       }
       #endif
-      int frames = 5;
-      do {
-	for (auto it = gfxQueue.begin(); it != gfxQueue.end(); ++it) {
-	  (*it)();
-	}
-	gfxQueue.clear();
+      runGfxQueue();
+      for (auto& entry : sdl::windowIdToDisplay)
+	entry.second->present();
+      static_cast<SDL2EventQueue*>(EventQueue::instance())->refresh();
+
+      {
+	std::lock_guard<std::mutex> lock(gfxMutex);
 	sleeping = false;
-	for (auto& entry : sdl::windowIdToDisplay)
-	  entry.second->present();
-	static_cast<SDL2EventQueue*>(EventQueue::instance())->refresh();
-      } while (sleeping && --frames);
+      }
+      gfxCondition.notify_all();
     }
 
     void activateApp() override {
@@ -56,7 +56,10 @@ namespace she {
     virtual bool isGfxThread() = 0;
     virtual bool isMainThread() = 0;
     virtual void gfx(std::function<void()>&& func, bool sleep = false) = 0;
-    virtual void sleep() = 0;
+
+    // Waits until there are new events to process or "timeout"
+    // milliseconds have elapsed (-1 to wait only for events).
+    virtual void sleep(int timeout = -1) = 0;
   };
 
   System* create_system();
@@ -0,0 +1,68 @@
+// LibreSprite UI Library
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ui/latency.h"
+
+namespace ui {
+
+static base::LatencyHistogram histograms[kLatencyStages];
+static base::timestamp_t input_timestamp = 0;
+
+const char* latency_stage_name(LatencyStage stage)
+{
+  switch (stage) {
+    case LatencyStage::Queue: return "queue";
+    case LatencyStage::Dispatch: return "dispatch";
+    case LatencyStage::Tool: return "tool";
+    case LatencyStage::Flip: return "flip";
+  }
+  return "";
+}
+
+void record_latency(LatencyStage stage, base::timestamp_t since)
+{
+  if (since)
+    histograms[int(stage)].add(base::current_timestamp() - since);
+}
+
+const base::LatencyHistogram& get_latency_histogram(LatencyStage stage)
+{
+  return histograms[int(stage)];
+}
+
+void reset_latency_histograms()
+{
+  for (auto& histogram : histograms)
+    histogram.reset();
+}
+
+std::string latency_report()
+{
+  std::string report;
+  for (int i=0; i<kLatencyStages; ++i) {
+    report += latency_stage_name(LatencyStage(i));
+    report += ": ";
+    report += histograms[i].summary();
+    report += "\n";
+  }
+  return report;
+}
+
+base::timestamp_t current_input_timestamp()
+{
+  return input_timestamp;
+}
+
+void set_current_input_timestamp(base::timestamp_t timestamp)
+{
+  input_timestamp = timestamp;
+}
+
+} // namespace ui
@@ -0,0 +1,43 @@
+// LibreSprite UI Library
+// Copyright (C) 2026  LibreSprite contributors
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#pragma once
+
+#include "base/latency_histogram.h"
+
+#include <string>
+
+namespace ui {
+
+  // Stages of the path of an input event (e.g. a pen movement) until
+  // its result is on the screen. Each stage measures the time since
+  // the OS received the event.
+  enum class LatencyStage {
+    Queue,      // The ui::Manager converts the event into a ui::Message
+    Dispatch,   // The ui::Message is sent to its widget
+    Tool,       // The active tool applies the input to the document
+    Flip,       // The result is flipped to the display
+  };
+
+  const int kLatencyStages = 4;
+
+  const char* latency_stage_name(LatencyStage stage);
+
+  // Latency histograms must be used from the UI thread only.
+  void record_latency(LatencyStage stage, base::timestamp_t since);
+  const base::LatencyHistogram& get_latency_histogram(LatencyStage stage);
+  void reset_latency_histograms();
+
+  // One line for each stage with its percentiles.
+  std::string latency_report();
+
+  // Timestamp of the input message that is being dispatched right
+  // now, or 0 if the current message isn't an input message. Used to
+  // measure the LatencyStage::Tool in deeper layers.
+  base::timestamp_t current_input_timestamp();
+  void set_current_input_timestamp(base::timestamp_t timestamp);
+
+} // namespace ui
@@ -21,6 +21,7 @@
 #include "she/surface.h"
 #include "she/system.h"
 #include "ui/intern.h"
+#include "ui/latency.h"
 #include "ui/manager.h"
 #include "ui/ui.h"
 
@@ -76,8 +77,16 @@ static Widget* capture_widget;  // The widget that captures the mouse
 
 static bool first_time = true;    // true when we don't enter in poll yet
 
+// Timestamp of the she::Event that is being converted to messages
+static base::timestamp_t event_timestamp = 0;
+
+// Timestamp of the oldest input message dispatched since the last
+// time something was flipped to the display
+static base::timestamp_t pending_flip_timestamp = 0;
+
 /* keyboard focus movement stuff */
 static bool move_focus(Manager* manager, Message* msg);
+static bool is_input_message(MessageType type);
 static int count_widgets_accept_focus(Widget* widget);
 static bool childs_accept_focus(Widget* widget, bool first);
 static Widget* next_widget(Widget* widget);
@@ -195,6 +204,11 @@ void Manager::flipDisplay()
       m_display->flip(rc);
     m_display->present();
 
+    if (pending_flip_timestamp && !m_dirtyRegion.isEmpty()) {
+      record_latency(LatencyStage::Flip, pending_flip_timestamp);
+      pending_flip_timestamp = 0;
+    }
+
     m_dirtyRegion.clear();
   }
 
@@ -292,6 +306,10 @@ void Manager::generateMessagesFromSheEvents()
     if (sheEvent.type() == she::Event::None)
       break;
 
+    // Messages generated from this event will have its timestamp
+    event_timestamp = sheEvent.timestamp();
+    record_latency(LatencyStage::Queue, event_timestamp);
+
     switch (sheEvent.type()) {
 
       case she::Event::CloseDisplay: {
@@ -422,10 +440,13 @@ void Manager::generateMessagesFromSheEvents()
   // Generate just one kSetCursorMessage for the last mouse position
   if (lastMouseMoveEvent.type() != she::Event::None) {
     sheEvent = lastMouseMoveEvent;
+    event_timestamp = sheEvent.timestamp();
     generateSetCursorMessage(sheEvent.position(),
                              sheEvent.modifiers(),
                              sheEvent.pointerType());
   }
+
+  event_timestamp = 0;
 }
 
 void Manager::handleMouseMove(const gfx::Point& mousePos,
@@ -619,6 +640,9 @@ void Manager::enqueueMessage(Message* msg)
 {
   ASSERT(msg != NULL);
 
+  if (event_timestamp)
+    msg->setTimestamp(event_timestamp);
+
 #ifdef REPORT_EVENTS
   if (msg->type() == kKeyDownMessage ||
       msg->type() == kKeyUpMessage) {
@@ -1270,6 +1294,17 @@ void Manager::pumpQueue()
     msg->markAsUsed();
     Message* first_msg = msg;
 
+    // Measure the latency of input messages
+    const bool inputMsg = is_input_message(msg->type());
+    const base::timestamp_t oldInputTimestamp = current_input_timestamp();
+    if (inputMsg) {
+      record_latency(LatencyStage::Dispatch, msg->timestamp());
+      set_current_input_timestamp(msg->timestamp());
+
+      if (!pending_flip_timestamp || msg->timestamp() < pending_flip_timestamp)
+        pending_flip_timestamp = msg->timestamp();
+    }
+
     // Call Timer::tick() if this is a tick message.
     if (msg->type() == kTimerMessage) {
       ASSERT(static_cast<TimerMessage*>(msg)->timer() != NULL);
@@ -1348,6 +1383,9 @@ void Manager::pumpQueue()
       }
     }
 
+    if (inputMsg)
+      set_current_input_timestamp(oldInputTimestamp);
+
     // Remove the message from the msg_queue
     it = msg_queue.erase(it);
 
@@ -1503,6 +1541,23 @@ void Manager::broadcastKeyMsg(Message* msg)
   }
 }
 
+static bool is_input_message(MessageType type)
+{
+  switch (type) {
+    case kKeyDownMessage:
+    case kKeyUpMessage:
+    case kMouseDownMessage:
+    case kMouseUpMessage:
+    case kDoubleClickMessage:
+    case kMouseMoveMessage:
+    case kMouseWheelMessage:
+    case kTouchMagnifyMessage:
+      return true;
+    default:
+      return false;
+  }
+}
+
 /***********************************************************************
                             Focus Movement
  ***********************************************************************/
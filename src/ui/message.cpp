@@ -21,6 +21,7 @@ namespace ui {
 Message::Message(MessageType type, KeyModifiers modifiers)
   : m_type(type)
   , m_used(false)
+  , m_timestamp(base::current_timestamp())
 {
   if (modifiers == kKeyUninitializedModifier) {
     // Get modifiers from the deprecated API
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "base/latency_histogram.h"
 #include "gfx/point.h"
 #include "gfx/rect.h"
 #include "ui/base.h"
@@ -48,6 +49,11 @@ namespace ui {
     bool onlyCmdPressed() const { return m_modifiers == kKeyCmdModifier; }
     bool onlyWinPressed() const { return m_modifiers == kKeyWinModifier; }
 
+    // When the input event that generated this message was received
+    // from the OS (or when the message was created).
+    base::timestamp_t timestamp() const { return m_timestamp; }
+    void setTimestamp(base::timestamp_t timestamp) { m_timestamp = timestamp; }
+
     void addRecipient(Widget* widget);
     void prependRecipient(Widget* widget);
     void removeRecipient(Widget* widget);
@@ -59,6 +65,7 @@ namespace ui {
     WidgetsList m_recipients; // List of recipients of the message
     bool m_used;              // Was used
     KeyModifiers m_modifiers; // Key modifiers pressed when message was created
+    base::timestamp_t m_timestamp;
   };
 
   class KeyMessage : public Message {
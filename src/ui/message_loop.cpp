@@ -11,6 +11,7 @@
 #include "ui/message_loop.h"
 
 #include "ui/manager.h"
+#include "ui/timer.h"
 #include "she/system.h"
 
 namespace ui {
@@ -24,10 +25,16 @@ void MessageLoop::pumpMessages()
 {
   if (m_manager->generateMessages()) {
     m_manager->dispatchMessages();
+
+    // Don't wait, there could be more messages to process (e.g. new
+    // mouse events while we were painting).
+    she::instance()->sleep(0);
   } else {
     m_manager->collectGarbage();
+
+    // Wait for new events (or the next timer tick).
+    she::instance()->sleep(Timer::getTimeout());
   }
-  she::instance()->sleep();
 }
 
 } // namespace ui
@@ -96,6 +96,23 @@ void Timer::pollTimers()
   }
 }
 
+int Timer::getTimeout()
+{
+  int timeout = -1;
+  base::tick_t t = base::current_tick();
+
+  for (Timer* timer : timers) {
+    if (timer && timer->isRunning()) {
+      base::tick_t next = timer->m_lastTick + timer->m_interval;
+      int remaining = (next > t ? int(next - t): 0);
+      if (timeout < 0 || remaining < timeout)
+        timeout = remaining;
+    }
+  }
+
+  return timeout;
+}
+
 void Timer::checkNoTimers()
 {
   ASSERT(timers.empty());
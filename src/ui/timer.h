@@ -36,6 +36,10 @@ namespace ui {
     static void pollTimers();
     static void checkNoTimers();
 
+    // Returns the number of milliseconds until the next running timer
+    // must tick, or -1 if there are no running timers.
+    static int getTimeout();
+
   protected:
     virtual void onTick();
 